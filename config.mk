@@ -21,8 +21,10 @@ CONFIG_UART = 1
 CONFIG_SPI = 0
 CONFIG_SPI_DEVICE = 0
 
-CONFIG_I2C = 0
-CONFIG_I2C_DEVICE = 0
+# i2c driver only for io expanders, built with IO_EXP=1. Not written as
+# = 1 so the config header does not define them for other builds
+CONFIG_I2C = $(if $(filter 1,$(IO_EXP)),1,0)
+CONFIG_I2C_DEVICE = $(CONFIG_I2C)
 CONFIG_LSM303 = 0
 CONFIG_M24M01 = 0
 
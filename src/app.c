@@ -15,12 +15,18 @@
 #include <stdarg.h>
 
 #include "gpio_map.h"
+#include "bitset.h"
+#include "processor.h"
+#include "timer.h"
+#include "wheel.h"
+#include "velocity.h"
 
 #include "def_config.h"
 
 #include "usb_arcade.h"
 
 #include "niffs_impl.h"
+#include "io_exp.h"
 #ifdef CONFIG_ANNOYATRON
 #include "app_annoyatron.h"
 #endif
@@ -34,21 +40,77 @@ volatile u8_t print_io = IOSTD;
 #define DEV_JOY1        2
 #define DEV_JOY2        3
 
-#define PIN_MARK_KB     (1<<DEV_KB)
-#define PIN_MARK_MOUSE  (1<<DEV_MOUSE)
-#define PIN_MARK_JOY1   (1<<DEV_JOY1)
-#define PIN_MARK_JOY2   (1<<DEV_JOY2)
-
-typedef struct __attribute__ (( packed )) {
-  bool pin_active : 1;
-  u8_t same_state : 7;
-} pin_debounce;
-
-typedef enum {
-  PIN_INACTIVE = 0,
-  PIN_ACTIVE,
-  PIN_ACTIVE_TERN
-} app_pin_state;
+// wakeup press not reported within this is counted as missed
+#define APP_WAKE_REPORT_MS    1000
+// rtc alarm period sampling pins not armed as exti wake sources while suspended
+#define APP_WAKE_POLL_MS      20
+
+// an active combo acts as an extra pin after the real pins, a matched motion
+// as an extra pin tapped after those, and a running macro as an extra pin
+// after those pressing its taps
+#define COMBO_PIN(c)    (APP_CONFIG_PINS + (c))
+#define MOTION_PIN(m)   (APP_CONFIG_PINS + APP_CONFIG_COMBOS + (m))
+#define MACRO_PIN(m)    (APP_CONFIG_PINS + APP_CONFIG_COMBOS + APP_CONFIG_MOTIONS + (m))
+// real pins, combo pins, motion pins and macro pins
+#define ALL_PINS        (APP_CONFIG_PINS + APP_CONFIG_COMBOS + APP_CONFIG_MOTIONS + APP_CONFIG_MACROS)
+// words in a pin bitset
+#define PIN_WORDS       BITSET_WORDS(ALL_PINS)
+// definition slots, one per pin on layer 0, a shared set for other layers,
+// one per combo, one per motion and one per running macro referring its
+// current tap
+#define SLOTS           (APP_CONFIG_PINS + APP_CONFIG_LAYER_DEFS + APP_CONFIG_COMBOS + \
+                         APP_CONFIG_MOTIONS + APP_CONFIG_MACROS)
+#define COMBO_SLOT(c)   (APP_CONFIG_PINS + APP_CONFIG_LAYER_DEFS + (c))
+#define MOTION_SLOT(m)  (APP_CONFIG_PINS + APP_CONFIG_LAYER_DEFS + APP_CONFIG_COMBOS + (m))
+#define MACRO_SLOT(m)   (APP_CONFIG_PINS + APP_CONFIG_LAYER_DEFS + APP_CONFIG_COMBOS + \
+                         APP_CONFIG_MOTIONS + (m))
+// motion steps of all motions, one bit each in the motion matcher
+#define MOTION_BITS     32
+
+// a pin's definitions in the definition pool
+typedef struct {
+  u8_t offs;        // index of first definition in pool
+  u8_t len;         // number of definitions
+  u8_t tern_pin;    // ternary pin number, 0 if none
+  u8_t tern_splice; // number of definitions before ternary splice
+  u8_t macro_len;   // number of last definitions being a macro, 0 if none
+} pin_def;
+
+// layer select pin
+typedef struct {
+  u8_t pin;         // pin number, 0 if none
+  u8_t mode;        // app_layer_mode
+} layer_sel;
+
+// pins of a combo
+typedef struct {
+  u32_t mask[PIN_WORDS];
+  u8_t pins;        // number of pins, 0 if free
+} combo_def;
+
+// a motion, steps as in def_config
+typedef struct {
+  u8_t steps[APP_CONFIG_MOTION_STEPS]; // 0 terminated if shorter, free if first is 0
+  u8_t step_ms;     // max time between steps
+  u8_t joystick;    // joystick of direction steps
+} motion_def;
+
+// a running macro
+typedef struct {
+  u8_t pin;         // pin running macro, one based, 0 if not running
+  u8_t pc;          // definition pool index of next entry
+  u8_t end;         // definition pool index after macro
+  bool cancel;      // stop when pin is released
+  bool tapping;     // tap pressed, released once reported
+  time wake;        // next entry not before this
+} macro_run;
+
+// a debounced pin edge
+typedef struct {
+  u32_t ts_us;      // time of sample, TIMER_get_us
+  u8_t pin;
+  bool active;
+} pin_event;
 
 typedef bool (* construct_report_f)(void *device_info, void *report);
 
@@ -56,12 +118,16 @@ typedef struct device_info_s {
   hid_id_type type;
   u8_t index;
   bool pending_change;    // if there are pending changes not sent over usb yet
-  bool timer_started;
-  task_timer timer;       // update poll timer
-  task *timer_task;       // update poll task
-  u16_t accelerator_1;    // current accelerator
-  u16_t accelerator_2;    // current accelerator secondary
+  wheel_timer timer;      // update poll timer
+  wheel_timer idle_timer; // repeats unchanged report at host idle rate
+  u32_t accelerator_1;    // current accelerator, Q16.16 of 0-VEL_ACC_MAX
+  u32_t accelerator_2;    // current accelerator secondary
+  u32_t acc_us;           // time accelerators were last ramped
   bool report_filter;     // if same device report should be filtered away or not
+  bool report_moves;      // report has relative movement, sent even if same
+  bool latch;             // if presses are kept until in a transmitted report
+  u32_t latched_presses;  // presses released before being transmitted
+  u32_t edge_us;          // pin edge of change in report, 0 if report is not from an edge
   void *report;          // device dependent report
   void *report_prev;     // device dependent report, previous
   u32_t report_len;       // length of device report
@@ -70,24 +136,151 @@ typedef struct device_info_s {
 
 static struct {
   // config
-  def_config pin_config[APP_CONFIG_PINS];
+  // definition slots, layer 0 definitions of each pin followed by
+  // definitions of pins on other layers
+  pin_def pin_defs[SLOTS];
+  u8_t slot_pin[APP_CONFIG_LAYER_DEFS];   // pin of layer slot
+  u8_t slot_layer[APP_CONFIG_LAYER_DEFS]; // layer of layer slot, 0 if free
+  // action table, definition slot per layer and pin
+  u8_t layer_map[APP_CONFIG_LAYERS][APP_CONFIG_PINS];
+  layer_sel layer_sels[APP_CONFIG_LAYERS];
+  hid_id def_pool[APP_CONFIG_DEF_POOL]; // definitions of all slots, packed
+  u16_t def_pool_used;
   u8_t debounce_valid_cycles;
   time mouse_delta;
   time joystick_delta;
   u16_t acc_pos_speed;
   u16_t acc_wheel_speed;
   u16_t acc_joystick_speed;
+  vel_curve acc_curves[_ACC_CNT];
+  u16_t acc_luts[_ACC_CNT][VEL_LUT_LEN]; // acc_curves tabulated
+  u8_t min_hold_ms;
+  u8_t latch_mask;
+  bool tern_release_first;
+  u8_t socd_mode[2];                     // app_socd_mode per joystick
+  u8_t socd_4way;                        // bit per joystick restricted to 4 ways
+  // reverse ternary index, pins referencing pin p as ternary pin are
+  // tern_deps[tern_dep_offs[p]] .. tern_deps[tern_dep_offs[p+1]-1]
+  u8_t tern_deps[SLOTS];
+  u8_t tern_dep_offs[ALL_PINS + 1];
+  combo_def combos[APP_CONFIG_COMBOS];
+  u8_t combo_order[APP_CONFIG_COMBOS];   // defined combos, most pins first
+  u8_t combo_cnt;
+  u32_t combo_pins[PIN_WORDS];           // pins part of any combo
+  u8_t combo_window_ms;
+  u8_t turbo_duty;                       // percent of turbo period pressed
+  u8_t usb_personality;                  // usb_personality at next boot
+  bool usb_latency;                      // latency interface at next boot
+  u32_t turbo_pins[PIN_WORDS];           // pins having turbo definitions
+  u64_t turbo_rates;                     // bit per turbo rate in Hz in use
+  // motions, compiled to a bit parallel matcher having one bit per step
+  motion_def motions[APP_CONFIG_MOTIONS];
+  u8_t motion_cnt;
+  u32_t motion_bits[APP_CONFIG_MOTIONS]; // steps of motion
+  u32_t motion_first;                    // first steps of motions
+  u32_t motion_last;                     // last steps of motions
+  u32_t motion_dir_bits[2][10];          // steps per joystick and numpad direction
+  u32_t motion_pin_bits[APP_CONFIG_PINS]; // steps pressing pin
+  u8_t motion_pin_dirs[APP_CONFIG_PINS]; // bit per joystick * 4 + -x, +x, -y, +y of pin
 
   // gpio states
   volatile bool dirty_gpio;
   volatile bool lock_gpio_sampling;
-  pin_debounce irq_debounce_map[APP_CONFIG_PINS];
-  volatile bool irq_cur_pin_active[APP_CONFIG_PINS];
+  u32_t irq_raw[PIN_WORDS];              // last sample, set = active
+  u32_t irq_unsettled[PIN_WORDS];        // pins still counting debounce cycles
+  u8_t irq_same_state[APP_CONFIG_PINS];  // debounce cycle counters
+  volatile u32_t irq_cur_active[PIN_WORDS]; // debounced pin states
+  u32_t sample_cycles_last;
+  u32_t sample_cycles_max;
+
+  // pin edge events, single producer APP_timer, single consumer app_pins_update
+  pin_event evq[APP_CONFIG_EVENT_QUEUE];
+  volatile u16_t evq_head;               // only written by producer
+  volatile u16_t evq_tail;               // only written by consumer
+  volatile bool evq_resync;              // events lost, resync from levels
+  volatile u32_t evq_overflows;
+  volatile u16_t evq_max_fill;
+  u32_t pins_unreported[PIN_WORDS];      // presses not in any report yet
+  u32_t pins_held[PIN_WORDS];            // reported presses held for min_hold_ms
+  u32_t held_since_us;
+  wheel_timer hold_timer;
+
+  // layer states
+  u8_t layer;                            // current layer
+  u8_t layers_held;                      // bitmask, momentary layers held
+  u8_t layers_toggled;                   // bitmask, toggled layers
+  u8_t layers_oneshot;                   // bitmask, one-shot layers armed
+  u8_t pin_layer[ALL_PINS];              // layer active pin was pressed on
+
+  // combo states
+  u32_t pins_chord[PIN_WORDS];           // combo pin presses within chord window
+  u32_t chord_start_us;                  // time of first press in chord window
+  u32_t pins_in_combo[PIN_WORDS];        // presses taken by an active combo
+
+  // motion states
+  u32_t motion_state;                    // steps matched
+  u32_t motion_us[APP_CONFIG_MOTIONS];   // time of last step matched
+  u8_t motion_held[2 * 4];               // pins held per joystick direction
+  u8_t motion_dir[2];                    // numpad direction per joystick
+  wheel_timer motion_timer;
+
+  // macro states
+  macro_run macros[APP_CONFIG_MACROS];
+  wheel_timer macro_timer;
+
+  // mouse movement, positions advance from time of last sent report, those
+  // after a constructed report are kept until it is sent
+  vel_axis mouse_axis[3];                // x, y, wheel
+  vel_axis mouse_axis_next[3];
+  u32_t mouse_us;
+  u32_t mouse_next_us;
+  bool mouse_idle;                       // no movement in last sent report
+  bool mouse_idle_next;
+  u8_t mouse_moving;                     // bit 0 position, bit 1 wheel velocity in report
+  // while moving, mouse reports are paced by usb start of frames
+  volatile bool mouse_sof_posted;
+  volatile bool usb_enum_logged;
+  app_mouse_stats mouse_stats;
+  u32_t mouse_stats_us;                  // time active is counted from
+  bool mouse_stats_active;
+
+  // usb suspend states
+  volatile bool suspend_pending;         // suspend signalled, not handled yet
+  bool suspended;                        // stopping from idle loop
+  bool suspend_wakeup;                   // host allows remote wakeup
+  u32_t suspend_ms;
+  volatile u16_t wake_lines;             // exti lines triggered while suspended
+  u16_t wake_armed;                      // exti lines armed
+  u8_t wake_line_pin[16];                // gpio pin of armed exti line
+  bool wake_report_pending;              // no report since wakeup yet
+  u32_t wake_us;
+  wheel_timer wake_timer;
+  app_suspend_stats suspend_stats;
+
+  // turbo states, phases of all rates follow one shared millisecond count
+  u16_t turbo_ms;                        // 0-999
+  u64_t turbo_on;                        // bit per turbo rate in Hz in on phase
+  wheel_timer turbo_timer;
+
+  // timer wheel ticks, counted by APP_timer and run in task context
+  volatile u32_t wheel_ticks;
+  u32_t wheel_ticked;
+  volatile bool wheel_posted;
+  time wheel_irq_ms;
 
   // app pin states
-  app_pin_state pin_state[APP_CONFIG_PINS];
-  app_pin_state pin_state_prev[APP_CONFIG_PINS];
-  u8_t pin_mark[APP_CONFIG_PINS];
+  u32_t pins_active[PIN_WORDS];          // active pins
+  u32_t pins_tern[PIN_WORDS];            // active pins using ternary definitions
+  u32_t pins_retrigger[PIN_WORDS];       // pins released for a ternary swap
+  u32_t pins_active_prev[PIN_WORDS];
+  u32_t pin_press_us[ALL_PINS];          // time of last press edge of pin
+  u32_t edge_us;                         // time of pin edge being applied
+  u32_t dev_pins[DEVICES][PIN_WORDS];    // pins having definitions for device
+  u32_t report_pins[PIN_WORDS];          // pins of report being constructed
+  u32_t latched[DEVICES][PIN_WORDS];     // presses not in a transmitted report yet
+  u32_t latched_report[DEVICES][PIN_WORDS]; // latched pins in constructed report
+  u32_t latched_sent[DEVICES][PIN_WORDS];   // latched pins in report being transmitted
+  u32_t latched_staged[DEVICES][PIN_WORDS]; // latched pins in report staged behind it
 
   // fs
   bool fs_mounted;
@@ -104,6 +297,48 @@ static struct {
   usb_joystick_report joystick_report2_prev;
 } app;
 
+// returns pin owning definition slot, or -1 for a free slot
+static int app_slot_pin(int slot) {
+  if (slot < APP_CONFIG_PINS) return slot;
+  if (slot >= MACRO_SLOT(0)) return -1;
+  if (slot >= MOTION_SLOT(0)) {
+    slot -= MOTION_SLOT(0);
+    return app.motions[slot].steps[0] ? MOTION_PIN(slot) : -1;
+  }
+  if (slot >= COMBO_SLOT(0)) {
+    slot -= COMBO_SLOT(0);
+    return app.combos[slot].pins ? COMBO_PIN(slot) : -1;
+  }
+  slot -= APP_CONFIG_PINS;
+  return app.slot_layer[slot] ? app.slot_pin[slot] : -1;
+}
+
+// definitions of pin, on layer it was pressed on
+static inline const pin_def *app_pin_def(int pin) {
+  if (pin >= MACRO_PIN(0)) {
+    return &app.pin_defs[MACRO_SLOT(pin - MACRO_PIN(0))];
+  }
+  if (pin >= MOTION_PIN(0)) {
+    return &app.pin_defs[MOTION_SLOT(pin - MOTION_PIN(0))];
+  }
+  if (pin >= COMBO_PIN(0)) {
+    return &app.pin_defs[COMBO_SLOT(pin - COMBO_PIN(0))];
+  }
+  return &app.pin_defs[app.layer_map[app.pin_layer[pin]][pin]];
+}
+
+// current layer is highest held, toggled or armed layer
+static void app_layer_resolve(void) {
+  u8_t layers = app.layers_held | app.layers_toggled | app.layers_oneshot;
+  app.layer = layers ? 31 - __builtin_clz(layers) : 0;
+}
+
+// numpad direction of joystick from held directions, opposite ones cancel
+static inline u8_t app_motion_dir(int j) {
+  const u8_t *held = &app.motion_held[j * 4];
+  return 5 + (held[1] > 0) - (held[0] > 0) + 3 * ((held[2] > 0) - (held[3] > 0));
+}
+
 
 #ifndef CONFIG_ANNOYATRON
 
@@ -120,19 +355,67 @@ static int arc_memcmp(void *a, void *b, u32_t len) {
 
 ///////////////////////////////// USB HID REPORT CONSTRUCTS
 
+// definition is a turbo in its off phase
+static inline bool app_turbo_off(hid_id id) {
+  u8_t hz = def_turbo_hz(id);
+  return hz && (app.turbo_on & (1ULL << hz)) == 0;
+}
+
+// returns definition pool range of a pin depending on ternary or not
 static void app_get_def_boundary(int pin, int *def_start, int *def_end) {
-  if (app.pin_config[pin].tern_pin) {
-    if (app.pin_state[pin] == PIN_ACTIVE_TERN) {
-      *def_start = app.pin_config[pin].tern_splice;
-      *def_end = APP_CONFIG_DEFS_PER_PIN;
+  const pin_def *p = app_pin_def(pin);
+  if (p->tern_pin) {
+    if (bitset_get(app.pins_tern, pin)) {
+      *def_start = p->offs + p->tern_splice;
+      *def_end = p->offs + p->len;
     } else {
-      *def_start = 0;
-      *def_end = app.pin_config[pin].tern_splice;
+      *def_start = p->offs;
+      *def_end = p->offs + p->tern_splice;
     }
   } else {
-    *def_start = 0;
-    *def_end = APP_CONFIG_DEFS_PER_PIN;
+    *def_start = p->offs;
+    *def_end = p->offs + p->len - p->macro_len;
+  }
+}
+
+// boot protocol keyboard report, modifiers and at most USB_KB_BOOT_KEYS keys,
+// all keys KC_ROLL_OVER if more are pressed
+static bool kb_construct_boot_report(usb_kb_report *r) {
+  int pin;
+  int keys = 0;
+  bool active = FALSE;
+
+  // rest of report stays zero for comparing with previous report
+  memset(r, 0, sizeof(usb_kb_report));
+
+  for (pin = bitset_next(app.report_pins, app.dev_pins[DEV_KB], PIN_WORDS, 0);
+      pin >= 0;
+      pin = bitset_next(app.report_pins, app.dev_pins[DEV_KB], PIN_WORDS, pin + 1)) {
+    int def_start, def_end;
+    app_get_def_boundary(pin, &def_start, &def_end);
+    int def;
+    for (def = def_start; def < def_end; def++) {
+      if (app.def_pool[def].type != HID_ID_TYPE_KEYBOARD) continue;
+      active = TRUE;
+      if (app_turbo_off(app.def_pool[def])) continue;
+      enum kb_hid_code kb_code = app.def_pool[def].kb.kb_code;
+      if (kb_code >= MOD_LCTRL) {
+        r->modifiers |= MOD_BIT(kb_code);
+      } else if (keys <= USB_KB_BOOT_KEYS) {
+        int i;
+        for (i = 0; i < keys && r->keymap[i] != kb_code; i++);
+        if (i < keys) continue;
+        if (keys == USB_KB_BOOT_KEYS) {
+          // overflow, only modifiers are looked for from here
+          memset(r->keymap, KC_ROLL_OVER, USB_KB_BOOT_KEYS);
+        } else {
+          r->keymap[keys] = kb_code;
+        }
+        keys++;
+      }
+    }
   }
+  return active;
 }
 
 static bool kb_construct_report(void *d_v, void *r_v) {
@@ -141,14 +424,17 @@ static bool kb_construct_report(void *d_v, void *r_v) {
   int pin;
   int report_ix = 0;
 
+  if (USB_ARC_boot_protocol(DEV_KB)) {
+    return kb_construct_boot_report(r);
+  }
+
   memset(r, 0, sizeof(usb_kb_report));
   bool active = FALSE;
 
-  // for each pin..
-  for (pin = 0; pin < APP_CONFIG_PINS && report_ix < USB_KB_REPORT_KEYMAP_SIZE; pin++) {
-    // .. which has keyboard tag and is not inactive ..
-    if ((app.pin_mark[pin] & PIN_MARK_KB)==0 || app.pin_state[pin] == PIN_INACTIVE) continue;
-
+  // for each active pin having keyboard definitions..
+  for (pin = bitset_next(app.report_pins, app.dev_pins[DEV_KB], PIN_WORDS, 0);
+      pin >= 0 && report_ix < USB_KB_REPORT_KEYMAP_SIZE;
+      pin = bitset_next(app.report_pins, app.dev_pins[DEV_KB], PIN_WORDS, pin + 1)) {
     // .. find out definitions group depending on ternary or not ..
     int def_start, def_end;
     app_get_def_boundary(pin, &def_start, &def_end);
@@ -159,9 +445,10 @@ static bool kb_construct_report(void *d_v, void *r_v) {
     for (def = def_start; def < def_end; def++) {
       // .. find keyboard definitions ..
       if (report_ix >= USB_KB_REPORT_KEYMAP_SIZE) break;
-      if (app.pin_config[pin].id[def].type == HID_ID_TYPE_KEYBOARD) {
+      if (app.def_pool[def].type == HID_ID_TYPE_KEYBOARD) {
         active = TRUE;
-        enum kb_hid_code kb_code = app.pin_config[pin].id[def].kb.kb_code;
+        if (app_turbo_off(app.def_pool[def])) continue;
+        enum kb_hid_code kb_code = app.def_pool[def].kb.kb_code;
         if (kb_code >= MOD_LCTRL) {
           // shift, ctrl, alt or gui
           r->modifiers |= MOD_BIT(kb_code);
@@ -187,51 +474,46 @@ static bool mouse_construct_report(void *d_v, void *r_v) {
   usb_mouse_report *r = (usb_mouse_report *)r_v;
   device_info *d = (device_info *)d_v;
   bool active = FALSE;
-  s32_t mdx = 0;
-  s32_t mdy = 0;
-  s32_t mdw = 0;
+  // velocity per axis x, y, wheel of first definition moving it
+  s32_t vel[3] = {0, 0, 0};
   u8_t butt_mask = 0;
-  int pin;
+  int pin, i;
+  // boot protocol report has no wheel
+  bool wheel = !USB_ARC_boot_protocol(DEV_MOUSE);
 
   memset(r, 0, sizeof(usb_mouse_report));
 
-  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
-    if ((app.pin_mark[pin] & PIN_MARK_MOUSE)==0 || app.pin_state[pin] == PIN_INACTIVE)
-      continue;
+  for (pin = bitset_next(app.report_pins, app.dev_pins[DEV_MOUSE], PIN_WORDS, 0);
+      pin >= 0;
+      pin = bitset_next(app.report_pins, app.dev_pins[DEV_MOUSE], PIN_WORDS, pin + 1)) {
     int def_start, def_end;
     app_get_def_boundary(pin, &def_start, &def_end);
 
     int def;
     for (def = def_start; def < def_end; def++) {
-      if (app.pin_config[pin].id[def].type == HID_ID_TYPE_MOUSE) {
+      if (app.def_pool[def].type == HID_ID_TYPE_MOUSE) {
         active = TRUE;
-        bool sign = app.pin_config[pin].id[def].mouse.mouse_sign;
-        u8_t data = app.pin_config[pin].id[def].mouse.mouse_data;
-
-        u8_t displacement;
-        if (app.pin_config[pin].id[def].mouse.mouse_acc) {
-          u16_t acc = app.pin_config[pin].id[def].mouse.mouse_code == MOUSE_WHEEL ?
-              d->accelerator_2 : d->accelerator_1;
-          if (acc + data < 0xfff) {
-            displacement = 1+(u8_t)(((u32_t)data * (u32_t)acc) >> 12);
-            displacement = MIN(displacement, data);
-          } else {
-            displacement = data;
-          }
-        } else {
-          displacement = data;
+        if (app_turbo_off(app.def_pool[def])) continue;
+        bool sign = app.def_pool[def].mouse.mouse_sign;
+        u8_t data = app.def_pool[def].mouse.mouse_data;
+        enum mouse_code code = app.def_pool[def].mouse.mouse_code;
+        const u16_t *lut = NULL;
+        if (app.def_pool[def].mouse.mouse_acc) {
+          lut = app.acc_luts[code == MOUSE_WHEEL ? ACC_MOUSE_WHEEL :
+                             code == MOUSE_Y ? ACC_MOUSE_Y : ACC_MOUSE_X];
         }
-        if (displacement == 0) displacement = 1;
+        s32_t v = VEL_target(data, lut,
+            code == MOUSE_WHEEL ? d->accelerator_2 : d->accelerator_1);
 
-        switch (app.pin_config[pin].id[def].mouse.mouse_code) {
+        switch (code) {
         case MOUSE_X:
-          if (mdx == 0) mdx += sign ? -displacement : displacement;
+          if (vel[0] == 0) vel[0] = sign ? -v : v;
           break;
         case MOUSE_Y:
-          if (mdy == 0) mdy += sign ? -displacement : displacement;
+          if (vel[1] == 0) vel[1] = sign ? -v : v;
           break;
         case MOUSE_WHEEL:
-          if (mdw == 0) mdw += sign ? -displacement : displacement;
+          if (wheel && vel[2] == 0) vel[2] = sign ? -v : v;
           break;
         case MOUSE_BUTTON1:
           butt_mask |= (1<<2);
@@ -248,14 +530,69 @@ static bool mouse_construct_report(void *d_v, void *r_v) {
     }
   }
 
-  r->dx = mdx < 0 ? MAX(-127, mdx) : MIN(127, mdx);
-  r->dy = mdy < 0 ? MAX(-127, mdy) : MIN(127, mdy);
-  r->wheel = mdw < 0 ? MAX(-127, mdw) : MIN(127, mdw);
+  // move axes from last sent report, a first movement moves one period
+  u32_t now = TIMER_get_us();
+  u32_t period_us = app.mouse_delta * 1000;
+  u32_t dt_us = app.mouse_idle ? period_us : MIN(now - app.mouse_us, 4 * period_us);
+  s8_t counts[3];
+  for (i = 0; i < 3; i++) {
+    app.mouse_axis_next[i] = app.mouse_axis[i];
+    counts[i] = VEL_step(&app.mouse_axis_next[i], vel[i], dt_us, period_us);
+  }
+  app.mouse_next_us = now;
+  if (counts[0] == 0 && counts[1] == 0 && counts[2] == 0) {
+    // nothing to report, keep remainders without waiting for a sent report
+    memcpy(app.mouse_axis, app.mouse_axis_next, sizeof(app.mouse_axis));
+    app.mouse_us = now;
+  }
+  d->report_moves = counts[0] != 0 || counts[1] != 0 || counts[2] != 0;
+
+  // count time active, holding buttons only or moving, for report rates
+  if (app.mouse_stats_active) {
+    u32_t ms = (now - app.mouse_stats_us) / 1000;
+    app.mouse_stats.ms[app.mouse_moving ? 1 : 0] += ms;
+    app.mouse_stats_us += ms * 1000;
+  } else {
+    app.mouse_stats_us = now;
+  }
+  app.mouse_stats_active = active;
+
+  app.mouse_moving = (vel[0] || vel[1] ? (1 << 0) : 0) | (vel[2] ? (1 << 1) : 0);
+  app.mouse_idle_next = app.mouse_moving == 0;
+  if (app.mouse_idle_next) {
+    // nothing to keep from last sent report
+    memset(app.mouse_axis, 0, sizeof(app.mouse_axis));
+    app.mouse_idle = TRUE;
+  }
+
+  r->dx = counts[0];
+  r->dy = counts[1];
+  r->wheel = counts[2];
   r->modifiers = butt_mask;
 
   return active;
 }
 
+// Resolves opposite directions of an axis by press times, disp and us are
+// indexed negative, positive. Returns displacement and sets kept_us to press
+// time of kept direction.
+static s32_t app_socd_resolve(app_socd_mode mode, const s32_t *disp, const u32_t *us, u32_t *kept_us) {
+  int kept;
+  if (disp[0] && disp[1]) {
+    if (mode == SOCD_NEUTRAL) return 0;
+    bool pos_later = (s32_t)(us[1] - us[0]) > 0;
+    kept = (mode == SOCD_LAST) == pos_later ? 1 : 0;
+  } else if (disp[0]) {
+    kept = 0;
+  } else if (disp[1]) {
+    kept = 1;
+  } else {
+    return 0;
+  }
+  *kept_us = us[kept];
+  return kept ? disp[1] : -disp[0];
+}
+
 static bool joystick_construct_report(void *d_v, void *r_v) {
   usb_joystick_report *r = (usb_joystick_report *)r_v;
   device_info *d = (device_info *)d_v;
@@ -263,52 +600,57 @@ static bool joystick_construct_report(void *d_v, void *r_v) {
   s32_t dx = 0;
   s32_t dy = 0;
   u16_t butt_mask = 0;
+  // per direction -x, +x, -y, +y: displacement of first definition, and
+  // last press, or first press for SOCD_FIRST, of pins in that direction
+  s32_t dir_disp[4] = {0, 0, 0, 0};
+  u32_t dir_us[4];
+  app_socd_mode socd = app.socd_mode[d->index];
 
   memset(r, 0, sizeof(usb_joystick_report));
 
   int pin;
-  u8_t mark = d->index == JOYSTICK1 ? PIN_MARK_JOY1 : PIN_MARK_JOY2;
+  const u32_t *dev_pins = app.dev_pins[d->index == JOYSTICK1 ? DEV_JOY1 : DEV_JOY2];
 
-  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
-    if ((app.pin_mark[pin] & mark)==0 || app.pin_state[pin] == PIN_INACTIVE)
-      continue;
+  for (pin = bitset_next(app.report_pins, dev_pins, PIN_WORDS, 0);
+      pin >= 0;
+      pin = bitset_next(app.report_pins, dev_pins, PIN_WORDS, pin + 1)) {
     int def_start, def_end;
     app_get_def_boundary(pin, &def_start, &def_end);
 
     int def;
     for (def = def_start; def < def_end; def++) {
-      if (app.pin_config[pin].id[def].type == HID_ID_TYPE_JOYSTICK) {
-        u8_t j_def_ix = app.pin_config[pin].id[def].joy.joystick_code >= _JOYSTICK_IX_2 ? JOYSTICK2 : JOYSTICK1;
+      if (app.def_pool[def].type == HID_ID_TYPE_JOYSTICK) {
+        u8_t j_def_ix = app.def_pool[def].joy.joystick_code >= _JOYSTICK_IX_2 ? JOYSTICK2 : JOYSTICK1;
         if (j_def_ix != d->index) continue;
 
         active = TRUE;
-        enum joystick_code mod_jcode =  app.pin_config[pin].id[def].joy.joystick_code -
+        if (app_turbo_off(app.def_pool[def])) continue;
+        enum joystick_code mod_jcode =  app.def_pool[def].joy.joystick_code -
             (j_def_ix == JOYSTICK2 ? _JOYSTICK_IX_2 : _JOYSTICK_IX_1);
 
-        bool sign = app.pin_config[pin].id[def].joy.joystick_sign;
-        u8_t data = app.pin_config[pin].id[def].joy.joystick_data;
+        bool sign = app.def_pool[def].joy.joystick_sign;
+        u8_t data = app.def_pool[def].joy.joystick_data;
 
-        u8_t displacement;
-        if (app.pin_config[pin].id[def].joy.joystick_acc) {
-          u16_t acc = d->accelerator_1;
-          if (acc + data < 0xfff) {
-            displacement = 1+(u8_t)(((u32_t)data * (u32_t)acc) >> 12);
-            displacement = MIN(displacement, data);
-          } else {
-            displacement = data;
-          }
-        } else {
-          displacement = data;
-        }
-        if (displacement == 0) displacement = 1;
+        // joystick axes are absolute, accelerator scales deflection
+        app_acc acc = (d->index == JOYSTICK2 ? ACC_JOY2_X : ACC_JOY1_X) +
+            (mod_jcode == JOYSTICK1_Y ? 1 : 0);
+        u8_t displacement = VEL_target(data,
+            app.def_pool[def].joy.joystick_acc ? app.acc_luts[acc] : NULL,
+            d->accelerator_1) / VEL_ONE;
 
         switch (mod_jcode) {
         case JOYSTICK1_X:
-          if (dx == 0) dx += sign ? -displacement : displacement;
-          break;
-        case JOYSTICK1_Y:
-          if (dy == 0) dy += sign ? -displacement : displacement;
+        case JOYSTICK1_Y: {
+          int dir = (mod_jcode - JOYSTICK1_X) * 2 + (sign ? 0 : 1);
+          u32_t us = app.pin_press_us[pin];
+          if (dir_disp[dir] == 0) {
+            dir_disp[dir] = displacement;
+            dir_us[dir] = us;
+          } else if (socd == SOCD_FIRST ? (s32_t)(us - dir_us[dir]) < 0 : (s32_t)(us - dir_us[dir]) > 0) {
+            dir_us[dir] = us;
+          }
           break;
+        }
         case JOYSTICK1_BUTTON1:
         case JOYSTICK1_BUTTON2:
         case JOYSTICK1_BUTTON3:
@@ -331,6 +673,18 @@ static bool joystick_construct_report(void *d_v, void *r_v) {
     }
   }
 
+  u32_t x_us, y_us;
+  dx = app_socd_resolve(socd, &dir_disp[0], &dir_us[0], &x_us);
+  dy = app_socd_resolve(socd, &dir_disp[2], &dir_us[2], &y_us);
+  if (dx && dy && (app.socd_4way & (1 << d->index))) {
+    // diagonal, keep direction pressed last
+    if ((s32_t)(x_us - y_us) > 0) {
+      dy = 0;
+    } else {
+      dx = 0;
+    }
+  }
+
   r->dx = dx < 0 ? MAX(-127, dx) : MIN(127, dx);
   r->dy = dy < 0 ? MAX(-127, dy) : MIN(127, dy);
 
@@ -342,6 +696,40 @@ static bool joystick_construct_report(void *d_v, void *r_v) {
 
 ///////////////////////////////// DEVICE STUFF
 
+// constructs device report from active pins and pins latched for device
+static bool device_construct_report(device_info *d) {
+  int dev = d - &app.devs[0];
+  int w;
+  for (w = 0; w < PIN_WORDS; w++) {
+    app.report_pins[w] = app.pins_active[w] | app.latched[dev][w];
+    app.latched_report[dev][w] = app.latched[dev][w];
+  }
+  return d->construct_report(d, d->report);
+}
+
+// starts application timer on wheel
+static void app_timer_start(wheel_timer *t, wheel_fn fn, void *arg_p, u32_t delay, u32_t recurrent) {
+  if (WHEEL_count() == 0) {
+    // ticks passed while wheel was idle are skipped
+    app.wheel_ticked = app.wheel_ticks;
+  }
+  WHEEL_start(t, fn, 0, arg_p, delay, recurrent);
+}
+
+static void app_device_timer_task(u32_t ignore, void *d_v);
+static void app_device_idle_task(u32_t ignore, void *d_v);
+
+// restarts idle period of device after a report, host idle rate 0 repeats
+// nothing
+static void device_start_idle_timer(device_info *d) {
+  u32_t idle_ms = USB_ARC_get_idle_ms(d - &app.devs[0]);
+  if (idle_ms) {
+    app_timer_start(&d->idle_timer, app_device_idle_task, d, idle_ms, 0);
+  } else {
+    WHEEL_stop(&d->idle_timer);
+  }
+}
+
 static void device_start_timer(device_info *d) {
   time tim_delta;
   switch (d->type) {
@@ -349,9 +737,8 @@ static void device_start_timer(device_info *d) {
   case HID_ID_TYPE_JOYSTICK: tim_delta = app.joystick_delta; break;
   default: tim_delta = 10; break;
   }
-  TASK_stop_timer(&d->timer);
-  TASK_start_timer(d->timer_task, &d->timer, 0, d, tim_delta, tim_delta, "tim");
-  d->timer_started = TRUE;
+  d->acc_us = TIMER_get_us();
+  app_timer_start(&d->timer, app_device_timer_task, d, tim_delta, tim_delta);
 }
 
 static bool device_can_send(device_info *d) {
@@ -374,6 +761,20 @@ static bool device_can_send(device_info *d) {
 }
 
 static void device_send_report(device_info *d) {
+  int dev = d - &app.devs[0];
+  // latched pins are released when the report is transmitted, which is
+  // after the report in flight if any
+  if (USB_ARC_tx_busy(dev)) {
+    memcpy(app.latched_staged[dev], app.latched_report[dev], sizeof(app.latched_staged[dev]));
+  } else {
+    memcpy(app.latched_sent[dev], app.latched_report[dev], sizeof(app.latched_sent[dev]));
+  }
+  // settled before handing over, a report not presented to host is done at
+  // once
+  d->pending_change = FALSE;
+  memcpy(d->report_prev, d->report, d->report_len);
+  USB_ARC_set_report_edge(dev, d->edge_us);
+  d->edge_us = 0;
   switch (d->type) {
   case HID_ID_TYPE_KEYBOARD:
     DBG(D_APP, D_DEBUG, "kb report\n");
@@ -385,6 +786,11 @@ static void device_send_report(device_info *d) {
         ((usb_mouse_report *)d->report)->dy,
         ((usb_mouse_report *)d->report)->wheel,
         ((usb_mouse_report *)d->report)->modifiers);
+    app.mouse_stats.reports[app.mouse_moving ? 1 : 0]++;
+    // movement in report is now reported
+    memcpy(app.mouse_axis, app.mouse_axis_next, sizeof(app.mouse_axis));
+    app.mouse_us = app.mouse_next_us;
+    app.mouse_idle = app.mouse_idle_next;
     USB_ARC_MOUSE_tx((usb_mouse_report *)d->report);
     break;
   case HID_ID_TYPE_JOYSTICK:
@@ -395,17 +801,28 @@ static void device_send_report(device_info *d) {
     ASSERT(FALSE);
     break;
   }
-  d->pending_change = FALSE;
-  memcpy(d->report_prev, d->report, d->report_len);
+  device_start_idle_timer(d);
 }
 
 static void device_check_report_dispatch(device_info *d, bool active) {
   bool can_send = device_can_send(d);
   if (d->report_filter) {
-    // relative reporting, do not send same report twice
-    if (arc_memcmp(d->report, d->report_prev, d->report_len) == 0) {
+    // do not send same report twice, unless it moves something again
+    if (!d->report_moves && arc_memcmp(d->report, d->report_prev, d->report_len) == 0) {
       // report same as previous, do not send
       d->pending_change = FALSE;
+      if (d->type == HID_ID_TYPE_MOUSE) app.mouse_stats.suppressed++;
+      // latched presses are already in previous report, unlatch them
+      int dev = d - &app.devs[0];
+      int w;
+      bool unlatched = FALSE;
+      for (w = 0; w < PIN_WORDS; w++) {
+        unlatched |= (app.latched_report[dev][w] & ~app.pins_active[w]) != 0;
+        app.latched[dev][w] &= ~app.latched_report[dev][w];
+      }
+      if (unlatched) {
+        device_check_report_dispatch(d, device_construct_report(d));
+      }
     } else {
       // report changed, send
       if (can_send) {
@@ -427,60 +844,462 @@ static void device_check_report_dispatch(device_info *d, bool active) {
   }
 }
 
+// device report transmitted, unlatch pins in it and send pending report or
+// report with unlatched releases
+static void device_report_done(device_info *d) {
+  int dev = d - &app.devs[0];
+  int w;
+  bool unlatched = FALSE;
+  if (app.wake_report_pending) {
+    // first report after a wakeup press
+    app.wake_report_pending = FALSE;
+    WHEEL_stop(&app.wake_timer);
+    app.suspend_stats.latency_us = TIMER_get_us() - app.wake_us;
+    app.suspend_stats.latency_us_max = MAX(app.suspend_stats.latency_us_max, app.suspend_stats.latency_us);
+  }
+  for (w = 0; w < PIN_WORDS; w++) {
+    unlatched |= (app.latched_sent[dev][w] & ~app.pins_active[w]) != 0;
+    app.latched[dev][w] &= ~app.latched_sent[dev][w];
+    // report staged behind it is in flight now
+    app.latched_sent[dev][w] = app.latched_staged[dev][w];
+    app.latched_staged[dev][w] = 0;
+  }
+  if (d->pending_change) {
+    device_send_report(d);
+  } else if (unlatched) {
+    bool active = device_construct_report(d);
+    device_check_report_dispatch(d, active);
+  }
+}
+
 ///////////////////////////////// PIN HANDLING
 
+static void app_pins_dirty_msg(u32_t ignore, void *ignore_p);
+static void app_macro_tick_msg(u32_t ignore, void *ignore_p);
+static void app_turbo_tick_msg(u32_t ignore, void *ignore_p);
+static void app_motion_tick_msg(u32_t ignore, void *ignore_p);
+static void app_add_dev_pins(int pin, int def_start, int def_end);
+#ifndef CONFIG_ANNOYATRON
+static u8_t app_used_devices(void);
+#endif
+static void app_motions_reset(void);
+
+// tapped pin can be released once reported and held for min_hold_ms
+static bool app_tap_done(int pin) {
+  return !bitset_get(app.pins_unreported, pin) && (!bitset_get(app.pins_held, pin) ||
+      TIMER_get_us() - app.held_since_us >= app.min_hold_ms * 1000);
+}
+
+// updates layer states on pin change
+static void app_layer_select(u8_t pin, bool active) {
+  bool select = FALSE;
+  int l;
+  for (l = 1; l < APP_CONFIG_LAYERS; l++) {
+    if (app.layer_sels[l].pin != pin + 1) continue;
+    select = TRUE;
+    switch (app.layer_sels[l].mode) {
+    case LAYER_HOLD:
+      if (active) app.layers_held |= (1 << l);
+      else        app.layers_held &= ~(1 << l);
+      break;
+    case LAYER_TOGGLE:
+      if (active) app.layers_toggled ^= (1 << l);
+      break;
+    case LAYER_ONESHOT:
+      if (active) app.layers_oneshot |= (1 << l);
+      break;
+    default:
+      break;
+    }
+  }
+  if (!select && active) {
+    // one-shot layers are used up by pressing any other pin
+    app.layers_oneshot = 0;
+  }
+  app_layer_resolve();
+}
+
+// starts macro of pressed pin, restarting it if already running
+static void app_macro_start(u8_t pin, const pin_def *p) {
+  int r;
+  int free_r = -1;
+  for (r = 0; r < APP_CONFIG_MACROS; r++) {
+    if (app.macros[r].pin == pin + 1) break;
+    if (free_r < 0 && app.macros[r].pin == 0) free_r = r;
+  }
+  if (r >= APP_CONFIG_MACROS) {
+    if (free_r < 0) {
+      DBG(D_APP, D_WARN, "pin %i no free macro runner\n", (pin+1));
+      return;
+    }
+    r = free_r;
+  }
+  macro_run *m = &app.macros[r];
+  int start = p->offs + p->len - p->macro_len;
+  // a tap in progress of a restarted macro is kept tapping, so the macro
+  // tick releases it once reported before stepping from the start again
+  m->pin = pin + 1;
+  m->pc = start + 1;
+  m->end = p->offs + p->len;
+  m->cancel = (MACRO_ARG(app.def_pool[start]) & MACRO_START_CANCEL) != 0;
+  m->wake = SYS_get_time_ms();
+  if (!WHEEL_is_running(&app.macro_timer)) {
+    app_timer_start(&app.macro_timer, app_macro_tick_msg, NULL, 1, 1);
+  }
+}
+
+// starts macros on press, stops cancellable macros on release
+static void app_macro_pin(u8_t pin, bool active) {
+  if (active) {
+    const pin_def *p = app_pin_def(pin);
+    if (p->macro_len) {
+      app_macro_start(pin, p);
+    }
+  } else {
+    int r;
+    for (r = 0; r < APP_CONFIG_MACROS; r++) {
+      macro_run *m = &app.macros[r];
+      if (m->pin == pin + 1 && m->cancel) {
+        // ends after releasing a tap in progress
+        m->pc = m->end;
+      }
+    }
+  }
+}
+
 static void app_trigger_pin(u8_t pin, bool active) {
   DBG(D_APP, D_DEBUG, "pin %i %s\n", (pin+1), active ? "!":"-");
+  bitset_put(app.pins_active, pin, active);
   if (active) {
-    if (app.pin_config[pin].tern_pin > 0) {
-      if (app.irq_cur_pin_active[app.pin_config[pin].tern_pin-1]) {
-        app.pin_state[pin] = PIN_ACTIVE_TERN;
-      } else {
-        app.pin_state[pin] = PIN_ACTIVE;
-      }
+    app.pin_press_us[pin] = app.edge_us;
+    // layer and ternary selection are kept on release, for latched presses
+    app.pin_layer[pin] = app.layer;
+    const pin_def *p = app_pin_def(pin);
+    bitset_put(app.pins_tern, pin, p->tern_pin > 0 &&
+        bitset_get(app.pins_active, p->tern_pin-1));
+  } else {
+    bitset_clr(app.pins_retrigger, pin);
+  }
+  if (pin < MACRO_PIN(0)) {
+    app_layer_select(pin, active);
+    app_macro_pin(pin, active);
+  }
+  if (active && !WHEEL_is_running(&app.turbo_timer) && bitset_get(app.turbo_pins, pin)) {
+    // first turbo press starts all rates in on phase
+    app.turbo_ms = 0;
+    app.turbo_on = app.turbo_duty ? app.turbo_rates : 0;
+    app_timer_start(&app.turbo_timer, app_turbo_tick_msg, NULL, 1, 1);
+  }
+  // swap definitions of held pins using this pin as ternary pin
+  int i;
+  for (i = app.tern_dep_offs[pin]; i < app.tern_dep_offs[pin+1]; i++) {
+    u8_t dep = app.tern_deps[i];
+    if (!bitset_get(app.pins_active, dep) || bitset_get(app.pins_tern, dep) == active ||
+        app_pin_def(dep)->tern_pin != pin + 1) {
+      continue;
+    }
+    DBG(D_APP, D_DEBUG, "pin %i ternary %s\n", (dep+1), active ? "!":"-");
+    if (app.tern_release_first) {
+      // release now, pressed again with new definitions on next update
+      bitset_clr(app.pins_active, dep);
+      bitset_set(app.pins_retrigger, dep);
     } else {
-      app.pin_state[pin] = PIN_ACTIVE;
+      bitset_put(app.pins_tern, dep, active);
+    }
+  }
+  int dev;
+  for (dev = 0; dev < DEVICES; dev++) {
+    if (!app.devs[dev].latch || !bitset_get(app.dev_pins[dev], pin)) continue;
+    if (active) {
+      bitset_set(app.latched[dev], pin);
+    } else if (bitset_get(app.latched[dev], pin)) {
+      app.devs[dev].latched_presses++;
+    }
+  }
+}
+
+// Matches presses in chord window against combos, most pins first. Returns
+// combo having all its pins pressed, or -1. If more is given, it is set if a
+// combo having more pins can still be completed by further presses. Costs a
+// few word operations per combo, whatever the number of pins.
+static int app_chord_match(bool *more) {
+  int i, w;
+  if (more) *more = FALSE;
+  for (i = 0; i < app.combo_cnt; i++) {
+    int c = app.combo_order[i];
+    const u32_t *mask = app.combos[c].mask;
+    u32_t missing = 0, other = 0, taken = 0;
+    for (w = 0; w < PIN_WORDS; w++) {
+      missing |= mask[w] & ~app.pins_chord[w];
+      other |= app.pins_chord[w] & ~mask[w];
+      taken |= mask[w] & (app.pins_active[w] | app.pins_in_combo[w]);
+    }
+    if (missing == 0) {
+      // combos having more pins come first, so more is already known
+      return c;
+    }
+    if (more && other == 0 && taken == 0) {
+      *more = TRUE;
+    }
+  }
+  return -1;
+}
+
+// Ends chord window, triggering given combo and taking its pins. Presses in
+// window not part of combo are triggered as single presses.
+static void app_chord_resolve(int c) {
+  int pin, w;
+  if (c >= 0) {
+    DBG(D_APP, D_DEBUG, "combo %i !\n", c);
+    for (w = 0; w < PIN_WORDS; w++) {
+      app.pins_chord[w] &= ~app.combos[c].mask[w];
+      app.pins_in_combo[w] |= app.combos[c].mask[w];
+    }
+    app_trigger_pin(COMBO_PIN(c), TRUE);
+    bitset_set(app.pins_unreported, COMBO_PIN(c));
+  }
+  for (pin = bitset_next(app.pins_chord, NULL, PIN_WORDS, 0);
+      pin >= 0;
+      pin = bitset_next(app.pins_chord, NULL, PIN_WORDS, pin + 1)) {
+    app_trigger_pin(pin, TRUE);
+    bitset_set(app.pins_unreported, pin);
+  }
+  memset(app.pins_chord, 0, sizeof(app.pins_chord));
+}
+
+// Handles pin edge with regard to combos. Presses of combo pins wait in the
+// chord window until a combo is complete or cannot be completed anymore.
+// Releasing a pin of an active combo releases the combo. Returns FALSE if the
+// edge is to be handled as a normal pin edge, or if it must be deferred in
+// which case defer is set.
+static bool app_combo_event(const pin_event *e, bool *defer) {
+  int c;
+  *defer = FALSE;
+  if (bitset_any(app.pins_chord, PIN_WORDS) &&
+      (!e->active || !bitset_get(app.combo_pins, e->pin) ||
+       e->ts_us - app.chord_start_us >= app.combo_window_ms * 1000)) {
+    // release, press of other pin or window timeout ends chord window
+    app_chord_resolve(app_chord_match(NULL));
+  }
+  if (e->active) {
+    if (!bitset_get(app.combo_pins, e->pin)) return FALSE;
+    if (!bitset_any(app.pins_chord, PIN_WORDS)) {
+      app.chord_start_us = e->ts_us;
+    }
+    bitset_set(app.pins_chord, e->pin);
+    bool more;
+    c = app_chord_match(&more);
+    if (!more) {
+      app_chord_resolve(c);
+    }
+    return TRUE;
+  }
+  if (!bitset_get(app.pins_in_combo, e->pin)) return FALSE;
+  // release active combos having this pin, once reported
+  for (c = 0; c < APP_CONFIG_COMBOS; c++) {
+    if (bitset_get(app.pins_active, COMBO_PIN(c)) && bitset_get(app.combos[c].mask, e->pin) &&
+        (bitset_get(app.pins_unreported, COMBO_PIN(c)) || bitset_get(app.pins_held, COMBO_PIN(c)))) {
+      *defer = TRUE;
+      return FALSE;
+    }
+  }
+  for (c = 0; c < APP_CONFIG_COMBOS; c++) {
+    if (bitset_get(app.pins_active, COMBO_PIN(c)) && bitset_get(app.combos[c].mask, e->pin)) {
+      DBG(D_APP, D_DEBUG, "combo %i -\n", c);
+      app_trigger_pin(COMBO_PIN(c), FALSE);
+    }
+  }
+  bitset_clr(app.pins_in_combo, e->pin);
+  return TRUE;
+}
+
+// drops combo states, presses in chord window are triggered as single presses
+// and active combos are released
+static void app_combos_reset(void) {
+  app_chord_resolve(-1);
+  int c;
+  for (c = 0; c < APP_CONFIG_COMBOS; c++) {
+    if (bitset_get(app.pins_active, COMBO_PIN(c))) {
+      app_trigger_pin(COMBO_PIN(c), FALSE);
     }
-  } else {
-    app.pin_state[pin] = PIN_INACTIVE;
   }
+  memset(app.pins_in_combo, 0, sizeof(app.pins_in_combo));
+}
+
+// taps motion pin, released by motion tick once reported
+static void app_motion_trigger(int m) {
+  int pin = MOTION_PIN(m);
+  DBG(D_APP, D_DEBUG, "motion %i !\n", m);
+  if (bitset_get(app.pins_active, pin)) return;
+  app_trigger_pin(pin, TRUE);
+  bitset_set(app.pins_unreported, pin);
+  if (!WHEEL_is_running(&app.motion_timer)) {
+    app_timer_start(&app.motion_timer, app_motion_tick_msg, NULL, 1, 1);
+  }
+}
+
+// Feeds debounced pin edge to motion matcher. A direction change of a
+// joystick or a press of a pin matches the steps of it following a matched
+// step, or starting a motion, as in shift-and. Other input in between is
+// ignored, so a motion needs its steps in order, each within step_ms of the
+// previous. Costs a few word operations per edge, plus one check per motion
+// when advancing.
+static void app_motion_event(const pin_event *e) {
+  if (app.motion_cnt == 0) return;
+  u32_t input = e->active ? app.motion_pin_bits[e->pin] : 0;
+  u8_t dirs = app.motion_pin_dirs[e->pin];
+  int j, m;
+  for (j = 0; j < 2; j++) {
+    u8_t joy_dirs = (dirs >> (j * 4)) & 0xf;
+    if (joy_dirs == 0) continue;
+    while (joy_dirs) {
+      u8_t *held = &app.motion_held[j * 4 + __builtin_ctz(joy_dirs)];
+      if (e->active) (*held)++;
+      else if (*held) (*held)--;
+      joy_dirs &= joy_dirs - 1;
+    }
+    u8_t dir = app_motion_dir(j);
+    if (dir != app.motion_dir[j]) {
+      app.motion_dir[j] = dir;
+      input |= app.motion_dir_bits[j][dir];
+    }
+  }
+  u32_t state = app.motion_state;
+  if ((((state << 1) | app.motion_first) & input) == 0) return;
+  // motions not advanced within their step time start over
+  for (m = 0; state && m < APP_CONFIG_MOTIONS; m++) {
+    if ((state & app.motion_bits[m]) &&
+        e->ts_us - app.motion_us[m] > app.motions[m].step_ms * 1000) {
+      state &= ~app.motion_bits[m];
+    }
+  }
+  u32_t adv = ((state << 1) | app.motion_first) & input;
+  state |= adv;
+  for (m = 0; adv && m < APP_CONFIG_MOTIONS; m++) {
+    u32_t bits = app.motion_bits[m];
+    if ((adv & bits) == 0) continue;
+    adv &= ~bits;
+    app.motion_us[m] = e->ts_us;
+    if (state & bits & app.motion_last) {
+      state &= ~bits;
+      app_motion_trigger(m);
+    }
+  }
+  app.motion_state = state;
+}
+
+// Applies queued pin edges in order. Stops at a release of a press that has
+// not been in a report yet, or that has been reported for less than
+// min_hold_ms, so every debounced press ends up in at least one report.
+// Returns TRUE if queue was drained.
+static bool app_pins_apply_events(void) {
+  while (app.evq_tail != app.evq_head) {
+    u16_t tail = app.evq_tail;
+    __DMB();
+    const pin_event *e = &app.evq[tail & (APP_CONFIG_EVENT_QUEUE - 1)];
+    bool defer;
+    app.edge_us = e->ts_us;
+    if (app_combo_event(e, &defer)) {
+      app_motion_event(e);
+      __DMB();
+      app.evq_tail = tail + 1;
+      continue;
+    }
+    if (defer || (!e->active && (bitset_get(app.pins_unreported, e->pin) ||
+        bitset_get(app.pins_held, e->pin)))) {
+      return FALSE;
+    }
+    app_trigger_pin(e->pin, e->active);
+    if (e->active) {
+      bitset_set(app.pins_unreported, e->pin);
+    }
+    app_motion_event(e);
+    __DMB();
+    app.evq_tail = tail + 1;
+  }
+  return TRUE;
 }
 
 // app pins have changed
 static void app_pins_update(void) {
   int pin;
+  int w;
+  u32_t now = TIMER_get_us();
+  app.edge_us = now;
 
-  app.lock_gpio_sampling = TRUE;
-  __DMB();
+  if (now - app.held_since_us >= app.min_hold_ms * 1000) {
+    memset(app.pins_held, 0, sizeof(app.pins_held));
+  }
 
-  // trigger changed pins
-  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
-    if (app.pin_state[pin] == PIN_INACTIVE && app.irq_cur_pin_active[pin]) {
-      app_trigger_pin(pin, TRUE);
-    } else if (app.pin_state[pin] != PIN_INACTIVE && !app.irq_cur_pin_active[pin]) {
-      app_trigger_pin(pin, FALSE);
+  // press pins released for a ternary swap again
+  for (pin = bitset_next(app.pins_retrigger, NULL, PIN_WORDS, 0);
+      pin >= 0;
+      pin = bitset_next(app.pins_retrigger, NULL, PIN_WORDS, pin + 1)) {
+    bitset_clr(app.pins_retrigger, pin);
+    app_trigger_pin(pin, TRUE);
+  }
+
+  // trigger changed pins in order of events
+  bool drained = app_pins_apply_events();
+
+  // events are stamped before this, so chord window cannot seem to start
+  // in the future
+  u32_t chord_us = TIMER_get_us() - app.chord_start_us;
+  bool chording = bitset_any(app.pins_chord, PIN_WORDS);
+  if (drained && chording && chord_us >= app.combo_window_ms * 1000) {
+    app_chord_resolve(app_chord_match(NULL));
+    chording = FALSE;
+  }
+
+  if (drained && app.evq_resync) {
+    // queue overflowed, trigger pins differing from debounced levels
+    u32_t changed[PIN_WORDS];
+    app.evq_resync = FALSE;
+    app_combos_reset();
+    app_motions_reset();
+    chording = FALSE;
+    app.lock_gpio_sampling = TRUE;
+    __DMB();
+    for (w = 0; w < PIN_WORDS; w++) {
+      changed[w] = app.irq_cur_active[w] ^ app.pins_active[w];
+    }
+    for (pin = bitset_next(changed, NULL, PIN_WORDS, 0);
+        pin >= 0;
+        pin = bitset_next(changed, NULL, PIN_WORDS, pin + 1)) {
+      app_trigger_pin(pin, bitset_get((u32_t *)app.irq_cur_active, pin));
     }
+    app.lock_gpio_sampling = FALSE;
+    __DMB();
   }
 
-  app.lock_gpio_sampling = FALSE;
-  __DMB();
+  // pins of devices that could not construct a report now
+  u32_t not_reported[PIN_WORDS];
+  memset(not_reported, 0, sizeof(not_reported));
 
   int i;
   for (i = 0; i < DEVICES; i++) {
     device_info *d = &app.devs[i];
     // already have pending data needing to be sent, no update so far
-    if (d->pending_change) continue;
+    if (d->pending_change) {
+      for (w = 0; w < PIN_WORDS; w++) {
+        not_reported[w] |= app.dev_pins[i][w];
+      }
+      continue;
+    }
 
-    bool active = d->construct_report(d, d->report);
+    bool active = device_construct_report(d);
     if (active) {
       DBG(D_APP, D_DEBUG, "device %i:%i active\n", d->type, d->index);
     } else {
       DBG(D_APP, D_DEBUG, "device %i:%i inactive\n", d->type, d->index);
     }
 
+    // a report sent now or left pending is from the last applied edge
+    d->edge_us = app.edge_us;
     device_check_report_dispatch(d, active);
+    if (!d->pending_change) d->edge_us = 0;
 
-    if (active && !d->timer_started) {
+    if (active && !WHEEL_is_running(&d->timer)) {
       // device pin pressed, start polling timer
       DBG(D_APP, D_DEBUG, "start timer for device %i:%i\n", d->type, d->index);
       device_start_timer(d);
@@ -488,33 +1307,233 @@ static void app_pins_update(void) {
   }
 
   // update app states
-  memcpy(&app.pin_state_prev[0], &app.pin_state[0], sizeof(app.pin_state));
+  memcpy(app.pins_active_prev, app.pins_active, sizeof(app.pins_active));
+
+  // presses now in reports are held for min_hold_ms
+  bool any_reported = FALSE;
+  for (w = 0; w < PIN_WORDS; w++) {
+    u32_t reported = app.pins_unreported[w] & ~not_reported[w];
+    app.pins_unreported[w] &= not_reported[w];
+    app.pins_held[w] |= reported;
+    any_reported |= reported != 0;
+  }
+  if (any_reported) {
+    app.held_since_us = now;
+  }
+
+  bool retrigger = bitset_any(app.pins_retrigger, PIN_WORDS);
+  if (!drained || retrigger || chording) {
+    // a release is deferred, keep dirty and continue when held long enough,
+    // or poll if device could not report the press yet. Ternary swaps
+    // continue right away, chords when window ends.
+    u32_t hold_left_ms = 0;
+    if (!drained) {
+      if (bitset_any(app.pins_unreported, PIN_WORDS)) {
+        hold_left_ms = 1;
+      } else {
+        hold_left_ms = app.min_hold_ms - (now - app.held_since_us) / 1000;
+      }
+    }
+    if (chording && !retrigger) {
+      u32_t chord_left_ms = app.combo_window_ms - chord_us / 1000;
+      if (drained || chord_left_ms < hold_left_ms) {
+        hold_left_ms = chord_left_ms;
+      }
+    }
+    if (hold_left_ms == 0) {
+      task *t = TASK_create(app_pins_dirty_msg, 0);
+      ASSERT(t);
+      TASK_run(t, 0, NULL);
+    } else {
+      app_timer_start(&app.hold_timer, app_pins_dirty_msg, NULL, hold_left_ms, 0);
+    }
+    if (!drained || retrigger) return;
+    // only waiting for chord window to end, edges meanwhile are handled at
+    // once as they may complete a combo
+  }
 
   app.dirty_gpio = FALSE;
+  __DMB();
+  if (app.evq_tail != app.evq_head || app.evq_resync) {
+    // events queued after draining but before clearing dirty flag
+    app.dirty_gpio = TRUE;
+    task *t = TASK_create(app_pins_dirty_msg, 0);
+    ASSERT(t);
+    TASK_run(t, 0, NULL);
+  }
+}
+
+// presses definitions of macro runner as a tap through its macro pin
+static void app_macro_tap(int r, int offs, int len) {
+  int pin = MACRO_PIN(r);
+  pin_def *p = &app.pin_defs[MACRO_SLOT(r)];
+  int dev;
+  for (dev = 0; dev < DEVICES; dev++) {
+    bitset_clr(app.dev_pins[dev], pin);
+  }
+  p->offs = offs;
+  p->len = len;
+  app_add_dev_pins(pin, offs, offs + len);
+  app.edge_us = TIMER_get_us();
+  app_trigger_pin(pin, TRUE);
+  bitset_set(app.pins_unreported, pin);
+  app.macros[r].tapping = TRUE;
+}
+
+// Advances macro runner by one entry. Returns TRUE if a tap was pressed.
+static bool app_macro_step(int r, time now) {
+  macro_run *m = &app.macros[r];
+  int dev;
+  for (dev = 0; dev < DEVICES; dev++) {
+    // release of previous tap must be transmitted before next press
+    if (app.devs[dev].pending_change && bitset_get(app.dev_pins[dev], MACRO_PIN(r))) {
+      return FALSE;
+    }
+  }
+  while (m->pc < m->end) {
+    hid_id id = app.def_pool[m->pc];
+    if (id.type != HID_ID_TYPE_NONE) {
+      app_macro_tap(r, m->pc, 1);
+      m->pc++;
+      return TRUE;
+    }
+    switch (MACRO_OP(id)) {
+    case MACRO_OP_DELAY:
+      m->wake = now + MACRO_ARG(id);
+      m->pc++;
+      return FALSE;
+    case MACRO_OP_GROUP:
+      app_macro_tap(r, m->pc + 1, MACRO_ARG(id));
+      m->pc += 1 + MACRO_ARG(id);
+      return TRUE;
+    default:
+      m->pc++;
+      break;
+    }
+  }
+  DBG(D_APP, D_DEBUG, "pin %i macro done\n", m->pin);
+  m->pin = 0;
+  return FALSE;
+}
+
+// Macro tick, each running macro advances at most one entry per tick. Taps
+// are released once reported and held for min_hold_ms, like pin presses.
+static void app_macro_tick_msg(u32_t ignore, void *ignore_p) {
+  time now = SYS_get_time_ms();
+  bool changed = FALSE;
+  bool running = FALSE;
+  int r;
+  for (r = 0; r < APP_CONFIG_MACROS; r++) {
+    macro_run *m = &app.macros[r];
+    if (m->pin == 0) continue;
+    if (m->tapping) {
+      if (app_tap_done(MACRO_PIN(r))) {
+        app_trigger_pin(MACRO_PIN(r), FALSE);
+        m->tapping = FALSE;
+        changed = TRUE;
+      }
+    } else if ((s32_t)(now - m->wake) >= 0) {
+      changed |= app_macro_step(r, now);
+    }
+    running |= m->pin != 0;
+  }
+  if (changed) {
+    app_pins_update();
+  }
+  if (!running) {
+    WHEEL_stop(&app.macro_timer);
+  }
+}
+
+// Motion tick, releases taps of matched motions
+static void app_motion_tick_msg(u32_t ignore, void *ignore_p) {
+  bool changed = FALSE;
+  bool tapping = FALSE;
+  int m;
+  for (m = 0; m < APP_CONFIG_MOTIONS; m++) {
+    int pin = MOTION_PIN(m);
+    if (!bitset_get(app.pins_active, pin)) continue;
+    if (app_tap_done(pin)) {
+      DBG(D_APP, D_DEBUG, "motion %i -\n", m);
+      app_trigger_pin(pin, FALSE);
+      changed = TRUE;
+    } else {
+      tapping = TRUE;
+    }
+  }
+  if (!tapping) {
+    WHEEL_stop(&app.motion_timer);
+  }
+  if (changed) {
+    app_pins_update();
+  }
+}
+
+// Turbo tick, flips phases of turbo rates and reports devices of held turbo
+// pins on a flip. Cost depends on number of rates in use, not on number of
+// turbo pins. The count is held while a report of such a device is pending,
+// so every phase reaches the host.
+static void app_turbo_tick_msg(u32_t ignore, void *ignore_p) {
+  int dev, w;
+  u8_t devs = 0;
+  for (dev = 0; dev < DEVICES; dev++) {
+    u32_t turbo = 0;
+    for (w = 0; w < PIN_WORDS; w++) {
+      turbo |= (app.pins_active[w] | app.latched[dev][w]) & app.turbo_pins[w] & app.dev_pins[dev][w];
+    }
+    if (turbo == 0) continue;
+    if (app.devs[dev].pending_change) return;
+    devs |= 1 << dev;
+  }
+  if (devs == 0) {
+    WHEEL_stop(&app.turbo_timer);
+    return;
+  }
+  app.turbo_ms = app.turbo_ms >= 999 ? 0 : app.turbo_ms + 1;
+  u64_t on = 0;
+  u64_t rates = app.turbo_rates;
+  while (rates) {
+    int hz = __builtin_ctzll(rates);
+    rates &= rates - 1;
+    if ((app.turbo_ms * hz) % 1000 < app.turbo_duty * 10) {
+      on |= 1ULL << hz;
+    }
+  }
+  if (on == app.turbo_on) return;
+  app.turbo_on = on;
+  for (dev = 0; dev < DEVICES; dev++) {
+    if (devs & (1 << dev)) {
+      device_info *d = &app.devs[dev];
+      device_check_report_dispatch(d, device_construct_report(d));
+    }
+  }
 }
 
 ///////////////////////////////// IRQ & EVENTS
 
-static void app_device_timer_task(u32_t ignore, void *d_v) {
-  device_info *d = (device_info *)d_v;
+// constructs and dispatches device report, stops polling when inactive
+static void device_poll(device_info *d) {
   // construct report
-  bool active = d->construct_report(d, d->report);
+  bool active = device_construct_report(d);
 
-  // update accelerators
+  // update accelerators, ramped by speed per report delta of elapsed time
+  u32_t now = TIMER_get_us();
+  u32_t dt_us = now - d->acc_us;
+  d->acc_us = now;
   if (!active) {
     d->accelerator_1 = 0;
     d->accelerator_2 = 0;
   } else {
     switch (d->type) {
     case HID_ID_TYPE_MOUSE: {
-      usb_mouse_report *r = (usb_mouse_report *)d->report;
-      if (r->dx != 0 || r->dy != 0) {
-        d->accelerator_1 = MIN(d->accelerator_1 + app.acc_pos_speed, 0xfff);
+      u32_t period_us = app.mouse_delta * 1000;
+      if (app.mouse_moving & (1 << 0)) {
+        d->accelerator_1 = VEL_ramp(d->accelerator_1, app.acc_pos_speed, dt_us, period_us);
       } else {
         d->accelerator_1 = 0;
       }
-      if (r->wheel != 0) {
-        d->accelerator_2 = MIN(d->accelerator_2 + app.acc_wheel_speed, 0xfff);
+      if (app.mouse_moving & (1 << 1)) {
+        d->accelerator_2 = VEL_ramp(d->accelerator_2, app.acc_wheel_speed, dt_us, period_us);
       } else {
         d->accelerator_2 = 0;
       }
@@ -523,7 +1542,8 @@ static void app_device_timer_task(u32_t ignore, void *d_v) {
     case HID_ID_TYPE_JOYSTICK: {
       usb_joystick_report *r = (usb_joystick_report *)d->report;
       if (r->dx != 0 || r->dy != 0) {
-        d->accelerator_1 = MIN(d->accelerator_1 + app.acc_joystick_speed, 0xfff);
+        d->accelerator_1 = VEL_ramp(d->accelerator_1, app.acc_joystick_speed, dt_us,
+            app.joystick_delta * 1000);
       } else {
         d->accelerator_1 = 0;
       }
@@ -537,37 +1557,73 @@ static void app_device_timer_task(u32_t ignore, void *d_v) {
 
   if (!active) {
     // no pins pressed, so stop polling this device
-    TASK_stop_timer(&d->timer);
+    WHEEL_stop(&d->timer);
     DBG(D_APP, D_DEBUG, "stop timer for device %i:%i\n", d->type, d->index);
-    d->timer_started = FALSE;
   }
 }
 
-static void app_kb_usb_cts_msg(u32_t ignore, void *ignore_p) {
-  device_info *d = &app.devs[DEV_KB];
-  if (d->pending_change) {
-    device_send_report(d);
+static void app_device_timer_task(u32_t ignore, void *d_v) {
+  device_poll((device_info *)d_v);
+}
+
+// nothing reported for the idle period, repeat unchanged report unless it
+// moves, a moving mouse reports anyway
+static void app_device_idle_task(u32_t ignore, void *d_v) {
+  device_info *d = (device_info *)d_v;
+  if (d->pending_change || d->report_moves) return;
+  if (USB_ARC_get_idle_ms(d - &app.devs[0]) == 0) return;
+  if (!device_can_send(d)) {
+    device_start_idle_timer(d);
+    return;
   }
-  DBG(D_APP, D_DEBUG, "device %i:%i cts\n", d->type, d->index);
+  device_send_report(d);
 }
 
-static void app_mouse_usb_cts_msg(u32_t ignore, void *ignore_p) {
-  device_info *d = &app.devs[DEV_MOUSE];
-  if (d->pending_change) {
-    device_send_report(d);
+// runs timer wheel ticks counted by APP_timer
+static void app_wheel_msg(u32_t ignore, void *ignore_p) {
+  app.wheel_posted = FALSE;
+  __DMB();
+  while (app.wheel_ticked != app.wheel_ticks) {
+    app.wheel_ticked++;
+    WHEEL_tick();
   }
+}
+
+static void app_kb_usb_cts_msg(u32_t ignore, void *ignore_p) {
+  device_info *d = &app.devs[DEV_KB];
+  device_report_done(d);
+  DBG(D_APP, D_DEBUG, "device %i:%i cts\n", d->type, d->index);
+}
+
+static void app_mouse_usb_cts_msg(u32_t ignore, void *ignore_p) {
+  device_info *d = &app.devs[DEV_MOUSE];
+  device_report_done(d);
   DBG(D_APP, D_DEBUG, "device %i:%i cts\n", d->type, d->index);
 }
 
 static void app_joystick_usb_cts_msg(u32_t j, void *ignore_p) {
   usb_joystick j_ix = j ? JOYSTICK2 : JOYSTICK1;
   device_info *d = &app.devs[j_ix == JOYSTICK1 ? DEV_JOY1 : DEV_JOY2];
-  if (d->pending_change) {
-    device_send_report(d);
-  }
+  device_report_done(d);
   DBG(D_APP, D_DEBUG, "device %i:%i cts\n", d->type, d->index);
 }
 
+// reports mouse movement once per usb frame while moving
+static void app_mouse_sof_msg(u32_t ignore, void *ignore_p) {
+  device_info *d = &app.devs[DEV_MOUSE];
+  app.mouse_sof_posted = FALSE;
+  __DMB();
+  // inactive mouse is not polled, and a report not yet polled by host is
+  // updated when it is
+  if (!WHEEL_is_running(&d->timer) || !device_can_send(d)) return;
+  device_poll(d);
+}
+
+static void app_usb_enumerated_msg(u32_t ignore, void *ignore_p) {
+  DBG(D_APP, D_INFO, "usb enumerated in %i ms, devices %04b\n",
+      USB_ARC_get_enum_time_ms(), USB_ARC_get_devices());
+}
+
 static void app_pins_dirty_msg(u32_t ignore, void *ignore_p) {
   app_pins_update();
 }
@@ -590,6 +1646,216 @@ static void app_joystick_usb_cts_irq(usb_joystick j_ix) {
   TASK_run(t, j_ix, NULL);
 }
 
+static void app_usb_sof_irq(void) {
+  if (!app.usb_enum_logged) {
+    app.usb_enum_logged = TRUE;
+    task *t = TASK_create(app_usb_enumerated_msg, 0);
+    ASSERT(t);
+    TASK_run(t, 0, NULL);
+  }
+  if (app.mouse_moving && !app.mouse_sof_posted) {
+    app.mouse_sof_posted = TRUE;
+    task *t = TASK_create(app_mouse_sof_msg, 0);
+    ASSERT(t);
+    TASK_run(t, 0, NULL);
+  }
+}
+
+/////////////////////////////////// USB SUSPEND
+
+#ifndef CONFIG_ANNOYATRON
+static void app_sample_pins(u32_t *raw);
+static void app_event_push(u8_t pin, bool active, u32_t ts_us);
+
+static void app_wake_irq(gpio_pin pin) {
+  app.wake_lines |= 1 << pin;
+}
+
+// arms gpio pins as exti wake sources, or disarms them. An exti line is
+// routed to one port only by AFIO_EXTICR, so of pins with same gpio number on
+// different ports only the first mapped wakes. The others are counted in
+// unarmed_pins, and are sampled when the rtc alarm wakes the cpu every
+// APP_WAKE_POLL_MS, or when another pin or the host wakes it.
+static void app_wake_arm(bool arm) {
+  const gpio_pin_map *in = GPIO_MAP_get_pin_map();
+  int line, i;
+  if (!arm) {
+    PROC_rtc_alarm(0);
+    for (line = 0; line < 16; line++) {
+      if (app.wake_armed & (1 << line)) {
+        gpio_interrupt_deconfig(in[app.wake_line_pin[line]].port, line);
+      }
+    }
+    app.wake_armed = 0;
+    return;
+  }
+  u16_t taken = 0;
+#ifdef CONFIG_IO_EXP
+  // expander INT line already wakes, by expander pins
+  taken = 1 << IO_EXP_INT_PIN;
+#endif
+  app.wake_lines = 0;
+  app.suspend_stats.wake_pins = 0;
+  app.suspend_stats.unarmed_pins = 0;
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    if (GPIO_MAP_IS_UNUSED(&in[i])) continue;
+    line = in[i].pin;
+    if (taken & (1 << line)) {
+      app.suspend_stats.unarmed_pins++;
+      continue;
+    }
+    taken |= 1 << line;
+    app.wake_armed |= 1 << line;
+    app.wake_line_pin[line] = i;
+    gpio_interrupt_config(in[i].port, in[i].pin, app_wake_irq, FLANK_DOWN);
+    gpio_interrupt_mask_enable(in[i].port, in[i].pin, TRUE);
+    app.suspend_stats.wake_pins++;
+  }
+}
+
+// samples pins after a wakeup, pins of triggered exti lines count as
+// pressed even if released already. Returns TRUE if any pin was pressed
+// while suspended.
+static bool app_wake_pins(u32_t *raw) {
+  u16_t lines = app.wake_lines;
+  bool pressed = FALSE;
+  int w;
+  app_sample_pins(raw);
+  while (lines) {
+    int line = bitset_lowest(lines);
+    lines &= ~(1 << line);
+    bitset_set(raw, app.wake_line_pin[line]);
+  }
+  for (w = 0; w < PIN_WORDS; w++) {
+    pressed |= (raw[w] & ~app.irq_cur_active[w]) != 0;
+  }
+  return pressed;
+}
+
+// queues presses of pins woken up on without debouncing, the edge having
+// woken the cpu. A pin released already is debounced to a release by the
+// sampler. Called with sampler stopped.
+static void app_wake_press(const u32_t *raw) {
+  u32_t now = TIMER_get_us();
+  int w;
+  for (w = 0; w < PIN_WORDS; w++) {
+    u32_t pressed = raw[w] & ~app.irq_cur_active[w];
+    app.irq_cur_active[w] |= pressed;
+    app.irq_raw[w] |= pressed;
+    app.irq_unsettled[w] &= ~pressed;
+    while (pressed) {
+      int bit = bitset_lowest(pressed);
+      pressed &= ~(1UL << bit);
+      app.irq_same_state[(w << 5) + bit] = 0;
+      app_event_push((w << 5) + bit, TRUE, now);
+    }
+  }
+  if (!app.dirty_gpio) {
+    app.dirty_gpio = TRUE;
+    task *t = TASK_create(app_pins_dirty_msg, 0);
+    ASSERT(t);
+    TASK_run(t, 0, NULL);
+  }
+}
+
+static void app_wake_timeout_task(u32_t ignore, void *ignore_p) {
+  if (app.wake_report_pending) {
+    app.wake_report_pending = FALSE;
+    app.suspend_stats.missed++;
+  }
+}
+
+// bus suspended, stops system timer and led and arms wake pins if host
+// allows remote wakeup
+static void app_suspend_enter(void) {
+  app.suspended = TRUE;
+  app.suspend_wakeup = USB_ARC_remote_wakeup_enabled();
+  app.suspend_stats.suspends++;
+  if (app.suspend_wakeup) app_wake_arm(TRUE);
+
+  enter_critical();
+  app.suspend_ms = PROC_get_rtc_ms();
+  PROC_system_timer(FALSE);
+  const gpio_pin_map *led = GPIO_MAP_get_led_map();
+  if (BOARD_LED_ACTIVE_LOW) {
+    gpio_enable(led->port, led->pin);
+  } else {
+    gpio_disable(led->port, led->pin);
+  }
+  exit_critical();
+}
+
+// host resumed, or a press woke the cpu and host is woken up
+static void app_suspend_leave(bool woken, const u32_t *raw) {
+  enter_critical();
+  app.suspend_stats.suspend_ms += PROC_get_rtc_ms() - app.suspend_ms;
+  if (woken) {
+    app_wake_press(raw);
+  }
+  PROC_system_timer(TRUE);
+  exit_critical();
+
+  app.suspended = FALSE;
+  if (app.suspend_wakeup) app_wake_arm(FALSE);
+  if (woken && USB_ARC_remote_wakeup()) {
+    app.suspend_stats.wakeups++;
+    app.wake_us = TIMER_get_us();
+    app.wake_report_pending = TRUE;
+    app_timer_start(&app.wake_timer, app_wake_timeout_task, NULL, APP_WAKE_REPORT_MS, 0);
+  }
+  DBG(D_APP, D_DEBUG, "usb %s\n", woken ? "remote wakeup" : "resumed");
+}
+
+bool APP_idle(void) {
+  u32_t raw[PIN_WORDS];
+  bool woken;
+  if (!app.suspended) {
+    if (!app.suspend_pending) return FALSE;
+    app.suspend_pending = FALSE;
+    __DMB();
+    if (!USB_ARC_is_suspended()) return FALSE;
+    app_suspend_enter();
+  }
+
+  enter_critical();
+  if (USB_ARC_is_suspended()
+#ifdef CONFIG_IO_EXP
+      // an expander read started by INT is finished before stopping
+      && !IO_EXP_busy()
+#endif
+      ) {
+    u32_t stop_ms = PROC_get_rtc_ms();
+    if (app.suspend_wakeup && app.suspend_stats.unarmed_pins) {
+      PROC_rtc_alarm(APP_WAKE_POLL_MS);
+    }
+    PROC_enter_stop();
+    app.suspend_stats.stop_ms += PROC_get_rtc_ms() - stop_ms;
+  }
+  // have the interrupt waking the cpu run
+  exit_critical();
+  enter_critical();
+  woken = app.suspend_wakeup && app_wake_pins(raw);
+  exit_critical();
+
+  // else back to main loop for tasks queued by the waking interrupt, and
+  // stop again when idle
+  if (woken || !USB_ARC_is_suspended()) {
+    app_suspend_leave(woken, raw);
+  }
+  return TRUE;
+}
+
+// usb irq, cpu is stopped from main loop when idle
+static void app_usb_suspend_irq(void) {
+  app.suspend_pending = TRUE;
+}
+#else
+
+bool APP_idle(void) {
+  return FALSE;
+}
+#endif // CONFIG_ANNOYATRON
+
 /////////////////////////////////// DEF CFG
 
 static void app_config_default(void) {
@@ -600,7 +1866,23 @@ static void app_config_default(void) {
   app.acc_wheel_speed = 4;
   app.joystick_delta = 7;
   app.acc_joystick_speed = 4;
-  memset(&app.pin_config, 0x00, sizeof(app.pin_config));
+  app_acc acc;
+  for (acc = 0; acc < _ACC_CNT; acc++) {
+    vel_curve linear = { .type = VEL_CURVE_LINEAR };
+    APP_cfg_set_acc_curve(acc, &linear);
+  }
+  app.min_hold_ms = 0;
+  app.combo_window_ms = 30;
+  app.turbo_duty = 50;
+  app.usb_personality = USB_ARC_COMPOSITE;
+  app.usb_latency = FALSE;
+  app.latch_mask = (1 << DEV_KB) | (1 << DEV_MOUSE) | (1 << DEV_JOY1) | (1 << DEV_JOY2);
+  app.tern_release_first = FALSE;
+  APP_cfg_set_socd(0, SOCD_LAST, FALSE);
+  APP_cfg_set_socd(1, SOCD_LAST, FALSE);
+  memset(app.layer_sels, 0, sizeof(app.layer_sels));
+  APP_cfg_set_gpio_map(GPIO_MAP_get_default_pin_map());
+  APP_cfg_clear_pins();
 
   def_config cfg;
   memset(&cfg, 0x00, sizeof(def_config));
@@ -631,6 +1913,9 @@ static void app_config_default(void) {
   cfg.id[1].kb.kb_code  = KC_RIGHT;
   APP_cfg_set_pin(&cfg);
   cfg.id[1].type = HID_ID_TYPE_NONE;
+  // buttons carry no data, it would be their turbo rate
+  cfg.id[0].joy.joystick_sign = 0;
+  cfg.id[0].joy.joystick_data = 0;
   // pin4 = JOYSTICK1_BUTTON1
   cfg.pin = 5;
   cfg.id[0].joy.joystick_code = JOYSTICK1_BUTTON1;
@@ -667,6 +1952,7 @@ static void app_config_default(void) {
   cfg.pin = 17;
   cfg.id[0].joy.joystick_sign = 0;
   APP_cfg_set_pin(&cfg);
+  cfg.id[0].joy.joystick_data = 0;
   // pin18 = JOYSTICK2_BUTTON1
   cfg.pin = 18;
   cfg.id[0].joy.joystick_code = JOYSTICK2_BUTTON1;
@@ -692,6 +1978,12 @@ static void app_config_default(void) {
 volatile static bool app_init = FALSE;
 void APP_init(void) {
   memset(&app, 0, sizeof(app));
+  WHEEL_init();
+  APP_cfg_clear_pins();
+  app_acc acc;
+  for (acc = 0; acc < _ACC_CNT; acc++) {
+    VEL_build_lut(&app.acc_curves[acc], app.acc_luts[acc]);
+  }
 
   int res = FS_mount();
   if (res == NIFFS_OK) {
@@ -707,6 +1999,11 @@ void APP_init(void) {
       app_config_default();
       DBG(D_APP, D_INFO, "no default config found, saving factory default");
       res = FS_save_config("default");
+    } else if (res == ERR_NIFFS_BAD_CONFIG) {
+      // kept on file until saved over, other firmware may still load it
+      app_config_default();
+      DBG(D_APP, D_WARN, "default config not loadable, using factory default\n");
+      res = NIFFS_OK;
     }
 
     if (res != NIFFS_OK) {
@@ -717,6 +2014,11 @@ void APP_init(void) {
   USB_ARC_set_kb_callback(app_kb_usb_cts_irq);
   USB_ARC_set_mouse_callback(app_mouse_usb_cts_irq);
   USB_ARC_set_joystick_callback(app_joystick_usb_cts_irq);
+  USB_ARC_set_sof_callback(app_usb_sof_irq);
+  USB_ARC_set_suspend_callback(app_usb_suspend_irq);
+  USB_ARC_set_personality(app.usb_personality);
+  USB_ARC_set_latency(app.usb_latency);
+  USB_ARC_set_devices(app_used_devices());
 #endif // CONFIG_ANNOYATRON
 
   USB_ARC_start();
@@ -737,7 +2039,6 @@ void APP_init(void) {
   app.devs[DEV_KB].report_prev = &app.kb_report_prev;
   app.devs[DEV_KB].report_len = sizeof(app.kb_report);
   app.devs[DEV_KB].report_filter = TRUE;
-  app.devs[DEV_KB].timer_task = TASK_create(app_device_timer_task, TASK_STATIC);
   // mouse device
   app.devs[DEV_MOUSE].type = HID_ID_TYPE_MOUSE;
   app.devs[DEV_MOUSE].index = 0;
@@ -745,8 +2046,8 @@ void APP_init(void) {
   app.devs[DEV_MOUSE].report = &app.mouse_report;
   app.devs[DEV_MOUSE].report_prev = &app.mouse_report_prev;
   app.devs[DEV_MOUSE].report_len = sizeof(app.mouse_report);
-  app.devs[DEV_MOUSE].report_filter = FALSE;
-  app.devs[DEV_MOUSE].timer_task = TASK_create(app_device_timer_task, TASK_STATIC);
+  app.devs[DEV_MOUSE].report_filter = TRUE;
+  app.mouse_idle = TRUE;
   // joystick1 device
   app.devs[DEV_JOY1].type = HID_ID_TYPE_JOYSTICK;
   app.devs[DEV_JOY1].index = (u8_t)JOYSTICK1;
@@ -755,7 +2056,6 @@ void APP_init(void) {
   app.devs[DEV_JOY1].report_prev = &app.joystick_report1_prev;
   app.devs[DEV_JOY1].report_len = sizeof(app.joystick_report1);
   app.devs[DEV_JOY1].report_filter = TRUE;
-  app.devs[DEV_JOY1].timer_task = TASK_create(app_device_timer_task, TASK_STATIC);
   // joystick2 device
   app.devs[DEV_JOY2].type = HID_ID_TYPE_JOYSTICK;
   app.devs[DEV_JOY2].index = (u8_t)JOYSTICK2;
@@ -764,36 +2064,686 @@ void APP_init(void) {
   app.devs[DEV_JOY2].report_prev = &app.joystick_report2_prev;
   app.devs[DEV_JOY2].report_len = sizeof(app.joystick_report2);
   app.devs[DEV_JOY2].report_filter = TRUE;
-  app.devs[DEV_JOY2].timer_task = TASK_create(app_device_timer_task, TASK_STATIC);
+  int dev;
+  for (dev = 0; dev < DEVICES; dev++) {
+    USB_ARC_set_report_source(dev, app.devs[dev].report, app.devs[dev].report_len);
+  }
+
+  APP_cfg_set_latch_mask(app.latch_mask);
 #endif // CONFIG_ANNOYATRON
 
   app_init = TRUE;
 }
 
-void APP_cfg_set_pin(def_config *cfg) {
-  memcpy(&app.pin_config[cfg->pin - 1], cfg, sizeof(def_config));
-  app.pin_state[cfg->pin - 1] = PIN_INACTIVE;
-  app.pin_state_prev[cfg->pin - 1] = PIN_INACTIVE;
-  app.irq_cur_pin_active[cfg->pin - 1] = FALSE;
+// rebuilds reverse ternary index
+static void app_build_tern_deps(void) {
+  int s, tern;
+  int n = 0;
+  for (tern = 0; tern < ALL_PINS; tern++) {
+    u32_t listed[PIN_WORDS];
+    memset(listed, 0, sizeof(listed));
+    app.tern_dep_offs[tern] = n;
+    for (s = 0; s < SLOTS; s++) {
+      int pin = app_slot_pin(s);
+      if (pin >= 0 && app.pin_defs[s].tern_pin == tern + 1 && !bitset_get(listed, pin)) {
+        bitset_set(listed, pin);
+        app.tern_deps[n++] = pin;
+      }
+    }
+  }
+  app.tern_dep_offs[ALL_PINS] = n;
+}
 
+// rebuilds layer action table, pins without definitions on a layer use the
+// definitions of the layer below
+static void app_build_layer_map(void) {
+  int l, pin, s;
+  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
+    app.layer_map[0][pin] = pin;
+  }
+  for (l = 1; l < APP_CONFIG_LAYERS; l++) {
+    memcpy(app.layer_map[l], app.layer_map[l-1], sizeof(app.layer_map[l]));
+    for (s = 0; s < APP_CONFIG_LAYER_DEFS; s++) {
+      if (app.slot_layer[s] == l) {
+        app.layer_map[l][app.slot_pin[s]] = APP_CONFIG_PINS + s;
+      }
+    }
+  }
+}
+
+// finds definition slot of pin on layer, or -1
+static int app_find_slot(int layer, int pin) {
+  if (layer == 0) return pin;
+  int s;
+  for (s = 0; s < APP_CONFIG_LAYER_DEFS; s++) {
+    if (app.slot_layer[s] == layer && app.slot_pin[s] == pin) {
+      return APP_CONFIG_PINS + s;
+    }
+  }
+  return -1;
+}
+
+// marks pin as having definitions for devices of given pool range
+static void app_add_dev_pins(int pin, int def_start, int def_end) {
   int def;
-  app.pin_mark[cfg->pin - 1] = 0;
-  for (def = 0; def < APP_CONFIG_DEFS_PER_PIN; def++) {
-    if (cfg->id[def].type == HID_ID_TYPE_KEYBOARD) {
-      app.pin_mark[cfg->pin - 1] |= PIN_MARK_KB;
-    } else if (cfg->id[def].type == HID_ID_TYPE_MOUSE) {
-      app.pin_mark[cfg->pin - 1] |= PIN_MARK_MOUSE;
-    } else if (cfg->id[def].type == HID_ID_TYPE_JOYSTICK) {
-      if (cfg->id[def].joy.joystick_code < _JOYSTICK_IX_2) {
-        app.pin_mark[cfg->pin - 1] |= PIN_MARK_JOY1;
+  for (def = def_start; def < def_end; def++) {
+    const hid_id *id = &app.def_pool[def];
+    if (id->type == HID_ID_TYPE_KEYBOARD) {
+      bitset_set(app.dev_pins[DEV_KB], pin);
+    } else if (id->type == HID_ID_TYPE_MOUSE) {
+      bitset_set(app.dev_pins[DEV_MOUSE], pin);
+    } else if (id->type == HID_ID_TYPE_JOYSTICK) {
+      if (id->joy.joystick_code < _JOYSTICK_IX_2) {
+        bitset_set(app.dev_pins[DEV_JOY1], pin);
       } else {
-        app.pin_mark[cfg->pin - 1] |= PIN_MARK_JOY2;
+        bitset_set(app.dev_pins[DEV_JOY2], pin);
+      }
+    }
+  }
+}
+
+#ifndef CONFIG_ANNOYATRON
+// devices having any definition, macros included, bit per DEV_*, for the
+// usb devices presented at start, at least the keyboard
+static u8_t app_used_devices(void) {
+  u8_t used = 0;
+  int s;
+  for (s = 0; s < SLOTS; s++) {
+    if (app_slot_pin(s) < 0) continue;
+    const pin_def *p = &app.pin_defs[s];
+    int def;
+    for (def = p->offs; def < p->offs + p->len; def++) {
+      const hid_id *id = &app.def_pool[def];
+      if (id->type == HID_ID_TYPE_KEYBOARD) {
+        used |= 1 << DEV_KB;
+      } else if (id->type == HID_ID_TYPE_MOUSE) {
+        used |= 1 << DEV_MOUSE;
+      } else if (id->type == HID_ID_TYPE_JOYSTICK) {
+        used |= 1 << (id->joy.joystick_code < _JOYSTICK_IX_2 ? DEV_JOY1 : DEV_JOY2);
       }
     }
   }
+  return used ? used : 1 << DEV_KB;
 }
-def_config *APP_cfg_get_pin(u8_t pin) {
-  return &app.pin_config[pin];
+#endif
+
+// recalculates which devices pin has definitions for, on any layer,
+// macros are tapped through macro pins
+static void app_update_dev_pins(int pin) {
+  int dev, s;
+  for (dev = 0; dev < DEVICES; dev++) {
+    bitset_clr(app.dev_pins[dev], pin);
+  }
+  for (s = 0; s < SLOTS; s++) {
+    if (app_slot_pin(s) != pin) continue;
+    const pin_def *p = &app.pin_defs[s];
+    app_add_dev_pins(pin, p->offs, p->offs + p->len - p->macro_len);
+  }
+}
+
+// stops all macros, definitions they run may move in pool
+static void app_macros_clear(void) {
+  int r, dev;
+  memset(app.macros, 0, sizeof(app.macros));
+  for (r = 0; r < APP_CONFIG_MACROS; r++) {
+    app.pin_defs[MACRO_SLOT(r)].len = 0;
+    bitset_clr(app.pins_active, MACRO_PIN(r));
+    bitset_clr(app.pins_active_prev, MACRO_PIN(r));
+    bitset_clr(app.pins_unreported, MACRO_PIN(r));
+    for (dev = 0; dev < DEVICES; dev++) {
+      bitset_clr(app.dev_pins[dev], MACRO_PIN(r));
+    }
+  }
+}
+
+// rebuilds set of pins having turbo definitions and turbo rates in use
+static void app_build_turbo(void) {
+  int s, def;
+  memset(app.turbo_pins, 0, sizeof(app.turbo_pins));
+  app.turbo_rates = 0;
+  for (s = 0; s < SLOTS; s++) {
+    int pin = app_slot_pin(s);
+    if (pin < 0) continue;
+    const pin_def *p = &app.pin_defs[s];
+    for (def = p->offs; def < p->offs + p->len - p->macro_len; def++) {
+      u8_t hz = def_turbo_hz(app.def_pool[def]);
+      if (hz) {
+        bitset_set(app.turbo_pins, pin);
+        app.turbo_rates |= 1ULL << hz;
+      }
+    }
+  }
+}
+
+// drops motions in progress and counts held joystick directions from
+// debounced pin levels
+static void app_motions_reset(void) {
+  int pin, d;
+  app.motion_state = 0;
+  memset(app.motion_held, 0, sizeof(app.motion_held));
+  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
+    if (!bitset_get((u32_t *)app.irq_cur_active, pin)) continue;
+    for (d = 0; d < 2 * 4; d++) {
+      if (app.motion_pin_dirs[pin] & (1 << d)) app.motion_held[d]++;
+    }
+  }
+  app.motion_dir[0] = app_motion_dir(0);
+  app.motion_dir[1] = app_motion_dir(1);
+}
+
+// compiles motions to matcher steps, and finds joystick directions of pins
+// from their layer 0 definitions
+static void app_build_motions(void) {
+  int m, i, pin, def;
+  int bit = 0;
+  app.motion_cnt = 0;
+  app.motion_first = 0;
+  app.motion_last = 0;
+  memset(app.motion_bits, 0, sizeof(app.motion_bits));
+  memset(app.motion_dir_bits, 0, sizeof(app.motion_dir_bits));
+  memset(app.motion_pin_bits, 0, sizeof(app.motion_pin_bits));
+  memset(app.motion_pin_dirs, 0, sizeof(app.motion_pin_dirs));
+  for (m = 0; m < APP_CONFIG_MOTIONS; m++) {
+    const motion_def *md = &app.motions[m];
+    if (md->steps[0] == 0) continue;
+    app.motion_cnt++;
+    app.motion_first |= 1UL << bit;
+    for (i = 0; i < APP_CONFIG_MOTION_STEPS && md->steps[i] && bit < MOTION_BITS; i++, bit++) {
+      u8_t step = md->steps[i];
+      app.motion_bits[m] |= 1UL << bit;
+      if (step & MOTION_STEP_PIN) {
+        app.motion_pin_bits[(step & ~MOTION_STEP_PIN) - 1] |= 1UL << bit;
+      } else {
+        app.motion_dir_bits[md->joystick][step] |= 1UL << bit;
+      }
+    }
+    app.motion_last |= 1UL << (bit - 1);
+  }
+  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
+    const pin_def *p = &app.pin_defs[pin];
+    for (def = p->offs; def < p->offs + p->len - p->macro_len; def++) {
+      hid_id id = app.def_pool[def];
+      if (id.type != HID_ID_TYPE_JOYSTICK) continue;
+      int j = id.joy.joystick_code >= _JOYSTICK_IX_2 ? 1 : 0;
+      enum joystick_code code = id.joy.joystick_code - (j ? _JOYSTICK_IX_2 : _JOYSTICK_IX_1);
+      if (code != JOYSTICK1_X && code != JOYSTICK1_Y) continue;
+      app.motion_pin_dirs[pin] |=
+          1 << (j * 4 + (code - JOYSTICK1_X) * 2 + (id.joy.joystick_sign ? 0 : 1));
+    }
+  }
+  app_motions_reset();
+}
+
+// rebuilds combo order and set of pins part of any combo
+static void app_build_combos(void) {
+  int c, i, w;
+  app.combo_cnt = 0;
+  memset(app.combo_pins, 0, sizeof(app.combo_pins));
+  for (c = 0; c < APP_CONFIG_COMBOS; c++) {
+    if (app.combos[c].pins == 0) continue;
+    for (w = 0; w < PIN_WORDS; w++) {
+      app.combo_pins[w] |= app.combos[c].mask[w];
+    }
+    // insertion sort, most pins first
+    for (i = app.combo_cnt;
+        i > 0 && app.combos[app.combo_order[i-1]].pins < app.combos[c].pins; i--) {
+      app.combo_order[i] = app.combo_order[i-1];
+    }
+    app.combo_order[i] = c;
+    app.combo_cnt++;
+  }
+}
+
+void APP_cfg_clear_pins(void) {
+  app_macros_clear();
+  memset(app.pin_defs, 0, sizeof(app.pin_defs));
+  memset(app.slot_layer, 0, sizeof(app.slot_layer));
+  memset(app.dev_pins, 0, sizeof(app.dev_pins));
+  memset(app.combos, 0, sizeof(app.combos));
+  memset(app.motions, 0, sizeof(app.motions));
+  app.def_pool_used = 0;
+  app_build_layer_map();
+  app_build_tern_deps();
+  app_build_combos();
+  app_build_motions();
+  app_build_turbo();
+}
+
+// number of definitions to store for cfg
+static int app_cfg_def_len(const def_config *cfg) {
+  int len;
+  // trailing empty definitions are not stored
+  for (len = APP_CONFIG_DEFS_PER_PIN; len > 0 && cfg->id[len-1].type == HID_ID_TYPE_NONE; len--);
+  if (cfg->tern_pin && len < cfg->tern_splice) {
+    len = cfg->tern_splice;
+  }
+  return len;
+}
+
+// stores len definitions of cfg in slot, resizing its part of the pool.
+// Returns FALSE if pool would overflow.
+static bool app_slot_store(int slot, const def_config *cfg, int len) {
+  pin_def *p = &app.pin_defs[slot];
+  if (app.def_pool_used - p->len + len > APP_CONFIG_DEF_POOL) {
+    return FALSE;
+  }
+
+  // make room in pool by moving definitions stored after this slot, an
+  // empty slot is appended to the end of the pool
+  if (p->len == 0) {
+    p->offs = app.def_pool_used;
+  }
+  int tail = p->offs + p->len;
+  memmove(&app.def_pool[p->offs + len], &app.def_pool[tail],
+      (app.def_pool_used - tail) * sizeof(hid_id));
+  app.def_pool_used = app.def_pool_used - p->len + len;
+  int i;
+  for (i = 0; i < SLOTS; i++) {
+    pin_def *o = &app.pin_defs[i];
+    if (o != p && o->len > 0 && o->offs >= tail) {
+      o->offs = o->offs - p->len + len;
+    }
+  }
+  memcpy(&app.def_pool[p->offs], cfg->id, len * sizeof(hid_id));
+  p->len = len;
+  p->tern_pin = cfg->tern_pin;
+  p->tern_splice = cfg->tern_splice;
+  p->macro_len = 0;
+  // ternary definitions hold no macros, see APP_cfg_set_pin
+  if (cfg->tern_pin == 0) {
+    for (i = 0; i < len; i++) {
+      if (cfg->id[i].type == HID_ID_TYPE_NONE && MACRO_OP(cfg->id[i]) == MACRO_OP_START) {
+        p->macro_len = len - i;
+        break;
+      }
+    }
+  }
+  return TRUE;
+}
+
+// sets definitions of combo of cfg, combos are identified by their pins
+static bool app_cfg_set_combo(def_config *cfg, int len) {
+  u32_t mask[PIN_WORDS];
+  int c, i, w;
+  memset(mask, 0, sizeof(mask));
+  bitset_set(mask, cfg->pin - 1);
+  for (i = 0; i < APP_CONFIG_COMBO_PINS - 1 && cfg->combo[i]; i++) {
+    if (cfg->combo[i] > APP_CONFIG_PINS) return FALSE;
+    bitset_set(mask, cfg->combo[i] - 1);
+  }
+  u8_t pins = 0;
+  for (w = 0; w < PIN_WORDS; w++) {
+    pins += __builtin_popcount(mask[w]);
+  }
+  for (c = 0; c < APP_CONFIG_COMBOS; c++) {
+    u32_t diff = 0;
+    for (w = 0; w < PIN_WORDS; w++) {
+      diff |= app.combos[c].mask[w] ^ mask[w];
+    }
+    if (app.combos[c].pins && diff == 0) break;
+  }
+  if (c >= APP_CONFIG_COMBOS) {
+    if (len == 0) return TRUE;
+    // allocate a combo
+    for (c = 0; c < APP_CONFIG_COMBOS && app.combos[c].pins != 0; c++);
+    if (c >= APP_CONFIG_COMBOS) {
+      return FALSE;
+    }
+    memset(&app.pin_defs[COMBO_SLOT(c)], 0, sizeof(pin_def));
+  }
+  if (!app_slot_store(COMBO_SLOT(c), cfg, len)) {
+    return FALSE;
+  }
+  memcpy(app.combos[c].mask, mask, sizeof(mask));
+  app.combos[c].pins = len > 0 ? pins : 0;
+  app_build_combos();
+  app_build_tern_deps();
+  app_build_turbo();
+
+  // combo released, its pins are free once released
+  bitset_clr(app.pins_active, COMBO_PIN(c));
+  bitset_clr(app.pins_active_prev, COMBO_PIN(c));
+  app_update_dev_pins(COMBO_PIN(c));
+  return TRUE;
+}
+
+// sets definitions of motion of cfg, motions are identified by their steps
+// and joystick
+static bool app_cfg_set_motion(def_config *cfg, int len) {
+  int m, i;
+  for (i = 0; i < APP_CONFIG_MOTION_STEPS && cfg->motion[i]; i++) {
+    u8_t step = cfg->motion[i];
+    if ((step & MOTION_STEP_PIN) ? (step & ~MOTION_STEP_PIN) > APP_CONFIG_PINS : step > 9) {
+      return FALSE;
+    }
+  }
+  int steps = i;
+  if (cfg->motion_joystick > 1) return FALSE;
+  for (m = 0; m < APP_CONFIG_MOTIONS; m++) {
+    if (app.motions[m].steps[0] && app.motions[m].joystick == cfg->motion_joystick &&
+        memcmp(app.motions[m].steps, cfg->motion, sizeof(cfg->motion)) == 0) break;
+  }
+  // steps of all motions share the matcher bits
+  int used = 0;
+  for (i = 0; i < APP_CONFIG_MOTIONS; i++) {
+    if (i != m) used += __builtin_popcount(app.motion_bits[i]);
+  }
+  if (m >= APP_CONFIG_MOTIONS) {
+    if (len == 0) return TRUE;
+    // allocate a motion
+    for (m = 0; m < APP_CONFIG_MOTIONS && app.motions[m].steps[0] != 0; m++);
+    if (m >= APP_CONFIG_MOTIONS) {
+      return FALSE;
+    }
+    memset(&app.pin_defs[MOTION_SLOT(m)], 0, sizeof(pin_def));
+  }
+  if (len > 0 && used + steps > MOTION_BITS) {
+    return FALSE;
+  }
+  if (!app_slot_store(MOTION_SLOT(m), cfg, len)) {
+    return FALSE;
+  }
+  memset(&app.motions[m], 0, sizeof(motion_def));
+  if (len > 0) {
+    memcpy(app.motions[m].steps, cfg->motion, sizeof(app.motions[m].steps));
+    app.motions[m].step_ms = cfg->motion_ms ? cfg->motion_ms : MOTION_STEP_MS;
+    app.motions[m].joystick = cfg->motion_joystick;
+  }
+  app_build_motions();
+  app_build_tern_deps();
+  app_build_turbo();
+
+  bitset_clr(app.pins_active, MOTION_PIN(m));
+  bitset_clr(app.pins_active_prev, MOTION_PIN(m));
+  bitset_clr(app.pins_unreported, MOTION_PIN(m));
+  app_update_dev_pins(MOTION_PIN(m));
+  return TRUE;
+}
+
+bool APP_cfg_set_pin(def_config *cfg) {
+  int pin = cfg->pin - 1;
+  if (cfg->layer >= APP_CONFIG_LAYERS || cfg->tern_pin > APP_CONFIG_PINS ||
+      cfg->tern_splice > APP_CONFIG_DEFS_PER_PIN) {
+    return FALSE;
+  }
+  int d;
+  for (d = 0; d < APP_CONFIG_DEFS_PER_PIN; d++) {
+    if (def_turbo_hz(cfg->id[d]) > DEF_TURBO_MAX_HZ) {
+      return FALSE;
+    }
+  }
+  app_macros_clear();
+  if (cfg->combo[0]) {
+    // combos are not layered nor ternary
+    cfg->tern_pin = 0;
+    return cfg->layer == 0 && app_cfg_set_combo(cfg, app_cfg_def_len(cfg));
+  }
+  if (cfg->motion[0]) {
+    // motions are not layered nor ternary
+    cfg->tern_pin = 0;
+    return cfg->layer == 0 && app_cfg_set_motion(cfg, app_cfg_def_len(cfg));
+  }
+  int len = app_cfg_def_len(cfg);
+  if (cfg->tern_pin) {
+    // ternary definitions run no macros, as enforced by parser
+    int i;
+    for (i = 0; i < len; i++) {
+      if (cfg->id[i].type == HID_ID_TYPE_NONE && MACRO_OP(cfg->id[i]) == MACRO_OP_START) {
+        return FALSE;
+      }
+    }
+  }
+  int slot = app_find_slot(cfg->layer, pin);
+  if (slot < 0) {
+    if (len == 0) return TRUE;
+    // allocate a layer slot
+    int s;
+    for (s = 0; s < APP_CONFIG_LAYER_DEFS && app.slot_layer[s] != 0; s++);
+    if (s >= APP_CONFIG_LAYER_DEFS) {
+      return FALSE;
+    }
+    slot = APP_CONFIG_PINS + s;
+    memset(&app.pin_defs[slot], 0, sizeof(pin_def));
+  }
+  if (!app_slot_store(slot, cfg, len)) {
+    return FALSE;
+  }
+  if (slot >= APP_CONFIG_PINS) {
+    app.slot_pin[slot - APP_CONFIG_PINS] = pin;
+    app.slot_layer[slot - APP_CONFIG_PINS] = len > 0 ? cfg->layer : 0;
+  }
+
+  app_build_layer_map();
+  app_build_tern_deps();
+  app_build_turbo();
+
+  bitset_clr(app.pins_active, pin);
+  bitset_clr(app.pins_tern, pin);
+  bitset_clr(app.pins_retrigger, pin);
+  bitset_clr(app.pins_active_prev, pin);
+  bitset_clr(app.pins_chord, pin);
+  bitset_clr(app.pins_in_combo, pin);
+  enter_critical();
+  // restart debouncing, an already pressed pin retriggers
+  bitset_clr((u32_t *)app.irq_cur_active, pin);
+  bitset_set(app.irq_unsettled, pin);
+  exit_critical();
+
+  if (cfg->layer == 0) {
+    // joystick directions of pin may have changed
+    app_build_motions();
+  }
+  app_update_dev_pins(pin);
+  return TRUE;
+}
+u8_t APP_cfg_get_pin(u8_t layer, u8_t pin, def_config *cfg) {
+  memset(cfg, 0, sizeof(def_config));
+  int slot = app_find_slot(layer, pin);
+  if (slot < 0 || app.pin_defs[slot].len == 0) {
+    return 0;
+  }
+  const pin_def *p = &app.pin_defs[slot];
+  cfg->pin = pin + 1;
+  cfg->layer = layer;
+  cfg->tern_pin = p->tern_pin;
+  cfg->tern_splice = p->tern_splice;
+  memcpy(cfg->id, &app.def_pool[p->offs], p->len * sizeof(hid_id));
+  return p->len;
+}
+u8_t APP_cfg_get_combo(u8_t combo, def_config *cfg) {
+  memset(cfg, 0, sizeof(def_config));
+  if (combo >= APP_CONFIG_COMBOS || app.combos[combo].pins == 0) {
+    return 0;
+  }
+  const pin_def *p = &app.pin_defs[COMBO_SLOT(combo)];
+  int pin, i = 0;
+  for (pin = bitset_next(app.combos[combo].mask, NULL, PIN_WORDS, 0);
+      pin >= 0 && i < APP_CONFIG_COMBO_PINS;
+      pin = bitset_next(app.combos[combo].mask, NULL, PIN_WORDS, pin + 1), i++) {
+    if (i == 0) {
+      cfg->pin = pin + 1;
+    } else {
+      cfg->combo[i-1] = pin + 1;
+    }
+  }
+  memcpy(cfg->id, &app.def_pool[p->offs], p->len * sizeof(hid_id));
+  return p->len;
+}
+u8_t APP_cfg_get_combo_usage(void) {
+  return app.combo_cnt;
+}
+u8_t APP_cfg_get_motion(u8_t motion, def_config *cfg) {
+  memset(cfg, 0, sizeof(def_config));
+  if (motion >= APP_CONFIG_MOTIONS || app.motions[motion].steps[0] == 0) {
+    return 0;
+  }
+  const pin_def *p = &app.pin_defs[MOTION_SLOT(motion)];
+  memcpy(cfg->motion, app.motions[motion].steps, sizeof(cfg->motion));
+  cfg->motion_ms = app.motions[motion].step_ms;
+  cfg->motion_joystick = app.motions[motion].joystick;
+  memcpy(cfg->id, &app.def_pool[p->offs], p->len * sizeof(hid_id));
+  return p->len;
+}
+u8_t APP_cfg_get_motion_usage(void) {
+  return app.motion_cnt;
+}
+void APP_cfg_set_combo_window_ms(u8_t ms) {
+  app.combo_window_ms = ms;
+}
+u8_t APP_cfg_get_combo_window_ms(void) {
+  return app.combo_window_ms;
+}
+void APP_cfg_set_turbo_duty(u8_t percent) {
+  app.turbo_duty = MAX(1, MIN(99, percent));
+}
+u8_t APP_cfg_get_turbo_duty(void) {
+  return app.turbo_duty;
+}
+void APP_cfg_set_usb_personality(usb_personality p) {
+  app.usb_personality = p == USB_ARC_SINGLE ? USB_ARC_SINGLE : USB_ARC_COMPOSITE;
+}
+usb_personality APP_cfg_get_usb_personality(void) {
+  return app.usb_personality;
+}
+void APP_cfg_set_usb_latency(bool on) {
+  app.usb_latency = on;
+}
+bool APP_cfg_get_usb_latency(void) {
+  return app.usb_latency;
+}
+void APP_cfg_set_layer(u8_t layer, u8_t pin, app_layer_mode mode) {
+  if (layer == 0 || layer >= APP_CONFIG_LAYERS) return;
+  if (mode > LAYER_ONESHOT || pin > APP_CONFIG_PINS) mode = LAYER_OFF;
+  app.layer_sels[layer].pin = mode == LAYER_OFF ? 0 : pin;
+  app.layer_sels[layer].mode = mode == LAYER_OFF || pin == 0 ? LAYER_OFF : mode;
+  u8_t bit = 1 << layer;
+  app.layers_held &= ~bit;
+  app.layers_toggled &= ~bit;
+  app.layers_oneshot &= ~bit;
+  app_layer_resolve();
+}
+app_layer_mode APP_cfg_get_layer(u8_t layer, u8_t *pin) {
+  *pin = app.layer_sels[layer].pin;
+  return app.layer_sels[layer].mode;
+}
+u8_t APP_get_layer(void) {
+  return app.layer;
+}
+u16_t APP_cfg_get_def_pool_usage(void) {
+  return app.def_pool_used;
+}
+u8_t APP_cfg_get_layer_def_usage(void) {
+  u8_t used = 0;
+  int s;
+  for (s = 0; s < APP_CONFIG_LAYER_DEFS; s++) {
+    if (app.slot_layer[s]) used++;
+  }
+  return used;
+}
+bool APP_cfg_set_gpio_map(const gpio_pin_map *map) {
+  if (GPIO_MAP_check_pin_map(map) >= 0) {
+    return FALSE;
+  }
+  const gpio_pin_map *cur = GPIO_MAP_get_pin_map();
+  int i, j;
+  app.lock_gpio_sampling = TRUE;
+  __DMB();
+  // release gpios not mapped anymore
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    bool keep = FALSE;
+    for (j = 0; !keep && j < APP_CONFIG_GPIO_PINS; j++) {
+      keep = cur[i].port == map[j].port && cur[i].pin == map[j].pin;
+    }
+    if (!keep) PROC_config_input(&cur[i], FALSE);
+  }
+  GPIO_MAP_set_pin_map(map);
+  cur = GPIO_MAP_get_pin_map();
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    PROC_config_input(&cur[i], TRUE);
+  }
+  app.sample_cycles_max = 0;
+  app.lock_gpio_sampling = FALSE;
+  __DMB();
+  return TRUE;
+}
+void APP_get_sample_cycles(u32_t *last, u32_t *max) {
+  *last = app.sample_cycles_last;
+  *max = app.sample_cycles_max;
+}
+void APP_get_event_stats(u32_t *overflows, u16_t *max_fill, u16_t *fill) {
+  *overflows = app.evq_overflows;
+  *max_fill = app.evq_max_fill;
+  *fill = app.evq_head - app.evq_tail;
+}
+void APP_clear_event_stats(void) {
+  app.evq_overflows = 0;
+  app.evq_max_fill = 0;
+}
+void APP_get_mouse_stats(app_mouse_stats *stats) {
+  memcpy(stats, &app.mouse_stats, sizeof(app_mouse_stats));
+}
+void APP_clear_mouse_stats(void) {
+  memset(&app.mouse_stats, 0, sizeof(app_mouse_stats));
+}
+void APP_get_suspend_stats(app_suspend_stats *stats) {
+  memcpy(stats, &app.suspend_stats, sizeof(app_suspend_stats));
+}
+void APP_clear_suspend_stats(void) {
+  u8_t wake_pins = app.suspend_stats.wake_pins;
+  u8_t unarmed_pins = app.suspend_stats.unarmed_pins;
+  memset(&app.suspend_stats, 0, sizeof(app_suspend_stats));
+  app.suspend_stats.wake_pins = wake_pins;
+  app.suspend_stats.unarmed_pins = unarmed_pins;
+}
+void APP_get_latched_presses(u32_t counts[4]) {
+  int dev;
+  for (dev = 0; dev < DEVICES; dev++) {
+    counts[dev] = app.devs[dev].latched_presses;
+  }
+}
+void APP_clear_latched_presses(void) {
+  int dev;
+  for (dev = 0; dev < DEVICES; dev++) {
+    app.devs[dev].latched_presses = 0;
+  }
+}
+void APP_cfg_set_latch_mask(u8_t mask) {
+  app.latch_mask = mask;
+  int dev;
+  for (dev = 0; dev < DEVICES; dev++) {
+    app.devs[dev].latch = (mask & (1 << dev)) != 0;
+    if (!app.devs[dev].latch) {
+      memset(app.latched[dev], 0, sizeof(app.latched[dev]));
+    }
+  }
+}
+u8_t APP_cfg_get_latch_mask(void) {
+  return app.latch_mask;
+}
+void APP_cfg_set_socd(u8_t joystick, app_socd_mode mode, bool four_way) {
+  if (joystick > JOYSTICK2 || mode > SOCD_FIRST) return;
+  app.socd_mode[joystick] = mode;
+  if (four_way) {
+    app.socd_4way |= (1 << joystick);
+  } else {
+    app.socd_4way &= ~(1 << joystick);
+  }
+}
+app_socd_mode APP_cfg_get_socd(u8_t joystick, bool *four_way) {
+  *four_way = (app.socd_4way & (1 << joystick)) != 0;
+  return app.socd_mode[joystick];
+}
+void APP_cfg_set_tern_release_first(bool release_first) {
+  app.tern_release_first = release_first;
+}
+bool APP_cfg_get_tern_release_first(void) {
+  return app.tern_release_first;
+}
+void APP_cfg_set_min_hold_ms(u8_t ms) {
+  app.min_hold_ms = ms;
+}
+u8_t APP_cfg_get_min_hold_ms(void) {
+  return app.min_hold_ms;
 }
 void APP_cfg_set_debounce_cycles(u8_t cycles) {
   app.debounce_valid_cycles = cycles;
@@ -831,39 +2781,128 @@ void APP_cfg_set_joystick_acc_speed(u16_t speed) {
 u16_t APP_cfg_get_joystick_acc_speed(void) {
   return app.acc_joystick_speed;
 }
+bool APP_cfg_set_acc_curve(app_acc acc, const vel_curve *curve) {
+  if (acc >= _ACC_CNT) return FALSE;
+  bool ok = VEL_build_lut(curve, app.acc_luts[acc]);
+  if (ok) {
+    memcpy(&app.acc_curves[acc], curve, sizeof(vel_curve));
+  } else {
+    memset(&app.acc_curves[acc], 0, sizeof(vel_curve));
+  }
+  return ok;
+}
+void APP_cfg_get_acc_curve(app_acc acc, vel_curve *curve) {
+  memcpy(curve, &app.acc_curves[acc % _ACC_CNT], sizeof(vel_curve));
+}
+
+#ifndef CONFIG_ANNOYATRON
+static GPIO_TypeDef * const app_gpio_ports[GPIO_MAP_PORTS] = {
+    GPIOA, GPIOB, GPIOC, GPIOD, GPIOE
+};
+
+// samples all pins into given bitset, set = active
+static void app_sample_pins(u32_t *raw) {
+  u32_t idr[GPIO_MAP_PORTS];
+  int i;
+  u8_t op_cnt;
+  const gpio_map_sample_op *op = GPIO_MAP_get_sample_ops(&op_cnt);
+
+  memset(raw, 0, PIN_WORDS * sizeof(u32_t));
+  // read each port of board once, inverted as pins are active low
+  for (i = 0; i < GPIO_MAP_PORTS; i++) {
+    if (BOARD_GPIO_PORTS & (1 << i)) {
+      idr[i] = ~app_gpio_ports[i]->IDR;
+    }
+  }
+  // extract runs of gpio bits, as derived from pin map
+  for (i = 0; i < op_cnt; i++, op++) {
+    raw[op->dst >> 5] |= ((idr[op->port] >> op->src) & op->mask) << (op->dst & 31);
+  }
+#ifdef CONFIG_IO_EXP
+  // expander states as of last INT triggered read, merged before debouncing
+  for (i = 0; i < IO_EXP_DEVICES; i++) {
+    u32_t exp_state = IO_EXP_get_state(i);
+    int pin = APP_CONFIG_GPIO_PINS + i * IO_EXP_PINS_PER_DEVICE;
+    raw[pin >> 5] |= exp_state << (pin & 31);
+    if ((pin & 31) > 32 - IO_EXP_PINS_PER_DEVICE) {
+      raw[(pin >> 5) + 1] |= exp_state >> (32 - (pin & 31));
+    }
+  }
+#endif
+}
+
+// queues a debounced pin edge, called from APP_timer, or with it stopped
+static void app_event_push(u8_t pin, bool active, u32_t ts_us) {
+  u16_t head = app.evq_head;
+  u16_t fill = head - app.evq_tail;
+  if (fill >= APP_CONFIG_EVENT_QUEUE) {
+    app.evq_overflows++;
+    app.evq_resync = TRUE;
+    return;
+  }
+  pin_event *e = &app.evq[head & (APP_CONFIG_EVENT_QUEUE - 1)];
+  e->ts_us = ts_us;
+  e->pin = pin;
+  e->active = active;
+  __DMB();
+  app.evq_head = head + 1;
+  if (fill + 1 > app.evq_max_fill) app.evq_max_fill = fill + 1;
+}
+
+// debounces sampled pins and queues an event per debounced edge, returns true
+// if any edge was queued. Only pins that recently changed are visited, stable
+// pins cost nothing.
+static bool app_debounce_pins(const u32_t *raw, u32_t ts_us) {
+  bool any_changes = FALSE;
+  int w;
+  for (w = 0; w < PIN_WORDS; w++) {
+    u32_t changed = raw[w] ^ app.irq_raw[w];
+    u32_t unsettled = app.irq_unsettled[w] | changed;
+    u32_t settled = 0;
+    app.irq_raw[w] = raw[w];
+    while (unsettled) {
+      int bit = bitset_lowest(unsettled);
+      u32_t m = 1UL << bit;
+      int pin = (w << 5) + bit;
+      unsettled &= ~m;
+      if (changed & m) {
+        app.irq_same_state[pin] = 0;
+      } else if (app.irq_same_state[pin] < app.debounce_valid_cycles) {
+        app.irq_same_state[pin]++;
+      } else {
+        // pin same state given nbr of cycles, now triggered
+        settled |= m;
+      }
+    }
+    app.irq_unsettled[w] = (app.irq_unsettled[w] | changed) & ~settled;
+    u32_t edges = (app.irq_cur_active[w] ^ raw[w]) & settled;
+    app.irq_cur_active[w] ^= edges;
+    while (edges) {
+      int bit = bitset_lowest(edges);
+      edges &= ~(1UL << bit);
+      app_event_push((w << 5) + bit, (raw[w] >> bit) & 1, ts_us);
+      any_changes = TRUE;
+    }
+  }
+  return any_changes || app.evq_resync;
+}
+#endif // CONFIG_ANNOYATRON
 
 void APP_timer(void) {
   if (app_init) {
 #ifndef CONFIG_ANNOYATRON
     // input read
     if (!app.lock_gpio_sampling) {
-      int pin;
-      const gpio_pin_map *map = GPIO_MAP_get_pin_map();
+      u32_t raw[PIN_WORDS];
+      u32_t now = TIMER_get_us();
+      u32_t cycles = TIMER_get_cycles();
+      app_sample_pins(raw);
+      cycles = TIMER_get_cycles() - cycles;
+      app.sample_cycles_last = cycles;
+      app.sample_cycles_max = MAX(app.sample_cycles_max, cycles);
 
       // debouncer
-      bool any_changes = FALSE;
-      for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
-        bool pin_active = gpio_get(map[pin].port, map[pin].pin) == 0;
-
-        if (pin_active == app.irq_debounce_map[pin].pin_active) {
-          if (app.irq_debounce_map[pin].same_state < app.debounce_valid_cycles) {
-            app.irq_debounce_map[pin].same_state++;
-          } else {
-            if (app.irq_cur_pin_active[pin] != pin_active) {
-              // pin same state given nbr of cycles, now triggered
-              app.irq_cur_pin_active[pin] = pin_active;
-            }
-          }
-        } else {
-          app.irq_debounce_map[pin].pin_active = pin_active;
-          app.irq_debounce_map[pin].same_state = 0;
-        }
-
-        if (app.irq_cur_pin_active[pin] != (app.pin_state[pin] != PIN_INACTIVE)) {
-          any_changes = TRUE;
-          //print("pin %i trig\n", pin);
-        }
-      }
+      bool any_changes = app_debounce_pins(raw, now);
 
       // post change
       if (!app.dirty_gpio && any_changes) {
@@ -873,22 +2912,30 @@ void APP_timer(void) {
         TASK_run(t, 0, NULL);
       }
     }
+
+    // application timers tick once per millisecond
+    time now_ms = SYS_get_time_ms();
+    if (now_ms != app.wheel_irq_ms) {
+      app.wheel_irq_ms = now_ms;
+      app.wheel_ticks++;
+      if (!app.wheel_posted && WHEEL_count() > 0) {
+        app.wheel_posted = TRUE;
+        task *t = TASK_create(app_wheel_msg, 0);
+        ASSERT(t);
+        TASK_run(t, 0, NULL);
+      }
+#ifdef CONFIG_IO_EXP
+      IO_EXP_timer();
+#endif
+    }
 #endif // CONFIG_ANNOYATRON
   }
   // led blink
   const gpio_pin_map *led = GPIO_MAP_get_led_map();
-  if (SYS_get_time_ms() % 1000 > 0) {
-#ifdef CONFIG_HY_TEST_BOARD
-    gpio_disable(led->port, led->pin);
-#else
+  if ((SYS_get_time_ms() % 1000 > 0) != BOARD_LED_ACTIVE_LOW) {
     gpio_enable(led->port, led->pin);
-#endif
   } else {
-#ifdef CONFIG_HY_TEST_BOARD
-    gpio_enable(led->port, led->pin);
-#else
     gpio_disable(led->port, led->pin);
-#endif
   }
 }
 
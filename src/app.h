@@ -10,11 +10,187 @@
 
 #include "system.h"
 #include "def_config.h"
+#include "gpio_map.h"
+#include "velocity.h"
+#include "usb_arcade.h"
+
+typedef enum {
+  LAYER_OFF = 0,
+  LAYER_HOLD,       // layer active while pin is held
+  LAYER_TOGGLE,     // pin press toggles layer
+  LAYER_ONESHOT,    // layer active for next press of another pin
+} app_layer_mode;
+
+// resolving of opposite joystick directions held at the same time
+typedef enum {
+  SOCD_LAST = 0,    // direction pressed last wins
+  SOCD_NEUTRAL,     // opposite directions cancel out
+  SOCD_FIRST,       // direction pressed first wins
+} app_socd_mode;
+
+// acceleration curves, per device axis. Mouse axes follow the position
+// accelerator, the wheel its own, joystick axes the joystick accelerator.
+typedef enum {
+  ACC_MOUSE_X = 0,
+  ACC_MOUSE_Y,
+  ACC_MOUSE_WHEEL,
+  ACC_JOY1_X,
+  ACC_JOY1_Y,
+  ACC_JOY2_X,
+  ACC_JOY2_Y,
+  _ACC_CNT
+} app_acc;
+
+// mouse reports, index 0 holding buttons only, index 1 moving
+typedef struct {
+  u32_t reports[2];   // reports sent
+  u32_t ms[2];        // time active
+  u32_t suppressed;   // reports not sent being same as last and not moving
+} app_mouse_stats;
+
+// usb suspend, times by rtc
+typedef struct {
+  u32_t suspends;         // bus suspended by host
+  u32_t suspend_ms;       // time suspended
+  u32_t stop_ms;          // time of that in stop mode
+  u32_t wakeups;          // remote wakeups signalled on a press
+  u32_t missed;           // wakeup presses not in a report within a second
+  u32_t latency_us;       // last wakeup to first report transmitted
+  u32_t latency_us_max;
+  u8_t wake_pins;         // gpio pins waking at last suspend
+  u8_t unarmed_pins;      // gpio pins sharing exti line with a waking pin
+} app_suspend_stats;
 
 void APP_init(void);
 void APP_timer(void);
-void APP_cfg_set_pin(def_config *cfg);
-def_config *APP_cfg_get_pin(u8_t pin);
+/**
+ * Called from main loop when no tasks are queued. While usb is suspended,
+ * stops the cpu until an interrupt and returns TRUE. Otherwise returns
+ * FALSE at once.
+ */
+bool APP_idle(void);
+/**
+ * Sets definitions of pin cfg->pin on layer cfg->layer, of the combo of
+ * cfg->pin and cfg->combo pins if any, or of the motion of cfg->motion steps
+ * if any. Returns FALSE if definition pool, layer definitions, combos or
+ * motions would overflow, or if cfg is invalid, leaving the pin unchanged.
+ */
+bool APP_cfg_set_pin(def_config *cfg);
+/**
+ * Fills cfg with definitions of pin (zero based) on layer. Returns number of
+ * definitions, if zero cfg->pin is also zero.
+ */
+u8_t APP_cfg_get_pin(u8_t layer, u8_t pin, def_config *cfg);
+/**
+ * Removes definitions of all pins on all layers.
+ */
+void APP_cfg_clear_pins(void);
+u16_t APP_cfg_get_def_pool_usage(void);
+u8_t APP_cfg_get_layer_def_usage(void);
+/**
+ * Fills cfg with definitions of combo index. Returns number of definitions,
+ * if zero the combo is unused.
+ */
+u8_t APP_cfg_get_combo(u8_t combo, def_config *cfg);
+u8_t APP_cfg_get_combo_usage(void);
+/**
+ * Fills cfg with definitions of motion index. Returns number of definitions,
+ * if zero the motion is unused.
+ */
+u8_t APP_cfg_get_motion(u8_t motion, def_config *cfg);
+u8_t APP_cfg_get_motion_usage(void);
+/**
+ * Sets time all pins of a combo must be pressed within to trigger the combo
+ * instead of the single pins, 0 disables combos. Presses of pins part of a
+ * combo are delayed at most this long.
+ */
+void APP_cfg_set_combo_window_ms(u8_t ms);
+u8_t APP_cfg_get_combo_window_ms(void);
+/**
+ * Sets percent of a turbo period, 1-99, that turbo keys and buttons are
+ * reported pressed.
+ */
+void APP_cfg_set_turbo_duty(u8_t percent);
+u8_t APP_cfg_get_turbo_duty(void);
+/**
+ * Sets how devices are presented over usb, effective at next boot.
+ */
+void APP_cfg_set_usb_personality(usb_personality p);
+usb_personality APP_cfg_get_usb_personality(void);
+/**
+ * Sets if the usb latency interface, sending timing records of transmitted
+ * reports, is presented, effective at next boot.
+ */
+void APP_cfg_set_usb_latency(bool on);
+bool APP_cfg_get_usb_latency(void);
+/**
+ * Sets pin (one based) selecting layer 1 to APP_CONFIG_LAYERS-1, or
+ * LAYER_OFF to have no select pin. When several layers are selected
+ * the highest wins. A pressed pin keeps the definitions of the layer it
+ * was pressed on until released.
+ */
+void APP_cfg_set_layer(u8_t layer, u8_t pin, app_layer_mode mode);
+app_layer_mode APP_cfg_get_layer(u8_t layer, u8_t *pin);
+/**
+ * Sets how opposite directions held at the same time are resolved for
+ * joystick 0 or 1, by their press times. If four_way is set a diagonal keeps
+ * the direction pressed last only, for maze games.
+ */
+void APP_cfg_set_socd(u8_t joystick, app_socd_mode mode, bool four_way);
+app_socd_mode APP_cfg_get_socd(u8_t joystick, bool *four_way);
+u8_t APP_get_layer(void);
+/**
+ * Remaps logical gpio pins to given map of APP_CONFIG_GPIO_PINS entries and
+ * reconfigures the gpios. Returns FALSE if map is bad.
+ */
+bool APP_cfg_set_gpio_map(const gpio_pin_map *map);
+/**
+ * Returns cpu cycles spent sampling gpios, last sample and max since
+ * last remap.
+ */
+void APP_get_sample_cycles(u32_t *last, u32_t *max);
+/**
+ * Returns pin event queue statistics, number of lost events, max and
+ * current number of queued events.
+ */
+void APP_get_event_stats(u32_t *overflows, u16_t *max_fill, u16_t *fill);
+void APP_clear_event_stats(void);
+/**
+ * Returns mouse report statistics, reports per second are reports per
+ * active time.
+ */
+void APP_get_mouse_stats(app_mouse_stats *stats);
+void APP_clear_mouse_stats(void);
+/**
+ * Returns usb suspend statistics. Latency counts from clocks restored after
+ * the wakeup press until the host has polled a report.
+ */
+void APP_get_suspend_stats(app_suspend_stats *stats);
+void APP_clear_suspend_stats(void);
+/**
+ * Returns number of presses released before a report with them was
+ * transmitted, for keyboard, mouse, joystick 1 and joystick 2.
+ */
+void APP_get_latched_presses(u32_t counts[4]);
+void APP_clear_latched_presses(void);
+/**
+ * Sets which devices latch presses until transmitted in a report, bit 0
+ * keyboard, bit 1 mouse, bit 2 joystick 1, bit 3 joystick 2.
+ */
+void APP_cfg_set_latch_mask(u8_t mask);
+u8_t APP_cfg_get_latch_mask(void);
+/**
+ * Sets how a held pin switches definitions when its ternary pin changes,
+ * FALSE swaps in one report, TRUE first reports old definitions released.
+ */
+void APP_cfg_set_tern_release_first(bool release_first);
+bool APP_cfg_get_tern_release_first(void);
+/**
+ * Sets minimum time a press is kept in reports before its release is
+ * reported, 0 for at least one report.
+ */
+void APP_cfg_set_min_hold_ms(u8_t ms);
+u8_t APP_cfg_get_min_hold_ms(void);
 void APP_cfg_set_debounce_cycles(u8_t cycles);
 u8_t APP_cfg_get_debounce_cycles(void);
 void APP_cfg_set_mouse_delta_ms(time ms);
@@ -27,5 +203,11 @@ void APP_cfg_set_joystick_delta_ms(time ms);
 time APP_cfg_get_joystick_delta_ms(void);
 void APP_cfg_set_joystick_acc_speed(u16_t speed);
 u16_t APP_cfg_get_joystick_acc_speed(void);
+/**
+ * Sets acceleration curve of accelerator, tabulated at once. Returns FALSE
+ * if user points are bad, in which case a linear curve is used.
+ */
+bool APP_cfg_set_acc_curve(app_acc acc, const vel_curve *curve);
+void APP_cfg_get_acc_curve(app_acc acc, vel_curve *curve);
 
 #endif /* APP_H_ */
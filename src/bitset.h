@@ -0,0 +1,67 @@
+/*
+ * bitset.h
+ *
+ * Packed bitsets of 32 bit words, one bit per pin. Iteration over set bits
+ * is count leading zeros based (rbit + clz on cortex m3), so cost scales
+ * with number of set bits rather than number of pins.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef SRC_BITSET_H_
+#define SRC_BITSET_H_
+
+#include "system.h"
+
+#define BITSET_WORDS(bits)    (((bits) + 31) / 32)
+
+static inline void bitset_set(u32_t *bs, int bit) {
+  bs[bit >> 5] |= (1UL << (bit & 31));
+}
+
+static inline void bitset_clr(u32_t *bs, int bit) {
+  bs[bit >> 5] &= ~(1UL << (bit & 31));
+}
+
+static inline bool bitset_get(const u32_t *bs, int bit) {
+  return (bs[bit >> 5] & (1UL << (bit & 31))) != 0;
+}
+
+static inline void bitset_put(u32_t *bs, int bit, bool val) {
+  if (val) {
+    bitset_set(bs, bit);
+  } else {
+    bitset_clr(bs, bit);
+  }
+}
+
+static inline bool bitset_any(const u32_t *bs, int words) {
+  while (words--) {
+    if (*bs++) return TRUE;
+  }
+  return FALSE;
+}
+
+// lowest set bit in word, word must not be zero
+static inline int bitset_lowest(u32_t w) {
+  return __builtin_ctz(w);
+}
+
+/**
+ * Returns index of first set bit in bs & mask at or after given bit, or
+ * -1 if none. Pass mask NULL to search bs only. Iterate with
+ *   for (b = bitset_next(bs, m, W, 0); b >= 0; b = bitset_next(bs, m, W, b+1))
+ */
+static inline int bitset_next(const u32_t *bs, const u32_t *mask, int words, int bit) {
+  int w = bit >> 5;
+  if (w >= words) return -1;
+  u32_t v = bs[w] & (mask ? mask[w] : ~0UL) & (~0UL << (bit & 31));
+  while (v == 0) {
+    if (++w >= words) return -1;
+    v = bs[w] & (mask ? mask[w] : ~0UL);
+  }
+  return (w << 5) + bitset_lowest(v);
+}
+
+#endif /* SRC_BITSET_H_ */
@@ -0,0 +1,54 @@
+/*
+ * board.h
+ *
+ * Selects the board description. Each board is described in one header,
+ * board_<name>.h, which must define
+ *
+ *   BOARD_NAME                  string
+ *   BOARD_PINS(X)               X(port, pin) per gpio pin, in pin order;
+ *                               X(GPIO_MAP_UNUSED_PORT, 0) for a hole
+ *   BOARD_LED_PORT/_PIN         status led
+ *   BOARD_LED_ACTIVE_LOW        1 if led lights when driven low
+ *   BOARD_USB_CABLE_PORT/_PIN   usb dp pullup control
+ *   BOARD_USB_CABLE_ACTIVE_LOW  1 if pullup is enabled by driving low,
+ *                               0 if enabled by driving high and released
+ *                               by floating the gpio
+ *   BOARD_SWJ_JTAG_DISABLE      1 to free PB3, PB4, PA15 from jtag, else
+ *                               they cannot be mapped to pins
+ *
+ * Build another board with `make BOARD=<name>`. Everything else, pin
+ * count, port clocks and sampling, is derived from the description here.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef SRC_BOARD_H_
+#define SRC_BOARD_H_
+
+#ifndef CONFIG_BOARD_FILE
+#define CONFIG_BOARD_FILE "board_arcade.h"
+#endif
+#include CONFIG_BOARD_FILE
+
+// for pins on PB6, PB7 which I2C1 takes when having io expanders
+#ifdef CONFIG_IO_EXP
+#define BOARD_PIN_NO_IO_EXP(X, port, pin) X(GPIO_MAP_UNUSED_PORT, 0)
+#else
+#define BOARD_PIN_NO_IO_EXP(X, port, pin) X(port, pin)
+#endif
+
+#define _BOARD_COUNT(port, pin)     +1
+#define _BOARD_PORT_BIT(port, pin)  | ((port) != GPIO_MAP_UNUSED_PORT ? (1 << (port)) : 0)
+
+// number of gpio pins, usable in #if
+#define BOARD_GPIO_PINS             (0 BOARD_PINS(_BOARD_COUNT))
+
+// bitmask of gpio ports to clock and sample, (1 << PORTx). PORTA and PORTB
+// are always used by uart, usb, swd and i2c.
+#define BOARD_GPIO_PORTS            ((1 << PORTA) | (1 << PORTB) \
+    BOARD_PINS(_BOARD_PORT_BIT) \
+    _BOARD_PORT_BIT(BOARD_LED_PORT, BOARD_LED_PIN) \
+    _BOARD_PORT_BIT(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN))
+
+#endif /* SRC_BOARD_H_ */
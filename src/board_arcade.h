@@ -0,0 +1,53 @@
+/*
+ * board_arcade.h
+ *
+ * The arcadehid board, STM32F103C8 minimum system board.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef SRC_BOARD_ARCADE_H_
+#define SRC_BOARD_ARCADE_H_
+
+#define BOARD_NAME                  "arcade"
+
+#define BOARD_PINS(X) \
+  X(PORTB, PIN12)   /* 1 */ \
+  X(PORTB, PIN13)   /* 2 */ \
+  X(PORTB, PIN14)   /* 3 */ \
+  X(PORTB, PIN15)   /* 4 */ \
+  X(PORTA, PIN8)    /* 5 */ \
+  X(PORTA, PIN9)    /* 6 */ \
+  X(PORTA, PIN10)   /* 7 */ \
+  X(PORTA, PIN15)   /* 8 */ \
+  X(PORTB, PIN3)    /* 9 */ \
+  X(PORTB, PIN4)    /* 10 */ \
+  X(PORTB, PIN5)    /* 11 */ \
+  BOARD_PIN_NO_IO_EXP(X, PORTB, PIN6)   /* 12 */ \
+  BOARD_PIN_NO_IO_EXP(X, PORTB, PIN7)   /* 13 */ \
+  X(PORTB, PIN11)   /* 14 */ \
+  X(PORTB, PIN10)   /* 15 */ \
+  X(PORTB, PIN2)    /* 16 */ \
+  X(PORTB, PIN1)    /* 17 */ \
+  X(PORTB, PIN0)    /* 18 */ \
+  X(PORTA, PIN7)    /* 19 */ \
+  X(PORTA, PIN6)    /* 20 */ \
+  X(PORTA, PIN5)    /* 21 */ \
+  X(PORTA, PIN4)    /* 22 */ \
+  X(PORTA, PIN1)    /* 23 */ \
+  X(PORTA, PIN0)    /* 24 */ \
+  X(PORTC, PIN14)   /* 25 */ \
+  X(PORTC, PIN13)   /* 26 */
+
+#define BOARD_LED_PORT              PORTC
+#define BOARD_LED_PIN               PIN15
+#define BOARD_LED_ACTIVE_LOW        0
+
+#define BOARD_USB_CABLE_PORT        PORTB
+#define BOARD_USB_CABLE_PIN         PIN9
+#define BOARD_USB_CABLE_ACTIVE_LOW  0
+
+#define BOARD_SWJ_JTAG_DISABLE      1
+
+#endif /* SRC_BOARD_ARCADE_H_ */
@@ -0,0 +1,31 @@
+/*
+ * board_hy_test.h
+ *
+ * HY-STM32 development board, for testing.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef SRC_BOARD_HY_TEST_H_
+#define SRC_BOARD_HY_TEST_H_
+
+#define BOARD_NAME                  "hy_test"
+
+#define BOARD_PINS(X) \
+  X(PORTE, PIN2)    /* 1 */ \
+  X(PORTE, PIN3)    /* 2 */ \
+  X(PORTE, PIN4)    /* 3 */ \
+  X(PORTE, PIN5)    /* 4 */
+
+#define BOARD_LED_PORT              PORTC
+#define BOARD_LED_PIN               PIN6
+#define BOARD_LED_ACTIVE_LOW        1
+
+#define BOARD_USB_CABLE_PORT        PORTC
+#define BOARD_USB_CABLE_PIN         PIN13
+#define BOARD_USB_CABLE_ACTIVE_LOW  1
+
+#define BOARD_SWJ_JTAG_DISABLE      0
+
+#endif /* SRC_BOARD_HY_TEST_H_ */
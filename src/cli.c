@@ -24,6 +24,8 @@
 #include "usb/usb_arc_codes.h"
 
 #include "niffs_impl.h"
+#include "io_exp.h"
+#include "wheel.h"
 
 #ifdef CONFIG_ANNOYATRON
 #include "app_annoyatron.h"
@@ -61,8 +63,31 @@ static int f_cfg_acc_pos_speed(u16_t speed);
 static int f_cfg_acc_whe_speed(u16_t speed);
 static int f_cfg_joy_delta(u8_t ms);
 static int f_cfg_joy_acc_speed(u16_t speed);
+static int f_cfg_min_hold(u8_t ms);
+static int f_cfg_latch(u8_t mask);
+static int f_cfg_tern_release(u8_t release_first);
+static int f_cfg_combo_window(u8_t ms);
+static int f_cfg_turbo_duty(u8_t percent);
+static int f_cfg_usb_mode(char *mode);
+static int f_cfg_usb_latency(u8_t on);
+
+static int f_events(char *cmd);
+static int f_timers(char *cmd);
+static int f_mouse_stats(char *cmd);
+static int f_suspend_stats(char *cmd);
+
+static int f_pinmap(int pin, char *gpio);
+static int f_layer(int layer, int pin, char *mode);
+static int f_socd(int joystick, char *mode, char *ways);
+static int f_acc_curve(char *acc, char *type);
+static void print_acc_curve(app_acc acc);
+
+#ifdef CONFIG_IO_EXP
+static int f_io_exp(char *cmd);
+#endif
 
 static int f_usb_enable(int ena);
+static int f_usb_info(void);
 static int f_usb_keyboard_test(void);
 
 static int f_fs_mount(void);
@@ -120,7 +145,9 @@ static void cli_print_app_name(void);
 static cmd c_tbl[] = {
     { .name = "def", .fn = (func) f_def_dummy, .dbg = FALSE,
         .help = "Define a pins function\n"
-            "Syntax: def pin<x> = [(def)* | pin<y> ? (def)* : (def)*]\n"
+            "Syntax: def (layer<n>) pin<x> = [(def)* | pin<y> ? (def)* : (def)*]\n"
+            "        def pin<x>+pin<y>(+pin<z>..) = (def)*\n"
+            "        def motion(<1-9 | pin<y>>* (<ms>ms) (joy<1-2>)) = (def)*\n"
             "ex: define pin 1 to send keyboard character A\n"
             "    def pin1 = a\n"
             "ex: define pin 2 to move mouse up\n"
@@ -129,6 +156,17 @@ static cmd c_tbl[] = {
             "    def pin3 = pin4 ? mouse_x(1) : mouse_x(-1)\n\n"
             "ex: define pin 5 to send keyboard sequence CTRL+ALT+DEL\n"
             "    def pin5 = LEFT_CTRL LEFT_ALT DELETE\n"
+            "ex: define pin 5 to send B on layer 1, see command layer\n"
+            "    def layer1 pin5 = b\n"
+            "ex: define pins 1 and 2 pressed together to send ESCAPE, see set_combo_window\n"
+            "    def pin1+pin2 = ESCAPE\n"
+            "ex: define pin 6 to autofire joystick button 1, see set_turbo_duty\n"
+            "    def pin6 = JOY1_BUTTON1(turbo 15hz)\n"
+            "ex: define joystick 1 quarter circle down to right, numpad notation, and pin 5 to\n"
+            "    press F1, steps within 150 ms of each other unless given\n"
+            "    def motion(2 3 6 pin5) = F1\n"
+            "ex: define pin 9 to type F2, wait, ENTER, wait and hello, macro_cancel stops on release\n"
+            "    def pin9 = macro(F2 10ms ENTER 50ms \"hello\")\n"
             "To see all possible definitions, use command sym\n"
     },
 
@@ -146,21 +184,125 @@ static cmd c_tbl[] = {
         .help = "Set number of milliseconds between mouse reports <0-255>\n"
     },
     { .name = "set_mouse_pos_acc", .fn = (func) f_cfg_acc_pos_speed, .dbg = FALSE,
-        .help = "Set mouse position accelerator speed (0-65535)\n"
+        .help = "Set mouse position accelerator speed (0-65535), with a linear curve\n"
     },
     { .name = "set_mouse_wheel_acc", .fn = (func) f_cfg_acc_whe_speed, .dbg = FALSE,
-        .help = "Set mouse wheel accelerator speed (0-65535)\n"
+        .help = "Set mouse wheel accelerator speed (0-65535), with a linear curve\n"
     },
     { .name = "set_joy_delta", .fn = (func) f_cfg_joy_delta, .dbg = FALSE,
         .help = "Set number of milliseconds between joystick reports <0-255>\n"
     },
     { .name = "set_joy_acc", .fn = (func) f_cfg_joy_acc_speed, .dbg = FALSE,
-        .help = "Set joystick direction accelerator speed (0-65535)\n"
+        .help = "Set joystick direction accelerator speed (0-65535), with a linear curve\n"
+    },
+    { .name = "set_min_hold", .fn = (func) f_cfg_min_hold, .dbg = FALSE,
+        .help = "Set minimum milliseconds a press stays in reports <0-255>\n"
+            "0 means the press is in at least one report\n"
+    },
+    { .name = "set_latch", .fn = (func) f_cfg_latch, .dbg = FALSE,
+        .help = "Set devices keeping presses until sent to host <0-15>\n"
+            "bit 0 keyboard, 1 mouse, 2 joystick 1, 3 joystick 2\n"
+    },
+    { .name = "set_tern_release", .fn = (func) f_cfg_tern_release, .dbg = FALSE,
+        .help = "Set how a held pin changes output when its ternary pin changes <0-1>\n"
+            "0 - swap to other definitions in one report\n"
+            "1 - report old definitions released before new are pressed\n"
+    },
+    { .name = "set_combo_window", .fn = (func) f_cfg_combo_window, .dbg = FALSE,
+        .help = "Set milliseconds within which all pins of a combo must be pressed <0-255>\n"
+            "0 disables combos\n"
+    },
+    { .name = "set_turbo_duty", .fn = (func) f_cfg_turbo_duty, .dbg = FALSE,
+        .help = "Set percent of a turbo period keys and buttons are pressed <1-99>\n"
+    },
+    { .name = "set_usb_mode", .fn = (func) f_cfg_usb_mode, .dbg = FALSE,
+        .help = "Set how devices are presented over usb, used from next boot\n"
+            "set_usb_mode <composite|single>\n"
+            "composite - one hid interface and endpoint per device\n"
+            "single - one hid interface and 1 ms endpoint for all devices\n"
+            "save config and reset for the change to take effect\n"
+    },
+    { .name = "set_usb_latency", .fn = (func) f_cfg_usb_latency, .dbg = FALSE,
+        .help = "Present a vendor hid interface sending timing of each report <0-1>\n"
+            "used from next boot, needs an endpoint left free by the devices\n"
+            "save config and reset for the change to take effect\n"
+    },
+    { .name = "events", .fn = (func) f_events, .dbg = FALSE,
+        .help = "Display pin event queue and latched press statistics\n"
+            "events (clear)\n"
+            "clear - resets statistics\n"
+    },
+    { .name = "timers", .fn = (func) f_timers, .dbg = FALSE,
+        .help = "Display application timer wheel occupancy and tick cost\n"
+            "timers (clear)\n"
+            "clear - resets statistics\n"
+    },
+    { .name = "mouse_stats", .fn = (func) f_mouse_stats, .dbg = FALSE,
+        .help = "Display mouse reports sent per second holding buttons only and moving\n"
+            "mouse_stats (clear)\n"
+            "clear - resets statistics\n"
+    },
+    { .name = "suspend_stats", .fn = (func) f_suspend_stats, .dbg = FALSE,
+        .help = "Display usb suspend time in stop mode, wakeups and wakeup latency\n"
+            "suspend_stats (clear)\n"
+            "clear - resets statistics\n"
+    },
+
+    { .name = "layer", .fn = (func) f_layer, .dbg = FALSE,
+        .help = "Display layers or set pin selecting a layer\n"
+            "layer (<layer> <pin> <hold|toggle|oneshot>)\n"
+            "layer <layer> off\n"
+            "hold - layer active while pin is held\n"
+            "toggle - pin switches layer on and off\n"
+            "oneshot - layer active for next pressed pin\n"
+            "ex: layer 1 9 hold\n"
+    },
+    { .name = "socd", .fn = (func) f_socd, .dbg = FALSE,
+        .help = "Display or set how opposite joystick directions held together resolve\n"
+            "socd (<joystick 1-2> <last|neutral|first> (4way))\n"
+            "last - direction pressed last wins\n"
+            "neutral - opposite directions cancel out\n"
+            "first - direction pressed first wins\n"
+            "4way - diagonals keep the direction pressed last, for maze games\n"
+            "ex: socd 1 neutral\n"
+    },
+    { .name = "acc_curve", .fn = (func) f_acc_curve, .dbg = FALSE,
+        .help = "Display or set how speed follows an accelerator\n"
+            "acc_curve (<axis> <linear|quadratic|s|points> (<x> <y>)*)\n"
+            "axis - mouse_x, mouse_y, mouse_wheel, joy1_x, joy1_y, joy2_x, joy2_y,\n"
+            "       or mouse_pos, joy1, joy2, joystick for both or all axes\n"
+            "linear - speed grows evenly\n"
+            "quadratic - speed grows slowly first\n"
+            "s - speed grows slowly first and last\n"
+            "points - linear between up to 6 points, x ascending percent of\n"
+            "         accelerator range, y percent of speed\n"
+            "ex: acc_curve mouse_pos points 0 10 50 20 100 100\n"
+            "ex: acc_curve joy1_y quadratic\n"
+    },
+    { .name = "pinmap", .fn = (func) f_pinmap, .dbg = FALSE,
+        .help = "Display or remap gpio pins\n"
+            "pinmap (<pin> <gpio>)\n"
+            "pinmap default\n"
+            "gpio is e.g. PB12, or none to unmap the pin\n"
+            "ex: pinmap 3 PC13\n"
     },
 
+#ifdef CONFIG_IO_EXP
+    { .name = "io_exp", .fn = (func) f_io_exp, .dbg = FALSE,
+        .help = "Display io expander states and read latencies\n"
+            "io_exp (clear)\n"
+            "clear - resets statistics\n"
+    },
+#endif
+
     { .name = "usb_enable", .fn = (func) f_usb_enable, .dbg = FALSE,
         .help = "Enables or disables usb\n"
     },
+    { .name = "usb_info", .fn = (func) f_usb_info, .dbg = FALSE,
+        .help = "Display usb mode, devices presented to host with their endpoints,\n"
+            "latency records with cpu cycles of their bookkeeping, and time from\n"
+            "start until host configured device\n"
+    },
 
     { .name = "usb_test_keyboard", .fn = (func) f_usb_keyboard_test,.dbg = FALSE,
         .help = "Test keys on keyboard\n"
@@ -408,6 +550,10 @@ static int f_sym(void) {
   return 0;
 }
 
+static const char *USB_MODE_NAME[] = {
+    "composite", "single"
+};
+
 static int f_cfg(void) {
   print("pin debounce cycles:                  %i\n", APP_cfg_get_debounce_cycles());
   print("mouse report delta:                   %i ms\n", APP_cfg_get_mouse_delta_ms());
@@ -415,18 +561,285 @@ static int f_cfg(void) {
   print("mouse wheel accelerator speed:        %i\n", APP_cfg_get_acc_wheel_speed());
   print("joystick report delta:                %i ms\n", APP_cfg_get_joystick_delta_ms());
   print("joystick direction accelerator speed: %i\n", APP_cfg_get_joystick_acc_speed());
+  print("minimum press hold:                   %i ms\n", APP_cfg_get_min_hold_ms());
+  print("latching devices:                     %04b\n", APP_cfg_get_latch_mask());
+  print("ternary change releases first:        %s\n", APP_cfg_get_tern_release_first() ? "yes" : "no");
+  print("combo window:                         %i ms\n", APP_cfg_get_combo_window_ms());
+  print("turbo duty cycle:                     %i percent\n", APP_cfg_get_turbo_duty());
+  print("usb mode:                             %s%s\n", USB_MODE_NAME[APP_cfg_get_usb_personality()],
+      APP_cfg_get_usb_personality() != USB_ARC_get_personality() ? " (after reset)" : "");
+  print("usb latency interface:                %s%s\n", APP_cfg_get_usb_latency() ? "yes" : "no",
+      APP_cfg_get_usb_latency() != USB_ARC_get_latency() ? " (after reset)" : "");
+  print("acceleration curves:\n");
+  app_acc acc;
+  for (acc = 0; acc < _ACC_CNT; acc++) {
+    print("  ");
+    print_acc_curve(acc);
+  }
 
 #ifndef CONFIG_ANNOYATRON
-  int pin;
-  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
-    def_config *c = APP_cfg_get_pin(pin);
-    if (c->pin) def_config_print(c);
+  int layer, pin;
+  for (layer = 0; layer < APP_CONFIG_LAYERS; layer++) {
+    for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
+      def_config c;
+      if (APP_cfg_get_pin(layer, pin, &c)) def_config_print(&c);
+    }
+  }
+  int combo;
+  for (combo = 0; combo < APP_CONFIG_COMBOS; combo++) {
+    def_config c;
+    if (APP_cfg_get_combo(combo, &c)) def_config_print(&c);
   }
+  int motion;
+  for (motion = 0; motion < APP_CONFIG_MOTIONS; motion++) {
+    def_config c;
+    if (APP_cfg_get_motion(motion, &c)) def_config_print(&c);
+  }
+  print("definitions used: %i of %i\n", APP_cfg_get_def_pool_usage(), APP_CONFIG_DEF_POOL);
+  print("layer pins used: %i of %i\n", APP_cfg_get_layer_def_usage(), APP_CONFIG_LAYER_DEFS);
+  print("combos used: %i of %i\n", APP_cfg_get_combo_usage(), APP_CONFIG_COMBOS);
+  print("motions used: %i of %i\n", APP_cfg_get_motion_usage(), APP_CONFIG_MOTIONS);
 #endif
 
   return 0;
 }
 
+static const char *LAYER_MODE_NAME[] = {
+    "off", "hold", "toggle", "oneshot"
+};
+
+static int f_layer(int layer, int pin, char *mode) {
+  if (_argc == 2 && !IS_STRING(layer) && IS_STRING(pin) &&
+      strcmp((char *)pin, LAYER_MODE_NAME[LAYER_OFF]) == 0) {
+    if (layer < 1 || layer >= APP_CONFIG_LAYERS) return -1;
+    APP_cfg_set_layer(layer, 0, LAYER_OFF);
+  } else if (_argc == 3 && !IS_STRING(layer) && !IS_STRING(pin) && IS_STRING(mode)) {
+    if (layer < 1 || layer >= APP_CONFIG_LAYERS || pin < 1 || pin > APP_CONFIG_PINS) {
+      return -1;
+    }
+    app_layer_mode m;
+    for (m = LAYER_HOLD; m <= LAYER_ONESHOT; m++) {
+      if (strcmp(mode, LAYER_MODE_NAME[m]) == 0) break;
+    }
+    if (m > LAYER_ONESHOT) return -1;
+    APP_cfg_set_layer(layer, pin, m);
+  } else if (_argc != 0) {
+    return -1;
+  }
+  int l;
+  for (l = 1; l < APP_CONFIG_LAYERS; l++) {
+    u8_t sel_pin;
+    app_layer_mode m = APP_cfg_get_layer(l, &sel_pin);
+    if (m == LAYER_OFF) {
+      print("layer %i: off\n", l);
+    } else {
+      print("layer %i: pin%i %s\n", l, sel_pin, LAYER_MODE_NAME[m]);
+    }
+  }
+  print("current layer: %i\n", APP_get_layer());
+  return 0;
+}
+
+static const char *SOCD_MODE_NAME[] = {
+    "last", "neutral", "first"
+};
+
+static int f_socd(int joystick, char *mode, char *ways) {
+  if (_argc >= 2 && _argc <= 3 && !IS_STRING(joystick) && IS_STRING(mode)) {
+    if (joystick < 1 || joystick > 2) return -1;
+    app_socd_mode m;
+    for (m = SOCD_LAST; m <= SOCD_FIRST; m++) {
+      if (strcmp(mode, SOCD_MODE_NAME[m]) == 0) break;
+    }
+    if (m > SOCD_FIRST) return -1;
+    if (_argc == 3 && (!IS_STRING(ways) || strcmp(ways, "4way") != 0)) return -1;
+    APP_cfg_set_socd(joystick - 1, m, _argc == 3);
+  } else if (_argc != 0) {
+    return -1;
+  }
+  int j;
+  for (j = 0; j < 2; j++) {
+    bool four_way;
+    app_socd_mode m = APP_cfg_get_socd(j, &four_way);
+    print("joystick %i: %s%s\n", j + 1, SOCD_MODE_NAME[m], four_way ? " 4way" : "");
+  }
+  return 0;
+}
+
+static const char *ACC_NAME[] = {
+    "mouse_x", "mouse_y", "mouse_wheel", "joy1_x", "joy1_y", "joy2_x", "joy2_y"
+};
+// names setting curves of several axes
+static const struct {
+  const char *name;
+  app_acc acc;
+  u8_t cnt;
+} ACC_GROUP[] = {
+    { "mouse_pos", ACC_MOUSE_X, 2 },
+    { "joy1", ACC_JOY1_X, 2 },
+    { "joy2", ACC_JOY2_X, 2 },
+    { "joystick", ACC_JOY1_X, 4 },
+};
+static const char *ACC_CURVE_NAME[] = {
+    "linear", "quadratic", "s", "points"
+};
+
+static void print_acc_curve(app_acc acc) {
+  vel_curve c;
+  int p;
+  APP_cfg_get_acc_curve(acc, &c);
+  print("%s: %s", ACC_NAME[acc], ACC_CURVE_NAME[c.type]);
+  if (c.type == VEL_CURVE_USER) {
+    for (p = 0; p < c.points; p++) {
+      print(" %i %i", c.x[p], c.y[p]);
+    }
+  }
+  print("\n");
+}
+
+static void set_acc_curves_linear(app_acc acc, int cnt) {
+  vel_curve linear = { .type = VEL_CURVE_LINEAR };
+  while (cnt--) {
+    APP_cfg_set_acc_curve(acc++, &linear);
+  }
+}
+
+static int f_acc_curve(char *acc_name, char *type) {
+  if (_argc >= 2 && IS_STRING(acc_name) && IS_STRING(type)) {
+    app_acc acc;
+    int cnt = 1, g;
+    vel_curve c;
+    memset(&c, 0, sizeof(vel_curve));
+    for (acc = 0; acc < _ACC_CNT; acc++) {
+      if (strcmp(acc_name, ACC_NAME[acc]) == 0) break;
+    }
+    for (g = 0; acc >= _ACC_CNT && g < sizeof(ACC_GROUP)/sizeof(ACC_GROUP[0]); g++) {
+      if (strcmp(acc_name, ACC_GROUP[g].name) == 0) {
+        acc = ACC_GROUP[g].acc;
+        cnt = ACC_GROUP[g].cnt;
+      }
+    }
+    for (c.type = 0; c.type < _VEL_CURVE_CNT; c.type++) {
+      if (strcmp(type, ACC_CURVE_NAME[c.type]) == 0) break;
+    }
+    if (acc >= _ACC_CNT || c.type >= _VEL_CURVE_CNT) return -1;
+    if (c.type == VEL_CURVE_USER) {
+      int a;
+      if (_argc < 4 || (_argc & 1) || (_argc - 2) / 2 > VEL_CURVE_POINTS) return -1;
+      for (a = 2; a < _argc; a += 2) {
+        if (IS_STRING(_args[a]) || IS_STRING(_args[a+1])) return -1;
+        if ((u32_t)_args[a] > 100 || (u32_t)_args[a+1] > 100) return -1;
+        c.x[c.points] = (u32_t)_args[a];
+        c.y[c.points] = (u32_t)_args[a+1];
+        c.points++;
+      }
+    } else if (_argc != 2) {
+      return -1;
+    }
+    while (cnt--) {
+      if (!APP_cfg_set_acc_curve(acc++, &c)) {
+        print("bad points, x must ascend, linear curve used\n");
+        break;
+      }
+    }
+  } else if (_argc != 0) {
+    return -1;
+  }
+  app_acc acc;
+  for (acc = 0; acc < _ACC_CNT; acc++) {
+    print_acc_curve(acc);
+  }
+  return 0;
+}
+
+static int f_pinmap(int pin, char *gpio) {
+  if (_argc == 1 && IS_STRING(pin) && strcmp((char *)pin, "default") == 0) {
+    if (!APP_cfg_set_gpio_map(GPIO_MAP_get_default_pin_map())) {
+      return -1;
+    }
+  } else if (_argc == 2 && !IS_STRING(pin) && IS_STRING(gpio)) {
+    if (pin < 1 || pin > APP_CONFIG_GPIO_PINS) {
+      print("bad pin, 1-%i\n", APP_CONFIG_GPIO_PINS);
+      return 0;
+    }
+    gpio_pin_map map[APP_CONFIG_GPIO_PINS];
+    memcpy(map, GPIO_MAP_get_pin_map(), sizeof(map));
+    if (strcmp(gpio, "none") == 0) {
+      map[pin-1].port = GPIO_MAP_UNUSED_PORT;
+      map[pin-1].pin = 0;
+    } else {
+      int gpin = -1;
+      if (gpio[0] == 'P' && gpio[1] != 0 && gpio[2] >= '0' && gpio[2] <= '9') {
+        gpin = gpio[2] - '0';
+        if (gpio[3] >= '0' && gpio[3] <= '9' && gpio[4] == 0) {
+          gpin = gpin * 10 + gpio[3] - '0';
+        } else if (gpio[3] != 0) {
+          gpin = -1;
+        }
+      }
+      if (gpio[1] < 'A' || gpio[1] >= 'A' + GPIO_MAP_PORTS || gpin < 0 || gpin > 15) {
+        print("bad gpio, e.g. PB12\n");
+        return 0;
+      }
+      map[pin-1].port = gpio[1] - 'A';
+      map[pin-1].pin = gpin;
+    }
+    int bad = GPIO_MAP_check_pin_map(map);
+    if (bad >= 0 || !APP_cfg_set_gpio_map(map)) {
+      print("gpio for pin %i is reserved, invalid or already used\n", bad + 1);
+      return 0;
+    }
+  } else if (_argc != 0) {
+    return -1;
+  }
+
+  const gpio_pin_map *map = GPIO_MAP_get_pin_map();
+  int i;
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    if (GPIO_MAP_IS_UNUSED(&map[i])) {
+      print("pin %i:\tnone\n", i+1);
+    } else {
+      print("pin %i:\tP%c%i\n", i+1, 'A' + map[i].port, map[i].pin);
+    }
+  }
+  u8_t ops;
+  u32_t cyc_last, cyc_max;
+  GPIO_MAP_get_sample_ops(&ops);
+  APP_get_sample_cycles(&cyc_last, &cyc_max);
+  print("sample ops: %i (default map %i)\n", ops,
+      GPIO_MAP_count_sample_ops(GPIO_MAP_get_default_pin_map()));
+  print("sample cycles: last %i  max %i\n", cyc_last, cyc_max);
+  return 0;
+}
+
+#ifdef CONFIG_IO_EXP
+static int f_io_exp(char *cmd) {
+  if (_argc == 1 && IS_STRING(cmd) && strcmp(cmd, "clear") == 0) {
+    IO_EXP_clear_stats();
+    return 0;
+  } else if (_argc != 0) {
+    return -1;
+  }
+  int dev;
+  for (dev = 0; dev < IO_EXP_DEVICES; dev++) {
+    io_exp_stats s;
+    IO_EXP_get_stats(dev, &s);
+    print("expander %i @ 0x%02x, pins %i-%i: %s\n", dev, IO_EXP_I2C_ADDR + dev,
+        APP_CONFIG_GPIO_PINS + dev * IO_EXP_PINS_PER_DEVICE + 1,
+        APP_CONFIG_GPIO_PINS + (dev + 1) * IO_EXP_PINS_PER_DEVICE,
+        IO_EXP_is_online(dev) ? "online" : "OFFLINE");
+    print("  state:      %016b\n", IO_EXP_get_state(dev));
+    print("  reads:      %i\n", s.reads);
+    print("  errors:     %i\n", s.errors);
+    print("  retriggers: %i\n", s.retriggers);
+    print("  offline:    %i\n", s.offline);
+    print("  latency us: last %i  min %i  avg %i  max %i\n",
+        s.lat_last_us, s.lat_min_us, s.lat_avg_us, s.lat_max_us);
+  }
+  return 0;
+}
+#endif
+
 static int f_cfg_pin_debounce(u8_t cycles) {
   if (_argc != 1) {
     return -1;
@@ -446,6 +859,7 @@ static int f_cfg_acc_pos_speed(u16_t speed) {
     return -1;
   }
   APP_cfg_set_acc_pos_speed(speed);
+  set_acc_curves_linear(ACC_MOUSE_X, 2);
   return 0;
 }
 static int f_cfg_acc_whe_speed(u16_t speed) {
@@ -453,6 +867,7 @@ static int f_cfg_acc_whe_speed(u16_t speed) {
     return -1;
   }
   APP_cfg_set_acc_wheel_speed(speed);
+  set_acc_curves_linear(ACC_MOUSE_WHEEL, 1);
   return 0;
 }
 
@@ -468,6 +883,175 @@ static int f_cfg_joy_acc_speed(u16_t speed) {
     return -1;
   }
   APP_cfg_set_joystick_acc_speed(speed);
+  set_acc_curves_linear(ACC_JOY1_X, 4);
+  return 0;
+}
+
+static int f_cfg_min_hold(u8_t ms) {
+  if (_argc != 1) {
+    return -1;
+  }
+  APP_cfg_set_min_hold_ms(ms);
+  return 0;
+}
+
+static int f_cfg_latch(u8_t mask) {
+  if (_argc != 1) {
+    return -1;
+  }
+  APP_cfg_set_latch_mask(mask);
+  return 0;
+}
+
+static int f_cfg_tern_release(u8_t release_first) {
+  if (_argc != 1) {
+    return -1;
+  }
+  APP_cfg_set_tern_release_first(release_first != 0);
+  return 0;
+}
+
+static int f_cfg_combo_window(u8_t ms) {
+  if (_argc != 1) {
+    return -1;
+  }
+  APP_cfg_set_combo_window_ms(ms);
+  return 0;
+}
+
+static int f_cfg_turbo_duty(u8_t percent) {
+  if (_argc != 1 || percent < 1 || percent > 99) {
+    return -1;
+  }
+  APP_cfg_set_turbo_duty(percent);
+  return 0;
+}
+
+static int f_cfg_usb_mode(char *mode) {
+  if (_argc != 1 || !IS_STRING(mode)) {
+    return -1;
+  }
+  usb_personality p;
+  for (p = USB_ARC_COMPOSITE; p <= USB_ARC_SINGLE; p++) {
+    if (strcmp(mode, USB_MODE_NAME[p]) == 0) break;
+  }
+  if (p > USB_ARC_SINGLE) return -1;
+  APP_cfg_set_usb_personality(p);
+  return 0;
+}
+
+static int f_cfg_usb_latency(u8_t on) {
+  if (_argc != 1) {
+    return -1;
+  }
+  APP_cfg_set_usb_latency(on != 0);
+  return 0;
+}
+
+static int f_events(char *cmd) {
+  if (_argc == 1 && IS_STRING(cmd) && strcmp(cmd, "clear") == 0) {
+    APP_clear_event_stats();
+    APP_clear_latched_presses();
+    return 0;
+  } else if (_argc != 0) {
+    return -1;
+  }
+  u32_t overflows;
+  u16_t max_fill, fill;
+  APP_get_event_stats(&overflows, &max_fill, &fill);
+  print("queued:     %i of %i\n", fill, APP_CONFIG_EVENT_QUEUE);
+  print("max queued: %i\n", max_fill);
+  print("overflows:  %i\n", overflows);
+  u32_t latched[4];
+  APP_get_latched_presses(latched);
+  print("latched presses: kb %i  mouse %i  joy1 %i  joy2 %i\n",
+      latched[0], latched[1], latched[2], latched[3]);
+  return 0;
+}
+
+static int f_timers(char *cmd) {
+  if (_argc == 1 && IS_STRING(cmd) && strcmp(cmd, "clear") == 0) {
+    WHEEL_clear_stats();
+    return 0;
+  } else if (_argc != 0) {
+    return -1;
+  }
+  wheel_stats s;
+  WHEEL_get_stats(&s);
+  print("running:     %i (level 0: %i, level 1: %i)\n", s.timers, s.level_timers[0], s.level_timers[1]);
+  print("max running: %i\n", s.timers_max);
+  print("ticks:       %i\n", s.ticks);
+  print("expired:     %i\n", s.expired);
+  print("cascaded:    %i\n", s.cascaded);
+  print("tick cycles: %i (max %i)\n", s.tick_cycles_last, s.tick_cycles_max);
+  return 0;
+}
+
+static int f_mouse_stats(char *cmd) {
+  if (_argc == 1 && IS_STRING(cmd) && strcmp(cmd, "clear") == 0) {
+    APP_clear_mouse_stats();
+    return 0;
+  } else if (_argc != 0) {
+    return -1;
+  }
+  app_mouse_stats s;
+  APP_get_mouse_stats(&s);
+  int i;
+  for (i = 0; i < 2; i++) {
+    print("%s %i reports in %i ms, %i per second\n",
+        i ? "moving:      " : "buttons only:", s.reports[i], s.ms[i],
+        s.ms[i] ? (u32_t)(((u64_t)s.reports[i] * 1000) / s.ms[i]) : 0);
+  }
+  print("suppressed:   %i\n", s.suppressed);
+  return 0;
+}
+
+static int f_suspend_stats(char *cmd) {
+  if (_argc == 1 && IS_STRING(cmd) && strcmp(cmd, "clear") == 0) {
+    APP_clear_suspend_stats();
+    return 0;
+  } else if (_argc != 0) {
+    return -1;
+  }
+  app_suspend_stats s;
+  APP_get_suspend_stats(&s);
+  print("suspends:     %i\n", s.suspends);
+  print("suspended:    %i ms, %i ms in stop mode\n", s.suspend_ms, s.stop_ms);
+  print("wakeups:      %i, %i missed\n", s.wakeups, s.missed);
+  print("latency:      %i us (max %i us)\n", s.latency_us, s.latency_us_max);
+  print("wake pins:    %i, %i sharing exti line\n", s.wake_pins, s.unarmed_pins);
+  print("remote wakeup %s by host\n", USB_ARC_remote_wakeup_enabled() ? "enabled" : "disabled");
+  return 0;
+}
+
+static int f_usb_info(void) {
+  static const char *DEV_NAME[] = {"keyboard:   ", "mouse:      ", "joystick1:  ", "joystick2:  "};
+  u8_t dev;
+  print("usb mode:    %s\n", USB_MODE_NAME[USB_ARC_get_personality()]);
+  for (dev = 0; dev < 4; dev++) {
+    if (USB_ARC_get_devices() & (1 << dev)) {
+      print("%sendpoint %i\n", DEV_NAME[dev], USB_ARC_get_endpoint(dev));
+    } else {
+      print("%snot presented\n", DEV_NAME[dev]);
+    }
+  }
+  if (USB_ARC_get_latency_endpoint()) {
+    u32_t sent, lost;
+    USB_ARC_get_latency_stats(&sent, &lost);
+    print("latency:     endpoint %i, %i records sent, %i lost\n",
+        USB_ARC_get_latency_endpoint(), sent, lost);
+    u32_t cyc_last, cyc_max;
+    USB_ARC_get_latency_cycles(&cyc_last, &cyc_max);
+    print("             record cycles: last %i  max %i\n", cyc_last, cyc_max);
+  } else if (USB_ARC_get_latency()) {
+    print("latency:     no endpoint left\n");
+  }
+  u32_t ms = USB_ARC_get_enum_time_ms();
+  if (ms) {
+    print("enumerated:  %i ms\n", ms);
+  } else {
+    print("enumerated:  not yet\n");
+  }
   return 0;
 }
 
@@ -714,12 +1298,15 @@ static int f_build(void) {
   cli_print_app_name();
   print("\ndate:%i build:%i\n\n", SYS_build_date(), SYS_build_number());
 
+  print("BOARD %s\n", BOARD_NAME);
   print("SYS_MAIN_TIMER_FREQ %i\n", SYS_MAIN_TIMER_FREQ);
   print("SYS_TIMER_TICK_FREQ %i\n", SYS_TIMER_TICK_FREQ);
   print("UART2_SPEED %i\n", UART2_SPEED);
   print("CONFIG_TASK_POOL %i\n", CONFIG_TASK_POOL);
   print("APP_CONFIG_PINS %i\n", APP_CONFIG_PINS);
+  print("IO_EXP_DEVICES %i\n", IO_EXP_DEVICES);
   print("APP_CONFIG_DEFS_PER_PIN %i\n", APP_CONFIG_DEFS_PER_PIN);
+  print("APP_CONFIG_DEF_POOL %i\n", APP_CONFIG_DEF_POOL);
   print("USB_KB_REPORT_KEYMAP_SIZE %i\n", USB_KB_REPORT_KEYMAP_SIZE);
 
   return 0;
@@ -984,8 +1571,16 @@ void CLI_parse(u32_t len, u8_t *buf) {
     bool ok = def_config_parse(&pindef, (char*)&buf[4], len-4);
     if (ok) {
       def_config_print(&pindef);
-      print("OK\n");
-      APP_cfg_set_pin(&pindef);
+      if (APP_cfg_set_pin(&pindef)) {
+        print("OK\n");
+      } else {
+        print("ERROR: out of definition space, %i of %i used, %i of %i layer pins used, "
+            "%i of %i combos used, %i of %i motions used\n",
+            APP_cfg_get_def_pool_usage(), APP_CONFIG_DEF_POOL,
+            APP_cfg_get_layer_def_usage(), APP_CONFIG_LAYER_DEFS,
+            APP_cfg_get_combo_usage(), APP_CONFIG_COMBOS,
+            APP_cfg_get_motion_usage(), APP_CONFIG_MOTIONS);
+      }
     }
     print(CLI_PROMPT);
     return;
@@ -26,7 +26,7 @@ typedef struct {
     };
     struct {
       hid_id_type type : 2;
-      u8_t kb_reserved : 6;
+      u8_t kb_turbo : 6;
       enum kb_hid_code kb_code : 8;
     } kb;
     struct {
@@ -47,8 +47,55 @@ typedef struct {
   };
 } __attribute__ (( packed )) hid_id;
 
+// Keys and buttons can autofire, their turbo rate in Hz is kept in bits
+// otherwise unused by them
+#define DEF_TURBO_MAX_HZ      60
+
+// returns turbo rate of definition in Hz, 0 if none
+static inline u8_t def_turbo_hz(hid_id id) {
+  switch (id.type) {
+  case HID_ID_TYPE_KEYBOARD:
+    return id.kb.kb_turbo;
+  case HID_ID_TYPE_MOUSE:
+    return id.mouse.mouse_code == MOUSE_BUTTON1 || id.mouse.mouse_code == MOUSE_BUTTON2 ||
+        id.mouse.mouse_code == MOUSE_BUTTON3 ? id.mouse.mouse_data : 0;
+  case HID_ID_TYPE_JOYSTICK:
+    return (id.joy.joystick_code & (_JOYSTICK_IX_2 - 1)) >= JOYSTICK1_BUTTON1 ?
+        id.joy.joystick_data : 0;
+  default:
+    return 0;
+  }
+}
+
+// Macros are stored as definitions following a MACRO_OP_START entry, always
+// last in a pin's definitions. Macro control entries are hid_ids of type
+// HID_ID_TYPE_NONE with op and argument in raw, other entries are tapped one
+// by one.
+enum macro_op {
+  MACRO_OP_NONE = 0,
+  MACRO_OP_START,   // arg MACRO_START_* flags
+  MACRO_OP_DELAY,   // arg milliseconds
+  MACRO_OP_GROUP,   // arg number of following entries tapped together
+};
+#define MACRO_START_CANCEL    (1<<0)  // macro stops when pin is released
+#define MACRO_DELAY_MAX       0xfff
+#define MACRO_OP(id)          ((id).raw >> 12)
+#define MACRO_ARG(id)         ((id).raw & 0xfff)
+#define MACRO_RAW(op, arg)    (((op) << 12) | (arg))
+
+// Motion inputs are sequences of joystick directions in numpad notation, 1
+// down left, 2 down .. 5 neutral .. 8 up, 9 up right, and pin presses. A
+// definition having motion steps has no pin.
+#define MOTION_STEP_PIN       0x80  // step is press of pin, one based, in low bits
+#define MOTION_STEP_MS        150   // default max milliseconds between steps
+
 typedef struct {
   u8_t pin;
+  u8_t combo[APP_CONFIG_COMBO_PINS - 1]; // further pins of a combo, 0 if unused
+  u8_t motion[APP_CONFIG_MOTION_STEPS];  // motion steps, 0 terminated if shorter
+  u8_t motion_ms;                        // max time between motion steps
+  u8_t motion_joystick;                  // joystick of motion directions, 0 or 1
+  u8_t layer;
   u8_t tern_pin;
   u8_t tern_splice;
   hid_id id[APP_CONFIG_DEFS_PER_PIN];
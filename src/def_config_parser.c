@@ -9,20 +9,21 @@
 
 #include "usb/usb_arc_codes.h"
 
-#define MAX_LEX_SYM_LEN   (4+APP_CONFIG_DEFS_PER_PIN*2+1)
+#define MAX_LEX_SYM_LEN   (5+(APP_CONFIG_COMBO_PINS-1)*2+APP_CONFIG_DEFS_PER_PIN*2+1)
 
 typedef enum {
-  LEX_UNKNOWN = 0, LEX_PIN, LEX_DEF, LEX_NUM, LEX_ASSIGN, LEX_TERN, LEX_TERN_OPT
+  LEX_UNKNOWN = 0, LEX_PIN, LEX_DEF, LEX_NUM, LEX_ASSIGN, LEX_TERN, LEX_TERN_OPT, LEX_LAYER, LEX_COMBO, LEX_MACRO, LEX_MOTION
 } lex_type;
 
+// 3 bytes, definition strings are limited to 255 characters
 typedef struct {
-  lex_type type;
-  u16_t offs_start;
-  u16_t offs_end;
-} lex_type_sym;
+  lex_type type : 8;
+  u8_t offs_start;
+  u8_t offs_end;
+} __attribute__ (( packed )) lex_type_sym;
 
 typedef enum {
-  LEX_STATE_INIT = 0, LEX_STATE_SYM, LEX_STATE_NUM
+  LEX_STATE_INIT = 0, LEX_STATE_SYM, LEX_STATE_NUM, LEX_STATE_MACRO
 } lex_state;
 
 const char *ignore_chars = " \t";
@@ -33,8 +34,18 @@ const char *num_chars =
 const char *numdef_chars = "()";
 const char *assign_chars = "=";
 const char *tern_chars = "?:";
+const char *combo_chars = "+";
 const char *pin_sym = "pin";
 const char *acc_sym = "acc";
+const char *layer_sym = "layer";
+const char *macro_sym = "macro";
+const char *macro_cancel_sym = "macro_cancel";
+const char *delay_sym = "ms";
+const char *turbo_sym = "turbo";
+const char *turbo_unit_sym = "hz";
+const char *motion_sym = "motion";
+const char *motion_joystick_sym = "joy";
+const char *string_chars = "\"";
 
 static u8_t lex_sym_ix;
 static lex_type_sym lex_syms[MAX_LEX_SYM_LEN];
@@ -71,6 +82,38 @@ static bool is_acc_sym(const char *str, lex_type_sym *sym) {
   return TRUE;
 }
 
+static bool is_layer_sym(const char *str, lex_type_sym *sym) {
+  if (1 + sym->offs_end - sym->offs_start != strlen(layer_sym) + 1) {
+    return FALSE;
+  }
+  int i;
+  for (i = 0; i < strlen(layer_sym); i++) {
+    if (to_lower(layer_sym[i]) != to_lower(str[sym->offs_start + i])) {
+      return FALSE;
+    }
+  }
+  char c = str[sym->offs_start + i];
+  return c >= '0' && c <= '9';
+}
+
+// symbol is name, ignoring case
+static bool is_sym_named(const char *name, const char *str, lex_type_sym *sym) {
+  if (1 + sym->offs_end - sym->offs_start != strlen(name)) {
+    return FALSE;
+  }
+  int i;
+  for (i = 0; i < strlen(name); i++) {
+    if (to_lower(name[i]) != to_lower(str[sym->offs_start + i])) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static bool is_macro_sym(const char *str, lex_type_sym *sym) {
+  return is_sym_named(macro_sym, str, sym) || is_sym_named(macro_cancel_sym, str, sym);
+}
+
 static bool parse_pin_nbr(const char *str, lex_type_sym *sym, u8_t *nbr) {
   if (!is_pin_sym(str, sym))
     return FALSE;
@@ -131,6 +174,8 @@ static bool emit_lex_sym(lex_type_sym *sym, const char *str) {
   case LEX_DEF: {
     if (is_pin_sym(str, sym)) {
       sym->type = LEX_PIN;
+    } else if (is_layer_sym(str, sym)) {
+      sym->type = LEX_LAYER;
     }
     break;
   }
@@ -138,6 +183,9 @@ static bool emit_lex_sym(lex_type_sym *sym, const char *str) {
   case LEX_NUM:
   case LEX_TERN:
   case LEX_TERN_OPT:
+  case LEX_COMBO:
+  case LEX_MACRO:
+  case LEX_MOTION:
     break;
   default:
     print_index_indicator(str, sym->offs_start);
@@ -165,20 +213,24 @@ static bool emit_lex_sym(lex_type_sym *sym, const char *str) {
 }
 
 static int sym_strcmp(const char *str, const char *sym_str, lex_type_sym *sym) {
-  char symdef, userdef;
   int symdeflen = strlen(str);
 
   if (sym->offs_end - sym->offs_start + 1 < symdeflen) return -1;
   const char *s2 = &sym_str[sym->offs_start];
-  while ((((symdef = *str++) != 0) & ((userdef = *s2++) != 0))) {
-    if (to_lower(symdef) != to_lower(userdef)) {
+  int i;
+  for (i = 0; i < symdeflen; i++) {
+    if (to_lower(str[i]) != to_lower(s2[i])) {
       return -1;
     }
   }
-  return (userdef == 0 || userdef == '(') ? 0 : 1;
+  // symbol must end here, or continue with a numerator
+  return (sym->offs_end - sym->offs_start + 1 == symdeflen ||
+      s2[symdeflen] == 0 || s2[symdeflen] == '(') ? 0 : 1;
 }
 
 static void lookup_def(const char *str, lex_type_sym *sym, hid_id *h_id, bool *numerator) {
+  // cleared data of buttons is no turbo, only set by a turbo numerator
+  memset(h_id, 0, sizeof(hid_id));
   // test keyboard definitions
   enum kb_hid_code kb_code;
   for (kb_code = 0; kb_code < _KB_HID_CODE_MAX; kb_code++) {
@@ -227,16 +279,39 @@ static bool lex(const char *str, u16_t len) {
   memset(lex_syms, 0, sizeof(lex_syms));
   lex_state state = LEX_STATE_INIT;
   lex_type_sym sym = { LEX_UNKNOWN, 0, 0 };
+  int macro_depth = 0;
+  bool macro_string = FALSE;
 
   for (i = 0; i < len + 1; i++) {
     char c = i >= len ? ignore_chars[0] : str[i];
+    if (state == LEX_STATE_MACRO) {
+      // macro or motion is one symbol up to matching parenthesis, parsed later
+      if (i >= len) {
+        print_index_indicator(str, sym.offs_start);
+        KEYPARSERR("Syntax error: %s without closing '%c'\n",
+            sym.type == LEX_MOTION ? motion_sym : macro_sym, numdef_chars[1]);
+        return FALSE;
+      }
+      if (c == string_chars[0]) {
+        macro_string = !macro_string;
+      } else if (!macro_string && c == numdef_chars[0]) {
+        macro_depth++;
+      } else if (!macro_string && c == numdef_chars[1] && macro_depth-- == 0) {
+        sym.offs_end = i;
+        if (!emit_lex_sym(&sym, str))
+          return FALSE;
+        state = LEX_STATE_INIT;
+      }
+      continue;
+    }
     bool is_ignore = strchr(ignore_chars, c) != 0;
     bool is_sym = strchr(sym_chars, c) != 0;
     bool is_num = strchr(num_chars, c) != 0;
     bool is_numdef = strchr(numdef_chars, c) != 0;
     bool is_assign = strchr(assign_chars, c) != 0;
     bool is_tern = strchr(tern_chars, c) != 0;
-    if (!(is_ignore || is_sym || is_num || is_numdef || is_assign || is_tern)) {
+    bool is_combo = strchr(combo_chars, c) != 0;
+    if (!(is_ignore || is_sym || is_num || is_numdef || is_assign || is_tern || is_combo)) {
       print_index_indicator(str, i);
       KEYPARSERR("Error: bad character [%c] @ index %i\n", c, i);
       return FALSE;
@@ -266,6 +341,12 @@ static bool lex(const char *str, u16_t len) {
         if (!emit_lex_sym(&sym, str))
           return FALSE;
         state = LEX_STATE_INIT;
+      } else if (is_combo) {
+        sym.type = LEX_COMBO;
+        sym.offs_start = sym.offs_end = i;
+        if (!emit_lex_sym(&sym, str))
+          return FALSE;
+        state = LEX_STATE_INIT;
       } else {
         print_index_indicator(str, i);
         KEYPARSERR("Error: unexpected character [%c] @ index %i\n", c, i);
@@ -275,6 +356,13 @@ static bool lex(const char *str, u16_t len) {
     case LEX_STATE_SYM:
       if (!is_sym) {
         sym.offs_end = i - 1;
+        if (c == numdef_chars[0] && (is_macro_sym(str, &sym) || is_sym_named(motion_sym, str, &sym))) {
+          sym.type = is_macro_sym(str, &sym) ? LEX_MACRO : LEX_MOTION;
+          macro_depth = 0;
+          macro_string = FALSE;
+          state = LEX_STATE_MACRO;
+          continue;
+        }
         if (!emit_lex_sym(&sym, str))
           return FALSE;
         // reparse
@@ -284,7 +372,7 @@ static bool lex(const char *str, u16_t len) {
       }
       break;
       case LEX_STATE_NUM:
-      if (is_num) {
+      if (is_num || is_ignore) {
         // ok
       } else if (is_numdef && c == numdef_chars[1]) {
         sym.offs_end = i-1;
@@ -296,6 +384,8 @@ static bool lex(const char *str, u16_t len) {
         return FALSE;
       }
       break;
+    case LEX_STATE_MACRO:
+      break;
     }
   }
   return TRUE;
@@ -343,12 +433,339 @@ static bool parse_numerator(lex_type_sym *sym, const char *str, hid_id *id) {
   return TRUE;
 }
 
+// parses turbo numerator, e.g. (turbo 15hz), of a key or button definition
+static bool parse_turbo(lex_type_sym *sym, const char *str, hid_id *id) {
+  int i = sym->offs_start + strlen(turbo_sym);
+  int end = sym->offs_end;
+  u32_t hz = 0;
+  while (i <= end && strchr(ignore_chars, str[i])) i++;
+  int digits = i;
+  while (i <= end && str[i] >= '0' && str[i] <= '9') {
+    hz = hz * 10 + str[i++] - '0';
+    if (hz > 0xff) break;
+  }
+  if (i == digits) {
+    print_index_indicator(str, i);
+    KEYPARSERR("Syntax error: expected turbo rate ");
+    print_lex_sym(sym, str);
+    return FALSE;
+  }
+  while (i <= end && strchr(ignore_chars, str[i])) i++;
+  if (i + strlen(turbo_unit_sym) - 1 <= end &&
+      to_lower(str[i]) == turbo_unit_sym[0] && to_lower(str[i+1]) == turbo_unit_sym[1]) {
+    i += strlen(turbo_unit_sym);
+  }
+  while (i <= end && strchr(ignore_chars, str[i])) i++;
+  if (i <= end) {
+    print_index_indicator(str, i);
+    KEYPARSERR("Syntax error: unexpected character [%c] @ index %i\n", str[i], i);
+    return FALSE;
+  }
+  if (hz == 0 || hz > DEF_TURBO_MAX_HZ) {
+    print_index_indicator(str, sym->offs_start);
+    KEYPARSERR("Error: turbo rate must be 1-%i%s\n", DEF_TURBO_MAX_HZ, turbo_unit_sym);
+    return FALSE;
+  }
+  if (id->type == HID_ID_TYPE_KEYBOARD) {
+    id->kb.kb_turbo = hz;
+  } else if (id->type == HID_ID_TYPE_MOUSE) {
+    id->mouse.mouse_data = hz;
+  } else if (id->type == HID_ID_TYPE_JOYSTICK) {
+    id->joy.joystick_data = hz;
+  }
+  if (def_turbo_hz(*id) != hz) {
+    print_index_indicator(str, sym->offs_start);
+    KEYPARSERR("Error: only keys and buttons can have turbo\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static bool macro_add(def_config *pindef, u8_t *def_ix, hid_id id, const char *str, u16_t ix) {
+  if (*def_ix >= APP_CONFIG_DEFS_PER_PIN) {
+    print_index_indicator(str, ix);
+    KEYPARSERR("Error: definition overflow\n");
+    return FALSE;
+  }
+  pindef->id[(*def_ix)++] = id;
+  return TRUE;
+}
+
+static bool macro_add_op(def_config *pindef, u8_t *def_ix, enum macro_op op, u16_t arg,
+    const char *str, u16_t ix) {
+  hid_id id;
+  id.type = HID_ID_TYPE_NONE;
+  id.raw = MACRO_RAW(op, arg);
+  return macro_add(pindef, def_ix, id, str, ix);
+}
+
+// adds a tap of the key typing character at index, like command usb_kb does
+static bool macro_add_char(def_config *pindef, u8_t *def_ix, const char *str, u16_t ix) {
+  char c = str[ix];
+  enum kb_hid_code code;
+  for (code = 0; code < _KB_HID_CODE_MAX; code++) {
+    const keymap *km = USB_ARC_get_keymap(code);
+    if (km->keys != NULL && strchr(km->keys, c)) break;
+  }
+  if (code >= _KB_HID_CODE_MAX) {
+    print_index_indicator(str, ix);
+    KEYPARSERR("Error: no key for character [%c]\n", c);
+    return FALSE;
+  }
+  hid_id id;
+  memset(&id, 0, sizeof(id));
+  id.type = HID_ID_TYPE_KEYBOARD;
+  if (c >= 'A' && c <= 'Z') {
+    id.kb.kb_code = MOD_LSHIFT;
+    if (!macro_add_op(pindef, def_ix, MACRO_OP_GROUP, 2, str, ix) ||
+        !macro_add(pindef, def_ix, id, str, ix)) {
+      return FALSE;
+    }
+  }
+  id.kb.kb_code = code;
+  return macro_add(pindef, def_ix, id, str, ix);
+}
+
+// parses macro token between start and end, a delay like 10ms or
+// definitions tapped together like LEFT_SHIFT+A
+static bool parse_macro_token(def_config *pindef, u8_t *def_ix, const char *str,
+    u8_t start, u8_t end) {
+  lex_type_sym sym = { LEX_DEF, start, end };
+  int i = start;
+  u32_t ms = 0;
+  while (i <= end && str[i] >= '0' && str[i] <= '9') {
+    ms = ms * 10 + str[i++] - '0';
+  }
+  if (i > start) {
+    sym.offs_start = i;
+    if (i > end || !is_sym_named(delay_sym, str, &sym)) {
+      print_index_indicator(str, start);
+      KEYPARSERR("Syntax error: expected delay like 10%s\n", delay_sym);
+      return FALSE;
+    }
+    if (ms == 0 || ms > MACRO_DELAY_MAX) {
+      print_index_indicator(str, start);
+      KEYPARSERR("Error: delay must be 1-%i%s\n", MACRO_DELAY_MAX, delay_sym);
+      return FALSE;
+    }
+    return macro_add_op(pindef, def_ix, MACRO_OP_DELAY, ms, str, start);
+  }
+
+  // count definitions tapped together, joined by combo character
+  int depth = 0;
+  u8_t group = 1;
+  for (i = start; i <= end; i++) {
+    if (str[i] == numdef_chars[0]) depth++;
+    else if (str[i] == numdef_chars[1]) depth--;
+    else if (depth == 0 && str[i] == combo_chars[0]) group++;
+  }
+  if (group > 1 && !macro_add_op(pindef, def_ix, MACRO_OP_GROUP, group, str, start)) {
+    return FALSE;
+  }
+  while (start <= end) {
+    // definition name, then numerator if definition has one
+    for (i = start; i <= end && str[i] != combo_chars[0] && str[i] != numdef_chars[0]; i++);
+    sym.offs_start = start;
+    sym.offs_end = i - 1;
+    hid_id h_id;
+    bool numerator = FALSE;
+    h_id.type = HID_ID_TYPE_NONE;
+    if (i > start) {
+      lookup_def(str, &sym, &h_id, &numerator);
+    }
+    if (h_id.type == HID_ID_TYPE_NONE) {
+      print_index_indicator(str, start);
+      KEYPARSERR("Syntax error: unknown definition ");
+      print_lex_sym(&sym, str);
+      return FALSE;
+    }
+    if (numerator) {
+      if (i > end || str[i] != numdef_chars[0]) {
+        print_index_indicator(str, start);
+        KEYPARSERR("Syntax error: expected numerator after ");
+        print_lex_sym(&sym, str);
+        return FALSE;
+      }
+      sym.type = LEX_NUM;
+      sym.offs_start = ++i;
+      for (; i <= end && str[i] != numdef_chars[1]; i++);
+      sym.offs_end = i - 1;
+      if (i > end) {
+        print_index_indicator(str, sym.offs_start);
+        KEYPARSERR("Syntax error: numerator without closing '%c'\n", numdef_chars[1]);
+        return FALSE;
+      }
+      if (!parse_numerator(&sym, str, &h_id)) {
+        return FALSE;
+      }
+      sym.type = LEX_DEF;
+      i++;
+    }
+    if (!macro_add(pindef, def_ix, h_id, str, start)) {
+      return FALSE;
+    }
+    if (i <= end && str[i] != combo_chars[0]) {
+      print_index_indicator(str, i);
+      KEYPARSERR("Syntax error: unexpected character [%c] @ index %i\n", str[i], i);
+      return FALSE;
+    }
+    if (i == end) {
+      print_index_indicator(str, i);
+      KEYPARSERR("Syntax error: combo '%c' @ index %i must be followed by a definition\n", combo_chars[0], i);
+      return FALSE;
+    }
+    start = i + 1;
+  }
+  return TRUE;
+}
+
+// Compiles macro symbol, e.g. macro(F2 10ms LEFT_CTRL+C "hello"), to
+// definitions following a MACRO_OP_START entry, see def_config.h. Each
+// token or string character is a tap, delays wait between taps.
+static bool parse_macro(def_config *pindef, u8_t *def_ix, const char *str, lex_type_sym *sym) {
+  int i;
+  for (i = sym->offs_start; str[i] != numdef_chars[0]; i++);
+  lex_type_sym name = { LEX_DEF, sym->offs_start, i - 1 };
+  u16_t flags = is_sym_named(macro_cancel_sym, str, &name) ? MACRO_START_CANCEL : 0;
+  if (!macro_add_op(pindef, def_ix, MACRO_OP_START, flags, str, sym->offs_start)) {
+    return FALSE;
+  }
+  u8_t start = *def_ix;
+  int end = sym->offs_end; // closing parenthesis
+  i++;
+  while (i < end) {
+    char c = str[i];
+    if (strchr(ignore_chars, c)) {
+      i++;
+    } else if (c == string_chars[0]) {
+      // string, typed character by character
+      for (i++; i < end && str[i] != string_chars[0]; i++) {
+        if (!macro_add_char(pindef, def_ix, str, i)) {
+          return FALSE;
+        }
+      }
+      i++;
+    } else {
+      // token up to whitespace outside of numerators
+      int token = i;
+      int depth = 0;
+      while (i < end && (depth > 0 || strchr(ignore_chars, str[i]) == 0)) {
+        if (str[i] == numdef_chars[0]) depth++;
+        else if (str[i] == numdef_chars[1]) depth--;
+        i++;
+      }
+      if (!parse_macro_token(pindef, def_ix, str, token, i - 1)) {
+        return FALSE;
+      }
+    }
+  }
+  if (*def_ix == start) {
+    print_index_indicator(str, sym->offs_start);
+    KEYPARSERR("Error: empty macro\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
 // syntax format:
-//   PIN ASSIGN {def* | PIN TERN def* TERN_OPT def*}
+//   (LAYER) PIN ASSIGN {def* | PIN TERN def* TERN_OPT def*}
+//   PIN {COMBO PIN}+ ASSIGN def*
+//   where the last def can be a MACRO, see parse_macro
 //
 //   def = SYM (NUM)
 //
 
+static bool motion_add(def_config *pindef, int *steps, u8_t step, const char *str, u16_t ix) {
+  if (*steps >= APP_CONFIG_MOTION_STEPS) {
+    print_index_indicator(str, ix);
+    KEYPARSERR("Error: max %i steps in a motion\n", APP_CONFIG_MOTION_STEPS);
+    return FALSE;
+  }
+  pindef->motion[(*steps)++] = step;
+  return TRUE;
+}
+
+// Parses motion symbol, e.g. motion(2 3 6 pin5 100ms joy2), to motion steps
+// of directions in numpad notation and pins. Time between steps and joystick
+// are optional.
+static bool parse_motion(def_config *pindef, const char *str, lex_type_sym *sym) {
+  int i;
+  int steps = 0;
+  for (i = sym->offs_start; str[i] != numdef_chars[0]; i++);
+  int end = sym->offs_end; // closing parenthesis
+  pindef->motion_ms = MOTION_STEP_MS;
+  pindef->motion_joystick = 0;
+  i++;
+  while (i < end) {
+    if (strchr(ignore_chars, str[i])) {
+      i++;
+      continue;
+    }
+    int start = i;
+    while (i < end && strchr(ignore_chars, str[i]) == 0) i++;
+    lex_type_sym token = { LEX_DEF, start, i - 1 };
+    u8_t nbr;
+    if (is_pin_sym(str, &token)) {
+      if (!parse_pin_nbr(str, &token, &nbr) || nbr == 0 || nbr > APP_CONFIG_PINS) {
+        print_index_indicator(str, start);
+        KEYPARSERR("Syntax error: bad motion pin number ");
+        print_lex_sym(&token, str);
+        return FALSE;
+      }
+      if (!motion_add(pindef, &steps, MOTION_STEP_PIN | nbr, str, start)) {
+        return FALSE;
+      }
+    } else if (sym_strcmp(motion_joystick_sym, str, &token) > 0) {
+      char c = str[start + strlen(motion_joystick_sym)];
+      if (i - start != strlen(motion_joystick_sym) + 1 || c < '1' || c > '2') {
+        print_index_indicator(str, start);
+        KEYPARSERR("Syntax error: expected joystick like %s2\n", motion_joystick_sym);
+        return FALSE;
+      }
+      pindef->motion_joystick = c - '1';
+    } else {
+      // directions, or time between steps like 100ms
+      u32_t ms = 0;
+      int j;
+      for (j = start; j < i && str[j] >= '0' && str[j] <= '9'; j++) {
+        ms = ms * 10 + str[j] - '0';
+      }
+      token.offs_start = j;
+      if (j == start || (j < i && !is_sym_named(delay_sym, str, &token))) {
+        print_index_indicator(str, start);
+        KEYPARSERR("Syntax error: expected numpad directions 1-9, pin, delay like 100%s or %s2\n",
+            delay_sym, motion_joystick_sym);
+        return FALSE;
+      }
+      if (j < i) {
+        if (ms == 0 || ms > 0xff) {
+          print_index_indicator(str, start);
+          KEYPARSERR("Error: time between steps must be 1-255%s\n", delay_sym);
+          return FALSE;
+        }
+        pindef->motion_ms = ms;
+        continue;
+      }
+      for (j = start; j < i; j++) {
+        if (str[j] == '0') {
+          print_index_indicator(str, j);
+          KEYPARSERR("Syntax error: numpad directions are 1-9\n");
+          return FALSE;
+        }
+        if (!motion_add(pindef, &steps, str[j] - '0', str, j)) {
+          return FALSE;
+        }
+      }
+    }
+  }
+  if (steps == 0) {
+    print_index_indicator(str, sym->offs_start);
+    KEYPARSERR("Error: empty motion\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
 static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t lex_sym_cnt) {
   int sym_ix;
 
@@ -356,6 +773,19 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
 
   memset(pindef, 0, sizeof(def_config));
 
+  // layer prefix
+  if (lex_sym_cnt > 0 && syms[0].type == LEX_LAYER) {
+    pindef->layer = str[syms[0].offs_start + strlen(layer_sym)] - '0';
+    if (pindef->layer >= APP_CONFIG_LAYERS) {
+      print_index_indicator(str, syms[0].offs_start);
+      KEYPARSERR("Syntax error: layer number out of range ");
+      print_lex_sym(&syms[0], str);
+      return FALSE;
+    }
+    syms++;
+    lex_sym_cnt--;
+  }
+
   // check common syntax
   int tern_ix = -1;
   int tern_opt_ix = -1;
@@ -382,6 +812,22 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
       break;
     case LEX_ASSIGN:
       break;
+    case LEX_COMBO:
+      break;
+    case LEX_MACRO:
+      if (sym_ix != lex_sym_cnt - 1) {
+        print_index_indicator(str, sym->offs_start);
+        KEYPARSERR("Syntax error: macro must be last definition\n");
+        return FALSE;
+      }
+      break;
+    case LEX_MOTION:
+      if (sym_ix != 0) {
+        print_index_indicator(str, sym->offs_start);
+        KEYPARSERR("Syntax error: motion must be first definition\n");
+        return FALSE;
+      }
+      break;
     case LEX_TERN:
       if (tern_ix >= 0) {
         print_index_indicator(str, sym->offs_start);
@@ -434,28 +880,78 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
     return FALSE;
   }
 
+  if (tern_ix >= 0 && syms[lex_sym_cnt - 1].type == LEX_MACRO) {
+    print_index_indicator(str, syms[lex_sym_cnt - 1].offs_start);
+    KEYPARSERR("Error: macros cannot be ternary definitions\n");
+    return FALSE;
+  }
+
   // assignment syntax
-  if (syms[0].type != LEX_PIN) {
+  if (syms[0].type == LEX_MOTION) {
+    if (pindef->layer > 0) {
+      KEYPARSERR("Error: motions cannot be defined on layers\n");
+      return FALSE;
+    }
+    if (!parse_motion(pindef, str, &syms[0])) {
+      return FALSE;
+    }
+  } else if (syms[0].type != LEX_PIN) {
     print_index_indicator(str, syms[0].offs_start);
     KEYPARSERR("Syntax error: expected pin as first definition, found ");
     print_lex_sym(&syms[0], str);
     return FALSE;
-  }
-
-  if (!parse_pin_nbr(str, &syms[0], &pindef->pin)) {
+  } else if (!parse_pin_nbr(str, &syms[0], &pindef->pin)) {
     print_index_indicator(str, syms[0].offs_start);
     KEYPARSERR("Syntax error: bad pin number ");
     print_lex_sym(&syms[0], str);
     return FALSE;
-  }
-
-  if (pindef->pin <= 0 || pindef->pin > APP_CONFIG_PINS) {
+  } else if (pindef->pin <= 0 || pindef->pin > APP_CONFIG_PINS) {
     print_index_indicator(str, syms[0].offs_start);
     KEYPARSERR("Syntax error: pin number out of range ");
     print_lex_sym(&syms[0], str);
     return FALSE;
   }
 
+  // combo pins, removed from symbols once parsed
+  int combo_ix = 0;
+  while (lex_sym_cnt >= 2 && syms[0].type == LEX_PIN && syms[1].type == LEX_COMBO) {
+    if (lex_sym_cnt < 3 || syms[2].type != LEX_PIN) {
+      print_index_indicator(str, syms[1].offs_start);
+      KEYPARSERR("Syntax error: combo '%c' @ index %i must be followed by a pin\n", combo_chars[0], syms[1].offs_start);
+      return FALSE;
+    }
+    if (combo_ix >= APP_CONFIG_COMBO_PINS - 1) {
+      print_index_indicator(str, syms[2].offs_start);
+      KEYPARSERR("Error: max %i pins in a combo\n", APP_CONFIG_COMBO_PINS);
+      return FALSE;
+    }
+    u8_t *combo_pin = &pindef->combo[combo_ix];
+    if (!parse_pin_nbr(str, &syms[2], combo_pin) || *combo_pin == 0 || *combo_pin > APP_CONFIG_PINS) {
+      print_index_indicator(str, syms[2].offs_start);
+      KEYPARSERR("Syntax error: bad combo pin number ");
+      print_lex_sym(&syms[2], str);
+      return FALSE;
+    }
+    int i;
+    bool dup = *combo_pin == pindef->pin;
+    for (i = 0; i < combo_ix; i++) {
+      dup |= *combo_pin == pindef->combo[i];
+    }
+    if (dup) {
+      print_index_indicator(str, syms[2].offs_start);
+      KEYPARSERR("Error: pin already in combo ");
+      print_lex_sym(&syms[2], str);
+      return FALSE;
+    }
+    combo_ix++;
+    memmove(&syms[1], &syms[3], (lex_sym_cnt - 3) * sizeof(lex_type_sym));
+    lex_sym_cnt -= 2;
+  }
+  if (combo_ix > 0 && pindef->layer > 0) {
+    KEYPARSERR("Error: combos cannot be defined on layers\n");
+    return FALSE;
+  }
+
   if (lex_sym_cnt < 2 || syms[1].type != LEX_ASSIGN) {
     if (lex_sym_cnt >= 1) print_index_indicator(str, syms[1].offs_start);
     KEYPARSERR(
@@ -470,7 +966,7 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
   }
 
   if (lex_sym_cnt >= 3) {
-    if (syms[2].type == LEX_DEF) {
+    if (syms[2].type == LEX_DEF || syms[2].type == LEX_MACRO) {
       pindef->tern_pin = 0;
     } else if (syms[2].type == LEX_PIN) {
       // ternary syntax
@@ -509,6 +1005,17 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
     }
   }
 
+  if (combo_ix > 0 && pindef->tern_pin > 0) {
+    print_index_indicator(str, syms[2].offs_start);
+    KEYPARSERR("Error: combos cannot be ternary\n");
+    return FALSE;
+  }
+  if (pindef->motion[0] && pindef->tern_pin > 0) {
+    print_index_indicator(str, syms[2].offs_start);
+    KEYPARSERR("Error: motions cannot be ternary\n");
+    return FALSE;
+  }
+
   // build
 
   def_ix = 0;
@@ -526,6 +1033,11 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
       return FALSE;
     }
     if (sym->type == LEX_DEF) {
+      if (def_ix >= APP_CONFIG_DEFS_PER_PIN) {
+        print_index_indicator(str, sym->offs_start);
+        KEYPARSERR("Error: definition overflow\n");
+        return FALSE;
+      }
       hid_id h_id;
       lookup_def(str, sym, &h_id, &numerator);
       pindef->id[def_ix].type = h_id.type;
@@ -547,17 +1059,17 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
         }
       }
       def_ix++;
-      if (def_ix > APP_CONFIG_DEFS_PER_PIN) {
-        print_index_indicator(str, syms[def_ix + 1].offs_start);
-        KEYPARSERR("Error: definition overflow\n");
-        return FALSE;
-      }
 
     } else if (sym->type == LEX_NUM) {
       if (prev_numerator) {
         if (!parse_numerator(sym, str, &pindef->id[def_ix-1])) {
           return FALSE;
         }
+      } else if (sym_ix > 0 && syms[sym_ix-1].type == LEX_DEF && def_ix > 0 &&
+          sym_strcmp(turbo_sym, str, sym) >= 0) {
+        if (!parse_turbo(sym, str, &pindef->id[def_ix-1])) {
+          return FALSE;
+        }
       } else {
         print_index_indicator(str, sym->offs_start);
         KEYPARSERR("Syntax error: unexpected numerator ");
@@ -577,6 +1089,15 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
       }
     } else if (sym->type == LEX_TERN_OPT) {
       pindef->tern_splice = def_ix;
+    } else if (sym->type == LEX_MACRO) {
+      if (pindef->tern_pin > 0) {
+        print_index_indicator(str, sym->offs_start);
+        KEYPARSERR("Error: macros cannot be ternary\n");
+        return FALSE;
+      }
+      if (!parse_macro(pindef, &def_ix, str, sym)) {
+        return FALSE;
+      }
     } else {
       print_index_indicator(str, sym->offs_start);
       KEYPARSERR("Syntax error: unexpected symbol ");
@@ -599,52 +1120,100 @@ static bool parse(def_config *pindef, const char *str, lex_type_sym *syms, u8_t
 }
 
 bool def_config_parse(def_config *pindef, const char *str, u16_t len) {
+  if (len > 0xff) {
+    KEYPARSERR("Error: too long definition\n");
+    return FALSE;
+  }
   if (lex(str, len)) {
     return parse(pindef, str, lex_syms, lex_sym_ix);
   }
   return FALSE;
 }
 
+static void print_hid_id(hid_id id) {
+  if (id.type == HID_ID_TYPE_KEYBOARD) {
+    print("%s", USB_ARC_get_keymap(id.kb.kb_code)->name);
+  } else if (id.type == HID_ID_TYPE_MOUSE) {
+    const keymap *km = USB_ARC_get_mousemap(id.mouse.mouse_code);
+    print("%s", km->name);
+    if (km->numerator) {
+      print("(");
+      if (id.mouse.mouse_acc) {
+        print("ACC");
+      }
+      print("%s%i", id.mouse.mouse_sign ? "-" : "+", id.mouse.mouse_data);
+      print(")");
+    }
+  } else if (id.type == HID_ID_TYPE_JOYSTICK) {
+    const keymap *km = USB_ARC_get_joystickmap(id.joy.joystick_code);
+    print("%s", km->name);
+    if (km->numerator) {
+      print("(");
+      if (id.joy.joystick_acc) {
+        print("ACC");
+      }
+      print("%s%i", id.joy.joystick_sign ? "-" : "+", id.joy.joystick_data);
+      print(")");
+    }
+  }
+  if (def_turbo_hz(id)) {
+    print("(%s %i%s)", turbo_sym, def_turbo_hz(id), turbo_unit_sym);
+  }
+}
+
 void def_config_print(def_config *pindef) {
   int i;
-  print("pin%i = ", pindef->pin);
+  if (pindef->layer > 0) {
+    print("layer%i ", pindef->layer);
+  }
+  if (pindef->motion[0]) {
+    print("%s(", motion_sym);
+    for (i = 0; i < APP_CONFIG_MOTION_STEPS && pindef->motion[i]; i++) {
+      if (pindef->motion[i] & MOTION_STEP_PIN) {
+        print("%spin%i", i > 0 ? " " : "", pindef->motion[i] & ~MOTION_STEP_PIN);
+      } else {
+        print("%s%i", i > 0 && (pindef->motion[i-1] & MOTION_STEP_PIN) ? " " : "", pindef->motion[i]);
+      }
+    }
+    if (pindef->motion_ms != MOTION_STEP_MS) {
+      print(" %i%s", pindef->motion_ms, delay_sym);
+    }
+    if (pindef->motion_joystick) {
+      print(" %s%i", motion_joystick_sym, pindef->motion_joystick + 1);
+    }
+    print(")");
+  } else {
+    print("pin%i", pindef->pin);
+  }
+  for (i = 0; i < APP_CONFIG_COMBO_PINS - 1 && pindef->combo[i]; i++) {
+    print("+pin%i", pindef->combo[i]);
+  }
+  print(" = ");
   if (pindef->tern_pin > 0) {
     print("pin%i ? ", pindef->tern_pin);
   }
+  bool macro = FALSE;
+  u16_t group = 0;
   for (i = 0; i < APP_CONFIG_DEFS_PER_PIN; i++) {
     hid_id id = pindef->id[i];
     if (pindef->tern_pin > 0 && i == pindef->tern_splice)
       print(": ");
     if (id.type != HID_ID_TYPE_NONE) {
-      if (id.type == HID_ID_TYPE_KEYBOARD) {
-        print("%s ", USB_ARC_get_keymap(id.kb.kb_code)->name);
-      } else if (id.type == HID_ID_TYPE_MOUSE) {
-        const keymap *km = USB_ARC_get_mousemap(id.mouse.mouse_code);
-        print("%s", km->name);
-        if (km->numerator) {
-          print("(");
-          if (id.mouse.mouse_acc) {
-            print("ACC");
-          }
-          print("%s%i", id.mouse.mouse_sign ? "-" : "+", id.mouse.mouse_data);
-          print(")");
-        }
-        print(" ");
-      } else if (id.type == HID_ID_TYPE_JOYSTICK) {
-        const keymap *km = USB_ARC_get_joystickmap(id.joy.joystick_code);
-        print("%s", km->name);
-        if (km->numerator) {
-          print("(");
-          if (id.joy.joystick_acc) {
-            print("ACC");
-          }
-          print("%s%i", id.joy.joystick_sign ? "-" : "+", id.joy.joystick_data);
-          print(")");
-        }
-        print(" ");
-      }
+      print_hid_id(id);
+      // definitions tapped together in macro are joined
+      print(group > 1 ? "+" : " ");
+      if (group > 0) group--;
+    } else if (MACRO_OP(id) == MACRO_OP_START) {
+      print("%s(", MACRO_ARG(id) & MACRO_START_CANCEL ? "MACRO_CANCEL" : "MACRO");
+      macro = TRUE;
+    } else if (MACRO_OP(id) == MACRO_OP_DELAY) {
+      print("%i%s ", MACRO_ARG(id), delay_sym);
+    } else if (MACRO_OP(id) == MACRO_OP_GROUP) {
+      group = MACRO_ARG(id);
     }
   }
+  if (macro) {
+    print(")");
+  }
   print("\n");
 }
-
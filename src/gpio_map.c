@@ -7,54 +7,118 @@
 
 #include "gpio_map.h"
 
-static const gpio_pin_map pin_map[APP_CONFIG_PINS] = {
-#ifdef CONFIG_HY_TEST_BOARD
-    {.port = PORTE, .pin = PIN2 },
-    {.port = PORTE, .pin = PIN3 },
-    {.port = PORTE, .pin = PIN4 },
-    {.port = PORTE, .pin = PIN5 },
-#else
-    {.port = PORTB, .pin = PIN12 }, //1
-    {.port = PORTB, .pin = PIN13 }, //2
-    {.port = PORTB, .pin = PIN14 }, //3
-    {.port = PORTB, .pin = PIN15 }, //4
-    {.port = PORTA, .pin = PIN8 }, //5
-    {.port = PORTA, .pin = PIN9 }, //6
-    {.port = PORTA, .pin = PIN10 }, //7
-    {.port = PORTA, .pin = PIN15 }, //8
-    {.port = PORTB, .pin = PIN3 }, //9
-    {.port = PORTB, .pin = PIN4 }, //10
-    {.port = PORTB, .pin = PIN5 }, //11
-    {.port = PORTB, .pin = PIN6 }, //12
-    {.port = PORTB, .pin = PIN7 }, //13
-    {.port = PORTB, .pin = PIN11 }, //14
-    {.port = PORTB, .pin = PIN10 }, //15
-    {.port = PORTB, .pin = PIN2 }, //16
-    {.port = PORTB, .pin = PIN1 }, //17
-    {.port = PORTB, .pin = PIN0 }, //18
-    {.port = PORTA, .pin = PIN7 }, //19
-    {.port = PORTA, .pin = PIN6 }, //20
-    {.port = PORTA, .pin = PIN5 }, //21
-    {.port = PORTA, .pin = PIN4 }, //22
-    {.port = PORTA, .pin = PIN1 }, //23
-    {.port = PORTA, .pin = PIN0 }, //24
-    {.port = PORTC, .pin = PIN14 }, //25
-    {.port = PORTC, .pin = PIN13 }, //26
-#endif
+#define _GPIO_MAP_ENTRY(p, n)   {.port = (p), .pin = (n) },
+
+static const gpio_pin_map pin_map_default[APP_CONFIG_GPIO_PINS] = {
+    BOARD_PINS(_GPIO_MAP_ENTRY)
 };
 
 static const gpio_pin_map led_map = {
-#ifdef CONFIG_HY_TEST_BOARD
-    .port =PORTC, .pin =PIN6
-#else
-    .port =PORTC, .pin =PIN15
+    .port = BOARD_LED_PORT, .pin = BOARD_LED_PIN
+};
+
+// gpios that can never be mapped to a pin
+static const gpio_pin_map reserved_map[] = {
+    {.port = PORTA, .pin = PIN2 }, // uart2 tx
+    {.port = PORTA, .pin = PIN3 }, // uart2 rx
+    {.port = PORTA, .pin = PIN11 }, // usb dm
+    {.port = PORTA, .pin = PIN12 }, // usb dp
+    {.port = PORTA, .pin = PIN13 }, // swdio
+    {.port = PORTA, .pin = PIN14 }, // swclk
+    {.port = BOARD_USB_CABLE_PORT, .pin = BOARD_USB_CABLE_PIN }, // usb cable
+#if !BOARD_SWJ_JTAG_DISABLE
+    {.port = PORTA, .pin = PIN15 }, // jtdi
+    {.port = PORTB, .pin = PIN3 }, // jtdo
+    {.port = PORTB, .pin = PIN4 }, // njtrst
+#endif
+#ifdef CONFIG_IO_EXP
+    {.port = PORTB, .pin = PIN6 }, // i2c1 scl
+    {.port = PORTB, .pin = PIN7 }, // i2c1 sda
+    {.port = IO_EXP_INT_PORT, .pin = IO_EXP_INT_PIN }, // expander int
 #endif
 };
 
+static gpio_pin_map pin_map[APP_CONFIG_GPIO_PINS];
+static gpio_map_sample_op sample_ops[APP_CONFIG_GPIO_PINS];
+static u8_t sample_op_cnt;
+
+static bool gpio_map_same(const gpio_pin_map *a, const gpio_pin_map *b) {
+  return a->port == b->port && a->pin == b->pin;
+}
+
+// derives sampler operations from map, returns number of operations
+static u8_t gpio_map_derive(const gpio_pin_map *map, gpio_map_sample_op *ops) {
+  u8_t cnt = 0;
+  gpio_map_sample_op *op = NULL;
+  int i;
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    const gpio_pin_map *m = &map[i];
+    if (GPIO_MAP_IS_UNUSED(m)) {
+      op = NULL;
+      continue;
+    }
+    // extend current run if next bit of same port and not crossing a word
+    if (op && op->port == m->port && (u32_t)(op->src + (i - op->dst)) == m->pin &&
+        (i & 31) != 0) {
+      op->mask = (op->mask << 1) | 1;
+    } else {
+      op = &ops[cnt++];
+      op->port = m->port;
+      op->src = m->pin;
+      op->dst = i;
+      op->mask = 1;
+    }
+  }
+  return cnt;
+}
+
+void GPIO_MAP_init(void) {
+  GPIO_MAP_set_pin_map(pin_map_default);
+}
+
 const gpio_pin_map *GPIO_MAP_get_pin_map(void) {
   return &pin_map[0];
 }
 
+const gpio_pin_map *GPIO_MAP_get_default_pin_map(void) {
+  return &pin_map_default[0];
+}
+
+int GPIO_MAP_check_pin_map(const gpio_pin_map *map) {
+  int i, j;
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    const gpio_pin_map *m = &map[i];
+    if (GPIO_MAP_IS_UNUSED(m)) continue;
+    if (m->port >= GPIO_MAP_PORTS || m->pin > PIN15) return i;
+    if ((BOARD_GPIO_PORTS & (1 << m->port)) == 0) return i;
+    if (gpio_map_same(m, &led_map)) return i;
+    for (j = 0; j < sizeof(reserved_map)/sizeof(reserved_map[0]); j++) {
+      if (gpio_map_same(m, &reserved_map[j])) return i;
+    }
+    for (j = 0; j < i; j++) {
+      if (gpio_map_same(m, &map[j])) return i;
+    }
+  }
+  return -1;
+}
+
+void GPIO_MAP_set_pin_map(const gpio_pin_map *map) {
+  if (map != pin_map) {
+    memcpy(pin_map, map, sizeof(pin_map));
+  }
+  sample_op_cnt = gpio_map_derive(pin_map, sample_ops);
+}
+
+const gpio_map_sample_op *GPIO_MAP_get_sample_ops(u8_t *count) {
+  *count = sample_op_cnt;
+  return &sample_ops[0];
+}
+
+u8_t GPIO_MAP_count_sample_ops(const gpio_pin_map *map) {
+  gpio_map_sample_op ops[APP_CONFIG_GPIO_PINS];
+  return gpio_map_derive(map, ops);
+}
+
 const gpio_pin_map *GPIO_MAP_get_led_map(void) {
   return &led_map;
 }
@@ -11,12 +11,50 @@
 #include "system.h"
 #include "gpio.h"
 
+// number of stm32 gpio ports a pin may be mapped to, PORTA..PORTE
+#define GPIO_MAP_PORTS          5
+
 typedef struct {
   gpio_port port;
   gpio_pin pin;
 } gpio_pin_map;
 
+// pin map entry not bound to any gpio, never sampled
+#define GPIO_MAP_UNUSED_PORT    ((gpio_port)0xff)
+#define GPIO_MAP_UNUSED         {.port = GPIO_MAP_UNUSED_PORT, .pin = 0 }
+#define GPIO_MAP_IS_UNUSED(m)   ((m)->port == GPIO_MAP_UNUSED_PORT)
+
+/**
+ * Sampler operation, derived from pin map. Extracts a run of consecutive
+ * gpio bits of one port into consecutive pins:
+ *   raw[dst/32] |= ((~IDR >> src) & mask) << (dst%32)
+ */
+typedef struct {
+  u8_t port;
+  u8_t src;
+  u8_t dst;
+  u16_t mask;
+} gpio_map_sample_op;
+
+void GPIO_MAP_init(void);
 const gpio_pin_map *GPIO_MAP_get_pin_map(void);
+const gpio_pin_map *GPIO_MAP_get_default_pin_map(void);
 const gpio_pin_map *GPIO_MAP_get_led_map(void);
+/**
+ * Checks a pin map of APP_CONFIG_GPIO_PINS entries. Returns index of first
+ * bad entry, i.e. a nonexisting, reserved or already mapped gpio or a gpio
+ * on a port the board does not clock, or -1 if ok.
+ */
+int GPIO_MAP_check_pin_map(const gpio_pin_map *map);
+/**
+ * Sets pin map and derives sampler operations. Does not configure gpios,
+ * see PROC_config_input.
+ */
+void GPIO_MAP_set_pin_map(const gpio_pin_map *map);
+const gpio_map_sample_op *GPIO_MAP_get_sample_ops(u8_t *count);
+/**
+ * Returns number of sampler operations needed for given map.
+ */
+u8_t GPIO_MAP_count_sample_ops(const gpio_pin_map *map);
 
 #endif /* SRC_GPIO_MAP_H_ */
@@ -0,0 +1,274 @@
+/*
+ * io_exp.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "io_exp.h"
+
+#ifdef CONFIG_IO_EXP
+
+#include "i2c_dev.h"
+#include "gpio.h"
+#include "timer.h"
+
+// MCP23017 registers, IOCON.BANK = 0, sequential addressing
+#define MCP_IPOLA       0x02
+#define MCP_IOCON       0x0a
+#define MCP_GPPUA       0x0c
+#define MCP_GPIOA       0x12
+
+#define MCP_IOCON_MIRROR  (1<<6)
+#define MCP_IOCON_ODR     (1<<2)
+
+// consecutive failed transfers before taking an expander offline
+#define IO_EXP_MAX_ERRORS 4
+// ms before configuring an offline expander again, doubled per failed
+// attempt up to max
+#define IO_EXP_RETRY_MS     8
+#define IO_EXP_RETRY_MAX_MS 1024
+
+typedef enum {
+  EXP_OFFLINE = 0,
+  EXP_CFG_PENDING,
+  EXP_CFG,
+  EXP_IDLE,
+  EXP_READ
+} io_exp_state;
+
+typedef struct {
+  // must be first, callback casts i2c_dev back to io_exp
+  i2c_dev i2c;
+  volatile io_exp_state state;
+  volatile bool pending;        // read requested
+  volatile u16_t gpio;          // last read state, set bit = active
+  u32_t t_trig_us;              // INT flank timestamp of pending read
+  u8_t err_cnt;
+  u16_t backoff_ms;             // delay of next retry when offline
+  u16_t retry_ms;               // ms left until retry, 0 if not retrying
+  u8_t rx[2];
+  i2c_dev_sequence read_seq[2];
+  io_exp_stats stats;
+} io_exp;
+
+static io_exp exps[IO_EXP_DEVICES];
+static volatile bool bus_busy = FALSE;
+
+// one INT for both ports, open drain so several expanders share the line
+static const u8_t cfg_iocon[] = {
+    MCP_IOCON, MCP_IOCON_MIRROR | MCP_IOCON_ODR
+};
+// IPOLA/B inverted so grounded input reads 1, GPINTENA/B all,
+// DEFVALA/B and INTCONA/B zero to interrupt on any change
+static const u8_t cfg_int[] = {
+    MCP_IPOLA, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00
+};
+// GPPUA/B pullups on all inputs
+static const u8_t cfg_pullup[] = {
+    MCP_GPPUA, 0xff, 0xff
+};
+static const u8_t reg_gpio = MCP_GPIOA;
+
+static const i2c_dev_sequence cfg_seq[] = {
+    I2C_SEQ_TX_STOP((u8_t *)cfg_iocon, sizeof(cfg_iocon)),
+    I2C_SEQ_TX_STOP((u8_t *)cfg_int, sizeof(cfg_int)),
+    I2C_SEQ_TX_STOP((u8_t *)cfg_pullup, sizeof(cfg_pullup)),
+};
+
+// takes expander offline, reading all inactive, until configured again
+// after backoff
+static void io_exp_offline(io_exp *e) {
+  e->state = EXP_OFFLINE;
+  e->pending = FALSE;
+  e->gpio = 0;
+  e->err_cnt = 0;
+  e->backoff_ms = e->backoff_ms == 0 ? IO_EXP_RETRY_MS :
+      MIN(e->backoff_ms * 2, IO_EXP_RETRY_MAX_MS);
+  e->retry_ms = e->backoff_ms;
+  e->stats.offline++;
+}
+
+// counts failed transfer, returns TRUE if expander was taken offline
+static bool io_exp_error(io_exp *e) {
+  e->stats.errors++;
+  if (++e->err_cnt >= IO_EXP_MAX_ERRORS) {
+    io_exp_offline(e);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+// starts next queued transfer if bus is free, called with irqs disabled.
+// A transfer not accepted by the driver stays queued for next kick.
+static void io_exp_kick(void) {
+  int i;
+  if (bus_busy) return;
+  for (i = 0; i < IO_EXP_DEVICES; i++) {
+    io_exp *e = &exps[i];
+    int res;
+    if (e->state == EXP_CFG_PENDING) {
+      e->state = EXP_CFG;
+      res = I2C_DEV_sequence(&e->i2c, cfg_seq, sizeof(cfg_seq)/sizeof(cfg_seq[0]));
+      if (res != I2C_OK) {
+        e->state = EXP_CFG_PENDING;
+      }
+    } else if (e->state == EXP_IDLE && e->pending) {
+      e->state = EXP_READ;
+      res = I2C_DEV_sequence(&e->i2c, e->read_seq, 2);
+      if (res != I2C_OK) {
+        e->state = EXP_IDLE;
+      } else {
+        e->pending = FALSE;
+      }
+    } else {
+      continue;
+    }
+    if (res == I2C_OK) {
+      bus_busy = TRUE;
+      return;
+    }
+    io_exp_error(e);
+  }
+}
+
+static void io_exp_request_all(u32_t now) {
+  int i;
+  for (i = 0; i < IO_EXP_DEVICES; i++) {
+    io_exp *e = &exps[i];
+    if (e->state != EXP_IDLE && e->state != EXP_READ) continue;
+    if (e->state == EXP_READ) {
+      e->stats.retriggers++;
+    }
+    if (!e->pending) {
+      e->t_trig_us = now;
+      e->pending = TRUE;
+    }
+  }
+}
+
+static void io_exp_i2c_cb(i2c_dev *dev, int res) {
+  io_exp *e = (io_exp *)dev;
+  bus_busy = FALSE;
+  if (e->state == EXP_CFG) {
+    if (res == I2C_OK) {
+      // initial read
+      e->state = EXP_IDLE;
+      e->t_trig_us = TIMER_get_us();
+      e->pending = TRUE;
+    } else if (!io_exp_error(e)) {
+      e->state = EXP_CFG_PENDING;
+    }
+  } else if (e->state == EXP_READ) {
+    e->state = EXP_IDLE;
+    if (res == I2C_OK) {
+      e->gpio = e->rx[0] | (e->rx[1] << 8);
+      e->err_cnt = 0;
+      e->backoff_ms = 0;
+      u32_t lat = TIMER_get_us() - e->t_trig_us;
+      io_exp_stats *s = &e->stats;
+      s->lat_last_us = lat;
+      if (s->reads == 0 || lat < s->lat_min_us) s->lat_min_us = lat;
+      if (lat > s->lat_max_us) s->lat_max_us = lat;
+      s->lat_avg_us = s->reads == 0 ? lat : (s->lat_avg_us * 7 + lat) / 8;
+      s->reads++;
+    } else if (!io_exp_error(e)) {
+      e->pending = TRUE;
+    }
+  }
+
+  enter_critical();
+  int i;
+  bool any_pending = FALSE;
+  for (i = 0; i < IO_EXP_DEVICES; i++) {
+    any_pending |= exps[i].pending || exps[i].state == EXP_CFG_PENDING;
+  }
+  if (!any_pending && gpio_get(IO_EXP_INT_PORT, IO_EXP_INT_PIN) == 0) {
+    // line still held low, some expander changed while another held INT
+    // asserted so no flank was seen
+    io_exp_request_all(TIMER_get_us());
+  }
+  io_exp_kick();
+  exit_critical();
+}
+
+static void io_exp_int_irq(gpio_pin pin) {
+  (void)pin;
+  u32_t now = TIMER_get_us();
+  enter_critical();
+  io_exp_request_all(now);
+  io_exp_kick();
+  exit_critical();
+}
+
+void IO_EXP_init(void) {
+  int i;
+  memset(exps, 0, sizeof(exps));
+  bus_busy = FALSE;
+  for (i = 0; i < IO_EXP_DEVICES; i++) {
+    io_exp *e = &exps[i];
+    I2C_DEV_init(&e->i2c, IO_EXP_I2C_CLOCK, _I2C_BUS(0), IO_EXP_I2C_ADDR + i);
+    I2C_DEV_set_callback(&e->i2c, io_exp_i2c_cb);
+    i2c_dev_sequence read_seq[2] = {
+        I2C_SEQ_TX((u8_t *)&reg_gpio, 1),
+        I2C_SEQ_RX_STOP(e->rx, 2)
+    };
+    memcpy(e->read_seq, read_seq, sizeof(read_seq));
+    if (I2C_DEV_open(&e->i2c) == I2C_OK) {
+      e->state = EXP_CFG_PENDING;
+    } else {
+      DBG(D_APP, D_WARN, "io_exp: could not open expander %i\n", i);
+    }
+  }
+
+  gpio_config(IO_EXP_INT_PORT, IO_EXP_INT_PIN, CLK_2MHZ, IN, AF0, OPENDRAIN, PULLUP);
+  gpio_interrupt_config(IO_EXP_INT_PORT, IO_EXP_INT_PIN, io_exp_int_irq, FLANK_DOWN);
+  gpio_interrupt_mask_enable(IO_EXP_INT_PORT, IO_EXP_INT_PIN, TRUE);
+
+  enter_critical();
+  io_exp_kick();
+  exit_critical();
+}
+
+void IO_EXP_timer(void) {
+  int i;
+  enter_critical();
+  for (i = 0; i < IO_EXP_DEVICES; i++) {
+    io_exp *e = &exps[i];
+    if (e->state == EXP_OFFLINE && e->retry_ms && --e->retry_ms == 0) {
+      // configure again, it may have lost power
+      e->state = EXP_CFG_PENDING;
+    }
+  }
+  io_exp_kick();
+  exit_critical();
+}
+
+u16_t IO_EXP_get_state(u8_t dev) {
+  return exps[dev].gpio;
+}
+
+bool IO_EXP_is_online(u8_t dev) {
+  return exps[dev].state != EXP_OFFLINE;
+}
+
+bool IO_EXP_busy(void) {
+  return bus_busy;
+}
+
+void IO_EXP_get_stats(u8_t dev, io_exp_stats *stats) {
+  enter_critical();
+  memcpy(stats, &exps[dev].stats, sizeof(io_exp_stats));
+  exit_critical();
+}
+
+void IO_EXP_clear_stats(void) {
+  int i;
+  enter_critical();
+  for (i = 0; i < IO_EXP_DEVICES; i++) {
+    memset(&exps[i].stats, 0, sizeof(io_exp_stats));
+  }
+  exit_critical();
+}
+
+#endif // CONFIG_IO_EXP
@@ -0,0 +1,59 @@
+/*
+ * io_exp.h
+ *
+ * MCP23017 I2C io expander inputs. A flank on the shared INT line starts an
+ * interrupt driven read of the GPIOA/GPIOB registers of all expanders. The
+ * sampler in APP_timer merges the latest read state into the pin map before
+ * debouncing, so nothing here ever blocks the timer or usb irqs.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef SRC_IO_EXP_H_
+#define SRC_IO_EXP_H_
+
+#include "system.h"
+
+typedef struct {
+  u32_t reads;        // completed register reads
+  u32_t errors;       // failed bus transfers
+  u32_t retriggers;   // INT flanks while a read was already ongoing
+  u32_t offline;      // times taken offline by consecutive errors
+  u32_t lat_last_us;  // INT flank to read completion
+  u32_t lat_min_us;
+  u32_t lat_max_us;
+  u32_t lat_avg_us;   // running average, 1/8 weight per read
+} io_exp_stats;
+
+#ifdef CONFIG_IO_EXP
+
+/**
+ * Configures all expanders and arms the INT line. Expanders failing
+ * consecutive transfers are taken offline and read as all inactive, and are
+ * configured again after a backoff doubling per failed attempt.
+ */
+void IO_EXP_init(void);
+/**
+ * Counts down offline backoffs and restarts transfers the driver did not
+ * accept. Call once per millisecond, from irq.
+ */
+void IO_EXP_timer(void);
+/**
+ * Returns last read input state of given expander, bit set means active
+ * (grounded) input. Bits 0-7 are GPA0-7, bits 8-15 are GPB0-7.
+ * Callable from irq.
+ */
+u16_t IO_EXP_get_state(u8_t dev);
+bool IO_EXP_is_online(u8_t dev);
+/**
+ * Returns TRUE while a transfer is ongoing, the bus must not be stopped
+ * then. Callable from irq.
+ */
+bool IO_EXP_busy(void);
+void IO_EXP_get_stats(u8_t dev, io_exp_stats *stats);
+void IO_EXP_clear_stats(void);
+
+#endif // CONFIG_IO_EXP
+
+#endif /* SRC_IO_EXP_H_ */
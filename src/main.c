@@ -11,6 +11,10 @@
 #include "app.h"
 #include "gpio.h"
 #include "usb/usb_arcade.h"
+#ifdef CONFIG_IO_EXP
+#include "i2c_driver.h"
+#include "io_exp.h"
+#endif
 
 static void assert_cb(void) {
   set_print_output(IOSTD);
@@ -29,6 +33,9 @@ int main(void) {
   UART_assure_tx(_UART(0), TRUE);
   //UART_sync_tx(_UART(0), TRUE);
   PROC_periph_init();
+#ifdef CONFIG_IO_EXP
+  I2C_init();
+#endif
   exit_critical();
 
   SYS_set_assert_callback(assert_cb);
@@ -51,13 +58,17 @@ int main(void) {
 
   CLI_init();
 
+#ifdef CONFIG_IO_EXP
+  IO_EXP_init();
+#endif
+
   rand_seed(0xd0decaed ^ SYS_get_tick());
 
   APP_init();
 
   while (1) {
     while (TASK_tick());
-    TASK_wait();
+    if (!APP_idle()) TASK_wait();
   }
 
   return 0;
@@ -157,6 +157,44 @@ int FS_save_config(char *name) {
   hdr.acc_wheel_speed = APP_cfg_get_acc_wheel_speed();
   hdr.joystick_delta_ms = APP_cfg_get_joystick_delta_ms();
   hdr.joystick_acc_speed = APP_cfg_get_joystick_acc_speed();
+  hdr.min_hold_ms = APP_cfg_get_min_hold_ms();
+  hdr.latch_mask = APP_cfg_get_latch_mask();
+  hdr.tern_release_first = APP_cfg_get_tern_release_first();
+  hdr.nbr_of_pin_defs = 0;
+  hdr.nbr_of_gpio_pins = APP_CONFIG_GPIO_PINS;
+  hdr.combo_window_ms = APP_cfg_get_combo_window_ms();
+  hdr.nbr_of_combos = APP_cfg_get_combo_usage();
+  hdr.nbr_of_motions = APP_cfg_get_motion_usage();
+  hdr.turbo_duty = APP_cfg_get_turbo_duty();
+  hdr.usb_personality = APP_cfg_get_usb_personality();
+  hdr.usb_latency = APP_cfg_get_usb_latency();
+  bool four_way;
+  hdr.socd_4way = 0;
+  hdr.socd_mode[0] = APP_cfg_get_socd(0, &four_way);
+  hdr.socd_4way |= four_way ? (1 << 0) : 0;
+  hdr.socd_mode[1] = APP_cfg_get_socd(1, &four_way);
+  hdr.socd_4way |= four_way ? (1 << 1) : 0;
+  app_acc acc;
+  for (acc = 0; acc < MIN(_ACC_CNT, FILE_ACC_CURVES); acc++) {
+    vel_curve c;
+    APP_cfg_get_acc_curve(acc, &c);
+    hdr.acc_curves[acc].type = c.type;
+    hdr.acc_curves[acc].points = c.points;
+    memcpy(hdr.acc_curves[acc].x, c.x, MIN(VEL_CURVE_POINTS, FILE_CURVE_POINTS));
+    memcpy(hdr.acc_curves[acc].y, c.y, MIN(VEL_CURVE_POINTS, FILE_CURVE_POINTS));
+  }
+  u8_t pin, layer;
+  def_config cfg;
+  memset(hdr.layer_pin, 0, sizeof(hdr.layer_pin));
+  memset(hdr.layer_mode, 0, sizeof(hdr.layer_mode));
+  for (layer = 1; layer < APP_CONFIG_LAYERS && layer < FILE_LAYERS; layer++) {
+    hdr.layer_mode[layer] = APP_cfg_get_layer(layer, &hdr.layer_pin[layer]);
+  }
+  for (layer = 0; layer < APP_CONFIG_LAYERS; layer++) {
+    for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
+      if (APP_cfg_get_pin(layer, pin, &cfg)) hdr.nbr_of_pin_defs++;
+    }
+  }
 
   res = NIFFS_write(&fs, fd, (u8_t *)&hdr, sizeof(hdr));
   if (res < NIFFS_OK) {
@@ -164,13 +202,77 @@ int FS_save_config(char *name) {
     NIFFS_close(&fs, fd);
     return res;
   }
-  def_config *cfg = APP_cfg_get_pin(0);
-    res = NIFFS_write(&fs, fd, (u8_t *)cfg, sizeof(def_config)*hdr.nbr_of_pins);
+  u8_t gpio_map[APP_CONFIG_GPIO_PINS];
+  const gpio_pin_map *map = GPIO_MAP_get_pin_map();
+  for (pin = 0; pin < APP_CONFIG_GPIO_PINS; pin++) {
+    gpio_map[pin] = GPIO_MAP_IS_UNUSED(&map[pin]) ?
+        FILE_GPIO_UNUSED : ((map[pin].port << 4) | map[pin].pin);
+  }
+  res = NIFFS_write(&fs, fd, gpio_map, sizeof(gpio_map));
   if (res < NIFFS_OK) {
-    DBG(D_FS, D_INFO, "save err: write cfg %i\n", res);
+    DBG(D_FS, D_INFO, "save err: write gpio map %i\n", res);
     NIFFS_close(&fs, fd);
     return res;
   }
+  for (layer = 0; layer < APP_CONFIG_LAYERS; layer++) {
+    for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
+      file_pin_def fpd;
+      fpd.def_len = APP_cfg_get_pin(layer, pin, &cfg);
+      if (fpd.def_len == 0) continue;
+      fpd.pin = cfg.pin;
+      fpd.layer = cfg.layer;
+      fpd.tern_pin = cfg.tern_pin;
+      fpd.tern_splice = cfg.tern_splice;
+      res = NIFFS_write(&fs, fd, (u8_t *)&fpd, sizeof(fpd));
+      if (res >= NIFFS_OK) {
+        res = NIFFS_write(&fs, fd, (u8_t *)cfg.id, fpd.def_len * sizeof(hid_id));
+      }
+      if (res < NIFFS_OK) {
+        DBG(D_FS, D_INFO, "save err: write cfg %i\n", res);
+        NIFFS_close(&fs, fd);
+        return res;
+      }
+    }
+  }
+  u8_t combo;
+  for (combo = 0; combo < APP_CONFIG_COMBOS; combo++) {
+    file_combo_def fcd;
+    fcd.def_len = APP_cfg_get_combo(combo, &cfg);
+    if (fcd.def_len == 0) continue;
+    memset(fcd.pins, 0, sizeof(fcd.pins));
+    fcd.pins[0] = cfg.pin;
+    for (pin = 1; pin < APP_CONFIG_COMBO_PINS && pin < FILE_COMBO_PINS; pin++) {
+      fcd.pins[pin] = cfg.combo[pin-1];
+    }
+    res = NIFFS_write(&fs, fd, (u8_t *)&fcd, sizeof(fcd));
+    if (res >= NIFFS_OK) {
+      res = NIFFS_write(&fs, fd, (u8_t *)cfg.id, fcd.def_len * sizeof(hid_id));
+    }
+    if (res < NIFFS_OK) {
+      DBG(D_FS, D_INFO, "save err: write combo %i\n", res);
+      NIFFS_close(&fs, fd);
+      return res;
+    }
+  }
+  u8_t motion;
+  for (motion = 0; motion < APP_CONFIG_MOTIONS; motion++) {
+    file_motion_def fmd;
+    fmd.def_len = APP_cfg_get_motion(motion, &cfg);
+    if (fmd.def_len == 0) continue;
+    memset(fmd.steps, 0, sizeof(fmd.steps));
+    memcpy(fmd.steps, cfg.motion, MIN(APP_CONFIG_MOTION_STEPS, FILE_MOTION_STEPS));
+    fmd.step_ms = cfg.motion_ms;
+    fmd.joystick = cfg.motion_joystick;
+    res = NIFFS_write(&fs, fd, (u8_t *)&fmd, sizeof(fmd));
+    if (res >= NIFFS_OK) {
+      res = NIFFS_write(&fs, fd, (u8_t *)cfg.id, fmd.def_len * sizeof(hid_id));
+    }
+    if (res < NIFFS_OK) {
+      DBG(D_FS, D_INFO, "save err: write motion %i\n", res);
+      NIFFS_close(&fs, fd);
+      return res;
+    }
+  }
 
   NIFFS_close(&fs, fd);
   return res < NIFFS_OK ? res : NIFFS_OK;
@@ -192,20 +294,22 @@ int FS_load_config(char *name) {
     NIFFS_close(&fs, fd);
     return res;
   }
+  // a config of other version is not converted, caller decides on defaults
   if (hdr.file_version != FS_FILE_VERSION) {
     print("wrong file version\n");
     NIFFS_close(&fs, fd);
-    return 0;
+    return ERR_NIFFS_BAD_CONFIG;
   }
-  if (hdr.defs_per_pin != APP_CONFIG_DEFS_PER_PIN) {
+  if (hdr.defs_per_pin > APP_CONFIG_DEFS_PER_PIN) {
     print("defs per pin mismatch\n");
     NIFFS_close(&fs, fd);
-    return 0;
+    return ERR_NIFFS_BAD_CONFIG;
   }
-  if (hdr.nbr_of_pins != APP_CONFIG_PINS) {
+  // fewer pins are ok, e.g. config saved before io expanders were added
+  if (hdr.nbr_of_pins > APP_CONFIG_PINS) {
     print("nbr of pin mismatch\n");
     NIFFS_close(&fs, fd);
-    return 0;
+    return ERR_NIFFS_BAD_CONFIG;
   }
 
   APP_cfg_set_debounce_cycles(hdr.debounce_cycles);
@@ -214,18 +318,149 @@ int FS_load_config(char *name) {
   APP_cfg_set_acc_wheel_speed(hdr.acc_wheel_speed);
   APP_cfg_set_joystick_delta_ms(hdr.joystick_delta_ms);
   APP_cfg_set_joystick_acc_speed(hdr.joystick_acc_speed);
+  APP_cfg_set_min_hold_ms(hdr.min_hold_ms);
+  APP_cfg_set_latch_mask(hdr.latch_mask);
+  APP_cfg_set_tern_release_first(hdr.tern_release_first);
+  APP_cfg_set_combo_window_ms(hdr.combo_window_ms);
+  APP_cfg_set_turbo_duty(hdr.turbo_duty);
+  APP_cfg_set_usb_personality(hdr.usb_personality);
+  APP_cfg_set_usb_latency(hdr.usb_latency);
+  APP_cfg_set_socd(0, hdr.socd_mode[0], hdr.socd_4way & (1 << 0));
+  APP_cfg_set_socd(1, hdr.socd_mode[1], hdr.socd_4way & (1 << 1));
+  app_acc acc;
+  for (acc = 0; acc < MIN(_ACC_CNT, FILE_ACC_CURVES); acc++) {
+    vel_curve c;
+    memset(&c, 0, sizeof(vel_curve));
+    c.type = hdr.acc_curves[acc].type;
+    c.points = hdr.acc_curves[acc].points;
+    memcpy(c.x, hdr.acc_curves[acc].x, MIN(VEL_CURVE_POINTS, FILE_CURVE_POINTS));
+    memcpy(c.y, hdr.acc_curves[acc].y, MIN(VEL_CURVE_POINTS, FILE_CURVE_POINTS));
+    APP_cfg_set_acc_curve(acc, &c);
+  }
 
   u8_t pin;
-  for (pin = 0; pin < APP_CONFIG_PINS; pin++) {
-    def_config cfg;
-    res = NIFFS_read(&fs, fd, (u8_t *)&cfg, sizeof(def_config));
+  u8_t gpio_map[256];
+  res = NIFFS_read(&fs, fd, gpio_map, hdr.nbr_of_gpio_pins);
+  if (res < NIFFS_OK) {
+    DBG(D_FS, D_INFO, "load err: read gpio map %i\n", res);
+    NIFFS_close(&fs, fd);
+    return res;
+  }
+  if (hdr.nbr_of_gpio_pins == APP_CONFIG_GPIO_PINS) {
+    gpio_pin_map map[APP_CONFIG_GPIO_PINS];
+    for (pin = 0; pin < APP_CONFIG_GPIO_PINS; pin++) {
+      if (gpio_map[pin] == FILE_GPIO_UNUSED) {
+        map[pin].port = GPIO_MAP_UNUSED_PORT;
+        map[pin].pin = 0;
+      } else {
+        map[pin].port = gpio_map[pin] >> 4;
+        map[pin].pin = gpio_map[pin] & 0xf;
+      }
+    }
+    if (!APP_cfg_set_gpio_map(map)) {
+      print("bad gpio map, keeping current\n");
+    }
+  } else {
+    print("gpio map size mismatch, keeping current\n");
+  }
+
+  u8_t layer;
+  for (layer = 1; layer < APP_CONFIG_LAYERS && layer < FILE_LAYERS; layer++) {
+    APP_cfg_set_layer(layer, hdr.layer_pin[layer], hdr.layer_mode[layer]);
+  }
+
+  def_config cfg;
+  // clear all pins, only defined pins are stored
+  APP_cfg_clear_pins();
+  for (pin = 0; pin < hdr.nbr_of_pin_defs; pin++) {
+    file_pin_def fpd;
+    memset(&cfg, 0, sizeof(def_config));
+    res = NIFFS_read(&fs, fd, (u8_t *)&fpd, sizeof(fpd));
+    if (res >= NIFFS_OK) {
+      if (fpd.pin == 0 || fpd.pin > APP_CONFIG_PINS || fpd.layer >= APP_CONFIG_LAYERS ||
+          fpd.def_len > APP_CONFIG_DEFS_PER_PIN || fpd.tern_pin > APP_CONFIG_PINS ||
+          fpd.tern_splice > APP_CONFIG_DEFS_PER_PIN) {
+        print("bad pin definition\n");
+        NIFFS_close(&fs, fd);
+        return ERR_NIFFS_BAD_CONFIG;
+      }
+      res = NIFFS_read(&fs, fd, (u8_t *)cfg.id, fpd.def_len * sizeof(hid_id));
+    }
     if (res < NIFFS_OK) {
       DBG(D_FS, D_INFO, "read err: read cfg %i\n", res);
       NIFFS_close(&fs, fd);
       return res;
     }
-    APP_cfg_set_pin(&cfg);
-    if (cfg.pin) def_config_print(&cfg);
+    cfg.pin = fpd.pin;
+    cfg.layer = fpd.layer;
+    cfg.tern_pin = fpd.tern_pin;
+    cfg.tern_splice = fpd.tern_splice;
+    if (!APP_cfg_set_pin(&cfg)) {
+      print("pin%i definition not applicable\n", cfg.pin);
+      NIFFS_close(&fs, fd);
+      return ERR_NIFFS_BAD_CONFIG;
+    }
+    def_config_print(&cfg);
+  }
+  // combos follow all pin definitions
+  u8_t combo;
+  for (combo = 0; combo < hdr.nbr_of_combos; combo++) {
+    file_combo_def fcd;
+    memset(&cfg, 0, sizeof(def_config));
+    res = NIFFS_read(&fs, fd, (u8_t *)&fcd, sizeof(fcd));
+    if (res >= NIFFS_OK) {
+      if (fcd.pins[0] == 0 || fcd.pins[0] > APP_CONFIG_PINS ||
+          fcd.def_len > APP_CONFIG_DEFS_PER_PIN) {
+        print("bad combo definition\n");
+        NIFFS_close(&fs, fd);
+        return ERR_NIFFS_BAD_CONFIG;
+      }
+      res = NIFFS_read(&fs, fd, (u8_t *)cfg.id, fcd.def_len * sizeof(hid_id));
+    }
+    if (res < NIFFS_OK) {
+      DBG(D_FS, D_INFO, "read err: read combo %i\n", res);
+      NIFFS_close(&fs, fd);
+      return res;
+    }
+    cfg.pin = fcd.pins[0];
+    for (pin = 1; pin < APP_CONFIG_COMBO_PINS && pin < FILE_COMBO_PINS; pin++) {
+      cfg.combo[pin-1] = fcd.pins[pin];
+    }
+    if (!APP_cfg_set_pin(&cfg)) {
+      print("combo%i definition not applicable\n", combo);
+      NIFFS_close(&fs, fd);
+      return ERR_NIFFS_BAD_CONFIG;
+    }
+    def_config_print(&cfg);
+  }
+  // motions follow combos
+  u8_t motion;
+  for (motion = 0; motion < hdr.nbr_of_motions; motion++) {
+    file_motion_def fmd;
+    memset(&cfg, 0, sizeof(def_config));
+    res = NIFFS_read(&fs, fd, (u8_t *)&fmd, sizeof(fmd));
+    if (res >= NIFFS_OK) {
+      if (fmd.steps[0] == 0 || fmd.def_len > APP_CONFIG_DEFS_PER_PIN) {
+        print("bad motion definition\n");
+        NIFFS_close(&fs, fd);
+        return ERR_NIFFS_BAD_CONFIG;
+      }
+      res = NIFFS_read(&fs, fd, (u8_t *)cfg.id, fmd.def_len * sizeof(hid_id));
+    }
+    if (res < NIFFS_OK) {
+      DBG(D_FS, D_INFO, "read err: read motion %i\n", res);
+      NIFFS_close(&fs, fd);
+      return res;
+    }
+    memcpy(cfg.motion, fmd.steps, MIN(APP_CONFIG_MOTION_STEPS, FILE_MOTION_STEPS));
+    cfg.motion_ms = fmd.step_ms;
+    cfg.motion_joystick = fmd.joystick;
+    if (!APP_cfg_set_pin(&cfg)) {
+      print("motion%i definition not applicable\n", motion);
+      NIFFS_close(&fs, fd);
+      return ERR_NIFFS_BAD_CONFIG;
+    }
+    def_config_print(&cfg);
   }
 
   NIFFS_close(&fs, fd);
@@ -10,9 +10,33 @@
 
 #include "niffs.h"
 
-#define FS_FILE_VERSION   2
+#define FS_FILE_VERSION   15
 
 #define ERR_NIFFS_HAL     -11050
+// config file of other version or with bad contents. Header errors are found
+// before anything is applied, a record not applicable leaves the settings
+// loaded before it, the caller starts over with defaults
+#define ERR_NIFFS_BAD_CONFIG -11051
+
+// layer select settings stored, index 0 is unused base layer
+#define FILE_LAYERS       8
+// pins stored per combo
+#define FILE_COMBO_PINS   4
+// steps stored per motion
+#define FILE_MOTION_STEPS 6
+// acceleration curves stored, mouse x, y and wheel, and x and y of both
+// joysticks
+#define FILE_ACC_CURVES   7
+// points stored per acceleration curve
+#define FILE_CURVE_POINTS 6
+
+// curve definition only, tables are built again at load
+typedef struct {
+  u8_t type;
+  u8_t points;
+  u8_t x[FILE_CURVE_POINTS];
+  u8_t y[FILE_CURVE_POINTS];
+} file_acc_curve;
 
 typedef struct {
   u16_t file_version;
@@ -25,8 +49,51 @@ typedef struct {
   u16_t acc_wheel_speed;
   time joystick_delta_ms;
   u16_t joystick_acc_speed;
+  u8_t min_hold_ms;
+  u8_t latch_mask;
+  u8_t tern_release_first;
+  u8_t layer_pin[FILE_LAYERS];
+  u8_t layer_mode[FILE_LAYERS];
+  u8_t nbr_of_pin_defs;
+  u8_t nbr_of_gpio_pins;
+  u8_t combo_window_ms;
+  u8_t nbr_of_combos;
+  u8_t turbo_duty;
+  u8_t socd_mode[2];
+  u8_t socd_4way;
+  u8_t nbr_of_motions;
+  file_acc_curve acc_curves[FILE_ACC_CURVES];
+  u8_t usb_personality;
+  u8_t usb_latency;
 } file_config_hdr;
 
+// followed by nbr_of_gpio_pins gpio map bytes, (port << 4) | pin or
+// FILE_GPIO_UNUSED, and then nbr_of_pin_defs records, each a file_pin_def followed by
+// def_len hid_ids. Only pins having definitions on a layer are stored. Last
+// come nbr_of_combos records, each a file_combo_def followed by def_len hid_ids,
+// and nbr_of_motions records, each a file_motion_def followed by def_len hid_ids.
+#define FILE_GPIO_UNUSED  0xff
+
+typedef struct {
+  u8_t pin;
+  u8_t layer;
+  u8_t def_len;
+  u8_t tern_pin;
+  u8_t tern_splice;
+} file_pin_def;
+
+typedef struct {
+  u8_t pins[FILE_COMBO_PINS]; // pin numbers, 0 if unused
+  u8_t def_len;
+} file_combo_def;
+
+typedef struct {
+  u8_t steps[FILE_MOTION_STEPS]; // motion steps as in def_config, 0 if unused
+  u8_t step_ms;
+  u8_t joystick;
+  u8_t def_len;
+} file_motion_def;
+
 int FS_mount(void);
 void FS_dump(void);
 void FS_ls(void);
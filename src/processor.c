@@ -10,11 +10,20 @@
 #include "gpio.h"
 #include "gpio_map.h"
 #include "usb_hw_config.h"
+#include "timer.h"
 
 static void RCC_config() {
-  RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
-  RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
-  RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOC, ENABLE);
+  // gpio ports used by board
+  const u32_t gpio_clk[GPIO_MAP_PORTS] = {
+      RCC_APB2Periph_GPIOA, RCC_APB2Periph_GPIOB, RCC_APB2Periph_GPIOC,
+      RCC_APB2Periph_GPIOD, RCC_APB2Periph_GPIOE
+  };
+  int i;
+  for (i = 0; i < GPIO_MAP_PORTS; i++) {
+    if (BOARD_GPIO_PORTS & (1 << i)) {
+      RCC_APB2PeriphClockCmd(gpio_clk[i], ENABLE);
+    }
+  }
   RCC_APB2PeriphClockCmd(RCC_APB2Periph_AFIO, ENABLE);
 
   #ifdef CONFIG_UART1
@@ -39,6 +48,10 @@ static void RCC_config() {
 
   RCC_APB1PeriphClockCmd(STM32_SYSTEM_TIMER_RCC, ENABLE);
 
+#ifdef CONFIG_IO_EXP
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
+#endif
+
   // usb
   RCC_USBCLKConfig(RCC_USBCLKSource_PLLCLK_1Div5);
   RCC_APB1PeriphClockCmd(RCC_APB1Periph_USB, ENABLE);
@@ -79,12 +92,37 @@ static void NVIC_config(void)
   NVIC_EnableIRQ(USART2_IRQn);
 #endif
 
+#ifdef CONFIG_IO_EXP
+  // Config & enable i2c interrupts, same prio as exti so they never preempt
+  // expander INT
+  NVIC_SetPriority(I2C1_EV_IRQn, NVIC_EncodePriority(prioGrp, 1, 0));
+  NVIC_EnableIRQ(I2C1_EV_IRQn);
+  NVIC_SetPriority(I2C1_ER_IRQn, NVIC_EncodePriority(prioGrp, 1, 0));
+  NVIC_EnableIRQ(I2C1_ER_IRQn);
+#endif
+
+  // Config & enable gpio exti interrupts, expander INT and pins waking from
+  // usb suspend
+  const IRQn_Type exti_irqs[] = {
+      EXTI0_IRQn, EXTI1_IRQn, EXTI2_IRQn, EXTI3_IRQn, EXTI4_IRQn,
+      EXTI9_5_IRQn, EXTI15_10_IRQn
+  };
+  int i;
+  for (i = 0; i < sizeof(exti_irqs)/sizeof(exti_irqs[0]); i++) {
+    NVIC_SetPriority(exti_irqs[i], NVIC_EncodePriority(prioGrp, 1, 0));
+    NVIC_EnableIRQ(exti_irqs[i]);
+  }
+
   // usb
   NVIC_SetPriority(USB_LP_CAN1_RX0_IRQn, NVIC_EncodePriority(prioGrp, 3, 0));
   NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
 
   NVIC_SetPriority(USBWakeUp_IRQn, NVIC_EncodePriority(prioGrp, 2, 0));
   NVIC_EnableIRQ(USBWakeUp_IRQn);
+
+  // rtc alarm, sampling pins not waking from usb suspend
+  NVIC_SetPriority(RTCAlarm_IRQn, NVIC_EncodePriority(prioGrp, 2, 0));
+  NVIC_EnableIRQ(RTCAlarm_IRQn);
 }
 
 static void UART2_config() {
@@ -94,6 +132,14 @@ static void UART2_config() {
 #endif
 }
 
+static void I2C_config() {
+#ifdef CONFIG_IO_EXP
+  // SCL, SDA
+  gpio_config(PORTB, PIN6, CLK_50MHZ, AF, AF0, OPENDRAIN, NOPULL);
+  gpio_config(PORTB, PIN7, CLK_50MHZ, AF, AF0, OPENDRAIN, NOPULL);
+#endif
+}
+
 static void TIM_config() {
   TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
 
@@ -115,10 +161,41 @@ static void TIM_config() {
 
   /* TIM enable counter */
   TIM_Cmd(STM32_SYSTEM_TIMER, ENABLE);
+
+  TIMER_init();
+}
+
+static void EXTI_config() {
+  // usb wakeup event on line 18, resumes cpu from stop mode
+  EXTI_InitTypeDef exti;
+  EXTI_ClearITPendingBit(EXTI_Line18);
+  exti.EXTI_Line = EXTI_Line18;
+  exti.EXTI_Mode = EXTI_Mode_Interrupt;
+  exti.EXTI_Trigger = EXTI_Trigger_Rising;
+  exti.EXTI_LineCmd = ENABLE;
+  EXTI_Init(&exti);
+
+  // rtc alarm event on line 17, resumes cpu from stop mode
+  EXTI_ClearITPendingBit(EXTI_Line17);
+  exti.EXTI_Line = EXTI_Line17;
+  EXTI_Init(&exti);
+}
+
+static void RTC_config() {
+  // rtc on lsi counting milliseconds, keeps counting in stop mode
+  PWR_BackupAccessCmd(ENABLE);
+  RCC_LSICmd(ENABLE);
+  while (RCC_GetFlagStatus(RCC_FLAG_LSIRDY) == RESET);
+  RCC_RTCCLKConfig(RCC_RTCCLKSource_LSI);
+  RCC_RTCCLKCmd(ENABLE);
+  RTC_WaitForSynchro();
+  RTC_WaitForLastTask();
+  RTC_SetPrescaler(PROC_LSI_FREQ / 1000 - 1);
+  RTC_WaitForLastTask();
 }
 
 static void GPIO_config() {
-#ifndef CONFIG_HY_TEST_BOARD
+#if BOARD_SWJ_JTAG_DISABLE
   // disable jtag, only SWD enabled, free pin PB3
   GPIO_PinRemapConfig(GPIO_Remap_SWJ_JTAGDisable, ENABLE);
 #endif
@@ -126,10 +203,11 @@ static void GPIO_config() {
   const gpio_pin_map *led = GPIO_MAP_get_led_map();
   gpio_config_out(led->port, led->pin, CLK_50MHZ, PUSHPULL, NOPULL);
 
+  GPIO_MAP_init();
   const gpio_pin_map *in = GPIO_MAP_get_pin_map();
   int i;
-  for (i = 0; i < APP_CONFIG_PINS; i++) {
-    gpio_config(in[i].port, in[i].pin, CLK_2MHZ, IN, AF0, OPENDRAIN, PULLUP);
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    PROC_config_input(&in[i], TRUE);
   }
 
   USB_Cable_Config(DISABLE);
@@ -137,6 +215,51 @@ static void GPIO_config() {
 
 // ifc
 
+void PROC_config_input(const gpio_pin_map *in, bool enable) {
+  if (GPIO_MAP_IS_UNUSED(in)) return;
+  if (enable) {
+    gpio_config(in->port, in->pin, CLK_2MHZ, IN, AF0, OPENDRAIN, PULLUP);
+  } else {
+    // back to reset state, floating input
+    gpio_config(in->port, in->pin, CLK_2MHZ, IN, AF0, OPENDRAIN, NOPULL);
+  }
+}
+
+void PROC_system_timer(bool run) {
+  TIM_Cmd(STM32_SYSTEM_TIMER, run ? ENABLE : DISABLE);
+}
+
+void PROC_enter_stop(void) {
+  PWR_EnterSTOPMode(PWR_Regulator_LowPower, PWR_STOPEntry_WFI);
+  // woken up running on hsi, start hse and pll again as configured
+  RCC_HSEConfig(RCC_HSE_ON);
+  if (RCC_WaitForHSEStartUp() == SUCCESS) {
+    RCC_PLLCmd(ENABLE);
+    while (RCC_GetFlagStatus(RCC_FLAG_PLLRDY) == RESET);
+    RCC_SYSCLKConfig(RCC_SYSCLKSource_PLLCLK);
+    while (RCC_GetSYSCLKSource() != 0x08);
+  }
+  // rtc registers are stale until resynchronized
+  RTC_WaitForSynchro();
+}
+
+u32_t PROC_get_rtc_ms(void) {
+  return RTC_GetCounter();
+}
+
+void PROC_rtc_alarm(u32_t ms) {
+  RTC_WaitForLastTask();
+  RTC_ITConfig(RTC_IT_ALR, DISABLE);
+  RTC_WaitForLastTask();
+  RTC_ClearITPendingBit(RTC_IT_ALR);
+  EXTI_ClearITPendingBit(EXTI_Line17);
+  if (ms == 0) return;
+  RTC_SetAlarm(RTC_GetCounter() + ms);
+  RTC_WaitForLastTask();
+  RTC_ITConfig(RTC_IT_ALR, ENABLE);
+  RTC_WaitForLastTask();
+}
+
 void PROC_base_init() {
   RCC_config();
   NVIC_config();
@@ -146,14 +269,17 @@ void PROC_periph_init() {
   DBGMCU_Config(STM32_SYSTEM_TIMER_DBGMCU, ENABLE);
   gpio_init();
 
-#ifdef CONFIG_HY_TEST_BOARD
-  gpio_config_out(PORTC, PIN13, CLK_50MHZ, PUSHPULL, NOPULL);
+#if BOARD_USB_CABLE_ACTIVE_LOW
+  gpio_config_out(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN, CLK_50MHZ, PUSHPULL, NOPULL);
 #else
-  gpio_config(PORTB, PIN9, CLK_2MHZ, IN, AF0, OPENDRAIN, NOPULL);
+  gpio_config(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN, CLK_2MHZ, IN, AF0, OPENDRAIN, NOPULL);
 #endif
 
   GPIO_config();
   UART2_config();
+  I2C_config();
+  EXTI_config();
+  RTC_config();
   TIM_config();
 }
 
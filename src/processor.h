@@ -8,8 +8,39 @@
 #ifndef PROCESSOR_H_
 #define PROCESSOR_H_
 
+#include "gpio_map.h"
+
+// nominal lsi frequency clocking rtc
+#define PROC_LSI_FREQ     40000
+
 void PROC_base_init();
 void PROC_periph_init();
+/**
+ * Configures gpio of given pin map entry as pulled up input if enabled,
+ * else releases it to floating input.
+ */
+void PROC_config_input(const gpio_pin_map *in, bool enable);
+/**
+ * Stops or restarts the system timer, and with it gpio sampling, system
+ * time and led.
+ */
+void PROC_system_timer(bool run);
+/**
+ * Enters stop mode until any enabled exti line or interrupt wakes the cpu,
+ * and restores clocks. Call with interrupts disabled, the waking interrupt
+ * runs when they are enabled again.
+ */
+void PROC_enter_stop(void);
+/**
+ * Returns milliseconds of rtc, clocked by lsi and counting also in stop
+ * mode. Only as accurate as lsi, up to some tens of percent.
+ */
+u32_t PROC_get_rtc_ms(void);
+/**
+ * Arms the rtc alarm to wake the cpu from stop mode by exti line 17 in given
+ * milliseconds of rtc, or disarms it if 0.
+ */
+void PROC_rtc_alarm(u32_t ms);
 
 void PROC_periph_init_bootloader();
 
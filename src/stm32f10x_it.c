@@ -3,6 +3,9 @@
 #include "uart_driver.h"
 #include "timer.h"
 #include "usb_istr.h"
+#ifdef CONFIG_IO_EXP
+#include "i2c_driver.h"
+#endif
 
 /**
   * @brief  This function handles NMI exception.
@@ -114,6 +117,18 @@ void UART4_IRQHandler(void)
 }
 #endif
 
+#ifdef CONFIG_IO_EXP
+void I2C1_EV_IRQHandler(void)
+{
+  I2C_IRQ_ev(_I2C_BUS(0));
+}
+
+void I2C1_ER_IRQHandler(void)
+{
+  I2C_IRQ_err(_I2C_BUS(0));
+}
+#endif
+
 void STM32_SYSTEM_TIMER_IRQ_FN(void)
 {
   //TRACE_IRQ_ENTER(STM32_SYSTEM_TIMER_IRQn);
@@ -129,6 +144,15 @@ void USBWakeUp_IRQHandler(void)
   TRACE_IRQ_EXIT(USBWakeUp_IRQn);
 }
 
+// rtc alarm
+void RTCAlarm_IRQHandler(void)
+{
+  TRACE_IRQ_ENTER(RTCAlarm_IRQn);
+  EXTI_ClearITPendingBit(EXTI_Line17);
+  RTC_ClearITPendingBit(RTC_IT_ALR);
+  TRACE_IRQ_EXIT(RTCAlarm_IRQn);
+}
+
 void USB_LP_CAN1_RX0_IRQHandler(void)
 {
 // Called once every ms
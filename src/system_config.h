@@ -11,6 +11,7 @@
 #include "config_header.h"
 #include "types.h"
 #include "stm32f10x.h"
+#include "board.h"
 
 #ifndef CONFIG_ANNOYATRON
 #define APP_NAME "ARCADEHID"
@@ -74,6 +75,26 @@
 #define I2C_MAX_ID            1
 #define I2C1_PORT             I2C1
 
+/** IO EXPANDERS **/
+// MCP23017 expanders on I2C1 (PB6 SCL, PB7 SDA), enabled by building
+// with IO_EXP=1. Pins 12 and 13 are taken by the bus, expander pins are
+// numbered after the gpio pins, 16 per expander, GPA0..7 then GPB0..7.
+#ifdef CONFIG_IO_EXP
+// number of expanders, addressed from IO_EXP_I2C_ADDR and upwards, up to 8
+#ifndef IO_EXP_DEVICES
+#define IO_EXP_DEVICES        1
+#endif
+// 7-bit address of first expander (A2..A0 = 0)
+#define IO_EXP_I2C_ADDR       0x20
+#define IO_EXP_I2C_CLOCK      400000
+// shared open-drain INT line of all expanders, active low
+#define IO_EXP_INT_PORT       PORTB
+#define IO_EXP_INT_PIN        PIN8
+#else
+#define IO_EXP_DEVICES        0
+#endif
+#define IO_EXP_PINS_PER_DEVICE  16
+
 /****************************************************/
 /******** Application build time configuration ******/
 /****************************************************/
@@ -134,12 +155,36 @@ u8_t get_print_output(void);
 
 /** APP CONFIG **/
 
-#ifdef CONFIG_HY_TEST_BOARD
-#define APP_CONFIG_PINS               4
-#else
-#define APP_CONFIG_PINS               26
+// gpio pins as described by board, see board.h
+#define APP_CONFIG_GPIO_PINS          BOARD_GPIO_PINS
+// all pins, more than gpio and expander pins only leaves the rest unsampled,
+// e.g. for host benchmarks
+#ifndef APP_CONFIG_PINS
+#define APP_CONFIG_PINS               (APP_CONFIG_GPIO_PINS + IO_EXP_DEVICES * IO_EXP_PINS_PER_DEVICE)
+#endif
+// max definitions on one pin
+#define APP_CONFIG_DEFS_PER_PIN       32
+// definitions of all pins share one pool, max 256
+#define APP_CONFIG_DEF_POOL           128
+// number of layers, max 8, layer 0 is the base layer
+#define APP_CONFIG_LAYERS             8
+// pins having definitions on layers above 0, shared by all layers
+#define APP_CONFIG_LAYER_DEFS         32
+// combos of pins having own definitions, e.g. pin1+pin2. Pins, combos,
+// motions and macros are numbered together in a byte.
+#ifndef APP_CONFIG_COMBOS
+#define APP_CONFIG_COMBOS             16
 #endif
-#define APP_CONFIG_DEFS_PER_PIN       8
+// max pins in a combo
+#define APP_CONFIG_COMBO_PINS         4
+// motion inputs, e.g. motion(2 3 6 pin5) for a quarter circle and a button
+#define APP_CONFIG_MOTIONS            8
+// max steps in a motion, steps of all motions must fit in 32
+#define APP_CONFIG_MOTION_STEPS       6
+// macros running at the same time
+#define APP_CONFIG_MACROS             4
+// debounced pin edges queued for report engine, power of two
+#define APP_CONFIG_EVENT_QUEUE        32
 
 
 /** DEBUG **/
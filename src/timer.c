@@ -11,9 +11,22 @@
 #include "cli.h"
 #include "app.h"
 
+#define TIMER_US_PER_TICK     (1000000 / SYS_MAIN_TIMER_FREQ)
+#define TIMER_CNT_PER_US      (SYS_CPU_FREQ / 1000000)
+
+static volatile u32_t timer_ticks = 0;
+
+void TIMER_init(void) {
+  // enable cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  TIMER_DWT_CYCCNT = 0;
+  TIMER_DWT_CTRL |= 1;
+}
+
 void TIMER_irq() {
   if (TIM_GetITStatus(STM32_SYSTEM_TIMER, TIM_IT_Update) != RESET) {
     TIM_ClearITPendingBit(STM32_SYSTEM_TIMER, TIM_IT_Update);
+    timer_ticks++;
 
     bool ms_update = SYS_timer();
     if (ms_update) {
@@ -24,3 +37,18 @@ void TIMER_irq() {
     CLI_timer();
   }
 }
+
+u32_t TIMER_get_us(void) {
+  u32_t ticks;
+  u32_t cnt;
+  do {
+    ticks = timer_ticks;
+    cnt = TIM_GetCounter(STM32_SYSTEM_TIMER);
+  } while (ticks != timer_ticks);
+  // called from higher irq prio with a pending, not yet serviced, update
+  if (TIM_GetFlagStatus(STM32_SYSTEM_TIMER, TIM_FLAG_Update) != RESET &&
+      cnt < (SYS_CPU_FREQ / SYS_MAIN_TIMER_FREQ) / 2) {
+    ticks++;
+  }
+  return ticks * TIMER_US_PER_TICK + cnt / TIMER_CNT_PER_US;
+}
@@ -8,6 +8,19 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
+#include "system.h"
+
+// DWT cycle counter, not covered by CMSIS V1.30 core_cm3.h
+#define TIMER_DWT_CTRL      (*(volatile u32_t *)0xE0001000)
+#define TIMER_DWT_CYCCNT    (*(volatile u32_t *)0xE0001004)
+#define TIMER_get_cycles()  TIMER_DWT_CYCCNT
+
+void TIMER_init(void);
 void TIMER_irq();
+/**
+ * Returns a free running microsecond timestamp, wraps after ~71 minutes.
+ * Callable from any context.
+ */
+u32_t TIMER_get_us(void);
 
 #endif /* TIMER_H_ */
@@ -21,6 +21,12 @@ typedef struct {
   };
 } usb_kb_report;
 
+// boot protocol reports, leading part of the full reports: keyboard
+// modifiers, reserved and 6 keys, mouse buttons, dx and dy
+#define USB_KB_BOOT_REPORT_SIZE       8
+#define USB_KB_BOOT_KEYS              6
+#define USB_MOUSE_BOOT_REPORT_SIZE    3
+
 typedef struct {
   union {
     u8_t raw[4];
@@ -50,21 +56,116 @@ typedef enum {
   JOYSTICK2
 } usb_joystick;
 
+// devices presented to the host, bit per device
+#define USB_ARC_DEV_KB          (1 << 0)
+#define USB_ARC_DEV_MOUSE       (1 << 1)
+#define USB_ARC_DEV_JOYSTICK1   (1 << 2)
+#define USB_ARC_DEV_JOYSTICK2   (1 << 3)
+
+// how devices are presented to the host
+typedef enum {
+  USB_ARC_COMPOSITE = 0,  // hid interface and endpoint per device
+  USB_ARC_SINGLE,         // one hid interface and 1 ms endpoint, devices by report id
+} usb_personality;
+
+// timing of a transmitted report, sent as input report of the latency
+// interface, little endian
+typedef struct __attribute__((packed)) {
+  u8_t dev;         // device bit index
+  u8_t seq;         // record number, gaps are records lost
+  u16_t frame;      // usb frame number report was taken by host in
+  u32_t edge_us;    // pin edge report results from, 0 if none, TIMER_get_us
+  u32_t armed_us;   // report put in PMA for next host poll, TIMER_get_us
+} usb_latency_record;
+
 typedef void (*usb_kb_report_ready_cb_f)(void);
 typedef void (*usb_mouse_report_ready_cb_f)(void);
 typedef void (*usb_joy_report_ready_cb_f)(usb_joystick joystick);
+typedef void (*usb_sof_cb_f)(void);
+typedef void (*usb_suspend_cb_f)(void);
 
+/**
+ * Reports can be given while the endpoint is busy with the previous one, they
+ * are then staged and sent on the next poll. Given with no room, a staged
+ * report is replaced.
+ */
 bool USB_ARC_KB_can_tx(void);
 bool USB_ARC_MOUSE_can_tx(void);
 bool USB_ARC_JOYSTICK_can_tx(usb_joystick joystick);
+// if a report of device bit index is in flight, a report given now is sent
+// after its report ready callback
+bool USB_ARC_tx_busy(u8_t dev);
 void USB_ARC_KB_tx(usb_kb_report *report);
 void USB_ARC_MOUSE_tx(usb_mouse_report *report);
 void USB_ARC_JOYSTICK_tx(usb_joystick joystick, usb_joystick_report *report);
 void USB_ARC_set_kb_callback(usb_kb_report_ready_cb_f cb);
 void USB_ARC_set_mouse_callback(usb_mouse_report_ready_cb_f cb);
 void USB_ARC_set_joystick_callback(usb_joy_report_ready_cb_f cb);
+// called from irq on each start of frame while configured, once per ms
+void USB_ARC_set_sof_callback(usb_sof_cb_f cb);
+// called from irq when host suspends the bus, the macrocell is then in low
+// power mode and the rest of the system may stop until the bus resumes
+void USB_ARC_set_suspend_callback(usb_suspend_cb_f cb);
+bool USB_ARC_is_suspended(void);
+// if host allows the device to wake it up from suspend
+bool USB_ARC_remote_wakeup_enabled(void);
+/**
+ * Signals resume to suspended host, returns FALSE if not suspended or host
+ * does not allow remote wakeup. Reports given meanwhile are sent once the
+ * host polls again.
+ */
+bool USB_ARC_remote_wakeup(void);
 
 void USB_ARC_init(void);
+/**
+ * Selects personality, effective from USB_ARC_start. In the single
+ * personality changed reports queue per device and are sent one per frame,
+ * keyboard first, then mouse and joysticks.
+ */
+void USB_ARC_set_personality(usb_personality p);
+usb_personality USB_ARC_get_personality(void);
+/**
+ * Selects devices presented to the host, USB_ARC_DEV_* bits, effective from
+ * USB_ARC_start. Devices left out get no interface, endpoint or report
+ * descriptor, their reports are dropped as if sent.
+ */
+void USB_ARC_set_devices(u8_t devices);
+u8_t USB_ARC_get_devices(void);
+// in endpoint of device bit index, 0 if not presented
+u8_t USB_ARC_get_endpoint(u8_t dev);
+/**
+ * Registers current report of device bit index, read without rebuilding
+ * when host asks for it with GET_REPORT.
+ */
+void USB_ARC_set_report_source(u8_t dev, const u8_t *report, u8_t len);
+// ms host wants unchanged reports of device bit index repeated at, 0 for
+// reports on change only
+u32_t USB_ARC_get_idle_ms(u8_t dev);
+/**
+ * If host selected boot protocol for device bit index. Only keyboard and
+ * mouse interfaces of the composite personality support it; their reports
+ * are then sent cut to the boot report size.
+ */
+bool USB_ARC_boot_protocol(u8_t dev);
+/**
+ * Presents a vendor defined hid interface sending a usb_latency_record per
+ * transmitted report, effective from USB_ARC_start. The interface needs an
+ * in endpoint left free by the presented devices and is left out if there
+ * is none.
+ */
+void USB_ARC_set_latency(bool on);
+bool USB_ARC_get_latency(void);
+// in endpoint of latency interface, 0 if not presented
+u8_t USB_ARC_get_latency_endpoint(void);
+// pin edge the next report given for device bit index results from, 0 if none
+void USB_ARC_set_report_edge(u8_t dev, u32_t edge_us);
+// latency records sent and lost because the host did not poll them in time
+void USB_ARC_get_latency_stats(u32_t *sent, u32_t *lost);
+// cpu cycles of latency record bookkeeping in the usb irq, when a report is
+// put in PMA or taken by host, last and max since boot
+void USB_ARC_get_latency_cycles(u32_t *last, u32_t *max);
+// ms from USB_ARC_start until host set configuration, 0 if not yet
+u32_t USB_ARC_get_enum_time_ms(void);
 void USB_ARC_start(void);
 
 #endif /* USB_ARC_H_ */
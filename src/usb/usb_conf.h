@@ -59,17 +59,13 @@
 
 #define ENDP0_RXADDR        (0x40)//(0x18)
 #define ENDP0_TXADDR        (0x80)//(0x58)
-// keyboard endpoint
+// hid endpoints 1 to 4, buffers packed from here in endpoint order for
+// presented devices, see ARC_build_descriptors. Being interrupt endpoints
+// they have one buffer each, the peripheral double buffers bulk and
+// isochronous endpoints only, next report is staged in ram instead
 #define ENDP1_TXADDR        (0xc0)
-// mouse endpoint
-#define ENDP2_TXADDR        (0x100)
 
 #ifndef CONFIG_ANNOYATRON
-// joystick1 endpoint
-#define ENDP3_TXADDR        (0x108)
-// joystick2 endpoint
-#define ENDP4_TXADDR        (0x110)
-
 // vcd endpoints
 #ifdef CONFIG_ARCHID_VCD
 #define ENDP5_TXADDR        (0x118)
@@ -77,6 +73,12 @@
 #define ENDP7_TXADDR        (0x160)
 #endif
 #endif // CONFIG_ANNOYATRON
+// end of hid endpoint buffers, vcd buffers or end of the 512 byte PMA
+#if defined(CONFIG_ARCHID_VCD) && !defined(CONFIG_ANNOYATRON)
+#define ENDP_HID_TXEND      ENDP5_TXADDR
+#else
+#define ENDP_HID_TXEND      (0x200)
+#endif
 
 /*-------------------------------------------------------------*/
 /* -------------------   ISTR events  -------------------------*/
@@ -87,7 +89,6 @@
 #define IMR_MSK (CNTR_CTRM  | CNTR_WKUPM | CNTR_SUSPM | CNTR_ERRM  | CNTR_SOFM \
                  | CNTR_ESOFM | CNTR_RESETM )
 
-#ifdef CONFIG_ARCHID_VCD
 /*#define CTR_CALLBACK*/
 /*#define DOVR_CALLBACK*/
 /*#define ERR_CALLBACK*/
@@ -96,7 +97,6 @@
 /*#define RESET_CALLBACK*/
 #define SOF_CALLBACK
 /*#define ESOF_CALLBACK*/
-#endif
 
 /* CTR service routines */
 /* associated to defined endpoints */
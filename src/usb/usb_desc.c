@@ -32,9 +32,32 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+// hid interface descriptor offsets
+#define HID_IFC_OFFS_NUMBER           2
+#define HID_IFC_OFFS_HID              9
+#define HID_IFC_OFFS_REPORT_LEN       16
+#define HID_IFC_OFFS_EP_ADDRESS       20
+#define HID_IFC_OFFS_EP_SIZE          22
+// vcd interfaces descriptor offsets, from the lengths of preceding descriptors
+#define VCD_LEN_IFC                   9
+#define VCD_LEN_HEADER_FUNC           5
+#define VCD_LEN_CALL_MGMT_FUNC        5
+#define VCD_LEN_ACM_FUNC              4
+#define VCD_LEN_UNION_FUNC            5
+#define VCD_LEN_EP                    7
+#define VCD_OFFS_CALL_MGMT            (VCD_LEN_IFC + VCD_LEN_HEADER_FUNC)
+#define VCD_OFFS_UNION                (VCD_OFFS_CALL_MGMT + VCD_LEN_CALL_MGMT_FUNC + VCD_LEN_ACM_FUNC)
+#define VCD_OFFS_DATA_IFC             (VCD_OFFS_UNION + VCD_LEN_UNION_FUNC + VCD_LEN_EP)
+#define VCD_OFFS_CTRL_NUMBER          2
+#define VCD_OFFS_CALL_DATA_IFC        (VCD_OFFS_CALL_MGMT + 4)
+#define VCD_OFFS_UNION_MASTER         (VCD_OFFS_UNION + 3)
+#define VCD_OFFS_UNION_SLAVE          (VCD_OFFS_UNION + 4)
+#define VCD_OFFS_DATA_NUMBER          (VCD_OFFS_DATA_IFC + 2)
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /* Extern variables ----------------------------------------------------------*/
+uint8_t ARC_config_descriptor[ARC_MAX_SIZE_CONFIG_DESC];
+arc_desc_layout ARC_layout;
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
@@ -74,31 +97,29 @@ const uint8_t ARC_device_descriptor[ARC_SIZE_DEVICE_DESC] =
 
 
 /* USB Configuration Descriptor */
-/*   All Descriptors (Configuration, Interface, Endpoint, Class, Vendor */
-const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
+/*   Header, interfaces are appended by ARC_build_descriptors */
+static const uint8_t ARC_config_header[ARC_SIZE_CONFIG_HEADER] =
   {
     0x09, /* bLength: Configuration Descriptor size */
     USB_CONFIGURATION_DESCRIPTOR_TYPE, /* bDescriptorType: Configuration */
-    ARC_SIZE_CONFIG_DESC,               /* wTotalLength: Bytes returned */
+    0x00,         /* wTotalLength: set when built */
     0x00,
-#ifndef CONFIG_ANNOYATRON
-#ifdef CONFIG_ARCHID_VCD
-/*P*/    0x06,         /*bNumInterfaces: nbr of interfaces */
-#else
-/*P*/    0x04,         /*bNumInterfaces: nbr of interfaces */
-#endif
-#else  // CONFIG_ANNOYATRON
-/*P*/    0x02,         /*bNumInterfaces: nbr of interfaces */
-#endif  // CONFIG_ANNOYATRON
+    0x00,         /*bNumInterfaces: set when built */
     0x01,         /*bConfigurationValue: Configuration value*/
     0x00,         /*iConfiguration: Index of string descriptor describing
                                      the configuration*/
     0xE0,         /*bmAttributes: Self powered */
     0x32,         /*MaxPower 100 mA: this current is used for detecting Vbus*/
+  };
 
-    /************** ifc 1:KEYBOARD          ****************/
+/* Hid interface per device, interface number and endpoint address are set
+   when built */
+static const uint8_t ARC_hid_interface_descriptors[ARC_DEVICES][ARC_SIZE_HID_IFC_DESC] =
+  {
+  {
+    /************** KEYBOARD                ****************/
     /************** Descriptor of interface ****************/
-    /* 09 */
+    /* 00 */
     0x09,         /*bLength: Interface Descriptor size*/
     USB_INTERFACE_DESCRIPTOR_TYPE,/*bDescriptorType: Interface descriptor type*/
     0x00,         /*bInterfaceNumber: Number of Interface*/
@@ -109,7 +130,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x01,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
     0,            /*iInterface: Index of string descriptor*/
     /******************** Descriptor of HID ********************/
-    /* 18 */
+    /* 09 */
     0x09,         /*bLength: HID Descriptor size*/
     HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
     0x11,         /*bcdHID: HID Class Spec release number*/
@@ -120,7 +141,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     ARC_KB_SIZE_REPORT_DESC,/*wItemLength: Total length of Report descriptor*/
     0x00,
     /******************** Descriptor of endpoint ********************/
-    /* 27 */
+    /* 18 */
     0x07,          /*bLength: Endpoint Descriptor size*/
     USB_ENDPOINT_DESCRIPTOR_TYPE, /*bDescriptorType:*/
 
@@ -129,11 +150,12 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x40,          /*wMaxPacketSize: 64 bytes max ///8 Byte max */
     0x00,
     24,          /*bInterval: Polling Interval (24 ms)*/
-    /* 34 */
-
-    /************** ifc 2:MOUSE             ****************/
+    /* 25 */
+  },
+  {
+    /************** MOUSE                   ****************/
     /************** Descriptor of interface ****************/
-    /* 34 */
+    /* 00 */
     0x09,         /*bLength: Interface Descriptor size*/
     USB_INTERFACE_DESCRIPTOR_TYPE,/*bDescriptorType: Interface descriptor type*/
     0x01,         /*bInterfaceNumber: Number of Interface*/
@@ -144,7 +166,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x02,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
     0,            /*iInterface: Index of string descriptor*/
     /******************** Descriptor of HID ********************/
-    /* 43 */
+    /* 09 */
     0x09,         /*bLength: HID Descriptor size*/
     HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
     0x00,         /*bcdHID: HID Class Spec release number*/
@@ -155,7 +177,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     ARC_MOUSE_SIZE_REPORT_DESC,/*wItemLength: Total length of Report descriptor*/
     0x00,
     /******************** Descriptor of endpoint ********************/
-    /* 52 */
+    /* 18 */
     0x07,          /*bLength: Endpoint Descriptor size*/
     USB_ENDPOINT_DESCRIPTOR_TYPE, /*bDescriptorType:*/
 
@@ -164,13 +186,12 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x04,          /*wMaxPacketSize: 4 bytes max */
     0x00,
     1,          /*bInterval: Polling Interval (1 ms)*/
-    /* 59 */
-
-    /*P*/
-#ifndef CONFIG_ANNOYATRON
-    /************** ifc 3:JOYSTICK1         ****************/
+    /* 25 */
+  },
+  {
+    /************** JOYSTICK1               ****************/
     /************** Descriptor of interface ****************/
-
+    /* 00 */
     0x09,         /*bLength: Interface Descriptor size*/
     USB_INTERFACE_DESCRIPTOR_TYPE,/*bDescriptorType: Interface descriptor type*/
     0x02,         /*bInterfaceNumber: Number of Interface*/
@@ -181,7 +202,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x00,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
     0,            /*iInterface: Index of string descriptor*/
     /******************** Descriptor of HID ********************/
-    /* 68 */
+    /* 09 */
     0x09,         /*bLength: HID Descriptor size*/
     HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
     0x10,         /*bcdHID: HID Class Spec release number*/
@@ -192,20 +213,21 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     ARC_JOYSTICK_SIZE_REPORT_DESC,/*wItemLength: Total length of Report descriptor*/
     0x00,
     /******************** Descriptor of endpoint ********************/
-    /* 77 */
+    /* 18 */
     0x07,          /*bLength: Endpoint Descriptor size*/
     USB_ENDPOINT_DESCRIPTOR_TYPE, /*bDescriptorType:*/
 
     0x83,          /*bEndpointAddress: Endpoint Address (IN)*/
     0x03,          /*bmAttributes: Interrupt endpoint*/
-    0x08,          /*wMaxPacketSize: 4 bytes max */
+    0x08,          /*wMaxPacketSize: 8 bytes max */
     0x00,
     10,          /*bInterval: Polling Interval (10 ms)*/
-    /* 84 */
-
-    /************** ifc 4:JOYSTICK2         ****************/
+    /* 25 */
+  },
+  {
+    /************** JOYSTICK2               ****************/
     /************** Descriptor of interface ****************/
-
+    /* 00 */
     0x09,         /*bLength: Interface Descriptor size*/
     USB_INTERFACE_DESCRIPTOR_TYPE,/*bDescriptorType: Interface descriptor type*/
     0x03,         /*bInterfaceNumber: Number of Interface*/
@@ -216,7 +238,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x00,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
     0,            /*iInterface: Index of string descriptor*/
     /******************** Descriptor of HID ********************/
-    /* 93 */
+    /* 09 */
     0x09,         /*bLength: HID Descriptor size*/
     HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
     0x10,         /*bcdHID: HID Class Spec release number*/
@@ -227,26 +249,110 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     ARC_JOYSTICK_SIZE_REPORT_DESC,/*wItemLength: Total length of Report descriptor*/
     0x00,
     /******************** Descriptor of endpoint ********************/
-    /* 102 */
+    /* 18 */
     0x07,          /*bLength: Endpoint Descriptor size*/
     USB_ENDPOINT_DESCRIPTOR_TYPE, /*bDescriptorType:*/
 
     0x84,          /*bEndpointAddress: Endpoint Address (IN)*/
     0x03,          /*bmAttributes: Interrupt endpoint*/
-    0x08,          /*wMaxPacketSize: 4 bytes max */
+    0x08,          /*wMaxPacketSize: 8 bytes max */
     0x00,
     10,          /*bInterval: Polling Interval (10 ms)*/
-    /* 109 */
-    /*P*/
+    /* 25 */
+  },
+  };
+
+#ifndef CONFIG_ANNOYATRON
+/* Hid interface of all devices, single hid interface personality, report
+   descriptor length is set when built */
+static const uint8_t ARC_single_interface_descriptor[ARC_SIZE_HID_IFC_DESC] =
+  {
+    /************** ALL DEVICES             ****************/
+    /************** Descriptor of interface ****************/
+    /* 00 */
+    0x09,         /*bLength: Interface Descriptor size*/
+    USB_INTERFACE_DESCRIPTOR_TYPE,/*bDescriptorType: Interface descriptor type*/
+    0x00,         /*bInterfaceNumber: Number of Interface*/
+    0x00,         /*bAlternateSetting: Alternate setting*/
+    0x01,         /*bNumEndpoints*/
+    0x03,         /*bInterfaceClass: HID*/
+    0x00,         /*bInterfaceSubClass : 1=BOOT, 0=no boot*/
+    0x00,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
+    0,            /*iInterface: Index of string descriptor*/
+    /******************** Descriptor of HID ********************/
+    /* 09 */
+    0x09,         /*bLength: HID Descriptor size*/
+    HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
+    0x11,         /*bcdHID: HID Class Spec release number*/
+    0x01,
+    0x00,         /*bCountryCode: Hardware target country*/
+    0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
+    0x22,         /*bDescriptorType*/
+    0x00,         /*wItemLength: Total length of Report descriptor*/
+    0x00,
+    /******************** Descriptor of endpoint ********************/
+    /* 18 */
+    0x07,          /*bLength: Endpoint Descriptor size*/
+    USB_ENDPOINT_DESCRIPTOR_TYPE, /*bDescriptorType:*/
 
-#ifdef CONFIG_ARCHID_VCD
-    /*P*/
-    /************** ifc 4:VCD                ****************/
+    0x81,          /*bEndpointAddress: Endpoint Address (IN)*/
+    0x03,          /*bmAttributes: Interrupt endpoint*/
+    0x40,          /*wMaxPacketSize: 64 bytes max */
+    0x00,
+    1,          /*bInterval: Polling Interval (1 ms)*/
+    /* 25 */
+  };
+
+/* Vendor defined hid interface of report latency records */
+static const uint8_t ARC_latency_interface_descriptor[ARC_SIZE_HID_IFC_DESC] =
+  {
+    /************** LATENCY RECORDS         ****************/
+    /************** Descriptor of interface ****************/
+    /* 00 */
+    0x09,         /*bLength: Interface Descriptor size*/
+    USB_INTERFACE_DESCRIPTOR_TYPE,/*bDescriptorType: Interface descriptor type*/
+    0x00,         /*bInterfaceNumber: Number of Interface*/
+    0x00,         /*bAlternateSetting: Alternate setting*/
+    0x01,         /*bNumEndpoints*/
+    0x03,         /*bInterfaceClass: HID*/
+    0x00,         /*bInterfaceSubClass : 1=BOOT, 0=no boot*/
+    0x00,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
+    0,            /*iInterface: Index of string descriptor*/
+    /******************** Descriptor of HID ********************/
+    /* 09 */
+    0x09,         /*bLength: HID Descriptor size*/
+    HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
+    0x11,         /*bcdHID: HID Class Spec release number*/
+    0x01,
+    0x00,         /*bCountryCode: Hardware target country*/
+    0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
+    0x22,         /*bDescriptorType*/
+    ARC_LATENCY_SIZE_REPORT_DESC,/*wItemLength: Total length of Report descriptor*/
+    0x00,
+    /******************** Descriptor of endpoint ********************/
+    /* 18 */
+    0x07,          /*bLength: Endpoint Descriptor size*/
+    USB_ENDPOINT_DESCRIPTOR_TYPE, /*bDescriptorType:*/
+
+    0x81,          /*bEndpointAddress: Endpoint Address (IN)*/
+    0x03,          /*bmAttributes: Interrupt endpoint*/
+    sizeof(usb_latency_record), /*wMaxPacketSize: one record */
+    0x00,
+    1,          /*bInterval: Polling Interval (1 ms)*/
+    /* 25 */
+  };
+#endif // CONFIG_ANNOYATRON
+
+#if defined(CONFIG_ARCHID_VCD) && !defined(CONFIG_ANNOYATRON)
+/* Virtual com port interfaces, interface numbers are set when built */
+static const uint8_t ARC_vcd_interface_descriptors[ARC_SIZE_VCD_DESC] =
+  {
+    /************** VCD                     ****************/
     /*Interface Descriptor*/
     0x09,   /* bLength: Interface Descriptor size */
     USB_INTERFACE_DESCRIPTOR_TYPE,  /* bDescriptorType: Interface */
     /* Interface descriptor type */
-    /*P*/0x04,   /* bInterfaceNumber: Number of Interface */
+    0x00,   /* bInterfaceNumber: Number of Interface */
     0x00,   /* bAlternateSetting: Alternate setting */
     0x01,   /* bNumEndpoints: One endpoints used */
     0x02,   /* bInterfaceClass: Communication Interface Class */
@@ -264,7 +370,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x24,   /* bDescriptorType: CS_INTERFACE */
     0x01,   /* bDescriptorSubtype: Call Management Func Desc */
     0x00,   /* bmCapabilities: D0+D1 */
-    /*P*/0x05,   /* bDataInterface: 5 *////////////0x01,   /* bDataInterface: 1 */
+    0x01,   /* bDataInterface: 1 */
     /*ACM Functional Descriptor*/
     0x04,   /* bFunctionLength */
     0x24,   /* bDescriptorType: CS_INTERFACE */
@@ -274,9 +380,9 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     0x05,   /* bFunctionLength */
     0x24,   /* bDescriptorType: CS_INTERFACE */
     0x06,   /* bDescriptorSubtype: Union func desc */
-    /*P*/0x04,   /* bMasterInterface: Communication class interface *////////////0x00,   /* bMasterInterface: Communication class interface */
-    /*P*/0x05,   /* bSlaveInterface0: Data Class Interface *//////////0x01,   /* bSlaveInterface0: Data Class Interface */
-    /*Endpoint 5 Descriptor (was 2) IN */
+    0x00,   /* bMasterInterface: Communication class interface */
+    0x01,   /* bSlaveInterface0: Data Class Interface */
+    /*Endpoint 5 Descriptor IN */
     0x07,   /* bLength: Endpoint Descriptor size */
     USB_ENDPOINT_DESCRIPTOR_TYPE,   /* bDescriptorType: Endpoint */
     0x85,   /* bEndpointAddress: (IN5) */
@@ -287,14 +393,14 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     /*Data class interface descriptor*/
     0x09,   /* bLength: Endpoint Descriptor size */
     USB_INTERFACE_DESCRIPTOR_TYPE,  /* bDescriptorType: */
-    /*P*/0x05,   /* bInterfaceNumber: Number of Interface */
+    0x01,   /* bInterfaceNumber: Number of Interface */
     0x00,   /* bAlternateSetting: Alternate setting */
     0x02,   /* bNumEndpoints: Two endpoints used */
     0x0A,   /* bInterfaceClass: CDC */
     0x00,   /* bInterfaceSubClass: */
     0x00,   /* bInterfaceProtocol: */
     0x00,   /* iInterface: */
-    /*Endpoint 6 Descriptor (was 3) OUT */
+    /*Endpoint 6 Descriptor OUT */
     0x07,   /* bLength: Endpoint Descriptor size */
     USB_ENDPOINT_DESCRIPTOR_TYPE,   /* bDescriptorType: Endpoint */
     0x06,   /* bEndpointAddress: (OUT6) */
@@ -302,7 +408,7 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     VIRTUAL_COM_PORT_DATA_SIZE,             /* wMaxPacketSize: */
     0x00,
     0x00,   /* bInterval: ignore for Bulk transfer */
-    /*Endpoint 7 Descriptor (was 1) IN */
+    /*Endpoint 7 Descriptor IN */
     0x07,   /* bLength: Endpoint Descriptor size */
     USB_ENDPOINT_DESCRIPTOR_TYPE,   /* bDescriptorType: Endpoint */
     0x87,   /* bEndpointAddress: (IN7) */
@@ -310,10 +416,9 @@ const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC] =
     VIRTUAL_COM_PORT_DATA_SIZE,             /* wMaxPacketSize: */
     0x00,
     0x00    /* bInterval */
-
+  };
 #endif
-#endif // CONFIG_ANNOYATRON
-}; /* config descriptor */
+
 
 const uint8_t ARC_KB_report_descriptor[ARC_KB_SIZE_REPORT_DESC] =
   {
@@ -473,6 +578,160 @@ const uint8_t ARC_JOYSTICK_report_descriptor[ARC_JOYSTICK_SIZE_REPORT_DESC] =
       0xc0                           // END_COLLECTION
       };
 
+#ifndef CONFIG_ANNOYATRON
+// keyboard, mouse and joystick report descriptors, each with a report id,
+// presented ones are copied to single personality report descriptor
+static const uint8_t ARC_single_report_segments[ARC_SINGLE_SIZE_REPORT_DESC] =
+  {
+      // keyboard, ARC_SINGLE_KB_SIZE_REPORT_DESC bytes
+      0x05, 0x01,                         // Usage Page (Generic Desktop)
+      0x09, 0x06,                         // Usage (Keyboard)
+      0xA1, 0x01,                         // Collection (Application)
+      0x85, ARC_REPORT_ID_KB,             //     Report ID
+      0x05, 0x07,                         //     Usage Page (Key Codes)
+      0x19, 0xe0,                         //     Usage Minimum (224)
+      0x29, 0xe7,                         //     Usage Maximum (231)
+      0x15, 0x00,                         //     Logical Minimum (0)
+      0x25, 0x01,                         //     Logical Maximum (1)
+      0x75, 0x01,                         //     Report Size (1)
+      0x95, 0x08,                         //     Report Count (8)
+      0x81, 0x02,                         //     Input (Data, Variable, Absolute)
+      0x95, 0x01,                         //     Report Count (1)
+      0x75, 0x08,                         //     Report Size (8)
+      0x81, 0x01,                         //     Input (Constant) reserved byte(1)
+      0x95, USB_KB_REPORT_KEYMAP_SIZE,    //     Report Count (normally 6)
+      0x75, 0x08,                         //     Report Size (8)
+      0x26, 0xff, 0x00,
+      0x05, 0x07,                         //     Usage Page (Key codes)
+      0x19, 0x00,                         //     Usage Minimum (0)
+      0x29, 0xbc,                         //     Usage Maximum (188)
+      0x81, 0x00,                         //     Input (Data, Array) Key array
+      0x95, 0x03,                         //     Report Count (3)
+      0x75, 0x01,                         //     Report Size (1)
+      0x05, 0x08,                         //     Usage Page (Page# for LEDs)
+      0x19, 0x01,                         //     Usage Minimum (1)
+      0x29, 0x03,                         //     Usage Maximum (3)
+      0x91, 0x02,                         //     Output (Data, Variable, Absolute), Led report
+      0x95, 0x05,                         //     Report Count (5)
+      0x75, 0x01,                         //     Report Size (1)
+      0x91, 0x01,                         //     Output (Data, Variable, Absolute), Led report padding
+      0xC0,                               // End Collection (Application)
+
+      // mouse, ARC_SINGLE_MOUSE_SIZE_REPORT_DESC bytes
+      0x05, 0x01,                         // Usage Page (Generic Desktop)
+      0x09, 0x02,                         // Usage (Mouse)
+      0xA1, 0x01,                         // Collection (Application)
+      0x85, ARC_REPORT_ID_MOUSE,          //   Report ID
+      0x09, 0x01,                         //   Usage (Pointer)
+      0xA1, 0x00,                         //   Collection (Physical)
+      0x05, 0x09,                         //     Usage Page (Buttons)
+      0x19, 0x01,                         //     Usage Minimum (1)
+      0x29, 0x03,                         //     Usage Maximum (3)
+      0x15, 0x00,                         //     Logical Minimum (0)
+      0x25, 0x01,                         //     Logical Maximum (1)
+      0x95, 0x03,                         //     Report Count (3)
+      0x75, 0x01,                         //     Report Size (1)
+      0x81, 0x02,                         //     Input (Variable)
+      0x95, 0x01,                         //     Report Count (1)
+      0x75, 0x05,                         //     Report Size (5)
+      0x81, 0x01,                         //     Input (Constant)
+      0x05, 0x01,                         //     Usage Page (Generic Desktop)
+      0x09, 0x30,                         //     Usage (X axis)
+      0x09, 0x31,                         //     Usage (Y axis)
+      0x09, 0x38,                         //     Usage (Wheel)
+      0x15, 0x81,                         //     Logical Minimum (-127)
+      0x25, 0x7F,                         //     Logical Maximum (127)
+      0x75, 0x08,                         //     Report Size (8)
+      0x95, 0x03,                         //     Report Count (3)
+      0x81, 0x06,                         //     Input (Variable, Relative)
+      0xC0,                               //   End Collection
+      0xC0,                               // End Collection
+
+      // joystick 1, ARC_SINGLE_JOYSTICK_SIZE_REPORT_DESC bytes
+      0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
+      0x09, 0x04,                    // USAGE (Joystick)
+      0xa1, 0x01,                    // COLLECTION (Application)
+      0x85, ARC_REPORT_ID_JOYSTICK1, //   REPORT_ID
+      0x15, 0x81,                    //   LOGICAL_MINIMUM (-127)
+      0x25, 0x7f,                    //   LOGICAL_MAXIMUM (127)
+      0x05, 0x01,                    //   USAGE_PAGE (Generic Desktop)
+      0x09, 0x01,                    //   USAGE (Pointer)
+      0xa1, 0x00,                    //   COLLECTION (Physical)
+      0x09, 0x30,                    //     USAGE (X)
+      0x09, 0x31,                    //     USAGE (Y)
+      0x75, 0x08,                    //     REPORT_SIZE (8)
+      0x95, 0x02,                    //     REPORT_COUNT (2)
+      0x81, 0x02,                    //     INPUT (Data,Var,Abs)
+      0xc0,                          //   END_COLLECTION
+      0x05, 0x09,                    //   USAGE_PAGE (Button)
+      0x19, 0x01,                    //   USAGE_MINIMUM (Button 1)
+      0x29, 0x08,                    //   USAGE_MAXIMUM (Button 8)
+      0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+      0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
+      0x75, 0x01,                    //   REPORT_SIZE (1)
+      0x95, 0x10,                    //   REPORT_COUNT (16)
+      0x55, 0x00,                    //   UNIT_EXPONENT (0)
+      0x65, 0x00,                    //   UNIT (None)
+      0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+      0xc0,                          // END_COLLECTION
+
+      // joystick 2, ARC_SINGLE_JOYSTICK_SIZE_REPORT_DESC bytes
+      0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
+      0x09, 0x04,                    // USAGE (Joystick)
+      0xa1, 0x01,                    // COLLECTION (Application)
+      0x85, ARC_REPORT_ID_JOYSTICK2, //   REPORT_ID
+      0x15, 0x81,                    //   LOGICAL_MINIMUM (-127)
+      0x25, 0x7f,                    //   LOGICAL_MAXIMUM (127)
+      0x05, 0x01,                    //   USAGE_PAGE (Generic Desktop)
+      0x09, 0x01,                    //   USAGE (Pointer)
+      0xa1, 0x00,                    //   COLLECTION (Physical)
+      0x09, 0x30,                    //     USAGE (X)
+      0x09, 0x31,                    //     USAGE (Y)
+      0x75, 0x08,                    //     REPORT_SIZE (8)
+      0x95, 0x02,                    //     REPORT_COUNT (2)
+      0x81, 0x02,                    //     INPUT (Data,Var,Abs)
+      0xc0,                          //   END_COLLECTION
+      0x05, 0x09,                    //   USAGE_PAGE (Button)
+      0x19, 0x01,                    //   USAGE_MINIMUM (Button 1)
+      0x29, 0x08,                    //   USAGE_MAXIMUM (Button 8)
+      0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+      0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
+      0x75, 0x01,                    //   REPORT_SIZE (1)
+      0x95, 0x10,                    //   REPORT_COUNT (16)
+      0x55, 0x00,                    //   UNIT_EXPONENT (0)
+      0x65, 0x00,                    //   UNIT (None)
+      0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+      0xc0                           // END_COLLECTION
+  };
+// offset of device segment in single report segments, and end
+static const uint8_t ARC_single_report_offsets[ARC_DEVICES + 1] =
+  {
+      0,
+      ARC_SINGLE_KB_SIZE_REPORT_DESC,
+      ARC_SINGLE_KB_SIZE_REPORT_DESC + ARC_SINGLE_MOUSE_SIZE_REPORT_DESC,
+      ARC_SINGLE_KB_SIZE_REPORT_DESC + ARC_SINGLE_MOUSE_SIZE_REPORT_DESC +
+        ARC_SINGLE_JOYSTICK_SIZE_REPORT_DESC,
+      ARC_SINGLE_SIZE_REPORT_DESC
+  };
+
+uint8_t ARC_single_report_descriptor[ARC_SINGLE_SIZE_REPORT_DESC];
+
+// one usb_latency_record per input report, opaque bytes to the host
+const uint8_t ARC_LATENCY_report_descriptor[ARC_LATENCY_SIZE_REPORT_DESC] =
+  {
+      0x06, 0x00, 0xff,              // USAGE_PAGE (Vendor Defined Page 1)
+      0x09, 0x01,                    // USAGE (Vendor Usage 1)
+      0xa1, 0x01,                    // COLLECTION (Application)
+      0x09, 0x02,                    //   USAGE (Vendor Usage 2)
+      0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+      0x26, 0xff, 0x00,              //   LOGICAL_MAXIMUM (255)
+      0x75, 0x08,                    //   REPORT_SIZE (8)
+      0x95, sizeof(usb_latency_record), //   REPORT_COUNT (12)
+      0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+      0xc0                           // END_COLLECTION
+  };
+#endif // CONFIG_ANNOYATRON
+
 /* USB String Descriptors (optional) */
 const uint8_t ARC_string_lang_ID[ARC_SIZE_STRING_LANGID] =
   {
@@ -515,3 +774,85 @@ uint8_t ARC_string_serial[ARC_SIZE_STRING_SERIAL] =
     'p', 0, 'e', 0, 'l', 0, 'l', 0, 'e', 0
   };
 
+// appends hid interface of device from template, giving it next interface
+// number, in endpoint and PMA buffer
+static uint8_t *desc_add_hid_ifc(uint8_t *d, const uint8_t *tmpl, uint8_t dev, uint16_t *txaddr)
+{
+  arc_desc_layout *l = &ARC_layout;
+  uint8_t ifc = l->hid_interfaces++;
+  uint8_t ep = ++l->endpoints;
+  memcpy(d, tmpl, ARC_SIZE_HID_IFC_DESC);
+  d[HID_IFC_OFFS_NUMBER] = ifc;
+  d[HID_IFC_OFFS_EP_ADDRESS] = 0x80 | ep;
+  l->ifc_dev[ifc] = dev;
+  l->ifc_hid_offs[ifc] = d + HID_IFC_OFFS_HID - ARC_config_descriptor;
+  l->ep_dev[ep] = dev;
+  l->ep_size[ep] = d[HID_IFC_OFFS_EP_SIZE] | (d[HID_IFC_OFFS_EP_SIZE + 1] << 8);
+  l->ep_txaddr[ep] = *txaddr;
+  *txaddr += (l->ep_size[ep] + 1) & ~1;
+  return d + ARC_SIZE_HID_IFC_DESC;
+}
+
+void ARC_build_descriptors(uint8_t single, uint8_t devices, uint8_t latency)
+{
+  arc_desc_layout *l = &ARC_layout;
+  uint8_t *d = ARC_config_descriptor;
+  uint16_t txaddr = ENDP1_TXADDR;
+  uint8_t dev;
+
+  memset(l, 0, sizeof(arc_desc_layout));
+  l->devices = devices;
+  memcpy(d, ARC_config_header, ARC_SIZE_CONFIG_HEADER);
+  d += ARC_SIZE_CONFIG_HEADER;
+
+  for (dev = 0; dev < ARC_DEVICES; dev++) {
+    if ((devices & (1 << dev)) == 0) continue;
+#ifndef CONFIG_ANNOYATRON
+    if (single) {
+      uint8_t offs = ARC_single_report_offsets[dev];
+      uint8_t len = ARC_single_report_offsets[dev + 1] - offs;
+      memcpy(&ARC_single_report_descriptor[l->report_size], &ARC_single_report_segments[offs], len);
+      l->report_size += len;
+      continue;
+    }
+#endif
+    d = desc_add_hid_ifc(d, ARC_hid_interface_descriptors[dev], dev, &txaddr);
+    l->dev_ep[dev] = l->endpoints;
+  }
+
+#ifndef CONFIG_ANNOYATRON
+  if (single) {
+    // all devices on first interface and endpoint
+    d = desc_add_hid_ifc(d, ARC_single_interface_descriptor, ARC_DEV_KB, &txaddr);
+    d[HID_IFC_OFFS_REPORT_LEN - ARC_SIZE_HID_IFC_DESC] = l->report_size & 0xff;
+    d[HID_IFC_OFFS_REPORT_LEN + 1 - ARC_SIZE_HID_IFC_DESC] = l->report_size >> 8;
+    for (dev = 0; dev < ARC_DEVICES; dev++) {
+      if (devices & (1 << dev)) l->dev_ep[dev] = 1;
+    }
+  }
+
+  if (latency && l->endpoints < ARC_DEVICES
+      && txaddr + sizeof(usb_latency_record) <= ENDP_HID_TXEND) {
+    d = desc_add_hid_ifc(d, ARC_latency_interface_descriptor, ARC_DEV_LATENCY, &txaddr);
+    l->latency_ep = l->endpoints;
+  }
+#endif
+  l->interfaces = l->hid_interfaces;
+
+#if defined(CONFIG_ARCHID_VCD) && !defined(CONFIG_ANNOYATRON)
+  // vcd interfaces follow hid interfaces, on fixed endpoints
+  memcpy(d, ARC_vcd_interface_descriptors, ARC_SIZE_VCD_DESC);
+  d[VCD_OFFS_CTRL_NUMBER] += l->interfaces;
+  d[VCD_OFFS_CALL_DATA_IFC] += l->interfaces;
+  d[VCD_OFFS_UNION_MASTER] += l->interfaces;
+  d[VCD_OFFS_UNION_SLAVE] += l->interfaces;
+  d[VCD_OFFS_DATA_NUMBER] += l->interfaces;
+  d += ARC_SIZE_VCD_DESC;
+  l->interfaces += 2;
+#endif
+
+  l->config_size = d - ARC_config_descriptor;
+  ARC_config_descriptor[2] = l->config_size & 0xff;
+  ARC_config_descriptor[3] = l->config_size >> 8;
+  ARC_config_descriptor[4] = l->interfaces;
+}
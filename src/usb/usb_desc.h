@@ -43,17 +43,46 @@
 
 #define HID_DESCRIPTOR_TYPE                     0x21
 #define ARC_SIZE_HID_DESC                   0x09
-#define ARC_OFFS_HID_DESC                   0x12
 
 #define ARC_SIZE_DEVICE_DESC                18
-#ifndef CONFIG_ANNOYATRON
-#ifdef CONFIG_ARCHID_VCD
-#define ARC_SIZE_CONFIG_DESC                59+50+58
+// configuration descriptor is built at start from presented devices, a
+// configuration header, a hid interface per device or one for all devices,
+// and the vcd interfaces
+#define ARC_SIZE_CONFIG_HEADER              9
+#define ARC_SIZE_HID_IFC_DESC               25
+#define ARC_SIZE_VCD_DESC                   58
+#if defined(CONFIG_ARCHID_VCD) && !defined(CONFIG_ANNOYATRON)
+#define ARC_MAX_SIZE_CONFIG_DESC            (ARC_SIZE_CONFIG_HEADER + ARC_DEVICES*ARC_SIZE_HID_IFC_DESC + ARC_SIZE_VCD_DESC)
 #else
-#define ARC_SIZE_CONFIG_DESC                59+50
+#define ARC_MAX_SIZE_CONFIG_DESC            (ARC_SIZE_CONFIG_HEADER + ARC_DEVICES*ARC_SIZE_HID_IFC_DESC)
 #endif
-#else // CONFIG_ANNOYATRON
-#define ARC_SIZE_CONFIG_DESC                59
+// devices, also index of hid interface descriptors
+#define ARC_DEV_KB                          0
+#define ARC_DEV_MOUSE                       1
+#define ARC_DEV_JOYSTICK1                   2
+#define ARC_DEV_JOYSTICK2                   3
+#define ARC_DEVICES                         4
+// vendor defined hid interface of report latency records, ep_dev and
+// ifc_dev of its endpoint and interface. Only presented on an endpoint left
+// free by the devices, so never adds to the max configuration size
+#ifndef CONFIG_ANNOYATRON
+#define ARC_DEV_LATENCY                     ARC_DEVICES
+#define ARC_LATENCY_SIZE_REPORT_DESC        21
+#endif
+#ifndef CONFIG_ANNOYATRON
+// single hid interface personality, devices told apart by report id
+#define ARC_SINGLE_KB_SIZE_REPORT_DESC      64
+#define ARC_SINGLE_MOUSE_SIZE_REPORT_DESC   54
+#define ARC_SINGLE_JOYSTICK_SIZE_REPORT_DESC 50
+#define ARC_SINGLE_SIZE_REPORT_DESC         (ARC_SINGLE_KB_SIZE_REPORT_DESC + \
+                                             ARC_SINGLE_MOUSE_SIZE_REPORT_DESC + \
+                                             2*ARC_SINGLE_JOYSTICK_SIZE_REPORT_DESC)
+// report ids, also send priority of reports on the single endpoint
+#define ARC_REPORT_ID_KB                    1
+#define ARC_REPORT_ID_MOUSE                 2
+#define ARC_REPORT_ID_JOYSTICK1             3
+#define ARC_REPORT_ID_JOYSTICK2             4
+#define ARC_SINGLE_REPORTS                  4
 #endif // CONFIG_ANNOYATRON
 #define ARC_KB_SIZE_REPORT_DESC             62
 #define ARC_MOUSE_SIZE_REPORT_DESC          74
@@ -72,16 +101,48 @@
 
 #endif
 
+// hid interfaces and in endpoints of built configuration descriptor
+typedef struct {
+  uint16_t config_size;
+  uint16_t report_size;                 // single personality report descriptor
+  uint8_t devices;                      // presented devices, bit per ARC_DEV_*
+  uint8_t interfaces;                   // all interfaces, vcd ones last
+  uint8_t hid_interfaces;
+  uint8_t ifc_dev[ARC_DEVICES];         // device of hid interface, composite
+  uint8_t ifc_hid_offs[ARC_DEVICES];    // hid descriptor offset of hid interface
+  uint8_t endpoints;                    // hid in endpoints, from 1
+  uint8_t latency_ep;                   // in endpoint of latency records, 0 if not presented
+  uint8_t dev_ep[ARC_DEVICES];          // in endpoint of device, 0 if not presented
+  uint8_t ep_dev[ARC_DEVICES + 1];      // device of in endpoint, composite
+  uint16_t ep_txaddr[ARC_DEVICES + 1];  // pma tx buffer of in endpoint
+  uint16_t ep_size[ARC_DEVICES + 1];    // max packet of in endpoint
+} arc_desc_layout;
+
 /* Exported functions ------------------------------------------------------- */
 extern const uint8_t ARC_device_descriptor[ARC_SIZE_DEVICE_DESC];
-extern const uint8_t ARC_config_descriptor[ARC_SIZE_CONFIG_DESC];
+extern uint8_t ARC_config_descriptor[ARC_MAX_SIZE_CONFIG_DESC];
 extern const uint8_t ARC_KB_report_descriptor[ARC_KB_SIZE_REPORT_DESC];
 extern const uint8_t ARC_MOUSE_report_descriptor[ARC_MOUSE_SIZE_REPORT_DESC];
 extern const uint8_t ARC_JOYSTICK_report_descriptor[ARC_JOYSTICK_SIZE_REPORT_DESC];
+#ifndef CONFIG_ANNOYATRON
+extern uint8_t ARC_single_report_descriptor[ARC_SINGLE_SIZE_REPORT_DESC];
+extern const uint8_t ARC_LATENCY_report_descriptor[ARC_LATENCY_SIZE_REPORT_DESC];
+#endif
 extern const uint8_t ARC_string_lang_ID[ARC_SIZE_STRING_LANGID];
 extern const uint8_t ARC_string_vendor[ARC_SIZE_STRING_VENDOR];
 extern const uint8_t ARC_string_product[ARC_SIZE_STRING_PRODUCT];
 extern uint8_t ARC_string_serial[ARC_SIZE_STRING_SERIAL];
+extern arc_desc_layout ARC_layout;
+
+/**
+ * Builds configuration descriptor and, in single personality, report
+ * descriptor for devices, a bit per ARC_DEV_*. Hid interfaces and in
+ * endpoints are numbered from 0 and 1 in device order, leaving out devices
+ * not presented, and endpoint buffers are packed in PMA after control
+ * endpoint. If latency, the latency interface follows the device interfaces
+ * when an endpoint and PMA are left for it.
+ */
+void ARC_build_descriptors(uint8_t single, uint8_t devices, uint8_t latency);
 
 #endif /* __USB_DESC_H */
 
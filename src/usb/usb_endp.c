@@ -31,10 +31,10 @@
 #include "usb_lib.h"
 #include "usb_istr.h"
 #include "usb_conf.h"
+#include "usb_pwr.h"
 
 #ifdef CONFIG_ARCHID_VCD
 #include "usb_desc.h"
-#include "usb_pwr.h"
 
 /* Interval between sending IN packets in frame number (1 frame = 1ms) */
 #define VCOMPORT_IN_FRAME_INTERVAL             5
@@ -45,42 +45,28 @@ extern uint8_t USB_Tx_State;
 
 #endif
 
-//keyboard
+// hid endpoints, assigned to presented devices in device order, or all
+// devices on endpoint 1 in single personality
 void EP1_IN_Callback(void)
 {
-  /* Set the transfer complete token to inform upper layer that the current 
-  transfer has been complete */
-  kb_tx_complete = 1;
-  if (kb_report_ready_cb) kb_report_ready_cb();
+  USB_ARC_ep_tx_done(ENDP1);
 }
 
-//mouse
 void EP2_IN_Callback(void)
 {
-  /* Set the transfer complete token to inform upper layer that the current
-  transfer has been complete */
-  mouse_tx_complete = 1;
-  if (mouse_report_ready_cb) mouse_report_ready_cb();
+  USB_ARC_ep_tx_done(ENDP2);
 }
 
 
 #ifndef CONFIG_ANNOYATRON
-//joystick1
 void EP3_IN_Callback(void)
 {
-  /* Set the transfer complete token to inform upper layer that the current
-  transfer has been complete */
-  joy1_tx_complete = 1;
-  if (joy_report_ready_cb) joy_report_ready_cb(JOYSTICK1);
+  USB_ARC_ep_tx_done(ENDP3);
 }
 
-//joystick2
 void EP4_IN_Callback(void)
 {
-  /* Set the transfer complete token to inform upper layer that the current
-  transfer has been complete */
-  joy2_tx_complete = 1;
-  if (joy_report_ready_cb) joy_report_ready_cb(JOYSTICK2);
+  USB_ARC_ep_tx_done(ENDP4);
 }
 
 #ifdef CONFIG_ARCHID_VCD
@@ -128,6 +114,10 @@ void EP6_OUT_Callback(void)
   }
 }
 
+#endif
+
+#endif // CONFIG_ANNOYATRON
+
 /*******************************************************************************
 * Function Name  : SOF_Callback / INTR_SOFINTR_Callback
 * Description    :
@@ -137,10 +127,14 @@ void EP6_OUT_Callback(void)
 *******************************************************************************/
 void SOF_Callback(void)
 {
+#if defined(CONFIG_ARCHID_VCD) && !defined(CONFIG_ANNOYATRON)
   static uint32_t FrameCount = 0;
+#endif
 
   if(bDeviceState == CONFIGURED)
   {
+    if (sof_cb) sof_cb();
+#if defined(CONFIG_ARCHID_VCD) && !defined(CONFIG_ANNOYATRON)
     if (FrameCount++ == VCOMPORT_IN_FRAME_INTERVAL)
     {
       /* Reset the frame counter */
@@ -149,12 +143,9 @@ void SOF_Callback(void)
       /* Check the data to be sent through IN pipe */
       Handle_USBAsynchXfer();
     }
+#endif
   }
 }
 
-#endif
-
-#endif // CONFIG_ANNOYATRON
-
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
 
@@ -11,20 +11,77 @@
 #include "usb_serial.h"
 
 #include "gpio.h"
+#include "timer.h"
 
 ErrorStatus HSEStartUpStatus;
 /* Extern variables ----------------------------------------------------------*/
-volatile uint8_t kb_tx_complete = 1;
-volatile uint8_t mouse_tx_complete = 1;
-volatile uint8_t joy1_tx_complete = 1;
-volatile uint8_t joy2_tx_complete = 1;
+static volatile uint8_t tx_complete[ARC_DEVICES] = {1, 1, 1, 1};
+// interrupt endpoints cannot be double buffered in PMA, so a report given
+// while the endpoint is busy is staged here and copied to PMA as soon as the
+// report before it is sent, being ready for the next poll
+static struct {
+  uint8_t data[sizeof(usb_kb_report)];
+  volatile uint8_t len;                 // 0 if nothing staged
+} staged[ARC_DEVICES];
 
 usb_kb_report_ready_cb_f kb_report_ready_cb = NULL;
 usb_mouse_report_ready_cb_f mouse_report_ready_cb = NULL;
 usb_joy_report_ready_cb_f joy_report_ready_cb = NULL;
+usb_sof_cb_f sof_cb = NULL;
+usb_suspend_cb_f suspend_cb = NULL;
 
 uint8_t kb_led_state = 0;
 
+static usb_personality personality = USB_ARC_COMPOSITE;
+#ifndef CONFIG_ANNOYATRON
+static uint8_t devices = USB_ARC_DEV_KB | USB_ARC_DEV_MOUSE | USB_ARC_DEV_JOYSTICK1 | USB_ARC_DEV_JOYSTICK2;
+#else
+static uint8_t devices = USB_ARC_DEV_KB | USB_ARC_DEV_MOUSE;
+#endif
+static uint32_t start_ms;
+static volatile uint32_t enum_ms;     // start to configured, 0 if not yet
+// current report of device, served on GET_REPORT
+static const uint8_t *report_src[ARC_DEVICES];
+static uint8_t report_src_len[ARC_DEVICES];
+// idle rate of device from SET_IDLE, in 4 ms, 0 repeats only on change
+static volatile uint8_t idle_rate[ARC_DEVICES];
+// HID_PROTOCOL_* of device from SET_PROTOCOL
+static volatile uint8_t protocol[ARC_DEVICES];
+
+#ifndef CONFIG_ANNOYATRON
+// single personality, report per report id waiting for endpoint 1, report
+// id first, slot is free again once report is copied to PMA
+static struct {
+  uint8_t data[1 + sizeof(usb_kb_report)];
+  uint8_t len;
+} single_reports[ARC_SINGLE_REPORTS];
+static volatile uint8_t single_busy;        // bit per report queued
+static volatile int8_t single_sending = -1; // report on endpoint, -1 if idle
+static bool latency = FALSE;
+#endif
+
+// latency interface, timing of reports per device and records waiting for
+// the latency endpoint. Records are made and sent from the usb irq, or with
+// irqs disabled
+#define LATENCY_RECORDS   16
+static struct {
+  uint32_t edge_us;         // edge of report given next
+  uint32_t staged_edge_us;  // edge of report staged or queued
+  uint32_t sent_edge_us;    // edge of report in PMA
+  uint32_t armed_us;        // when report in PMA was put there
+} lat_dev[ARC_DEVICES];
+static struct {
+  usb_latency_record rec[LATENCY_RECORDS];
+  uint8_t head;
+  uint8_t tail;
+  bool sending;             // record on latency endpoint
+  uint8_t seq;
+  uint32_t sent;
+  uint32_t lost;
+  uint32_t cycles_last;     // cpu cycles of last record bookkeeping
+  uint32_t cycles_max;
+} lat;
+
 #ifdef CONFIG_ARCHID_VCD
 
 uint8_t tx_buf[USB_VCD_TX_BUF_SIZE];
@@ -39,18 +96,18 @@ uint8_t USB_Tx_State = 0;
 static void IntToUnicode(uint32_t value, uint8_t *pbuf, uint8_t len);
 
 void USB_Cable_Config(FunctionalState NewState) {
-#ifdef CONFIG_HY_TEST_BOARD
+#if BOARD_USB_CABLE_ACTIVE_LOW
   if (NewState != DISABLE) {
-    GPIO_ResetBits(GPIOC, GPIO_Pin_13);
+    gpio_disable(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN);
   } else {
-    GPIO_SetBits(GPIOC, GPIO_Pin_13);
+    gpio_enable(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN);
   }
 #else
   if (NewState != DISABLE) {
-    gpio_config(PORTB, PIN9, CLK_2MHZ, OUT, AF0, PUSHPULL, NOPULL);
-    gpio_enable(PORTB, PIN9);
+    gpio_config(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN, CLK_2MHZ, OUT, AF0, PUSHPULL, NOPULL);
+    gpio_enable(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN);
   } else {
-    gpio_config(PORTB, PIN9, CLK_2MHZ, IN, AF0, OPENDRAIN, NOPULL);
+    gpio_config(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN, CLK_2MHZ, IN, AF0, OPENDRAIN, NOPULL);
   }
 #endif
 }
@@ -67,79 +124,285 @@ void USB_ARC_set_joystick_callback(usb_joy_report_ready_cb_f cb) {
   joy_report_ready_cb = cb;
 }
 
-bool USB_ARC_KB_can_tx(void) {
-  return kb_tx_complete != 0;
+void USB_ARC_set_sof_callback(usb_sof_cb_f cb) {
+  sof_cb = cb;
 }
 
-bool USB_ARC_MOUSE_can_tx(void) {
-  return mouse_tx_complete != 0;
+void USB_ARC_set_suspend_callback(usb_suspend_cb_f cb) {
+  suspend_cb = cb;
 }
 
-bool USB_ARC_JOYSTICK_can_tx(usb_joystick j) {
-  return j == JOYSTICK1 ? joy1_tx_complete : joy2_tx_complete;
+void Enter_LowPowerMode(void) {
+  bDeviceState = SUSPENDED;
+  if (suspend_cb) suspend_cb();
 }
 
-void USB_ARC_KB_tx(usb_kb_report *report)
-{
-  // byte 0:   modifiers
-  // byte 1:   reserved (0x00)
-  // byte 2-x: keypresses
-  report->reserved = 0;
+void Leave_LowPowerMode(void) {
+  if (Device_Info.Current_Configuration != 0) {
+    bDeviceState = CONFIGURED;
+  } else {
+    bDeviceState = ATTACHED;
+  }
+}
 
-  uint32_t spoon_guard = 1000000;
-  while(kb_tx_complete==0 && --spoon_guard);
-  ASSERT(spoon_guard > 0);
+bool USB_ARC_is_suspended(void) {
+  return bDeviceState == SUSPENDED;
+}
 
-  /* Reset the control token to inform upper layer that a transfer is ongoing */
-  kb_tx_complete = 0;
+bool USB_ARC_remote_wakeup_enabled(void) {
+  return (pInformation->Current_Feature & (1 << 5)) != 0;
+}
 
-  /* Copy keyboard vector info in ENDP1 Tx Packet Memory Area*/
-  USB_SIL_Write(EP1_IN, report->raw, sizeof(report->raw));
+bool USB_ARC_remote_wakeup(void) {
+  if (!USB_ARC_is_suspended() || !USB_ARC_remote_wakeup_enabled()) return FALSE;
+  // resume signalling is timed by esof interrupts from here
+  enter_critical();
+  Resume(RESUME_INTERNAL);
+  exit_critical();
+  return TRUE;
+}
 
-  /* Enable endpoint for transmission */
-  SetEPTxValid(ENDP1);
+static void lat_cycles(uint32_t cycles) {
+  cycles = TIMER_get_cycles() - cycles;
+  lat.cycles_last = cycles;
+  lat.cycles_max = MAX(lat.cycles_max, cycles);
+}
 
+// report of device put in PMA
+static void lat_armed(uint8_t dev, uint32_t edge_us) {
+  if (ARC_layout.latency_ep == 0) return;
+  uint32_t cycles = TIMER_get_cycles();
+  lat_dev[dev].sent_edge_us = edge_us;
+  lat_dev[dev].armed_us = TIMER_get_us();
+  lat_cycles(cycles);
 }
 
-void USB_ARC_MOUSE_tx(usb_mouse_report *report)
-{
-  uint32_t spoon_guard = 1000000;
-  while(mouse_tx_complete==0 && --spoon_guard);
-  ASSERT(spoon_guard > 0);
+// puts next record on latency endpoint, which must be idle
+static void lat_send_next(void) {
+  if (lat.tail == lat.head) {
+    lat.sending = FALSE;
+    return;
+  }
+  USB_SIL_Write(0x80 | ARC_layout.latency_ep, (uint8_t *)&lat.rec[lat.tail % LATENCY_RECORDS],
+      sizeof(usb_latency_record));
+  SetEPTxValid(ARC_layout.latency_ep);
+  lat.tail++;
+  lat.sent++;
+  lat.sending = TRUE;
+}
 
-  /* Reset the control token to inform upper layer that a transfer is ongoing */
-  mouse_tx_complete = 0;
+// report of device in PMA taken by host, queues its record
+static void lat_taken(uint8_t dev) {
+  if (ARC_layout.latency_ep == 0) return;
+  uint32_t cycles = TIMER_get_cycles();
+  uint8_t seq = lat.seq++;
+  if ((uint8_t)(lat.head - lat.tail) >= LATENCY_RECORDS) {
+    lat.lost++;
+    lat_cycles(cycles);
+    return;
+  }
+  usb_latency_record *r = &lat.rec[lat.head % LATENCY_RECORDS];
+  r->dev = dev;
+  r->seq = seq;
+  r->frame = _GetFNR() & FNR_FN;
+  r->edge_us = lat_dev[dev].sent_edge_us;
+  r->armed_us = lat_dev[dev].armed_us;
+  lat.head++;
+  if (!lat.sending) lat_send_next();
+  lat_cycles(cycles);
+}
 
-  /* Copy mouse position info in ENDP2 Tx Packet Memory Area*/
-  USB_SIL_Write(EP2_IN, report->raw, sizeof(report->raw));
+// report of device sent, or dropped
+static void dev_report_ready(uint8_t dev) {
+  switch (dev) {
+  case ARC_DEV_KB:
+    if (kb_report_ready_cb) kb_report_ready_cb();
+    break;
+  case ARC_DEV_MOUSE:
+    if (mouse_report_ready_cb) mouse_report_ready_cb();
+    break;
+  case ARC_DEV_JOYSTICK1:
+    if (joy_report_ready_cb) joy_report_ready_cb(JOYSTICK1);
+    break;
+  case ARC_DEV_JOYSTICK2:
+    if (joy_report_ready_cb) joy_report_ready_cb(JOYSTICK2);
+    break;
+  }
+}
 
-  /* Enable endpoint for transmission */
-  SetEPTxValid(ENDP2);
+#ifndef CONFIG_ANNOYATRON
+// sends queued report of lowest id, endpoint 1 must be idle
+static void single_send_next(void) {
+  uint8_t queued = single_busy;
+  int ix;
+  single_sending = -1;
+  if (queued == 0) return;
+  for (ix = 0; (queued & (1 << ix)) == 0; ix++);
+  single_sending = ix;
+  USB_SIL_Write(EP1_IN, single_reports[ix].data, single_reports[ix].len);
+  SetEPTxValid(ENDP1);
+  lat_armed(ix, lat_dev[ix].staged_edge_us);
+  single_busy &= ~(1 << ix);
+}
 
+// a report still queued for the device is replaced
+static void single_tx(uint8_t report_id, const uint8_t *raw, uint8_t len, uint32_t edge_us) {
+  int ix = report_id - 1;
+  enter_critical();
+  single_reports[ix].data[0] = report_id;
+  memcpy(&single_reports[ix].data[1], raw, len);
+  single_reports[ix].len = 1 + len;
+  lat_dev[ix].staged_edge_us = edge_us;
+  single_busy |= 1 << ix;
+  if (single_sending < 0) {
+    single_send_next();
+  }
+  exit_critical();
 }
 
-void USB_ARC_JOYSTICK_tx(usb_joystick j, usb_joystick_report *report)
-{
-  uint32_t spoon_guard = 1000000;
-  if (j == JOYSTICK1) {
-    while(joy1_tx_complete==0 && --spoon_guard);
+static bool single_can_tx(uint8_t report_id) {
+  return (single_busy & (1 << (report_id - 1))) == 0;
+}
+
+static void single_tx_done(void) {
+  int ix = single_sending;
+  if (ix < 0) return;
+  lat_taken(ix);
+  single_send_next();
+  // report ids follow device order
+  dev_report_ready(ix);
+}
+#endif // CONFIG_ANNOYATRON
+
+void USB_ARC_reset(void) {
+  uint8_t dev;
+  for (dev = 0; dev < ARC_DEVICES; dev++) {
+    tx_complete[dev] = 1;
+    staged[dev].len = 0;
+    // report on change only until host sets an idle rate
+    idle_rate[dev] = 0;
+    // hid devices must power up in report protocol
+    protocol[dev] = HID_PROTOCOL_REPORT;
+  }
+#ifndef CONFIG_ANNOYATRON
+  single_busy = 0;
+  single_sending = -1;
+#endif
+  lat.head = 0;
+  lat.tail = 0;
+  lat.sending = FALSE;
+}
+
+void USB_ARC_ep_tx_done(uint8_t ep) {
+  if (ep == ARC_layout.latency_ep) {
+    lat_send_next();
+    return;
+  }
+#ifndef CONFIG_ANNOYATRON
+  if (personality == USB_ARC_SINGLE) {
+    single_tx_done();
+    return;
+  }
+#endif
+  uint8_t dev = ARC_layout.ep_dev[ep];
+  lat_taken(dev);
+  if (staged[dev].len) {
+    // next report is ready, have it sent on next poll
+    USB_SIL_Write(0x80 | ep, staged[dev].data, staged[dev].len);
+    SetEPTxValid(ep);
+    staged[dev].len = 0;
+    lat_armed(dev, lat_dev[dev].staged_edge_us);
   } else {
-    while(joy2_tx_complete==0 && --spoon_guard);
+    /* Set the transfer complete token to inform upper layer that the current
+    transfer has been complete */
+    tx_complete[dev] = 1;
+  }
+  dev_report_ready(dev);
+}
+
+static bool dev_can_tx(uint8_t dev) {
+#ifndef CONFIG_ANNOYATRON
+  if (personality == USB_ARC_SINGLE) return single_can_tx(dev + 1);
+#endif
+  return tx_complete[dev] != 0 || staged[dev].len == 0;
+}
+
+static void dev_tx(uint8_t dev, uint8_t *raw, uint8_t len) {
+  uint8_t ep = ARC_layout.dev_ep[dev];
+  uint32_t edge_us = lat_dev[dev].edge_us;
+  lat_dev[dev].edge_us = 0;
+  if (ep == 0) {
+    // not presented to host, dropped as if sent
+    dev_report_ready(dev);
+    return;
   }
-  ASSERT(spoon_guard > 0);
 
-  /* Reset the control token to inform upper layer that a transfer is ongoing */
-  if (j == JOYSTICK1) {
-    joy1_tx_complete= 0;
+#ifndef CONFIG_ANNOYATRON
+  if (personality == USB_ARC_SINGLE) {
+    single_tx(dev + 1, raw, len, edge_us);
+    return;
+  }
+#endif
+
+  enter_critical();
+  if (tx_complete[dev]) {
+    /* Reset the control token to inform upper layer that a transfer is ongoing */
+    tx_complete[dev] = 0;
+
+    /* Copy report in device endpoint Tx Packet Memory Area*/
+    USB_SIL_Write(0x80 | ep, raw, len);
+
+    /* Enable endpoint for transmission */
+    SetEPTxValid(ep);
+    lat_armed(dev, edge_us);
   } else {
-    joy2_tx_complete = 0;
+    // endpoint busy, copied to PMA when current report is sent, replacing
+    // any report staged before
+    memcpy(staged[dev].data, raw, len);
+    staged[dev].len = len;
+    lat_dev[dev].staged_edge_us = edge_us;
   }
+  exit_critical();
+}
+
+bool USB_ARC_tx_busy(u8_t dev) {
+#ifndef CONFIG_ANNOYATRON
+  if (personality == USB_ARC_SINGLE) return single_sending == dev;
+#endif
+  return tx_complete[dev] == 0;
+}
+
+bool USB_ARC_KB_can_tx(void) {
+  return dev_can_tx(ARC_DEV_KB);
+}
+
+bool USB_ARC_MOUSE_can_tx(void) {
+  return dev_can_tx(ARC_DEV_MOUSE);
+}
+
+bool USB_ARC_JOYSTICK_can_tx(usb_joystick j) {
+  return dev_can_tx(j == JOYSTICK1 ? ARC_DEV_JOYSTICK1 : ARC_DEV_JOYSTICK2);
+}
 
-  /* Copy joystick info in ENDP3/4 Tx Packet Memory Area*/
-  USB_SIL_Write(j == JOYSTICK1 ? EP3_IN : EP4_IN, report->raw, sizeof(report->raw));
+void USB_ARC_KB_tx(usb_kb_report *report)
+{
+  // byte 0:   modifiers
+  // byte 1:   reserved (0x00)
+  // byte 2-x: keypresses
+  report->reserved = 0;
+  dev_tx(ARC_DEV_KB, report->raw,
+      USB_ARC_boot_protocol(ARC_DEV_KB) ? USB_KB_BOOT_REPORT_SIZE : sizeof(report->raw));
+}
 
-  /* Enable endpoint for transmission */
-  SetEPTxValid(j == JOYSTICK1 ? ENDP3 : ENDP4);
+void USB_ARC_MOUSE_tx(usb_mouse_report *report)
+{
+  dev_tx(ARC_DEV_MOUSE, report->raw,
+      USB_ARC_boot_protocol(ARC_DEV_MOUSE) ? USB_MOUSE_BOOT_REPORT_SIZE : sizeof(report->raw));
+}
+
+void USB_ARC_JOYSTICK_tx(usb_joystick j, usb_joystick_report *report)
+{
+  dev_tx(j == JOYSTICK1 ? ARC_DEV_JOYSTICK1 : ARC_DEV_JOYSTICK2, report->raw, sizeof(report->raw));
 }
 
 void Get_SerialNum(void)
@@ -182,7 +445,130 @@ void USB_ARC_init(void) {
 #endif
 }
 
+void USB_ARC_set_personality(usb_personality p) {
+#ifndef CONFIG_ANNOYATRON
+  personality = p;
+#endif
+}
+
+usb_personality USB_ARC_get_personality(void) {
+  return personality;
+}
+
+void USB_ARC_set_latency(bool on) {
+#ifndef CONFIG_ANNOYATRON
+  latency = on;
+#endif
+}
+
+bool USB_ARC_get_latency(void) {
+#ifndef CONFIG_ANNOYATRON
+  return latency;
+#else
+  return FALSE;
+#endif
+}
+
+u8_t USB_ARC_get_latency_endpoint(void) {
+  return ARC_layout.latency_ep;
+}
+
+void USB_ARC_set_report_edge(u8_t dev, u32_t edge_us) {
+  if (dev < ARC_DEVICES) lat_dev[dev].edge_us = edge_us;
+}
+
+void USB_ARC_get_latency_stats(u32_t *sent, u32_t *lost) {
+  *sent = lat.sent;
+  *lost = lat.lost;
+}
+
+void USB_ARC_get_latency_cycles(u32_t *last, u32_t *max) {
+  *last = lat.cycles_last;
+  *max = lat.cycles_max;
+}
+
+void USB_ARC_set_devices(u8_t devs) {
+  devices = devs;
+}
+
+u8_t USB_ARC_get_devices(void) {
+  return devices;
+}
+
+void USB_ARC_set_report_source(u8_t dev, const u8_t *report, u8_t len) {
+  if (dev >= ARC_DEVICES) return;
+  report_src[dev] = report;
+  report_src_len[dev] = report ? MIN(len, sizeof(usb_kb_report)) : 0;
+}
+
+uint8_t USB_ARC_get_report(uint8_t dev, uint8_t *buf) {
+  if (report_src[dev] == NULL) return 0;
+  uint8_t len = report_src_len[dev];
+  if (USB_ARC_boot_protocol(dev)) {
+    len = MIN(len, dev == ARC_DEV_KB ? USB_KB_BOOT_REPORT_SIZE : USB_MOUSE_BOOT_REPORT_SIZE);
+  }
+  memcpy(buf, report_src[dev], len);
+  return len;
+}
+
+void USB_ARC_set_idle(uint8_t devs, uint8_t rate) {
+  uint8_t dev;
+  for (dev = 0; dev < ARC_DEVICES; dev++) {
+    if (devs & (1 << dev)) idle_rate[dev] = rate;
+  }
+}
+
+uint8_t USB_ARC_get_idle(uint8_t dev) {
+  return idle_rate[dev];
+}
+
+// boot protocol is only for the keyboard and mouse interfaces, having the
+// boot subclass
+static bool dev_has_boot(uint8_t dev) {
+  return personality == USB_ARC_COMPOSITE && (dev == ARC_DEV_KB || dev == ARC_DEV_MOUSE);
+}
+
+bool USB_ARC_set_protocol(uint8_t devs, uint8_t p) {
+  uint8_t dev;
+  if (p != HID_PROTOCOL_BOOT && p != HID_PROTOCOL_REPORT) return FALSE;
+  for (dev = 0; dev < ARC_DEVICES; dev++) {
+    if ((devs & (1 << dev)) && p == HID_PROTOCOL_BOOT && !dev_has_boot(dev)) return FALSE;
+  }
+  for (dev = 0; dev < ARC_DEVICES; dev++) {
+    if (devs & (1 << dev)) protocol[dev] = p;
+  }
+  return TRUE;
+}
+
+uint8_t USB_ARC_get_protocol(uint8_t dev) {
+  return protocol[dev];
+}
+
+bool USB_ARC_boot_protocol(u8_t dev) {
+  return dev < ARC_DEVICES && protocol[dev] == HID_PROTOCOL_BOOT;
+}
+
+u32_t USB_ARC_get_idle_ms(u8_t dev) {
+  return dev < ARC_DEVICES ? idle_rate[dev] * 4 : 0;
+}
+
+u8_t USB_ARC_get_endpoint(u8_t dev) {
+  return dev < ARC_DEVICES ? ARC_layout.dev_ep[dev] : 0;
+}
+
+void USB_ARC_configured(void) {
+  if (enum_ms == 0) {
+    enum_ms = MAX(SYS_get_time_ms() - start_ms, 1);
+  }
+}
+
+u32_t USB_ARC_get_enum_time_ms(void) {
+  return enum_ms;
+}
+
 void USB_ARC_start(void) {
+  start_ms = SYS_get_time_ms();
+  enum_ms = 0;
   USB_Init();
 }
 
@@ -19,16 +19,36 @@ extern usb_serial_rx_cb rx_cb;
 void Handle_USBAsynchXfer(void);
 #endif
 
-extern volatile uint8_t kb_tx_complete;
-extern volatile uint8_t mouse_tx_complete;
-extern volatile uint8_t joy1_tx_complete;
-extern volatile uint8_t joy2_tx_complete;
 extern usb_kb_report_ready_cb_f kb_report_ready_cb;
 extern usb_mouse_report_ready_cb_f mouse_report_ready_cb;
 extern usb_joy_report_ready_cb_f joy_report_ready_cb;
+extern usb_sof_cb_f sof_cb;
+extern usb_suspend_cb_f suspend_cb;
 
 extern uint8_t kb_led_state;
 
+// hid in endpoint sent, sends staged report, or next queued report in
+// single personality
+void USB_ARC_ep_tx_done(uint8_t ep);
+// usb reset, reports on endpoints or staged are dropped and idle rates and
+// protocols are back to defaults
+void USB_ARC_reset(void);
+// copies current report of device to buf, returns length, 0 if none
+uint8_t USB_ARC_get_report(uint8_t dev, uint8_t *buf);
+// sets idle rate in 4 ms of devices, bit per device
+void USB_ARC_set_idle(uint8_t devs, uint8_t rate);
+uint8_t USB_ARC_get_idle(uint8_t dev);
+// sets HID_PROTOCOL_* of devices, bit per device, returns FALSE if a device
+// cannot take it
+bool USB_ARC_set_protocol(uint8_t devs, uint8_t p);
+uint8_t USB_ARC_get_protocol(uint8_t dev);
+// host set configuration
+void USB_ARC_configured(void);
+// bus suspended, macrocell in low power mode, called from irq
+void Enter_LowPowerMode(void);
+// bus resumed by host or by remote wakeup, called from irq
+void Leave_LowPowerMode(void);
+
 void USB_Cable_Config (FunctionalState NewState);
 void Get_SerialNum(void);
 
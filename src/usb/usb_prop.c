@@ -39,7 +39,15 @@
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-uint32_t ProtocolValue;
+// GET_REPORT and GET_IDLE data, report id first in single personality
+static uint8_t get_report_data[1 + sizeof(usb_kb_report)];
+static uint8_t get_report_len;
+static uint8_t get_idle_data;
+static uint8_t get_protocol_data;
+#ifndef CONFIG_ANNOYATRON
+// keyboard led output report in single personality, report id first
+static uint8_t kb_led_report[2];
+#endif
 
 #ifdef CONFIG_ARCHID_VCD
 
@@ -100,8 +108,8 @@ ONE_DESCRIPTOR Device_Descriptor =
 
 ONE_DESCRIPTOR Config_Descriptor =
   {
-    (uint8_t*)ARC_config_descriptor,
-    ARC_SIZE_CONFIG_DESC
+    ARC_config_descriptor,
+    0
   };
 
 ONE_DESCRIPTOR ARC_KB_Report_Descriptor =
@@ -122,9 +130,24 @@ ONE_DESCRIPTOR ARC_JOYSTICK_Report_Descriptor =
     ARC_JOYSTICK_SIZE_REPORT_DESC
   };
 
+#ifndef CONFIG_ANNOYATRON
+ONE_DESCRIPTOR ARC_SINGLE_Report_Descriptor =
+  {
+    ARC_single_report_descriptor,
+    0
+  };
+
+ONE_DESCRIPTOR ARC_LATENCY_Report_Descriptor =
+  {
+    (uint8_t *)ARC_LATENCY_report_descriptor,
+    ARC_LATENCY_SIZE_REPORT_DESC
+  };
+#endif
+
+// set to hid descriptor of requested interface
 ONE_DESCRIPTOR ARC_Hid_Descriptor =
   {
-    (uint8_t*)ARC_config_descriptor + ARC_OFFS_HID_DESC,
+    ARC_config_descriptor,
     ARC_SIZE_HID_DESC
   };
 
@@ -141,6 +164,52 @@ ONE_DESCRIPTOR String_Descriptor[4] =
 /* Extern function prototypes ------------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
+/*******************************************************************************
+* Function Name  : ARC_interface_devices
+* Description    : Devices of the interface a hid class request is for.
+* Input          : None.
+* Output         : None.
+* Return         : Bit per device, 0 if none or latency interface.
+*******************************************************************************/
+static uint8_t ARC_interface_devices(void)
+{
+  uint8_t ifc = pInformation->USBwIndex0;
+  if (ifc >= ARC_layout.hid_interfaces)
+  {
+    return 0;
+  }
+#ifndef CONFIG_ANNOYATRON
+  if (ARC_layout.ifc_dev[ifc] == ARC_DEV_LATENCY) {
+    return 0;
+  }
+  if (USB_ARC_get_personality() == USB_ARC_SINGLE) {
+    return ARC_layout.devices;
+  }
+#endif
+  return 1 << ARC_layout.ifc_dev[ifc];
+}
+
+/*******************************************************************************
+* Function Name  : ARC_request_devices
+* Description    : Devices a hid class request is for, by interface, or by
+*                  report id in single personality where 0 is all devices.
+* Input          : None.
+* Output         : None.
+* Return         : Bit per device, 0 if none.
+*******************************************************************************/
+static uint8_t ARC_request_devices(void)
+{
+  uint8_t devs = ARC_interface_devices();
+#ifndef CONFIG_ANNOYATRON
+  if (USB_ARC_get_personality() == USB_ARC_SINGLE) {
+    uint8_t id = pInformation->USBwValue0;
+    if (id == 0) return devs;
+    return id <= ARC_DEVICES ? devs & (1 << (id - 1)) : 0;
+  }
+#endif
+  return devs;
+}
+
 /*******************************************************************************
 * Function Name  : ARC_init.
 * Description    : Joystick Mouse init routine.
@@ -154,6 +223,13 @@ void ARC_init(void)
   ID*/
   Get_SerialNum();
 
+  ARC_build_descriptors(USB_ARC_get_personality() == USB_ARC_SINGLE, USB_ARC_get_devices(),
+      USB_ARC_get_latency());
+  Config_Descriptor.Descriptor_Size = ARC_layout.config_size;
+#ifndef CONFIG_ANNOYATRON
+  ARC_SINGLE_Report_Descriptor.Descriptor_Size = ARC_layout.report_size;
+#endif
+
   pInformation->Current_Configuration = 0;
   /* Connect the device */
   PowerOn();
@@ -177,8 +253,8 @@ void ARC_Reset(void)
   pInformation->Current_Configuration = 0;
   pInformation->Current_Interface = 0;/*the default Interface*/
 
-  /* Current Feature initialization */
-  pInformation->Current_Feature = ARC_config_descriptor[7];
+  /* Current Feature initialization, remote wakeup is off until host enables it */
+  pInformation->Current_Feature = Config_Descriptor.Descriptor[7] & ~(1 << 5);
   SetBTABLE(BTABLE_ADDRESS);
   /* Initialize Endpoint 0 */
 
@@ -190,36 +266,24 @@ void ARC_Reset(void)
   SetEPRxCount(ENDP0, Device_Property.MaxPacketSize);
   SetEPRxValid(ENDP0);
 
-  /* Initialize Endpoint 1 */
-  SetEPType(ENDP1, EP_INTERRUPT);
-  SetEPTxAddr(ENDP1, ENDP1_TXADDR);
-  SetEPTxCount(ENDP1, USB_KB_REPORT_KEYMAP_SIZE);
-  SetEPRxStatus(ENDP1, EP_RX_DIS);
-  SetEPTxStatus(ENDP1, EP_TX_NAK);
-
-  /* Initialize Endpoint 2 */
-  SetEPType(ENDP2, EP_INTERRUPT);
-  SetEPTxAddr(ENDP2, ENDP2_TXADDR);
-  SetEPTxCount(ENDP2, 8);
-  SetEPRxStatus(ENDP2, EP_RX_DIS);
-  SetEPTxStatus(ENDP2, EP_TX_NAK);
+  /* Initialize hid Endpoints, those not described are disabled */
+  USB_ARC_reset();
+  uint8_t ep;
+  for (ep = ENDP1; ep <= ARC_DEVICES && ep < EP_NUM; ep++) {
+    if (ep > ARC_layout.endpoints) {
+      SetEPTxStatus(ep, EP_TX_DIS);
+      SetEPRxStatus(ep, EP_RX_DIS);
+      continue;
+    }
+    SetEPType(ep, EP_INTERRUPT);
+    SetEPTxAddr(ep, ARC_layout.ep_txaddr[ep]);
+    SetEPTxCount(ep, ARC_layout.ep_size[ep]);
+    SetEPRxStatus(ep, EP_RX_DIS);
+    SetEPTxStatus(ep, EP_TX_NAK);
+  }
 
 #ifndef CONFIG_ANNOYATRON
 
-  /* Initialize Endpoint 3 */
-  SetEPType(ENDP3, EP_INTERRUPT);
-  SetEPTxAddr(ENDP3, ENDP3_TXADDR);
-  SetEPTxCount(ENDP3, 8);
-  SetEPRxStatus(ENDP3, EP_RX_DIS);
-  SetEPTxStatus(ENDP3, EP_TX_NAK);
-
-  /* Initialize Endpoint 4 */
-  SetEPType(ENDP4, EP_INTERRUPT);
-  SetEPTxAddr(ENDP4, ENDP4_TXADDR);
-  SetEPTxCount(ENDP4, 8);
-  SetEPRxStatus(ENDP4, EP_RX_DIS);
-  SetEPTxStatus(ENDP4, EP_TX_NAK);
-
 #ifdef CONFIG_ARCHID_VCD
 
   /* Initialize Endpoint 7 */
@@ -263,6 +327,7 @@ void ARC_SetConfiguration(void)
   {
     /* Device configured */
     bDeviceState = CONFIGURED;
+    USB_ARC_configured();
   }
 }
 /*******************************************************************************
@@ -285,6 +350,12 @@ void ARC_SetDeviceAddress (void)
 void ARC_Status_In(void)
 {
   static uint8_t old_led_state = 0;
+#ifndef CONFIG_ANNOYATRON
+  if (USB_ARC_get_personality() == USB_ARC_SINGLE && kb_led_report[0] == ARC_REPORT_ID_KB) {
+    kb_led_state = kb_led_report[1];
+    kb_led_report[0] = 0;
+  }
+#endif
   if (old_led_state != kb_led_state) {
     //print("led state:%s %s\n", kb_led_state & 1 ? "NUM":"", kb_led_state & 2 ? "CAPS":"");
     old_led_state = kb_led_state;
@@ -310,6 +381,12 @@ void ARC_Status_Out (void)
 
 uint8_t *ARC_set_configuration(uint16_t Length)
 {
+#ifndef CONFIG_ANNOYATRON
+  if (USB_ARC_get_personality() == USB_ARC_SINGLE) {
+    pInformation->Ctrl_Info.Usb_wLength = sizeof(kb_led_report);
+    return kb_led_report;
+  }
+#endif
   pInformation->Ctrl_Info.Usb_wLength = 1;
   return &kb_led_state;
 }
@@ -364,30 +441,65 @@ RESULT ARC_Data_Setup(uint8_t RequestNo)
 
   if ((RequestNo == GET_DESCRIPTOR)
       && (Type_Recipient == (STANDARD_REQUEST | INTERFACE_RECIPIENT))
-      && (pInformation->USBwIndex0 >= 0 || pInformation->USBwIndex0 <= 3))
+      && (pInformation->USBwIndex0 < ARC_layout.hid_interfaces))
   {
+    uint8_t ifc = pInformation->USBwIndex0;
     if (pInformation->USBwValue1 == REPORT_DESCRIPTOR)
     {
-      if (pInformation->USBwIndex0 == 0) {
+#ifndef CONFIG_ANNOYATRON
+      if (ARC_layout.ifc_dev[ifc] == ARC_DEV_LATENCY) {
+        CopyRoutine = ARC_GetLatencyReportDescriptor;
+      } else if (USB_ARC_get_personality() == USB_ARC_SINGLE) {
+        CopyRoutine = ARC_GetSingleReportDescriptor;
+      } else
+#endif
+      if (ARC_layout.ifc_dev[ifc] == ARC_DEV_KB) {
         CopyRoutine = ARC_GetKBReportDescriptor;
-      } else if (pInformation->USBwIndex0 == 1) {
+      } else if (ARC_layout.ifc_dev[ifc] == ARC_DEV_MOUSE) {
         CopyRoutine = ARC_GetMouseReportDescriptor;
-      } else { // ix 2 | | 3
+      } else { // joystick 1 | | 2
         CopyRoutine = ARC_GetJoystickReportDescriptor;
       }
     }
     else if (pInformation->USBwValue1 == HID_DESCRIPTOR_TYPE)
     {
+      ARC_Hid_Descriptor.Descriptor = ARC_config_descriptor + ARC_layout.ifc_hid_offs[ifc];
       CopyRoutine = ARC_GetHIDDescriptor;
     }
 
   } /* End of GET_DESCRIPTOR */
 
-  /*** GET_PROTOCOL ***/
+  /*** GET_REPORT, GET_IDLE, GET_PROTOCOL ***/
   else if ((Type_Recipient == (CLASS_REQUEST | INTERFACE_RECIPIENT))
-           && RequestNo == GET_PROTOCOL)
+           && (RequestNo == GET_REPORT || RequestNo == GET_IDLE || RequestNo == GET_PROTOCOL))
   {
-    CopyRoutine = ARC_GetProtocolValue;
+    // protocol is per interface, wValue holds no report id
+    uint8_t devs = RequestNo == GET_PROTOCOL ? ARC_interface_devices() : ARC_request_devices();
+    uint8_t dev;
+    for (dev = 0; dev < ARC_DEVICES && (devs & (1 << dev)) == 0; dev++);
+    if (dev == ARC_DEVICES)
+    {
+      return USB_UNSUPPORT;
+    }
+    if (RequestNo == GET_IDLE)
+    {
+      get_idle_data = USB_ARC_get_idle(dev);
+      CopyRoutine = ARC_GetIdle;
+    }
+    else if (RequestNo == GET_PROTOCOL)
+    {
+      get_protocol_data = USB_ARC_get_protocol(dev);
+      CopyRoutine = ARC_GetProtocolValue;
+    }
+    else if (pInformation->USBwValue1 == HID_REPORT_INPUT
+        && (USB_ARC_get_personality() == USB_ARC_COMPOSITE || pInformation->USBwValue0 != 0))
+    {
+      // served from report as currently built, report id first if any
+      uint8_t *d = get_report_data;
+      if (USB_ARC_get_personality() == USB_ARC_SINGLE) *d++ = dev + 1;
+      get_report_len = (d - get_report_data) + USB_ARC_get_report(dev, d);
+      CopyRoutine = ARC_GetReport;
+    }
   }
   /*** SET_CONFIGURATION ***/
   else if (RequestNo == SET_CONFIGURATION) {
@@ -441,6 +553,24 @@ RESULT ARC_NoData_Setup(uint8_t RequestNo)
     {
       return ARC_SetProtocol();
     }
+    else if (RequestNo == SET_IDLE)
+    {
+      uint8_t devs = ARC_request_devices();
+      if (devs == 0)
+      {
+#ifndef CONFIG_ANNOYATRON
+        // latency interface sends records as they come, idle rate is moot
+        if (pInformation->USBwIndex0 < ARC_layout.hid_interfaces
+            && ARC_layout.ifc_dev[pInformation->USBwIndex0] == ARC_DEV_LATENCY)
+        {
+          return USB_SUCCESS;
+        }
+#endif
+        return USB_UNSUPPORT;
+      }
+      USB_ARC_set_idle(devs, pInformation->USBwValue1);
+      return USB_SUCCESS;
+    }
 #ifdef CONFIG_ARCHID_VCD
     else if (RequestNo == SET_COMM_FEATURE)
     {
@@ -518,6 +648,16 @@ uint8_t *ARC_GetJoystickReportDescriptor(uint16_t Length)
 {
   return Standard_GetDescriptorData(Length, &ARC_JOYSTICK_Report_Descriptor);
 }
+#ifndef CONFIG_ANNOYATRON
+uint8_t *ARC_GetSingleReportDescriptor(uint16_t Length)
+{
+  return Standard_GetDescriptorData(Length, &ARC_SINGLE_Report_Descriptor);
+}
+uint8_t *ARC_GetLatencyReportDescriptor(uint16_t Length)
+{
+  return Standard_GetDescriptorData(Length, &ARC_LATENCY_Report_Descriptor);
+}
+#endif
 
 /*******************************************************************************
 * Function Name  : ARC_GetHIDDescriptor.
@@ -546,11 +686,7 @@ RESULT ARC_Get_Interface_Setting(uint8_t Interface, uint8_t AlternateSetting)
   {
     return USB_UNSUPPORT;
   }
-#if defined(CONFIG_ARCHID_VCD) && !defined(CONFIG_ANNOYATRON)
-  else if (Interface > 1)
-#else
-    else if (Interface > 0)
-#endif
+  else if (Interface >= ARC_layout.interfaces)
   {
     return USB_UNSUPPORT;
   }
@@ -559,15 +695,19 @@ RESULT ARC_Get_Interface_Setting(uint8_t Interface, uint8_t AlternateSetting)
 
 /*******************************************************************************
 * Function Name  : ARC_SetProtocol
-* Description    : Joystick Set Protocol request routine.
+* Description    : Set Protocol request routine, boot protocol only for
+*                  keyboard and mouse interfaces.
 * Input          : None.
 * Output         : None.
-* Return         : USB SUCCESS.
+* Return         : USB_SUCCESS or USB_UNSUPPORT.
 *******************************************************************************/
 RESULT ARC_SetProtocol(void)
 {
-  uint8_t wValue0 = pInformation->USBwValue0;
-  ProtocolValue = wValue0;
+  uint8_t devs = ARC_interface_devices();
+  if (devs == 0 || !USB_ARC_set_protocol(devs, pInformation->USBwValue0))
+  {
+    return USB_UNSUPPORT;
+  }
   return USB_SUCCESS;
 }
 
@@ -587,8 +727,42 @@ uint8_t *ARC_GetProtocolValue(uint16_t Length)
   }
   else
   {
-    return (uint8_t *)(&ProtocolValue);
+    return &get_protocol_data;
+  }
+}
+
+/*******************************************************************************
+* Function Name  : ARC_GetReport
+* Description    : get the current report of device, GET_REPORT
+* Input          : Length.
+* Output         : None.
+* Return         : address of the report.
+*******************************************************************************/
+uint8_t *ARC_GetReport(uint16_t Length)
+{
+  if (Length == 0)
+  {
+    pInformation->Ctrl_Info.Usb_wLength = get_report_len - pInformation->Ctrl_Info.Usb_wOffset;
+    return NULL;
+  }
+  return get_report_data + pInformation->Ctrl_Info.Usb_wOffset;
+}
+
+/*******************************************************************************
+* Function Name  : ARC_GetIdle
+* Description    : get the idle rate of device, GET_IDLE
+* Input          : Length.
+* Output         : None.
+* Return         : address of the idle rate.
+*******************************************************************************/
+uint8_t *ARC_GetIdle(uint16_t Length)
+{
+  if (Length == 0)
+  {
+    pInformation->Ctrl_Info.Usb_wLength = 1;
+    return NULL;
   }
+  return &get_idle_data;
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -68,9 +68,13 @@ uint8_t *ARC_GetConfigDescriptor(uint16_t);
 uint8_t *ARC_GetStringDescriptor(uint16_t);
 RESULT ARC_SetProtocol(void);
 uint8_t *ARC_GetProtocolValue(uint16_t Length);
+uint8_t *ARC_GetReport(uint16_t Length);
+uint8_t *ARC_GetIdle(uint16_t Length);
 uint8_t *ARC_GetKBReportDescriptor(uint16_t Length);
 uint8_t *ARC_GetMouseReportDescriptor(uint16_t Length);
 uint8_t *ARC_GetJoystickReportDescriptor(uint16_t Length);
+uint8_t *ARC_GetSingleReportDescriptor(uint16_t Length);
+uint8_t *ARC_GetLatencyReportDescriptor(uint16_t Length);
 uint8_t *ARC_GetHIDDescriptor(uint16_t Length);
 uint8_t *ARC_VCP_GetLineCoding(uint16_t Length);
 uint8_t *ARC_VCP_SetLineCoding(uint16_t Length);
@@ -87,6 +91,11 @@ uint8_t *ARC_VCP_SetLineCoding(uint16_t Length);
 //#define ARC_SetDeviceAddress          NOP_Process
 
 #define REPORT_DESCRIPTOR                  0x22
+// GET_REPORT report types
+#define HID_REPORT_INPUT                   0x01
+// SET_PROTOCOL protocols
+#define HID_PROTOCOL_BOOT                  0x00
+#define HID_PROTOCOL_REPORT                0x01
 
 #define SEND_ENCAPSULATED_COMMAND   0x00
 #define GET_ENCAPSULATED_RESPONSE   0x01
@@ -162,6 +162,8 @@ void Suspend(void)
 	/* enter system in STOP mode, only when wakeup flag in not set */
 	if((_GetISTR()&ISTR_WKUP)==0)
 	{
+		/* stop mode is entered by application, outside of irq */
+		Enter_LowPowerMode();
 	}
 	else
 	{
@@ -196,7 +198,7 @@ void Resume_Init(void)
   
   /* restore full power */
   /* ... on connected devices */
-  //Leave_LowPowerMode();
+  Leave_LowPowerMode();
 
   /* reset FSUSP bit */
   _SetCNTR(IMR_MSK);
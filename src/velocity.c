@@ -0,0 +1,92 @@
+/*
+ * velocity.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "velocity.h"
+
+u32_t VEL_ramp(u32_t acc, u16_t speed, u32_t dt_us, u32_t period_us) {
+  if (period_us == 0) period_us = 1;
+  u64_t step = ((u64_t)speed * dt_us * VEL_ONE) / period_us;
+  u64_t ramped = acc + step;
+  return ramped > (u64_t)VEL_ACC_MAX * VEL_ONE ? (u32_t)VEL_ACC_MAX * VEL_ONE : (u32_t)ramped;
+}
+
+// speed fraction in Q16 of curve at t, Q16 of accelerator range
+static u32_t vel_curve_at(const vel_curve *c, u32_t t) {
+  int p;
+  switch (c->type) {
+  case VEL_CURVE_QUADRATIC:
+    return ((u64_t)t * t) >> 16;
+  case VEL_CURVE_S:
+    // 3t^2 - 2t^3
+    return ((((u64_t)t * t) >> 16) * (3 * VEL_ONE - 2 * t)) >> 16;
+  case VEL_CURVE_USER:
+    for (p = 0; p < c->points && t > (u32_t)c->x[p] * VEL_ONE / 100; p++);
+    if (p == 0) return (u32_t)c->y[0] * VEL_ONE / 100;
+    if (p == c->points) return (u32_t)c->y[p-1] * VEL_ONE / 100;
+    {
+      u32_t x0 = (u32_t)c->x[p-1] * VEL_ONE / 100;
+      u32_t x1 = (u32_t)c->x[p] * VEL_ONE / 100;
+      s32_t y0 = (s32_t)c->y[p-1] * VEL_ONE / 100;
+      s32_t y1 = (s32_t)c->y[p] * VEL_ONE / 100;
+      return y0 + (s32_t)(((s64_t)(y1 - y0) * (t - x0)) / (s32_t)(x1 - x0));
+    }
+  default:
+    return t;
+  }
+}
+
+bool VEL_build_lut(const vel_curve *c, u16_t *lut) {
+  vel_curve linear = { .type = VEL_CURVE_LINEAR };
+  bool ok = c->type < _VEL_CURVE_CNT;
+  if (c->type == VEL_CURVE_USER) {
+    int p;
+    ok = c->points > 0 && c->points <= VEL_CURVE_POINTS;
+    for (p = 0; ok && p < c->points; p++) {
+      ok = c->x[p] <= 100 && c->y[p] <= 100 && (p == 0 || c->x[p] > c->x[p-1]);
+    }
+  }
+  if (!ok) c = &linear;
+  int i;
+  for (i = 0; i < VEL_LUT_LEN; i++) {
+    u32_t f = vel_curve_at(c, (u32_t)i * VEL_ONE / (VEL_LUT_LEN - 1));
+    lut[i] = MIN(f, VEL_ONE) >> 1;
+  }
+  return ok;
+}
+
+s32_t VEL_target(u8_t data, const u16_t *lut, u32_t accelerator) {
+  s32_t vel = (s32_t)data * VEL_ONE;
+  if (lut) {
+    // index in Q16, interpolating between entries
+    u32_t ix = ((u64_t)MIN(accelerator, (u32_t)VEL_ACC_MAX * VEL_ONE) * (VEL_LUT_LEN - 1)) / VEL_ACC_MAX;
+    u32_t f = lut[ix >> 16];
+    if ((ix >> 16) < VEL_LUT_LEN - 1) {
+      f = (f * (VEL_ONE - (ix & 0xffff)) + lut[(ix >> 16) + 1] * (ix & 0xffff)) >> 16;
+    }
+    vel = (s32_t)((data * f) << 1);
+  }
+  return MAX(vel, VEL_ONE);
+}
+
+s8_t VEL_step(vel_axis *a, s32_t vel, u32_t dt_us, u32_t period_us) {
+  if (vel == 0) {
+    a->pos = 0;
+    return 0;
+  }
+  if (period_us == 0) period_us = 1;
+  s64_t pos = a->pos + ((s64_t)vel * dt_us) / period_us;
+  // whole counts toward zero, remainder keeps sign of movement
+  s64_t counts = pos / VEL_ONE;
+  if (counts > VEL_REPORT_MAX || counts < -VEL_REPORT_MAX) {
+    counts = counts > 0 ? VEL_REPORT_MAX : -VEL_REPORT_MAX;
+    pos = 0;
+  } else {
+    pos -= counts * VEL_ONE;
+  }
+  a->pos = (s32_t)pos;
+  return (s8_t)counts;
+}
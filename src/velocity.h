@@ -0,0 +1,76 @@
+/*
+ * velocity.h
+ *
+ * Fixed point velocity model for emulated mouse and joystick movement.
+ * Velocities are counts per nominal report period in Q16.16 and axes keep
+ * the part of their position not reported yet, so movement speed does not
+ * depend on how often reports are actually sent, and velocities below one
+ * count per report still move. Accelerators ramp per elapsed microsecond.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef SRC_VELOCITY_H_
+#define SRC_VELOCITY_H_
+
+#include "system.h"
+
+#define VEL_ONE           (1L << 16)
+// accelerator range, an accelerator is Q16.16 of 0 to VEL_ACC_MAX
+#define VEL_ACC_MAX       0xfff
+// max counts in one report
+#define VEL_REPORT_MAX    127
+// entries in an acceleration table, indexed by accelerator
+#define VEL_LUT_LEN       64
+// max points of a user acceleration curve
+#define VEL_CURVE_POINTS  6
+
+// shape of speed over accelerator range
+typedef enum {
+  VEL_CURVE_LINEAR = 0,
+  VEL_CURVE_QUADRATIC,  // slow start
+  VEL_CURVE_S,          // slow start and end, smoothstep
+  VEL_CURVE_USER,       // linear between user points
+  _VEL_CURVE_CNT
+} vel_curve_type;
+
+// acceleration curve, user points are percent of accelerator range and of
+// speed, ascending in accelerator range
+typedef struct {
+  u8_t type;
+  u8_t points;
+  u8_t x[VEL_CURVE_POINTS];
+  u8_t y[VEL_CURVE_POINTS];
+} vel_curve;
+
+// position not reported yet, counts in Q16.16
+typedef struct {
+  s32_t pos;
+} vel_axis;
+
+/**
+ * Returns accelerator ramped by speed per period_us for dt_us, capped at
+ * VEL_ACC_MAX.
+ */
+u32_t VEL_ramp(u32_t acc, u16_t speed, u32_t dt_us, u32_t period_us);
+/**
+ * Tabulates curve to lut of VEL_LUT_LEN speed fractions in Q15, entry i
+ * being the speed at i / (VEL_LUT_LEN-1) of the accelerator range. Returns
+ * FALSE if user points are bad, tabulating a linear curve instead.
+ */
+bool VEL_build_lut(const vel_curve *c, u16_t *lut);
+/**
+ * Returns velocity of a definition moving data counts per period, scaled by
+ * lut interpolated at accelerator unless lut is NULL, but at least one count
+ * per period.
+ */
+s32_t VEL_target(u8_t data, const u16_t *lut, u32_t accelerator);
+/**
+ * Advances axis at velocity for dt_us and returns whole counts to report,
+ * at most VEL_REPORT_MAX either way. The remainder is kept in axis, but
+ * dropped when velocity is zero or the report overflows.
+ */
+s8_t VEL_step(vel_axis *a, s32_t vel, u32_t dt_us, u32_t period_us);
+
+#endif /* SRC_VELOCITY_H_ */
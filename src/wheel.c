@@ -0,0 +1,132 @@
+/*
+ * wheel.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "wheel.h"
+#include "timer.h"
+
+#define WHEEL_MASK        (WHEEL_SLOTS - 1)
+
+static struct {
+  wheel_timer *slots[2][WHEEL_SLOTS];
+  u32_t now;
+  wheel_stats stats;
+} wheel;
+
+static void wheel_link(wheel_timer **head, wheel_timer *t) {
+  t->next = *head;
+  if (t->next) t->next->pprev = &t->next;
+  t->pprev = head;
+  *head = t;
+}
+
+static void wheel_unlink(wheel_timer *t) {
+  *t->pprev = t->next;
+  if (t->next) t->next->pprev = t->pprev;
+  t->next = NULL;
+  t->pprev = NULL;
+}
+
+// links timer into the slot its expiry falls in
+static void wheel_insert(wheel_timer *t) {
+  u32_t delta = t->expiry - wheel.now;
+  u32_t blocks = (t->expiry >> WHEEL_SLOT_BITS) - (wheel.now >> WHEEL_SLOT_BITS);
+  if (delta < WHEEL_SLOTS) {
+    wheel_link(&wheel.slots[0][t->expiry & WHEEL_MASK], t);
+  } else if (blocks < WHEEL_SLOTS) {
+    wheel_link(&wheel.slots[1][(t->expiry >> WHEEL_SLOT_BITS) & WHEEL_MASK], t);
+  } else {
+    // goes round level 1, inserted again when its slot comes up
+    wheel_link(&wheel.slots[1][(wheel.now >> WHEEL_SLOT_BITS) & WHEEL_MASK], t);
+  }
+}
+
+void WHEEL_init(void) {
+  memset(&wheel, 0, sizeof(wheel));
+}
+
+void WHEEL_start(wheel_timer *t, wheel_fn fn, u32_t arg, void *arg_p, u32_t delay, u32_t recurrent) {
+  if (WHEEL_is_running(t)) {
+    wheel_unlink(t);
+  } else {
+    wheel.stats.timers++;
+    wheel.stats.timers_max = MAX(wheel.stats.timers_max, wheel.stats.timers);
+  }
+  t->fn = fn;
+  t->arg = arg;
+  t->arg_p = arg_p;
+  t->expiry = wheel.now + MAX(delay, 1);
+  t->recurrent = recurrent;
+  wheel_insert(t);
+}
+
+void WHEEL_stop(wheel_timer *t) {
+  if (!WHEEL_is_running(t)) return;
+  wheel_unlink(t);
+  wheel.stats.timers--;
+}
+
+void WHEEL_tick(void) {
+  u32_t cycles = TIMER_get_cycles();
+  wheel_timer *t;
+  wheel.now++;
+  wheel.stats.ticks++;
+  if ((wheel.now & WHEEL_MASK) == 0) {
+    // move timers of level 1 slot due in coming ticks down
+    wheel_timer *list = wheel.slots[1][(wheel.now >> WHEEL_SLOT_BITS) & WHEEL_MASK];
+    if (list) {
+      list->pprev = &list;
+      wheel.slots[1][(wheel.now >> WHEEL_SLOT_BITS) & WHEEL_MASK] = NULL;
+    }
+    while ((t = list) != NULL) {
+      wheel_unlink(t);
+      wheel_insert(t);
+      wheel.stats.cascaded++;
+    }
+  }
+  // callbacks can only start timers expiring in later slots
+  wheel_timer **slot = &wheel.slots[0][wheel.now & WHEEL_MASK];
+  while ((t = *slot) != NULL) {
+    wheel_unlink(t);
+    if (t->recurrent) {
+      t->expiry = wheel.now + t->recurrent;
+      wheel_insert(t);
+    } else {
+      wheel.stats.timers--;
+    }
+    wheel.stats.expired++;
+    t->fn(t->arg, t->arg_p);
+  }
+  cycles = TIMER_get_cycles() - cycles;
+  wheel.stats.tick_cycles_last = cycles;
+  wheel.stats.tick_cycles_max = MAX(wheel.stats.tick_cycles_max, cycles);
+}
+
+u16_t WHEEL_count(void) {
+  return wheel.stats.timers;
+}
+
+void WHEEL_get_stats(wheel_stats *stats) {
+  int l, s;
+  wheel_timer *t;
+  memcpy(stats, &wheel.stats, sizeof(wheel_stats));
+  for (l = 0; l < 2; l++) {
+    stats->level_timers[l] = 0;
+    for (s = 0; s < WHEEL_SLOTS; s++) {
+      for (t = wheel.slots[l][s]; t; t = t->next) {
+        stats->level_timers[l]++;
+      }
+    }
+  }
+}
+
+void WHEEL_clear_stats(void) {
+  wheel.stats.timers_max = wheel.stats.timers;
+  wheel.stats.ticks = 0;
+  wheel.stats.expired = 0;
+  wheel.stats.cascaded = 0;
+  wheel.stats.tick_cycles_max = 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * wheel.h
+ *
+ * Application timer wheel, two levels of WHEEL_SLOTS lists. Level 0 holds
+ * timers expiring within WHEEL_SLOTS ticks, one tick per slot, level 1
+ * holds later timers, WHEEL_SLOTS ticks per slot, which are moved down to
+ * level 0 when their slot comes up. Timers further away than level 1 spans
+ * go round level 1 until due. Starting and stopping a timer is O(1), a tick
+ * expires one level 0 slot and every WHEEL_SLOTS ticks moves one level 1
+ * slot down.
+ *
+ * Not reentrant, start, stop and tick from task context only.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef SRC_WHEEL_H_
+#define SRC_WHEEL_H_
+
+#include "system.h"
+
+#define WHEEL_SLOT_BITS   5
+#define WHEEL_SLOTS       (1 << WHEEL_SLOT_BITS)
+
+typedef void (* wheel_fn)(u32_t arg, void *arg_p);
+
+typedef struct wheel_timer_s {
+  struct wheel_timer_s *next;
+  struct wheel_timer_s **pprev; // link pointing to this timer, NULL if stopped
+  wheel_fn fn;
+  u32_t arg;
+  void *arg_p;
+  u32_t expiry;                 // tick of expiry
+  u32_t recurrent;              // ticks between expiries, 0 if single shot
+} wheel_timer;
+
+typedef struct {
+  u32_t ticks;
+  u16_t timers;             // running timers
+  u16_t timers_max;
+  u16_t level_timers[2];    // running timers per level
+  u32_t expired;            // timer callbacks called
+  u32_t cascaded;           // timers moved from level 1
+  u32_t tick_cycles_last;   // cpu cycles of last tick, including callbacks
+  u32_t tick_cycles_max;
+} wheel_stats;
+
+void WHEEL_init(void);
+/**
+ * Starts timer calling fn(arg, arg_p) after delay ticks, at least one, and
+ * then every recurrent ticks unless zero. A running timer is restarted.
+ */
+void WHEEL_start(wheel_timer *t, wheel_fn fn, u32_t arg, void *arg_p, u32_t delay, u32_t recurrent);
+/**
+ * Stops timer, may be called for a stopped timer and from its own callback.
+ */
+void WHEEL_stop(wheel_timer *t);
+static inline bool WHEEL_is_running(const wheel_timer *t) {
+  return t->pprev != NULL;
+}
+/**
+ * Advances wheel one tick, calling callbacks of expired timers.
+ */
+void WHEEL_tick(void);
+u16_t WHEEL_count(void);
+void WHEEL_get_stats(wheel_stats *stats);
+void WHEEL_clear_stats(void);
+
+#endif /* SRC_WHEEL_H_ */
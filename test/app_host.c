@@ -0,0 +1,393 @@
+/*
+ * app_host.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "app_host.h"
+#include "gpio_map.h"
+#include "processor.h"
+#include "niffs_impl.h"
+#include "def_config_parser.h"
+
+#define SYS_TICK_US   (1000000 / SYS_MAIN_TIMER_FREQ)
+#define USB_DEVS      4
+
+static struct {
+  bool busy;
+  bool staged;
+  u8_t staged_len;
+  u8_t staged_data[32];
+  const u8_t *src;
+  u8_t src_len;
+  u32_t idle_ms;
+} usb_dev[USB_DEVS];
+static usb_kb_report_ready_cb_f kb_cb;
+static usb_mouse_report_ready_cb_f mouse_cb;
+static usb_joy_report_ready_cb_f joy_cb;
+static usb_sof_cb_f sof_cb;
+static usb_suspend_cb_f suspend_cb;
+static bool suspended;
+static bool remote_wakeup;
+static bool timer_running;
+static u32_t stops;
+static bool stopped;
+static u32_t stop_irqs;
+static bool alarm_armed;
+static u32_t alarm_us;
+static u32_t wakeups;
+static bool polling;
+static u8_t devices;
+static u32_t overruns;
+static u32_t next_frame_us;
+
+static app_host_report reports[APP_HOST_REPORTS];
+static int report_cnt;
+
+void app_host_restart(void) {
+  host_init();
+  memset(usb_dev, 0, sizeof(usb_dev));
+  kb_cb = NULL;
+  mouse_cb = NULL;
+  joy_cb = NULL;
+  sof_cb = NULL;
+  suspend_cb = NULL;
+  suspended = FALSE;
+  remote_wakeup = FALSE;
+  timer_running = TRUE;
+  stops = 0;
+  stopped = FALSE;
+  alarm_armed = FALSE;
+  wakeups = 0;
+  polling = TRUE;
+  overruns = 0;
+  next_frame_us = 1000;
+  report_cnt = 0;
+  GPIO_MAP_init();
+  APP_init();
+  host_run_tasks();
+}
+
+void app_host_init_default(void) {
+  niffs_ram_erase();
+  app_host_restart();
+}
+
+void app_host_init(void) {
+  app_host_init_default();
+  APP_cfg_clear_pins();
+}
+
+static void usb_log(u8_t dev, const void *report, u8_t len);
+
+static void usb_frame(void) {
+  int dev;
+  if (sof_cb) sof_cb();
+  if (!polling) return;
+  for (dev = 0; dev < USB_DEVS; dev++) {
+    if (!usb_dev[dev].busy) continue;
+    if (usb_dev[dev].staged) {
+      // staged report given to endpoint for next poll
+      usb_dev[dev].staged = FALSE;
+      usb_log(dev, usb_dev[dev].staged_data, usb_dev[dev].staged_len);
+    } else {
+      usb_dev[dev].busy = FALSE;
+    }
+    switch (dev) {
+    case 0: if (kb_cb) kb_cb(); break;
+    case 1: if (mouse_cb) mouse_cb(); break;
+    default: if (joy_cb) joy_cb(dev == 2 ? JOYSTICK1 : JOYSTICK2); break;
+    }
+  }
+}
+
+void app_host_run_us(u32_t us) {
+  u32_t end = host_get_us() + us;
+  while ((s32_t)(end - host_get_us()) > 0) {
+    host_advance_us(SYS_TICK_US);
+    if (timer_running) APP_timer();
+    if ((s32_t)(host_get_us() - next_frame_us) >= 0) {
+      next_frame_us += 1000;
+      // no frames on a suspended bus
+      if (!suspended) usb_frame();
+    }
+    // stopped cpu is woken by a gpio interrupt, an interrupt queueing a
+    // task, the rtc alarm or a resume
+    if (stopped && suspended && host_gpio_irqs() == stop_irqs &&
+        host_tasks_queued() == 0 &&
+        !(alarm_armed && (s32_t)(host_get_us() - alarm_us) >= 0)) {
+      continue;
+    }
+    if (stopped && alarm_armed && (s32_t)(host_get_us() - alarm_us) >= 0) {
+      alarm_armed = FALSE;
+    }
+    stopped = FALSE;
+    // main loop, stopping when idle
+    host_run_tasks();
+    APP_idle();
+  }
+}
+
+void app_host_pin(int pin, bool pressed) {
+  const gpio_pin_map *m = &GPIO_MAP_get_pin_map()[pin - 1];
+  ASSERT(!GPIO_MAP_IS_UNUSED(m));
+  host_gpio_set(m->port, m->pin, !pressed);
+}
+
+bool app_host_def(const char *def) {
+  def_config cfg;
+  if (!def_config_parse(&cfg, def, strlen(def))) return FALSE;
+  return APP_cfg_set_pin(&cfg);
+}
+
+void app_host_poll(bool poll) {
+  polling = poll;
+}
+
+void app_host_suspend(bool wakeup) {
+  suspended = TRUE;
+  remote_wakeup = wakeup;
+  if (suspend_cb) suspend_cb();
+}
+
+void app_host_resume(void) {
+  suspended = FALSE;
+}
+
+bool app_host_suspended(void) {
+  return suspended;
+}
+
+u32_t app_host_stops(void) {
+  return stops;
+}
+
+u32_t app_host_wakeups(void) {
+  return wakeups;
+}
+
+bool app_host_timer_running(void) {
+  return timer_running;
+}
+
+void app_host_set_idle_ms(u8_t dev, u32_t ms) {
+  usb_dev[dev].idle_ms = ms;
+}
+
+int app_host_report_count(u8_t dev) {
+  int i, n = 0;
+  for (i = 0; i < report_cnt; i++) {
+    if (reports[i].dev == dev) n++;
+  }
+  return n;
+}
+
+const app_host_report *app_host_report_get(u8_t dev, int ix) {
+  int i;
+  for (i = 0; i < report_cnt; i++) {
+    if (reports[i].dev == dev && ix-- == 0) return &reports[i];
+  }
+  return NULL;
+}
+
+const app_host_report *app_host_report_last(u8_t dev) {
+  int i;
+  for (i = report_cnt - 1; i >= 0; i--) {
+    if (reports[i].dev == dev) return &reports[i];
+  }
+  return NULL;
+}
+
+void app_host_reports_clear(void) {
+  report_cnt = 0;
+}
+
+int app_host_kb_keys(u8_t *keys, int max) {
+  const app_host_report *r = app_host_report_last(0);
+  int n = 0;
+  if (r) {
+    int i;
+    const usb_kb_report *kb = (const usb_kb_report *)r->data;
+    for (i = 0; i < USB_KB_REPORT_KEYMAP_SIZE && n < max - 1; i++) {
+      if (kb->keymap[i]) keys[n++] = kb->keymap[i];
+    }
+  }
+  keys[n] = 0;
+  return n;
+}
+
+bool app_host_kb_report_has(const app_host_report *r, enum kb_hid_code key) {
+  int i;
+  if (r == NULL) return FALSE;
+  const usb_kb_report *kb = (const usb_kb_report *)r->data;
+  if (key >= MOD_LCTRL) {
+    return (kb->modifiers & (1 << (key - MOD_LCTRL))) != 0;
+  }
+  for (i = 0; i < USB_KB_REPORT_KEYMAP_SIZE; i++) {
+    if (kb->keymap[i] == key) return TRUE;
+  }
+  return FALSE;
+}
+
+bool app_host_kb_has(enum kb_hid_code key) {
+  return app_host_kb_report_has(app_host_report_last(0), key);
+}
+
+int app_host_kb_first(enum kb_hid_code key) {
+  int ix;
+  const app_host_report *r;
+  for (ix = 0; (r = app_host_report_get(0, ix)) != NULL; ix++) {
+    if (app_host_kb_report_has(r, key)) return ix;
+  }
+  return -1;
+}
+
+u32_t app_host_overruns(void) {
+  return overruns;
+}
+
+// usb device
+
+static void usb_log(u8_t dev, const void *report, u8_t len) {
+  if (report_cnt < APP_HOST_REPORTS) {
+    app_host_report *r = &reports[report_cnt++];
+    r->dev = dev;
+    r->us = host_get_us();
+    r->len = len;
+    memcpy(r->data, report, len);
+  }
+}
+
+// staged behind a busy endpoint as the device does, replacing a staged one
+static void usb_tx(u8_t dev, const void *report, u8_t len) {
+  if (!usb_dev[dev].busy) {
+    usb_dev[dev].busy = TRUE;
+    usb_log(dev, report, len);
+    return;
+  }
+  if (usb_dev[dev].staged) overruns++;
+  usb_dev[dev].staged = TRUE;
+  usb_dev[dev].staged_len = len;
+  memcpy(usb_dev[dev].staged_data, report, len);
+}
+
+bool USB_ARC_tx_busy(u8_t dev) {
+  return usb_dev[dev].busy;
+}
+
+bool USB_ARC_KB_can_tx(void) {
+  return !usb_dev[0].busy || !usb_dev[0].staged;
+}
+
+bool USB_ARC_MOUSE_can_tx(void) {
+  return !usb_dev[1].busy || !usb_dev[1].staged;
+}
+
+bool USB_ARC_JOYSTICK_can_tx(usb_joystick joystick) {
+  return !usb_dev[2 + joystick].busy || !usb_dev[2 + joystick].staged;
+}
+
+void USB_ARC_KB_tx(usb_kb_report *report) {
+  usb_tx(0, report, sizeof(usb_kb_report));
+}
+
+void USB_ARC_MOUSE_tx(usb_mouse_report *report) {
+  usb_tx(1, report, sizeof(usb_mouse_report));
+}
+
+void USB_ARC_JOYSTICK_tx(usb_joystick joystick, usb_joystick_report *report) {
+  usb_tx(2 + joystick, report, sizeof(usb_joystick_report));
+}
+
+void USB_ARC_set_kb_callback(usb_kb_report_ready_cb_f cb) {
+  kb_cb = cb;
+}
+
+void USB_ARC_set_mouse_callback(usb_mouse_report_ready_cb_f cb) {
+  mouse_cb = cb;
+}
+
+void USB_ARC_set_joystick_callback(usb_joy_report_ready_cb_f cb) {
+  joy_cb = cb;
+}
+
+void USB_ARC_set_sof_callback(usb_sof_cb_f cb) {
+  sof_cb = cb;
+}
+
+void USB_ARC_set_suspend_callback(usb_suspend_cb_f cb) {
+  suspend_cb = cb;
+}
+
+bool USB_ARC_is_suspended(void) {
+  return suspended;
+}
+
+bool USB_ARC_remote_wakeup_enabled(void) {
+  return remote_wakeup;
+}
+
+// host resumes at once
+bool USB_ARC_remote_wakeup(void) {
+  if (!suspended || !remote_wakeup) return FALSE;
+  suspended = FALSE;
+  wakeups++;
+  return TRUE;
+}
+
+void USB_ARC_set_personality(usb_personality p) {
+}
+
+void USB_ARC_set_devices(u8_t d) {
+  devices = d;
+}
+
+void USB_ARC_set_report_source(u8_t dev, const u8_t *report, u8_t len) {
+  usb_dev[dev].src = report;
+  usb_dev[dev].src_len = len;
+}
+
+u32_t USB_ARC_get_idle_ms(u8_t dev) {
+  return usb_dev[dev].idle_ms;
+}
+
+bool USB_ARC_boot_protocol(u8_t dev) {
+  return FALSE;
+}
+
+void USB_ARC_set_latency(bool on) {
+}
+
+void USB_ARC_set_report_edge(u8_t dev, u32_t edge_us) {
+}
+
+void USB_ARC_start(void) {
+}
+
+// processor
+
+void PROC_config_input(const gpio_pin_map *in, bool enable) {
+}
+
+void PROC_system_timer(bool run) {
+  timer_running = run;
+}
+
+// returns at once, the main loop is not run again until woken. Pins sampled
+// right after are as sampled when entering stop.
+void PROC_enter_stop(void) {
+  ASSERT(host_critical_depth() > 0);
+  stops++;
+  stopped = TRUE;
+  stop_irqs = host_gpio_irqs();
+}
+
+void PROC_rtc_alarm(u32_t ms) {
+  alarm_armed = ms != 0;
+  alarm_us = host_get_us() + ms * 1000;
+}
+
+u32_t PROC_get_rtc_ms(void) {
+  return host_get_us() / 1000;
+}
@@ -0,0 +1,105 @@
+/*
+ * app_host.h
+ *
+ * Runs app.c on the host. Fakes the usb device as a host polling every
+ * 1 ms frame, a report given to a busy endpoint being staged behind it.
+ * Fakes the processor too. The file system is kept in ram, see
+ * niffs_ram.c, and is erased at init so factory defaults are loaded. Pins
+ * are pressed through their mapped gpio and sampled by APP_timer at the
+ * system timer rate. The main loop is run each system tick.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _APP_HOST_H
+#define _APP_HOST_H
+
+#include "host.h"
+#include "app.h"
+#include "usb_arcade.h"
+
+#define APP_HOST_REPORTS  256
+
+typedef struct {
+  u8_t dev;           // device bit index
+  u32_t us;           // when given to endpoint
+  u8_t len;
+  u8_t data[32];
+} app_host_report;
+
+/**
+ * Starts app with factory defaults, all pins released, then clears all
+ * definitions.
+ */
+void app_host_init(void);
+/**
+ * Starts app keeping the factory default definitions.
+ */
+void app_host_init_default(void);
+/**
+ * Starts app again as after a reset, loading the config saved on file.
+ */
+void app_host_restart(void);
+/**
+ * Runs system timer ticks and usb frames for given time.
+ */
+void app_host_run_us(u32_t us);
+#define app_host_run_ms(ms) app_host_run_us((ms) * 1000)
+/**
+ * Presses or releases pin, one based as in definitions.
+ */
+void app_host_pin(int pin, bool pressed);
+/**
+ * Parses and sets definition as the def command, e.g. "pin1 = a". Returns
+ * FALSE if not parsed or not stored.
+ */
+bool app_host_def(const char *def);
+/**
+ * Host stops or resumes polling reports, the endpoints stay full meanwhile.
+ */
+void app_host_poll(bool poll);
+void app_host_set_idle_ms(u8_t dev, u32_t ms);
+/**
+ * Host suspends the bus, allowing remote wakeup or not, or resumes it. The
+ * main loop calls APP_idle after running tasks, each a STOP mode entry
+ * while suspended. A stopped main loop runs again only on a gpio interrupt,
+ * a queued task, the rtc alarm or resume.
+ */
+void app_host_suspend(bool wakeup);
+void app_host_resume(void);
+bool app_host_suspended(void);
+u32_t app_host_stops(void);
+u32_t app_host_wakeups(void);
+bool app_host_timer_running(void);
+
+int app_host_report_count(u8_t dev);
+/**
+ * Returns reports given to device endpoint in order, NULL if no such.
+ */
+const app_host_report *app_host_report_get(u8_t dev, int ix);
+const app_host_report *app_host_report_last(u8_t dev);
+void app_host_reports_clear(void);
+/**
+ * Returns TRUE if keyboard report holds key.
+ */
+bool app_host_kb_report_has(const app_host_report *r, enum kb_hid_code key);
+/**
+ * Returns TRUE if last keyboard report holds key.
+ */
+bool app_host_kb_has(enum kb_hid_code key);
+/**
+ * Returns index of first keyboard report holding key, -1 if none.
+ */
+int app_host_kb_first(enum kb_hid_code key);
+/**
+ * Returns key codes of last keyboard report in given array, zero
+ * terminated, number of keys returned.
+ */
+int app_host_kb_keys(u8_t *keys, int max);
+/**
+ * Returns number of staged reports replaced before reaching the endpoint.
+ */
+u32_t app_host_overruns(void);
+
+#endif
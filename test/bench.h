@@ -0,0 +1,56 @@
+/*
+ * bench.h
+ *
+ * Host benchmark helpers. Costs are counted in time stamp counter cycles on
+ * x86, else in nanoseconds, and only compare builds run on the same host.
+ * Included first, before system headers redefining time.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT  "cycles"
+static inline uint64_t bench_now(void) {
+  return __builtin_ia32_rdtsc();
+}
+#else
+#define BENCH_UNIT  "ns"
+static inline uint64_t bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+// cost of reading the counter, to subtract from single measured calls
+static inline uint64_t bench_overhead(void) {
+  uint64_t min = ~0ULL;
+  int i;
+  for (i = 0; i < 1000; i++) {
+    uint64_t t0 = bench_now();
+    uint64_t t = bench_now() - t0;
+    if (t < min) min = t;
+  }
+  return min;
+}
+
+// median of measured costs, sorts them
+static inline uint64_t bench_median(uint64_t *v, int n) {
+  int i, j;
+  for (i = 1; i < n; i++) {
+    uint64_t x = v[i];
+    for (j = i; j > 0 && v[j-1] > x; j--) v[j] = v[j-1];
+    v[j] = x;
+  }
+  return v[n / 2];
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * bench_combos.c
+ *
+ * Cost of matching the chord window against all combos, built with
+ * APP_CONFIG_COMBOS raised to hundreds of random 2 to 4 pin combos. app.c is
+ * included for its static state and matcher.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "bench.h"
+#include "app.c"
+#include "app_host.h"
+#include <stdlib.h>
+
+#define BATCHES 11
+#define REPS    10000
+
+// times app_chord_match on current chord window, per call, median of batches
+static uint64_t bench_match(int *match) {
+  uint64_t cost[BATCHES];
+  bool more;
+  int i, b;
+  for (b = 0; b < BATCHES; b++) {
+    uint64_t t0 = bench_now();
+    for (i = 0; i < REPS; i++) {
+      *match = app_chord_match(&more);
+      __asm__ volatile("" ::: "memory");
+    }
+    cost[b] = (bench_now() - t0) / REPS;
+  }
+  return bench_median(cost, BATCHES);
+}
+
+int main(void) {
+  app_host_init();
+  srand(1);
+  int c, p;
+  for (c = 0; c < APP_CONFIG_COMBOS; c++) {
+    int pins = 2 + rand() % 3;
+    app.combos[c].pins = pins;
+    for (p = 0; p < pins; p++) {
+      int pin;
+      do {
+        pin = rand() % APP_CONFIG_GPIO_PINS;
+      } while (bitset_get(app.combos[c].mask, pin));
+      bitset_set(app.combos[c].mask, pin);
+    }
+  }
+  app_build_combos();
+
+  // a single press completes no combo, all combos are visited
+  int match;
+  memset(app.pins_chord, 0, sizeof(app.pins_chord));
+  bitset_set(app.pins_chord, bitset_next(app.combo_pins, NULL, PIN_WORDS, 0));
+  uint64_t none = bench_match(&match);
+  ASSERT(match < 0);
+
+  // pins of the combo matched last
+  c = app.combo_order[app.combo_cnt - 1];
+  memcpy(app.pins_chord, app.combos[c].mask, sizeof(app.pins_chord));
+  uint64_t last = bench_match(&match);
+  ASSERT(match >= 0);
+
+  printf("%i combos, %i words per bitset: app_chord_match %i %s without match, "
+      "%i %s matching last, %i.%02i %s per combo\n",
+      app.combo_cnt, PIN_WORDS, (int)none, BENCH_UNIT, (int)last, BENCH_UNIT,
+      (int)(none / app.combo_cnt), (int)(none * 100 / app.combo_cnt % 100), BENCH_UNIT);
+  return 0;
+}
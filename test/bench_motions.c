@@ -0,0 +1,83 @@
+/*
+ * bench_motions.c
+ *
+ * Throughput of the motion matcher, 8 motions of 32 steps in all fed random
+ * edges of 12 pins. app.c is included for its static state and matcher.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "bench.h"
+#include "app.c"
+#include "app_host.h"
+#include <stdlib.h>
+
+#define PINS      12
+#define EDGES     2000000
+#define EDGE_US   15000
+
+static const char *defs[] = {
+    "pin1 = joy1_y(-127)",
+    "pin2 = joy1_y(127)",
+    "pin3 = joy1_x(-127)",
+    "pin4 = joy1_x(127)",
+    "pin5 = joy1_button1",
+    "pin6 = joy1_button2",
+    "pin7 = joy1_button3",
+    "pin8 = joy1_button4",
+    "pin9 = a",
+    "pin10 = b",
+    "pin11 = c",
+    "pin12 = d",
+    "motion(2 3 6 pin5) = f1",
+    "motion(2 1 4 pin5) = f2",
+    "motion(6 2 3 pin6) = f3",
+    "motion(4 2 1 pin6) = f4",
+    "motion(6 3 2 pin7) = f5",
+    "motion(4 1 2 pin7) = f6",
+    "motion(8 9 6 pin8) = f7",
+    "motion(8 7 4 pin8) = f8",
+};
+
+int main(void) {
+  app_host_init();
+  int i;
+  for (i = 0; i < sizeof(defs) / sizeof(defs[0]); i++) {
+    ASSERT(app_host_def(defs[i]));
+  }
+  ASSERT(app.motion_cnt == 8);
+  int steps = 0;
+  for (i = 0; i < APP_CONFIG_MOTIONS; i++) {
+    steps += __builtin_popcount(app.motion_bits[i]);
+  }
+
+  // random edges, generated up front
+  static pin_event edges[EDGES];
+  bool level[PINS] = { 0 };
+  srand(1);
+  for (i = 0; i < EDGES; i++) {
+    int pin = rand() % PINS;
+    level[pin] = !level[pin];
+    edges[i].pin = pin;
+    edges[i].active = level[pin];
+    edges[i].ts_us = i * EDGE_US;
+  }
+
+  // taps stay active as no reports are made, later matches are only checked
+  uint64_t t0 = bench_now();
+  for (i = 0; i < EDGES; i++) {
+    app_motion_event(&edges[i]);
+  }
+  uint64_t cost = bench_now() - t0;
+  int matched = 0;
+  for (i = 0; i < APP_CONFIG_MOTIONS; i++) {
+    if (bitset_get(app.pins_active, MOTION_PIN(i))) matched++;
+  }
+
+  printf("%i motions of %i steps, %i random edges of %i pins: %i.%02i %s per edge, "
+      "%i motions matched\n",
+      app.motion_cnt, steps, EDGES, PINS, (int)(cost / EDGES),
+      (int)(cost * 100 / EDGES % 100), BENCH_UNIT, matched);
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * bench_pins.c
+ *
+ * Pin state size and cost of app_pins_update, built at 26, 64 and 128 pins
+ * by overriding APP_CONFIG_PINS. All pins are defined, gpio pins are
+ * pressed. app.c is included for its static state and update function.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "bench.h"
+#include "app.c"
+#include "app_host.h"
+
+#define BATCHES 11
+#define REPS    10000
+#define EDGES   2001
+
+static void bench_setup(void) {
+  app_host_init();
+  def_config cfg;
+  int pin;
+  for (pin = 1; pin <= APP_CONFIG_PINS; pin++) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.pin = pin;
+    cfg.id[0].type = HID_ID_TYPE_KEYBOARD;
+    cfg.id[0].kb.kb_code = KC_A + (pin % 26);
+    ASSERT(APP_cfg_set_pin(&cfg));
+  }
+  // one pin held, two active
+  app_host_pin(1, TRUE);
+  app_host_pin(2, TRUE);
+  app_host_run_ms(20);
+}
+
+int main(void) {
+  u32_t pin_state = sizeof(app.irq_raw) + sizeof(app.irq_unsettled) +
+      sizeof(app.irq_same_state) + sizeof(app.irq_cur_active) +
+      sizeof(app.pins_active) + sizeof(app.pins_tern) +
+      sizeof(app.pins_active_prev) + sizeof(app.dev_pins);
+  printf("%i pins: pin state %i bytes, %i words per bitset\n",
+      APP_CONFIG_PINS, pin_state, PIN_WORDS);
+
+  bench_setup();
+  uint64_t overhead = bench_overhead();
+
+  // update finding no edges, median of batches
+  static uint64_t cost[EDGES];
+  int i, b;
+  for (b = 0; b < BATCHES; b++) {
+    uint64_t t0 = bench_now();
+    for (i = 0; i < REPS; i++) {
+      app_pins_update();
+    }
+    cost[b] = (bench_now() - t0) / REPS;
+  }
+  uint64_t idle = bench_median(cost, BATCHES);
+
+  // update applying a press or release of a third pin, median of edges
+  for (i = 0; i < EDGES; i++) {
+    app_host_pin(3, (i & 1) == 0);
+    int s;
+    for (s = 0; s <= app.debounce_valid_cycles + 1; s++) {
+      host_advance_us(1000000 / SYS_MAIN_TIMER_FREQ);
+      APP_timer();
+    }
+    uint64_t t = bench_now();
+    app_pins_update();
+    cost[i] = bench_now() - t - overhead;
+    // send reports and run tasks queued meanwhile
+    app_host_run_ms(3);
+  }
+  uint64_t edge = bench_median(cost, EDGES);
+
+  printf("%i pins: app_pins_update %i %s idle, %i %s per edge\n",
+      APP_CONFIG_PINS, (int)idle, BENCH_UNIT, (int)edge, BENCH_UNIT);
+  return 0;
+}
@@ -0,0 +1,9 @@
+/*
+ * config_header.h
+ *
+ * Host stand-in for the header generated from config.mk, features are
+ * selected per test in test/makefile.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
@@ -0,0 +1,44 @@
+/*
+ * core_cm3.h
+ *
+ * Host stand-in for the CMSIS core header, whose intrinsics are cortex-m3
+ * assembly. Only what stm32f10x.h and the modules under test refer to.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef __CM3_CORE_H__
+#define __CM3_CORE_H__
+
+#include <stdint.h>
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+
+typedef struct {
+  __IO uint32_t ISER[8];
+} NVIC_Type;
+
+typedef struct {
+  __I  uint32_t CPUID;
+  __IO uint32_t ICSR;
+  __IO uint32_t VTOR;
+  __IO uint32_t AIRCR;
+  __IO uint32_t SCR;
+  __IO uint32_t CCR;
+} SCB_Type;
+
+typedef struct {
+  __IO uint32_t CTRL;
+  __IO uint32_t LOAD;
+  __IO uint32_t VAL;
+  __I  uint32_t CALIB;
+} SysTick_Type;
+
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __WFI(void) { }
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * gpio.h
+ *
+ * Host stand-in for generic_embedded gpio.h, see host.h for driving inputs.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _GPIO_H
+#define _GPIO_H
+
+#include "system.h"
+
+typedef enum {
+  PORTA = 0, PORTB, PORTC, PORTD, PORTE, _IO_PORTS
+} gpio_port;
+typedef enum {
+  PIN0 = 0, PIN1, PIN2, PIN3, PIN4, PIN5, PIN6, PIN7,
+  PIN8, PIN9, PIN10, PIN11, PIN12, PIN13, PIN14, PIN15, _IO_PINS
+} gpio_pin;
+typedef enum { CLK_2MHZ = 0, CLK_10MHZ, CLK_50MHZ } gpio_speed;
+typedef enum { IN = 0, OUT, AF, ANALOG } gpio_mode;
+typedef enum { AF0 = 0 } gpio_af;
+typedef enum { PUSHPULL = 0, OPENDRAIN } gpio_outtype;
+typedef enum { NOPULL = 0, PULLUP, PULLDOWN } gpio_pull;
+typedef enum { FLANK_UP = 0, FLANK_DOWN, FLANK_BOTH } gpio_flank;
+
+typedef void (*gpio_interrupt_fn)(gpio_pin pin);
+
+void gpio_config(gpio_port port, gpio_pin pin, gpio_speed speed, gpio_mode mode,
+    gpio_af af, gpio_outtype outtype, gpio_pull pull);
+void gpio_enable(gpio_port port, gpio_pin pin);
+void gpio_disable(gpio_port port, gpio_pin pin);
+u32_t gpio_get(gpio_port port, gpio_pin pin);
+s32_t gpio_interrupt_config(gpio_port port, gpio_pin pin, gpio_interrupt_fn fn,
+    gpio_flank flank);
+void gpio_interrupt_deconfig(gpio_port port, gpio_pin pin);
+void gpio_interrupt_mask_enable(gpio_port port, gpio_pin pin, bool enable);
+
+#endif
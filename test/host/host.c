@@ -0,0 +1,235 @@
+/*
+ * host.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "host.h"
+#include "taskq.h"
+#include "miniutils.h"
+#include "timer.h"
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define HOST_TASKS  32
+
+// peripheral registers, apb1 up to flash interface, and private peripheral
+// bus with dwt and system control space
+static const struct {
+  u32_t addr;
+  u32_t len;
+} host_reg_pages[] = {
+  { PERIPH_BASE, 0x24000 },
+  { 0xe0000000, 0x100000 },
+};
+
+static GPIO_TypeDef * const host_gpio_ports[_IO_PORTS] = {
+  GPIOA, GPIOB, GPIOC, GPIOD, GPIOE
+};
+
+static u32_t host_us;
+static int host_critical;
+static task host_task_pool[HOST_TASKS];
+static task *host_task_q_first;
+static task *host_task_q_last;
+static u16_t host_gpio_in[_IO_PORTS];
+static u16_t host_gpio_out_lvl[_IO_PORTS];
+static struct {
+  gpio_interrupt_fn fn;
+  gpio_port port;
+  gpio_flank flank;
+  bool enabled;
+} host_gpio_irq[_IO_PINS];
+static u32_t host_gpio_irq_cnt;
+
+static void host_map_registers(void) {
+  static bool mapped = FALSE;
+  int i;
+  if (mapped) return;
+  for (i = 0; i < sizeof(host_reg_pages)/sizeof(host_reg_pages[0]); i++) {
+    void *a = (void *)(uintptr_t)host_reg_pages[i].addr;
+    void *m = mmap(a, host_reg_pages[i].len, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (m != a) {
+      printf("host: could not map registers at %08x\n", host_reg_pages[i].addr);
+      fflush(stdout);
+      abort();
+    }
+  }
+  mapped = TRUE;
+}
+
+void host_init(void) {
+  int i;
+  host_map_registers();
+  host_us = 0;
+  host_critical = 0;
+  memset(host_task_pool, 0, sizeof(host_task_pool));
+  host_task_q_first = host_task_q_last = NULL;
+  memset(host_gpio_irq, 0, sizeof(host_gpio_irq));
+  host_gpio_irq_cnt = 0;
+  memset(host_gpio_out_lvl, 0, sizeof(host_gpio_out_lvl));
+  for (i = 0; i < _IO_PORTS; i++) {
+    host_gpio_in[i] = 0xffff;
+    host_gpio_ports[i]->IDR = 0xffff;
+  }
+}
+
+u32_t host_get_us(void) {
+  return host_us;
+}
+
+void host_advance_us(u32_t us) {
+  host_us += us;
+}
+
+int host_critical_depth(void) {
+  return host_critical;
+}
+
+// system
+
+void SYS_assert(const char *f, s32_t l) {
+  printf("ASSERT %s:%i\n", f, l);
+  fflush(stdout);
+  abort();
+}
+
+sys_time SYS_get_time_ms(void) {
+  return host_us / 1000;
+}
+
+u32_t TIMER_get_us(void) {
+  return host_us;
+}
+
+void enter_critical(void) {
+  host_critical++;
+}
+
+void exit_critical(void) {
+  ASSERT(host_critical > 0);
+  host_critical--;
+}
+
+void v_printf(int io, const char *f, va_list arg) {
+  (void)io;
+  vprintf(f, arg);
+}
+
+// tasks
+
+task *TASK_create(task_f f, u8_t flags) {
+  int i;
+  for (i = 0; i < HOST_TASKS; i++) {
+    if (host_task_pool[i].f == NULL) {
+      host_task_pool[i].f = f;
+      host_task_pool[i].flags = flags;
+      return &host_task_pool[i];
+    }
+  }
+  return NULL;
+}
+
+void TASK_run(task *t, u32_t arg, void *arg_p) {
+  t->arg = arg;
+  t->arg_p = arg_p;
+  t->next = NULL;
+  if (host_task_q_last) {
+    host_task_q_last->next = t;
+  } else {
+    host_task_q_first = t;
+  }
+  host_task_q_last = t;
+}
+
+int host_tasks_queued(void) {
+  int n = 0;
+  task *t;
+  for (t = host_task_q_first; t; t = t->next) n++;
+  return n;
+}
+
+int host_run_tasks(void) {
+  int n = 0;
+  while (host_task_q_first) {
+    task *t = host_task_q_first;
+    host_task_q_first = t->next;
+    if (host_task_q_first == NULL) host_task_q_last = NULL;
+    task_f f = t->f;
+    if ((t->flags & TASK_STATIC) == 0) {
+      t->f = NULL;
+    }
+    f(t->arg, t->arg_p);
+    n++;
+  }
+  return n;
+}
+
+// gpio
+
+void gpio_config(gpio_port port, gpio_pin pin, gpio_speed speed, gpio_mode mode,
+    gpio_af af, gpio_outtype outtype, gpio_pull pull) {
+}
+
+void gpio_enable(gpio_port port, gpio_pin pin) {
+  host_gpio_out_lvl[port] |= 1 << pin;
+}
+
+void gpio_disable(gpio_port port, gpio_pin pin) {
+  host_gpio_out_lvl[port] &= ~(1 << pin);
+}
+
+bool host_gpio_out(gpio_port port, gpio_pin pin) {
+  return (host_gpio_out_lvl[port] >> pin) & 1;
+}
+
+u32_t gpio_get(gpio_port port, gpio_pin pin) {
+  return host_gpio_in[port] & (1 << pin);
+}
+
+s32_t gpio_interrupt_config(gpio_port port, gpio_pin pin, gpio_interrupt_fn fn,
+    gpio_flank flank) {
+  host_gpio_irq[pin].fn = fn;
+  host_gpio_irq[pin].port = port;
+  host_gpio_irq[pin].flank = flank;
+  host_gpio_irq[pin].enabled = FALSE;
+  return 0;
+}
+
+void gpio_interrupt_deconfig(gpio_port port, gpio_pin pin) {
+  host_gpio_irq[pin].fn = NULL;
+  host_gpio_irq[pin].enabled = FALSE;
+}
+
+void gpio_interrupt_mask_enable(gpio_port port, gpio_pin pin, bool enable) {
+  host_gpio_irq[pin].enabled = enable;
+}
+
+void host_gpio_set(gpio_port port, gpio_pin pin, bool high) {
+  bool was = (host_gpio_in[port] >> pin) & 1;
+  if (high) {
+    host_gpio_in[port] |= 1 << pin;
+  } else {
+    host_gpio_in[port] &= ~(1 << pin);
+  }
+  host_gpio_ports[port]->IDR = host_gpio_in[port];
+  if (was == high || host_gpio_irq[pin].fn == NULL ||
+      !host_gpio_irq[pin].enabled || host_gpio_irq[pin].port != port) {
+    return;
+  }
+  gpio_flank f = host_gpio_irq[pin].flank;
+  if (f == FLANK_BOTH || (f == FLANK_UP) == high) {
+    host_gpio_irq_cnt++;
+    host_gpio_irq[pin].fn(pin);
+  }
+}
+
+u32_t host_gpio_irqs(void) {
+  return host_gpio_irq_cnt;
+}
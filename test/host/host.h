@@ -0,0 +1,53 @@
+/*
+ * host.h
+ *
+ * Fake platform for running firmware modules on the host: a settable
+ * microsecond clock, a task queue run on demand, gpio input levels with
+ * flank interrupts and, for modules reading registers directly, the stm32
+ * peripheral and debug register pages mapped as plain memory.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _HOST_H
+#define _HOST_H
+
+#include "system.h"
+#include "gpio.h"
+
+/**
+ * Resets clock, tasks, gpio levels and interrupt configs. Gpios read high,
+ * as pulled up inputs. Maps peripheral registers on first call.
+ */
+void host_init(void);
+u32_t host_get_us(void);
+/**
+ * Advances clock without running any timer.
+ */
+void host_advance_us(u32_t us);
+/**
+ * Runs queued tasks, including tasks queued meanwhile, until queue is empty.
+ * Returns number of tasks run.
+ */
+int host_run_tasks(void);
+int host_tasks_queued(void);
+/**
+ * Sets input level of gpio, calling configured interrupt on a matching
+ * flank. Also reflected in the port IDR register.
+ */
+void host_gpio_set(gpio_port port, gpio_pin pin, bool high);
+/**
+ * Returns number of gpio interrupts called since init.
+ */
+u32_t host_gpio_irqs(void);
+/**
+ * Returns level last driven by gpio_enable/gpio_disable.
+ */
+bool host_gpio_out(gpio_port port, gpio_pin pin);
+/**
+ * Returns current nesting of enter_critical.
+ */
+int host_critical_depth(void);
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * i2c_dev.h
+ *
+ * Host stand-in for generic_embedded i2c_dev.h, implemented by the device
+ * models in test/.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _I2C_DEV_H
+#define _I2C_DEV_H
+
+#include "i2c_driver.h"
+
+typedef struct i2c_dev_s i2c_dev;
+typedef void (*i2c_dev_callback)(i2c_dev *dev, int res);
+
+typedef struct {
+  u8_t *buf;
+  u16_t len;
+  bool rx;
+  bool gen_stop;
+} i2c_dev_sequence;
+
+struct i2c_dev_s {
+  i2c_bus *bus;
+  u32_t clock;
+  u8_t addr;
+  bool opened;
+  i2c_dev_callback i2c_dev_callback;
+  void *user_p;
+};
+
+#define I2C_SEQ_TX(b, l)        {(b), (l), FALSE, FALSE}
+#define I2C_SEQ_TX_STOP(b, l)   {(b), (l), FALSE, TRUE}
+#define I2C_SEQ_RX(b, l)        {(b), (l), TRUE, FALSE}
+#define I2C_SEQ_RX_STOP(b, l)   {(b), (l), TRUE, TRUE}
+
+void I2C_DEV_init(i2c_dev *dev, u32_t clock, i2c_bus *bus, u8_t addr);
+void I2C_DEV_set_callback(i2c_dev *dev, i2c_dev_callback cb);
+int I2C_DEV_open(i2c_dev *dev);
+int I2C_DEV_close(i2c_dev *dev);
+int I2C_DEV_sequence(i2c_dev *dev, const i2c_dev_sequence *seq, u8_t seq_len);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * i2c_driver.h
+ *
+ * Host stand-in for generic_embedded i2c_driver.h.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _I2C_DRIVER_H
+#define _I2C_DRIVER_H
+
+#include "system.h"
+
+#define I2C_OK              0
+#define I2C_ERR_BUS_BUSY    -7000
+#define I2C_ERR_UNKNOWN_STATE -7001
+
+typedef struct i2c_bus_s {
+  u8_t id;
+} i2c_bus;
+
+extern i2c_bus __i2c_bus_vec[I2C_MAX_ID];
+
+#define _I2C_BUS(x) (&__i2c_bus_vec[(x)])
+
+#endif
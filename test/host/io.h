@@ -0,0 +1,15 @@
+/*
+ * io.h
+ *
+ * Host stand-in for generic_embedded io.h.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _IO_H
+#define _IO_H
+
+#include "system.h"
+
+#endif
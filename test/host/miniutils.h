@@ -0,0 +1,18 @@
+/*
+ * miniutils.h
+ *
+ * Host stand-in for generic_embedded miniutils.h.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _MINIUTILS_H
+#define _MINIUTILS_H
+
+#include "system.h"
+#include <stdarg.h>
+
+void v_printf(int io, const char *f, va_list arg);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * niffs.h
+ *
+ * Host stand-in for the niffs api used by niffs_impl.c, see niffs_ram.c.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _NIFFS_H
+#define _NIFFS_H
+
+#include "niffs_config.h"
+
+#define NIFFS_OK                      0
+#define ERR_NIFFS_FILE_NOT_FOUND      -10000
+#define ERR_NIFFS_NOT_A_FILESYSTEM    -10001
+#define ERR_NIFFS_END_OF_FILE         -10002
+#define ERR_NIFFS_FILEDESC_BAD        -10003
+#define ERR_NIFFS_OUT_OF_FILEDESCS    -10004
+#define ERR_NIFFS_FULL                -10005
+
+#define NIFFS_O_RDONLY    (1<<0)
+#define NIFFS_O_WRONLY    (1<<1)
+#define NIFFS_O_RDWR      (NIFFS_O_RDONLY | NIFFS_O_WRONLY)
+#define NIFFS_O_CREAT     (1<<2)
+#define NIFFS_O_TRUNC     (1<<3)
+#define NIFFS_O_APPEND    (1<<4)
+
+#define NIFFS_SEEK_SET    0
+
+typedef struct {
+  int obj_id;
+  u32_t offs;
+  u8_t flags;
+} niffs_file_desc;
+
+typedef struct {
+  bool mounted;
+  niffs_file_desc *descs;
+  u32_t descs_len;
+} niffs;
+
+typedef struct {
+  int ix;
+} niffs_DIR;
+
+typedef struct {
+  u32_t total_bytes;
+  u32_t used_bytes;
+  bool overflow;
+} niffs_info;
+
+struct niffs_dirent {
+  u8_t name[NIFFS_NAME_LEN];
+  int obj_id;
+  u32_t size;
+};
+
+typedef int (*niffs_hal_erase_f)(u8_t *addr, u32_t len);
+typedef int (*niffs_hal_write_f)(u8_t *addr, const u8_t *src, u32_t len);
+
+int NIFFS_init(niffs *fs, u8_t *phys_addr, u32_t sectors, u32_t sector_size,
+    u32_t logical_page_size, u8_t *buf, u32_t buf_len,
+    niffs_file_desc *descs, u32_t file_desc_len,
+    niffs_hal_erase_f erase_f, niffs_hal_write_f write_f, u32_t lin_sectors);
+int NIFFS_mount(niffs *fs);
+int NIFFS_unmount(niffs *fs);
+int NIFFS_format(niffs *fs);
+int NIFFS_chk(niffs *fs);
+void NIFFS_dump(niffs *fs);
+int NIFFS_info(niffs *fs, niffs_info *i);
+int NIFFS_creat(niffs *fs, const char *name, u8_t mode);
+int NIFFS_open(niffs *fs, const char *name, u8_t flags, u8_t mode);
+int NIFFS_read(niffs *fs, int fd, u8_t *dst, u32_t len);
+int NIFFS_write(niffs *fs, int fd, const u8_t *data, u32_t len);
+int NIFFS_close(niffs *fs, int fd);
+int NIFFS_remove(niffs *fs, const char *name);
+int NIFFS_rename(niffs *fs, const char *old_name, const char *new_name);
+niffs_DIR *NIFFS_opendir(niffs *fs, const char *name, niffs_DIR *d);
+struct niffs_dirent *NIFFS_readdir(niffs_DIR *d, struct niffs_dirent *e);
+int NIFFS_closedir(niffs_DIR *d);
+
+/**
+ * Removes all files and the file system, mounting formats it again.
+ */
+void niffs_ram_erase(void);
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * niffs_ram.c
+ *
+ * Host stand-in for niffs, files kept whole in ram. Only the semantics
+ * niffs_impl.c relies on: reads return bytes read or end of file, writes
+ * append at the file offset, truncate and create on open. Flash hal
+ * functions are never called.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "niffs.h"
+
+#define RAM_FILES     4
+#define RAM_FILE_SIZE 8192
+
+static struct {
+  bool used;
+  char name[NIFFS_NAME_LEN];
+  u32_t size;
+  u8_t data[RAM_FILE_SIZE];
+} files[RAM_FILES];
+static bool formatted;
+
+static int file_find(const char *name) {
+  int i;
+  for (i = 0; i < RAM_FILES; i++) {
+    if (files[i].used && strncmp(files[i].name, name, NIFFS_NAME_LEN) == 0) return i;
+  }
+  return -1;
+}
+
+static niffs_file_desc *fd_get(niffs *fs, int fd) {
+  if (fd < 0 || fd >= (int)fs->descs_len || fs->descs[fd].obj_id < 0) return NULL;
+  return &fs->descs[fd];
+}
+
+void niffs_ram_erase(void) {
+  memset(files, 0, sizeof(files));
+  formatted = FALSE;
+}
+
+int NIFFS_init(niffs *fs, u8_t *phys_addr, u32_t sectors, u32_t sector_size,
+    u32_t logical_page_size, u8_t *buf, u32_t buf_len,
+    niffs_file_desc *descs, u32_t file_desc_len,
+    niffs_hal_erase_f erase_f, niffs_hal_write_f write_f, u32_t lin_sectors) {
+  memset(fs, 0, sizeof(niffs));
+  fs->descs = descs;
+  fs->descs_len = file_desc_len;
+  u32_t i;
+  for (i = 0; i < file_desc_len; i++) {
+    descs[i].obj_id = -1;
+  }
+  return NIFFS_OK;
+}
+
+int NIFFS_mount(niffs *fs) {
+  if (!formatted) return ERR_NIFFS_NOT_A_FILESYSTEM;
+  fs->mounted = TRUE;
+  return NIFFS_OK;
+}
+
+int NIFFS_unmount(niffs *fs) {
+  fs->mounted = FALSE;
+  return NIFFS_OK;
+}
+
+int NIFFS_format(niffs *fs) {
+  memset(files, 0, sizeof(files));
+  formatted = TRUE;
+  return NIFFS_OK;
+}
+
+int NIFFS_chk(niffs *fs) {
+  return NIFFS_OK;
+}
+
+void NIFFS_dump(niffs *fs) {
+}
+
+int NIFFS_info(niffs *fs, niffs_info *i) {
+  int f;
+  memset(i, 0, sizeof(niffs_info));
+  i->total_bytes = RAM_FILES * RAM_FILE_SIZE;
+  for (f = 0; f < RAM_FILES; f++) {
+    if (files[f].used) i->used_bytes += files[f].size;
+  }
+  return NIFFS_OK;
+}
+
+int NIFFS_creat(niffs *fs, const char *name, u8_t mode) {
+  if (file_find(name) >= 0) return NIFFS_OK;
+  int i;
+  for (i = 0; i < RAM_FILES && files[i].used; i++);
+  if (i >= RAM_FILES) return ERR_NIFFS_FULL;
+  memset(&files[i], 0, sizeof(files[i]));
+  files[i].used = TRUE;
+  strncpy(files[i].name, name, NIFFS_NAME_LEN - 1);
+  return NIFFS_OK;
+}
+
+int NIFFS_open(niffs *fs, const char *name, u8_t flags, u8_t mode) {
+  int f = file_find(name);
+  if (f < 0) {
+    if ((flags & NIFFS_O_CREAT) == 0) return ERR_NIFFS_FILE_NOT_FOUND;
+    int res = NIFFS_creat(fs, name, mode);
+    if (res != NIFFS_OK) return res;
+    f = file_find(name);
+  }
+  int fd;
+  for (fd = 0; fd < (int)fs->descs_len && fs->descs[fd].obj_id >= 0; fd++);
+  if (fd >= (int)fs->descs_len) return ERR_NIFFS_OUT_OF_FILEDESCS;
+  if (flags & NIFFS_O_TRUNC) files[f].size = 0;
+  fs->descs[fd].obj_id = f;
+  fs->descs[fd].flags = flags;
+  fs->descs[fd].offs = (flags & NIFFS_O_APPEND) ? files[f].size : 0;
+  return fd;
+}
+
+int NIFFS_read(niffs *fs, int fd, u8_t *dst, u32_t len) {
+  niffs_file_desc *d = fd_get(fs, fd);
+  if (d == NULL) return ERR_NIFFS_FILEDESC_BAD;
+  if (len == 0) return 0;
+  u32_t size = files[d->obj_id].size;
+  if (d->offs >= size) return ERR_NIFFS_END_OF_FILE;
+  len = MIN(len, size - d->offs);
+  memcpy(dst, &files[d->obj_id].data[d->offs], len);
+  d->offs += len;
+  return len;
+}
+
+int NIFFS_write(niffs *fs, int fd, const u8_t *data, u32_t len) {
+  niffs_file_desc *d = fd_get(fs, fd);
+  if (d == NULL) return ERR_NIFFS_FILEDESC_BAD;
+  if (d->offs + len > RAM_FILE_SIZE) return ERR_NIFFS_FULL;
+  memcpy(&files[d->obj_id].data[d->offs], data, len);
+  d->offs += len;
+  files[d->obj_id].size = MAX(files[d->obj_id].size, d->offs);
+  return NIFFS_OK;
+}
+
+int NIFFS_close(niffs *fs, int fd) {
+  niffs_file_desc *d = fd_get(fs, fd);
+  if (d == NULL) return ERR_NIFFS_FILEDESC_BAD;
+  d->obj_id = -1;
+  return NIFFS_OK;
+}
+
+int NIFFS_remove(niffs *fs, const char *name) {
+  int f = file_find(name);
+  if (f < 0) return ERR_NIFFS_FILE_NOT_FOUND;
+  files[f].used = FALSE;
+  return NIFFS_OK;
+}
+
+int NIFFS_rename(niffs *fs, const char *old_name, const char *new_name) {
+  int f = file_find(old_name);
+  if (f < 0) return ERR_NIFFS_FILE_NOT_FOUND;
+  NIFFS_remove(fs, new_name);
+  memset(files[f].name, 0, NIFFS_NAME_LEN);
+  strncpy(files[f].name, new_name, NIFFS_NAME_LEN - 1);
+  return NIFFS_OK;
+}
+
+niffs_DIR *NIFFS_opendir(niffs *fs, const char *name, niffs_DIR *d) {
+  d->ix = 0;
+  return d;
+}
+
+struct niffs_dirent *NIFFS_readdir(niffs_DIR *d, struct niffs_dirent *e) {
+  for (; d->ix < RAM_FILES; d->ix++) {
+    if (!files[d->ix].used) continue;
+    memcpy(e->name, files[d->ix].name, NIFFS_NAME_LEN);
+    e->obj_id = d->ix;
+    e->size = files[d->ix].size;
+    d->ix++;
+    return e;
+  }
+  return NULL;
+}
+
+int NIFFS_closedir(niffs_DIR *d) {
+  return NIFFS_OK;
+}
@@ -0,0 +1,44 @@
+/*
+ * system.h
+ *
+ * Host stand-in for generic_embedded system.h, only what the modules under
+ * test use. Asserts abort the test, debug output is compiled out.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _SYSTEM_H
+#define _SYSTEM_H
+
+#include "types.h"
+#include "system_config.h"
+#include <string.h>
+#include <stdio.h>
+
+typedef u32_t sys_time;
+
+#define D_APP   (1<<0)
+#define D_CLI   (1<<1)
+#define D_FS    (1<<2)
+#define D_USB   (1<<3)
+#define D_I2C   (1<<4)
+#define D_ANY   0xffffffff
+
+#define D_DEBUG 0
+#define D_INFO  1
+#define D_WARN  2
+#define D_FATAL 3
+
+#define DBG(mask, lvl, ...) do { if (0) printf(__VA_ARGS__); } while (0)
+#define ASSERT(x) do { if (!(x)) SYS_assert(__FILE__, __LINE__); } while (0)
+
+#define MIN(a,b) ((a)<(b)?(a):(b))
+#define MAX(a,b) ((a)>(b)?(a):(b))
+
+void SYS_assert(const char *f, s32_t l);
+sys_time SYS_get_time_ms(void);
+void enter_critical(void);
+void exit_critical(void);
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * taskq.h
+ *
+ * Host stand-in for generic_embedded taskq.h. Tasks run in order when the
+ * test calls host_run_tasks.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _TASKQ_H
+#define _TASKQ_H
+
+#include "system.h"
+
+typedef void (*task_f)(u32_t arg, void *arg_p);
+
+typedef struct task_s {
+  task_f f;
+  u8_t flags;
+  u32_t arg;
+  void *arg_p;
+  struct task_s *next;
+} task;
+
+#define TASK_STATIC   (1<<0)
+
+task *TASK_create(task_f f, u8_t flags);
+void TASK_run(task *t, u32_t arg, void *arg_p);
+
+#endif
@@ -0,0 +1,252 @@
+/*
+ * mcp23017.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "mcp23017.h"
+#include "host.h"
+
+#define MCP_ERR_NACK  -7010
+
+static mcp23017 mcps[MCP_DEVICES];
+static u8_t mcp_addr;
+static int mcp_devs;
+static gpio_port mcp_int_port;
+static gpio_pin mcp_int_pin;
+
+static struct {
+  i2c_dev *dev;
+  const i2c_dev_sequence *seq;
+  u8_t seq_len;
+} cur;
+static int fail_cnt;
+static int reject_cnt;
+static u32_t started;
+
+i2c_bus __i2c_bus_vec[I2C_MAX_ID];
+
+static void mcp_reset(mcp23017 *m) {
+  memset(m->regs, 0, sizeof(m->regs));
+  m->regs[MCP_IODIRA] = 0xff;
+  m->regs[MCP_IODIRA+1] = 0xff;
+}
+
+// levels as read through GPIO, inverted by IPOL
+static u16_t mcp_polarity(mcp23017 *m, u16_t levels) {
+  return levels ^ (m->regs[MCP_IPOLA] | (m->regs[MCP_IPOLA+1] << 8));
+}
+
+static bool mcp_int_asserted(mcp23017 *m, int port) {
+  u8_t iocon = m->regs[MCP_IOCON];
+  if (iocon & MCP_IOCON_MIRROR) {
+    return (m->regs[MCP_INTFA] | m->regs[MCP_INTFA+1]) != 0;
+  }
+  return m->regs[MCP_INTFA + port] != 0;
+}
+
+// wired AND of all INT outputs, only INTA is modelled as wired to the line
+static void mcp_update_int_line(void) {
+  int i;
+  bool low = FALSE;
+  for (i = 0; i < mcp_devs; i++) {
+    low |= mcps[i].powered && mcp_int_asserted(&mcps[i], 0);
+  }
+  host_gpio_set(mcp_int_port, mcp_int_pin, !low);
+}
+
+// interrupt on change, against DEFVAL for bits set in INTCON
+static void mcp_eval_int(mcp23017 *m, u16_t prev) {
+  int port;
+  for (port = 0; port < 2; port++) {
+    u8_t en = m->regs[MCP_GPINTENA + port];
+    u8_t now = m->pins >> (port * 8);
+    u8_t was = prev >> (port * 8);
+    u8_t intcon = m->regs[MCP_INTCONA + port];
+    u8_t ref = (m->regs[MCP_DEFVALA + port] & intcon) | (was & ~intcon);
+    u8_t trig = (now ^ ref) & en;
+    if (trig && m->regs[MCP_INTFA + port] == 0) {
+      m->regs[MCP_INTFA + port] = trig;
+      m->regs[MCP_INTCAPA + port] = mcp_polarity(m, m->pins) >> (port * 8);
+    }
+  }
+}
+
+static u8_t mcp_read_reg(mcp23017 *m, u8_t reg) {
+  u8_t v;
+  int port = reg & 1;
+  switch (reg & ~1) {
+  case MCP_GPIOA:
+    v = mcp_polarity(m, m->pins) >> (port * 8);
+    m->regs[MCP_INTFA + port] = 0;
+    break;
+  case MCP_INTCAPA:
+    v = m->regs[reg];
+    m->regs[MCP_INTFA + port] = 0;
+    break;
+  default:
+    v = m->regs[reg];
+    break;
+  }
+  return v;
+}
+
+static void mcp_write_reg(mcp23017 *m, u8_t reg, u8_t v) {
+  switch (reg) {
+  case MCP_INTFA:
+  case MCP_INTFA+1:
+  case MCP_INTCAPA:
+  case MCP_INTCAPA+1:
+    // read only
+    break;
+  case MCP_IOCON:
+  case MCP_IOCON+1:
+    m->regs[MCP_IOCON] = m->regs[MCP_IOCON+1] = v;
+    break;
+  default:
+    m->regs[reg] = v;
+    break;
+  }
+}
+
+void mcp_init(u8_t addr, int devices, gpio_port int_port, gpio_pin int_pin) {
+  int i;
+  memset(mcps, 0, sizeof(mcps));
+  memset(&cur, 0, sizeof(cur));
+  mcp_addr = addr;
+  mcp_devs = devices;
+  mcp_int_port = int_port;
+  mcp_int_pin = int_pin;
+  fail_cnt = 0;
+  reject_cnt = 0;
+  started = 0;
+  for (i = 0; i < devices; i++) {
+    mcp_reset(&mcps[i]);
+    mcps[i].powered = TRUE;
+    mcps[i].pins = 0xffff;
+  }
+}
+
+void mcp_power(int dev, bool on) {
+  mcp23017 *m = &mcps[dev];
+  if (on && !m->powered) {
+    mcp_reset(m);
+  }
+  m->powered = on;
+  mcp_update_int_line();
+}
+
+mcp23017 *mcp_get(int dev) {
+  return &mcps[dev];
+}
+
+void mcp_set_pins(int dev, u16_t pins) {
+  mcp23017 *m = &mcps[dev];
+  u16_t prev = m->pins;
+  m->pins = pins;
+  mcp_eval_int(m, prev);
+  mcp_update_int_line();
+}
+
+bool mcp_busy(void) {
+  return cur.dev != NULL;
+}
+
+void mcp_fail_transfers(int count) {
+  fail_cnt = count;
+}
+
+void mcp_reject_starts(int count) {
+  reject_cnt = count;
+}
+
+u32_t mcp_started(void) {
+  return started;
+}
+
+bool mcp_complete(void) {
+  if (cur.dev == NULL) return FALSE;
+  i2c_dev *dev = cur.dev;
+  const i2c_dev_sequence *seq = cur.seq;
+  u8_t seq_len = cur.seq_len;
+  cur.dev = NULL;
+
+  int ix = dev->addr - mcp_addr;
+  mcp23017 *m = ix >= 0 && ix < mcp_devs ? &mcps[ix] : NULL;
+  int res = I2C_OK;
+  if (m == NULL || !m->powered || fail_cnt > 0) {
+    if (fail_cnt > 0) fail_cnt--;
+    res = MCP_ERR_NACK;
+  } else {
+    // first tx byte of a write sets register pointer, following bytes and
+    // reads auto increment
+    u8_t ptr = 0;
+    bool ptr_set = FALSE;
+    int s;
+    for (s = 0; s < seq_len; s++) {
+      int b;
+      for (b = 0; b < seq[s].len; b++) {
+        if (seq[s].rx) {
+          seq[s].buf[b] = mcp_read_reg(m, ptr);
+          ptr = (ptr + 1) % MCP_REGS;
+        } else if (!ptr_set) {
+          ptr = seq[s].buf[b];
+          ptr_set = TRUE;
+        } else {
+          mcp_write_reg(m, ptr, seq[s].buf[b]);
+          ptr = (ptr + 1) % MCP_REGS;
+        }
+      }
+      if (seq[s].gen_stop) ptr_set = FALSE;
+    }
+    m->transfers++;
+    mcp_update_int_line();
+  }
+  if (dev->i2c_dev_callback) {
+    dev->i2c_dev_callback(dev, res);
+  }
+  return TRUE;
+}
+
+int mcp_complete_all(void) {
+  int n = 0;
+  while (mcp_complete()) n++;
+  return n;
+}
+
+// i2c_dev api
+
+void I2C_DEV_init(i2c_dev *dev, u32_t clock, i2c_bus *bus, u8_t addr) {
+  memset(dev, 0, sizeof(i2c_dev));
+  dev->bus = bus;
+  dev->clock = clock;
+  dev->addr = addr;
+}
+
+void I2C_DEV_set_callback(i2c_dev *dev, i2c_dev_callback cb) {
+  dev->i2c_dev_callback = cb;
+}
+
+int I2C_DEV_open(i2c_dev *dev) {
+  dev->opened = TRUE;
+  return I2C_OK;
+}
+
+int I2C_DEV_close(i2c_dev *dev) {
+  dev->opened = FALSE;
+  return I2C_OK;
+}
+
+int I2C_DEV_sequence(i2c_dev *dev, const i2c_dev_sequence *seq, u8_t seq_len) {
+  ASSERT(dev->opened);
+  if (cur.dev != NULL || reject_cnt > 0) {
+    if (reject_cnt > 0) reject_cnt--;
+    return I2C_ERR_BUS_BUSY;
+  }
+  cur.dev = dev;
+  cur.seq = seq;
+  cur.seq_len = seq_len;
+  started++;
+  return I2C_OK;
+}
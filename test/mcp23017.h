@@ -0,0 +1,87 @@
+/*
+ * mcp23017.h
+ *
+ * Register model of MCP23017 expanders behind the i2c_dev api, IOCON.BANK 0
+ * addressing with sequential operation. Pin levels are set by the test, a
+ * changed input enabled in GPINTEN latches INTF and INTCAP and pulls the
+ * INT output low until GPIO or INTCAP of that port is read. With
+ * IOCON.MIRROR both ports drive the same INT, which all models share as one
+ * open drain line wired to the configured gpio.
+ *
+ * Transfers are accepted by I2C_DEV_sequence and completed, calling the
+ * device callback as from the i2c irq, when the test calls mcp_complete.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _MCP23017_H
+#define _MCP23017_H
+
+#include "i2c_dev.h"
+#include "gpio.h"
+
+#define MCP_DEVICES   8
+#define MCP_REGS      0x16
+
+#define MCP_IODIRA    0x00
+#define MCP_IPOLA     0x02
+#define MCP_GPINTENA  0x04
+#define MCP_DEFVALA   0x06
+#define MCP_INTCONA   0x08
+#define MCP_IOCON     0x0a
+#define MCP_GPPUA     0x0c
+#define MCP_INTFA     0x0e
+#define MCP_INTCAPA   0x10
+#define MCP_GPIOA     0x12
+#define MCP_OLATA     0x14
+
+#define MCP_IOCON_MIRROR  (1<<6)
+#define MCP_IOCON_ODR     (1<<2)
+
+typedef struct {
+  u8_t regs[MCP_REGS];
+  u16_t pins;           // input levels, set bit high
+  bool powered;         // acks its address
+  u32_t transfers;      // completed sequences addressed to this model
+} mcp23017;
+
+/**
+ * Resets all models to power on state, present at addresses addr and
+ * upwards, and wires their INT to given gpio.
+ */
+void mcp_init(u8_t addr, int devices, gpio_port int_port, gpio_pin int_pin);
+mcp23017 *mcp_get(int dev);
+/**
+ * Powering off makes the expander nack all transfers, powering on resets
+ * its registers.
+ */
+void mcp_power(int dev, bool on);
+/**
+ * Sets input levels, set bit high. Grounded buttons read low.
+ */
+void mcp_set_pins(int dev, u16_t pins);
+/**
+ * Returns TRUE if a transfer is accepted and not completed.
+ */
+bool mcp_busy(void);
+/**
+ * Completes ongoing transfer, returns FALSE if none.
+ */
+bool mcp_complete(void);
+/**
+ * Completes transfers, including ones started from callbacks, until idle.
+ */
+int mcp_complete_all(void);
+/**
+ * Next given number of accepted transfers fail with a nack, as by a
+ * disconnected or powered down expander.
+ */
+void mcp_fail_transfers(int count);
+/**
+ * Next given number of I2C_DEV_sequence calls are rejected with bus busy.
+ */
+void mcp_reject_starts(int count);
+u32_t mcp_started(void);
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * test.h
+ *
+ * Minimal host test runner. A test is a void function, checks report file
+ * and line of failure and the test continues.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#ifndef _TEST_H
+#define _TEST_H
+
+#include <stdio.h>
+
+static int test_checks;
+static int test_failures;
+static const char *test_name;
+
+#define TEST_CHECK(x) do { \
+  test_checks++; \
+  if (!(x)) { \
+    test_failures++; \
+    printf("  FAIL %s:%i %s: %s\n", __FILE__, __LINE__, test_name, #x); \
+  } \
+} while (0)
+
+#define TEST_EQ(a, b) do { \
+  long long _a = (long long)(a), _b = (long long)(b); \
+  test_checks++; \
+  if (_a != _b) { \
+    test_failures++; \
+    printf("  FAIL %s:%i %s: %s == %s, got %lli, expected %lli\n", \
+        __FILE__, __LINE__, test_name, #a, #b, _a, _b); \
+  } \
+} while (0)
+
+#define TEST_RUN(fn) do { \
+  test_name = #fn; \
+  fn(); \
+} while (0)
+
+static inline int test_report(const char *suite) {
+  printf("%s: %i checks, %i failed\n", suite, test_checks, test_failures);
+  return test_failures ? 1 : 0;
+}
+
+#endif
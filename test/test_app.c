@@ -0,0 +1,1003 @@
+/*
+ * test_app.c
+ *
+ * app.c pin handling, from sampled gpios to reports given to the usb
+ * endpoints.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "test.h"
+#include "app_host.h"
+#include "bitset.h"
+#include "taskq.h"
+#include "def_config_parser.h"
+#include "niffs_impl.h"
+#include "gpio_map.h"
+
+#define DEV_KB      0
+#define DEV_JOY1    2
+
+// sampler runs at system timer rate, a pin triggers when the sample it
+// changed in is followed by debounce cycles plus one equal samples
+#define SAMPLE_US   (1000000 / SYS_MAIN_TIMER_FREQ)
+
+static void test_bitset(void) {
+  u32_t bs[BITSET_WORDS(70)];
+  u32_t mask[BITSET_WORDS(70)];
+  memset(bs, 0, sizeof(bs));
+  memset(mask, 0xff, sizeof(mask));
+  TEST_EQ(BITSET_WORDS(70), 3);
+  TEST_CHECK(!bitset_any(bs, 3));
+  TEST_EQ(bitset_next(bs, NULL, 3, 0), -1);
+
+  bitset_set(bs, 69);
+  bitset_set(bs, 0);
+  bitset_set(bs, 31);
+  bitset_set(bs, 32);
+  bitset_put(bs, 40, TRUE);
+  bitset_put(bs, 41, FALSE);
+  TEST_CHECK(bitset_any(bs, 3));
+  TEST_CHECK(bitset_get(bs, 31));
+  TEST_CHECK(!bitset_get(bs, 41));
+
+  // ascending order over word boundaries
+  int order[] = {0, 31, 32, 40, 69};
+  int b, i = 0;
+  for (b = bitset_next(bs, NULL, 3, 0); b >= 0; b = bitset_next(bs, NULL, 3, b + 1)) {
+    TEST_EQ(b, order[i]);
+    i++;
+  }
+  TEST_EQ(i, 5);
+
+  // masked
+  bitset_clr(mask, 32);
+  bitset_clr(mask, 0);
+  TEST_EQ(bitset_next(bs, mask, 3, 0), 31);
+  TEST_EQ(bitset_next(bs, mask, 3, 32), 40);
+  TEST_EQ(bitset_next(bs, mask, 3, 70), -1);
+
+  bitset_clr(bs, 69);
+  TEST_EQ(bitset_next(bs, NULL, 3, 41), -1);
+}
+
+static void test_debounce(void) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = a"));
+  u8_t cycles = APP_cfg_get_debounce_cycles();
+  TEST_CHECK(cycles > 0);
+
+  app_host_pin(1, TRUE);
+  app_host_run_us((cycles + 1) * SAMPLE_US);
+  TEST_EQ(app_host_report_count(DEV_KB), 0);
+  app_host_run_us(SAMPLE_US);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  TEST_CHECK(app_host_kb_has(KC_A));
+
+  app_host_pin(1, FALSE);
+  app_host_run_ms(5);
+  TEST_EQ(app_host_report_count(DEV_KB), 2);
+  TEST_CHECK(!app_host_kb_has(KC_A));
+}
+
+static void test_debounce_bounce(void) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = a"));
+  u8_t cycles = APP_cfg_get_debounce_cycles();
+
+  // bouncing restarts the count
+  int i;
+  for (i = 0; i < 5; i++) {
+    app_host_pin(1, TRUE);
+    app_host_run_us(cycles * SAMPLE_US / 2);
+    app_host_pin(1, FALSE);
+    app_host_run_us(SAMPLE_US);
+  }
+  TEST_EQ(app_host_report_count(DEV_KB), 0);
+  app_host_pin(1, TRUE);
+  app_host_run_ms(5);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  TEST_CHECK(app_host_kb_has(KC_A));
+}
+
+static void test_pins_over_words(void) {
+  app_host_init();
+  // pins sampled in different ports and gpio runs, all in one report
+  int pins[] = {1, 9, 13, 22, APP_CONFIG_GPIO_PINS};
+  enum kb_hid_code keys[] = {KC_A, KC_B, KC_C, KC_D, KC_E};
+  char def[32];
+  int i;
+  for (i = 0; i < 5; i++) {
+    sprintf(def, "pin%i = %c", pins[i], 'a' + i);
+    TEST_CHECK(app_host_def(def));
+  }
+  for (i = 0; i < 5; i++) {
+    app_host_pin(pins[i], TRUE);
+  }
+  app_host_run_ms(5);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  for (i = 0; i < 5; i++) {
+    TEST_CHECK(app_host_kb_has(keys[i]));
+  }
+  // pins come out in ascending order
+  u8_t got[8];
+  TEST_EQ(app_host_kb_keys(got, sizeof(got)), 5);
+  for (i = 0; i < 5; i++) {
+    TEST_EQ(got[i], keys[i]);
+  }
+  app_host_pin(13, FALSE);
+  app_host_run_ms(5);
+  TEST_CHECK(!app_host_kb_has(KC_C));
+  TEST_CHECK(app_host_kb_has(KC_D));
+  TEST_EQ(app_host_overruns(), 0);
+}
+
+// reports given while one is in flight are staged, a tap latched in the
+// staged report is kept until that one is transmitted
+static void test_staged_latch(void) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = a"));
+  TEST_CHECK(app_host_def("pin2 = b"));
+  app_host_poll(FALSE);
+  app_host_pin(1, TRUE);
+  app_host_run_ms(2);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  // staged behind, then released while endpoint and stage are full
+  app_host_pin(2, TRUE);
+  app_host_run_ms(2);
+  app_host_pin(2, FALSE);
+  app_host_run_ms(2);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  app_host_poll(TRUE);
+  app_host_run_ms(5);
+  TEST_EQ(app_host_report_count(DEV_KB), 3);
+  const app_host_report *r = app_host_report_get(DEV_KB, 1);
+  TEST_CHECK(app_host_kb_report_has(r, KC_A));
+  TEST_CHECK(app_host_kb_report_has(r, KC_B));
+  TEST_CHECK(app_host_kb_has(KC_A));
+  TEST_CHECK(!app_host_kb_has(KC_B));
+  TEST_EQ(app_host_overruns(), 0);
+
+  // a tap within one frame while a report is in flight
+  app_host_reports_clear();
+  app_host_pin(2, TRUE);
+  app_host_run_us(SAMPLE_US * 11);
+  app_host_pin(2, FALSE);
+  app_host_run_ms(10);
+  TEST_CHECK(app_host_kb_first(KC_B) >= 0);
+  TEST_CHECK(!app_host_kb_has(KC_B));
+  TEST_CHECK(app_host_kb_has(KC_A));
+  TEST_EQ(app_host_overruns(), 0);
+}
+
+static void test_default_buttons(void) {
+  app_host_init_default();
+  // pin5 = JOYSTICK1_BUTTON1, held without autofire
+  app_host_pin(5, TRUE);
+  app_host_run_ms(200);
+  TEST_EQ(app_host_report_count(DEV_JOY1), 1);
+  const usb_joystick_report *r =
+      (const usb_joystick_report *)app_host_report_last(DEV_JOY1)->data;
+  TEST_EQ(r->buttons1, 1);
+  app_host_pin(5, FALSE);
+  app_host_run_ms(20);
+  TEST_EQ(app_host_report_count(DEV_JOY1), 2);
+  r = (const usb_joystick_report *)app_host_report_last(DEV_JOY1)->data;
+  TEST_EQ(r->buttons1, 0);
+
+  // button data beyond turbo rates is refused
+  def_config cfg;
+  TEST_EQ(APP_cfg_get_pin(0, 5, &cfg), 1);
+  cfg.id[0].joy.joystick_data = DEF_TURBO_MAX_HZ + 1;
+  TEST_CHECK(!APP_cfg_set_pin(&cfg));
+  cfg.id[0].joy.joystick_data = DEF_TURBO_MAX_HZ;
+  TEST_CHECK(APP_cfg_set_pin(&cfg));
+}
+
+// time last report was given to endpoint, never if none
+static u32_t last_us(u8_t dev) {
+  const app_host_report *r = app_host_report_last(dev);
+  return r ? r->us : 0x7fffffff;
+}
+
+static void combo_setup(void) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = a"));
+  TEST_CHECK(app_host_def("pin2 = b"));
+  TEST_CHECK(app_host_def("pin3 = c"));
+  TEST_CHECK(app_host_def("pin1+pin2 = escape"));
+  TEST_EQ(APP_cfg_get_combo_usage(), 1);
+}
+
+static void test_combo(void) {
+  combo_setup();
+  app_host_pin(1, TRUE);
+  app_host_run_ms(5);
+  // waiting in chord window
+  TEST_EQ(app_host_report_count(DEV_KB), 0);
+  app_host_pin(2, TRUE);
+  u32_t t = host_get_us();
+  app_host_run_ms(5);
+  // complete with no bigger combo, window ends at once
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  TEST_CHECK(app_host_kb_has(KC_ESCAPE));
+  TEST_CHECK(!app_host_kb_has(KC_A));
+  TEST_CHECK(!app_host_kb_has(KC_B));
+  TEST_CHECK(last_us(DEV_KB) - t <= 2000);
+
+  // releasing any pin releases the combo, the other sends nothing alone
+  app_host_pin(1, FALSE);
+  app_host_run_ms(5);
+  TEST_EQ(app_host_report_count(DEV_KB), 2);
+  TEST_CHECK(!app_host_kb_has(KC_ESCAPE));
+  app_host_run_ms(50);
+  app_host_pin(2, FALSE);
+  app_host_run_ms(50);
+  TEST_EQ(app_host_report_count(DEV_KB), 2);
+  TEST_EQ(app_host_kb_first(KC_A), -1);
+  TEST_EQ(app_host_kb_first(KC_B), -1);
+}
+
+static void test_combo_window_timeout(void) {
+  combo_setup();
+  u8_t window = APP_cfg_get_combo_window_ms();
+  TEST_EQ(window, 30);
+  app_host_pin(1, TRUE);
+  u32_t t = host_get_us();
+  app_host_run_ms(window - 5);
+  TEST_EQ(app_host_report_count(DEV_KB), 0);
+  app_host_run_ms(10);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  u32_t lat = last_us(DEV_KB) - t;
+  TEST_CHECK(lat >= window * 1000 && lat <= window * 1000 + 2000);
+
+  // pin of combo pressed after window is single press
+  app_host_pin(2, TRUE);
+  app_host_run_ms(window + 5);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  TEST_CHECK(app_host_kb_has(KC_B));
+  TEST_EQ(app_host_kb_first(KC_ESCAPE), -1);
+}
+
+static void test_combo_other_pin_ends_window(void) {
+  combo_setup();
+  app_host_pin(1, TRUE);
+  app_host_run_ms(3);
+  app_host_pin(3, TRUE);
+  app_host_run_ms(5);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  TEST_CHECK(app_host_kb_has(KC_C));
+  // held back press comes first
+  TEST_CHECK(app_host_kb_first(KC_A) <= app_host_kb_first(KC_C));
+  TEST_EQ(app_host_kb_first(KC_ESCAPE), -1);
+}
+
+static void test_combo_tap_in_window(void) {
+  combo_setup();
+  app_host_pin(1, TRUE);
+  app_host_run_ms(5);
+  app_host_pin(1, FALSE);
+  app_host_run_ms(10);
+  // release ends window, tap is reported as press and release
+  TEST_EQ(app_host_kb_first(KC_A), 0);
+  TEST_CHECK(app_host_report_count(DEV_KB) >= 2);
+  TEST_CHECK(!app_host_kb_has(KC_A));
+  TEST_CHECK(last_us(DEV_KB) < 20000);
+}
+
+static void test_combo_bigger(void) {
+  combo_setup();
+  TEST_CHECK(app_host_def("pin1+pin2+pin3 = f1"));
+  app_host_pin(1, TRUE);
+  app_host_pin(2, TRUE);
+  app_host_run_ms(5);
+  // bigger combo can still complete
+  TEST_EQ(app_host_report_count(DEV_KB), 0);
+  app_host_pin(3, TRUE);
+  app_host_run_ms(5);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  TEST_CHECK(app_host_kb_has(KC_F1));
+  TEST_CHECK(!app_host_kb_has(KC_ESCAPE));
+  TEST_CHECK(!app_host_kb_has(KC_C));
+  app_host_pin(1, FALSE);
+  app_host_pin(2, FALSE);
+  app_host_pin(3, FALSE);
+  app_host_run_ms(50);
+  TEST_CHECK(!app_host_kb_has(KC_F1));
+
+  // smaller one when window ends
+  app_host_reports_clear();
+  app_host_pin(1, TRUE);
+  app_host_pin(2, TRUE);
+  app_host_run_ms(40);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  TEST_CHECK(app_host_kb_has(KC_ESCAPE));
+  TEST_CHECK(!app_host_kb_has(KC_F1));
+}
+
+static void test_combo_window_zero(void) {
+  combo_setup();
+  APP_cfg_set_combo_window_ms(0);
+  app_host_pin(1, TRUE);
+  app_host_run_ms(3);
+  TEST_EQ(app_host_report_count(DEV_KB), 1);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  app_host_pin(2, TRUE);
+  app_host_run_ms(3);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  TEST_CHECK(app_host_kb_has(KC_B));
+  TEST_EQ(app_host_kb_first(KC_ESCAPE), -1);
+}
+
+// pin5 is a, b on layer 1 and c on layer 2
+static void layer_setup(void) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin5 = a"));
+  TEST_CHECK(app_host_def("layer1 pin5 = b"));
+  TEST_CHECK(app_host_def("layer2 pin5 = c"));
+  TEST_CHECK(app_host_def("pin6 = d"));
+}
+
+// taps pin5, returns key reported
+static enum kb_hid_code layer_tap(void) {
+  enum kb_hid_code key = KC_NO;
+  app_host_pin(5, TRUE);
+  app_host_run_ms(20);
+  if (app_host_kb_has(KC_A)) key = KC_A;
+  if (app_host_kb_has(KC_B)) key = KC_B;
+  if (app_host_kb_has(KC_C)) key = KC_C;
+  app_host_pin(5, FALSE);
+  app_host_run_ms(20);
+  return key;
+}
+
+static void layer_press(int pin, bool pressed) {
+  app_host_pin(pin, pressed);
+  app_host_run_ms(20);
+}
+
+static void test_layer_hold(void) {
+  layer_setup();
+  APP_cfg_set_layer(1, 9, LAYER_HOLD);
+  APP_cfg_set_layer(2, 10, LAYER_HOLD);
+  TEST_EQ(layer_tap(), KC_A);
+  layer_press(9, TRUE);
+  TEST_EQ(layer_tap(), KC_B);
+  TEST_EQ(layer_tap(), KC_B);
+  // highest held layer wins
+  layer_press(10, TRUE);
+  TEST_EQ(layer_tap(), KC_C);
+  layer_press(10, FALSE);
+  TEST_EQ(layer_tap(), KC_B);
+  layer_press(9, FALSE);
+  TEST_EQ(layer_tap(), KC_A);
+  // select pins report nothing themselves
+  TEST_EQ(app_host_report_count(DEV_KB), 12);
+}
+
+static void test_layer_toggle(void) {
+  layer_setup();
+  APP_cfg_set_layer(1, 9, LAYER_TOGGLE);
+  layer_press(9, TRUE);
+  layer_press(9, FALSE);
+  TEST_EQ(layer_tap(), KC_B);
+  TEST_EQ(layer_tap(), KC_B);
+  layer_press(9, TRUE);
+  TEST_EQ(layer_tap(), KC_A);
+  layer_press(9, FALSE);
+  TEST_EQ(layer_tap(), KC_A);
+}
+
+static void test_layer_oneshot(void) {
+  layer_setup();
+  APP_cfg_set_layer(2, 9, LAYER_ONESHOT);
+  layer_press(9, TRUE);
+  layer_press(9, FALSE);
+  TEST_EQ(layer_tap(), KC_C);
+  TEST_EQ(layer_tap(), KC_A);
+  // used up by a press of any other pin
+  layer_press(9, TRUE);
+  layer_press(9, FALSE);
+  layer_press(6, TRUE);
+  layer_press(6, FALSE);
+  TEST_EQ(layer_tap(), KC_A);
+}
+
+// a pressed pin keeps the definitions of the layer it was pressed on
+static void test_layer_keep_on_release(void) {
+  layer_setup();
+  APP_cfg_set_layer(1, 9, LAYER_HOLD);
+  layer_press(9, TRUE);
+  layer_press(5, TRUE);
+  TEST_CHECK(app_host_kb_has(KC_B));
+  // layer released while pin5 held, b stays
+  layer_press(9, FALSE);
+  TEST_CHECK(app_host_kb_has(KC_B));
+  TEST_CHECK(!app_host_kb_has(KC_A));
+  layer_press(5, FALSE);
+  TEST_CHECK(!app_host_kb_has(KC_B));
+  TEST_EQ(app_host_kb_first(KC_A), -1);
+  // and the other way round
+  layer_press(5, TRUE);
+  layer_press(9, TRUE);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  TEST_CHECK(!app_host_kb_has(KC_B));
+  layer_press(5, FALSE);
+  TEST_CHECK(!app_host_kb_has(KC_A));
+  TEST_EQ(layer_tap(), KC_B);
+}
+
+// pins 1 and 2 left and right, 3 and 4 up and down of joystick 1
+static void socd_setup(app_socd_mode mode, bool four_way) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = joy1_x(-127)"));
+  TEST_CHECK(app_host_def("pin2 = joy1_x(127)"));
+  TEST_CHECK(app_host_def("pin3 = joy1_y(-127)"));
+  TEST_CHECK(app_host_def("pin4 = joy1_y(127)"));
+  APP_cfg_set_socd(0, mode, four_way);
+}
+
+static const usb_joystick_report *socd_report(void) {
+  app_host_run_ms(10);
+  return (const usb_joystick_report *)app_host_report_last(DEV_JOY1)->data;
+}
+
+static void test_socd_last(void) {
+  socd_setup(SOCD_LAST, FALSE);
+  app_host_pin(1, TRUE);
+  TEST_EQ(socd_report()->dx, -127);
+  app_host_pin(2, TRUE);
+  TEST_EQ(socd_report()->dx, 127);
+  // released, the direction still held wins again
+  app_host_pin(2, FALSE);
+  TEST_EQ(socd_report()->dx, -127);
+  app_host_pin(2, TRUE);
+  app_host_pin(1, FALSE);
+  TEST_EQ(socd_report()->dx, 127);
+  app_host_pin(1, TRUE);
+  TEST_EQ(socd_report()->dx, -127);
+}
+
+static void test_socd_first(void) {
+  socd_setup(SOCD_FIRST, FALSE);
+  app_host_pin(3, TRUE);
+  TEST_EQ(socd_report()->dy, -127);
+  app_host_pin(4, TRUE);
+  TEST_EQ(socd_report()->dy, -127);
+  app_host_pin(3, FALSE);
+  TEST_EQ(socd_report()->dy, 127);
+  // pressed again, now pressed after the one held
+  app_host_pin(3, TRUE);
+  TEST_EQ(socd_report()->dy, 127);
+}
+
+static void test_socd_neutral(void) {
+  socd_setup(SOCD_NEUTRAL, FALSE);
+  app_host_pin(1, TRUE);
+  app_host_pin(3, TRUE);
+  const usb_joystick_report *r = socd_report();
+  TEST_EQ(r->dx, -127);
+  TEST_EQ(r->dy, -127);
+  // opposite directions cancel, other axis unaffected
+  app_host_pin(2, TRUE);
+  r = socd_report();
+  TEST_EQ(r->dx, 0);
+  TEST_EQ(r->dy, -127);
+  app_host_pin(1, FALSE);
+  TEST_EQ(socd_report()->dx, 127);
+}
+
+static void test_socd_4way(void) {
+  socd_setup(SOCD_LAST, TRUE);
+  app_host_pin(2, TRUE);
+  const usb_joystick_report *r = socd_report();
+  TEST_EQ(r->dx, 127);
+  TEST_EQ(r->dy, 0);
+  // diagonal keeps the direction pressed last
+  app_host_pin(3, TRUE);
+  r = socd_report();
+  TEST_EQ(r->dx, 0);
+  TEST_EQ(r->dy, -127);
+  app_host_pin(1, TRUE);
+  r = socd_report();
+  TEST_EQ(r->dx, -127);
+  TEST_EQ(r->dy, 0);
+  app_host_pin(1, FALSE);
+  app_host_pin(2, FALSE);
+  r = socd_report();
+  TEST_EQ(r->dx, 0);
+  TEST_EQ(r->dy, -127);
+  // 8 way again
+  APP_cfg_set_socd(0, SOCD_LAST, FALSE);
+  app_host_pin(2, TRUE);
+  r = socd_report();
+  TEST_EQ(r->dx, 127);
+  TEST_EQ(r->dy, -127);
+}
+
+// acceleration curves apply per axis, x stays linear
+static void test_acc_curve_axis(void) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = joy1_x(ACC127)"));
+  TEST_CHECK(app_host_def("pin2 = joy1_y(ACC127)"));
+  vel_curve half = { .type = VEL_CURVE_USER, .points = 2, .x = { 0, 100 }, .y = { 50, 50 } };
+  TEST_CHECK(APP_cfg_set_acc_curve(ACC_JOY1_Y, &half));
+  app_host_pin(1, TRUE);
+  app_host_pin(2, TRUE);
+  app_host_run_ms(10000);
+  const usb_joystick_report *r =
+      (const usb_joystick_report *)app_host_report_last(DEV_JOY1)->data;
+  TEST_EQ(r->dx, 127);
+  TEST_CHECK(r->dy >= 62 && r->dy <= 64);
+}
+
+static void motion_setup(const char *motion) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = joy1_y(-127)"));
+  TEST_CHECK(app_host_def("pin2 = joy1_y(127)"));
+  TEST_CHECK(app_host_def("pin3 = joy1_x(-127)"));
+  TEST_CHECK(app_host_def("pin4 = joy1_x(127)"));
+  TEST_CHECK(app_host_def("pin5 = joy1_button1"));
+  TEST_CHECK(app_host_def("pin6 = a"));
+  TEST_CHECK(app_host_def(motion));
+  TEST_EQ(APP_cfg_get_motion_usage(), 1);
+}
+
+// quarter circle forward and button, 2 3 6 pin5
+static void motion_qcf(u32_t step_ms) {
+  app_host_pin(2, TRUE);
+  app_host_run_ms(step_ms);
+  app_host_pin(4, TRUE);
+  app_host_run_ms(step_ms);
+  app_host_pin(2, FALSE);
+  app_host_run_ms(step_ms);
+  app_host_pin(5, TRUE);
+  app_host_run_ms(step_ms);
+}
+
+static void test_motion(void) {
+  motion_setup("motion(2 3 6 pin5) = f1");
+  motion_qcf(30);
+  int ix = app_host_kb_first(KC_F1);
+  TEST_CHECK(ix >= 0);
+  // tapped, released once reported
+  app_host_run_ms(50);
+  TEST_CHECK(!app_host_kb_has(KC_F1));
+  TEST_EQ(app_host_report_count(DEV_KB), 2);
+  // the inputs themselves are reported as usual
+  const usb_joystick_report *r =
+      (const usb_joystick_report *)app_host_report_last(DEV_JOY1)->data;
+  TEST_EQ(r->buttons1, 1);
+  TEST_EQ(r->dx, 127);
+
+  // again
+  app_host_pin(4, FALSE);
+  app_host_pin(5, FALSE);
+  app_host_run_ms(50);
+  motion_qcf(30);
+  app_host_run_ms(50);
+  TEST_EQ(app_host_report_count(DEV_KB), 4);
+}
+
+static void test_motion_min_hold(void) {
+  motion_setup("motion(2 3 6 pin5) = f1");
+  APP_cfg_set_min_hold_ms(20);
+  motion_qcf(30);
+  app_host_run_ms(50);
+  int ix = app_host_kb_first(KC_F1);
+  TEST_CHECK(ix >= 0);
+  const app_host_report *press = app_host_report_get(DEV_KB, ix);
+  const app_host_report *release = app_host_report_get(DEV_KB, ix + 1);
+  TEST_CHECK(press && release && !app_host_kb_report_has(release, KC_F1));
+  if (press && release) {
+    u32_t held_us = release->us - press->us;
+    TEST_CHECK(held_us >= 20000 && held_us <= 22000);
+  }
+}
+
+static void test_motion_too_slow(void) {
+  motion_setup("motion(2 3 6 pin5) = f1");
+  motion_qcf(200);
+  app_host_run_ms(50);
+  TEST_EQ(app_host_kb_first(KC_F1), -1);
+}
+
+static void test_motion_step_time(void) {
+  motion_setup("motion(2 3 6 pin5 250ms) = f1");
+  motion_qcf(200);
+  TEST_CHECK(app_host_kb_first(KC_F1) >= 0);
+
+  motion_setup("motion(2 3 6 pin5 100ms) = f1");
+  motion_qcf(120);
+  app_host_run_ms(50);
+  TEST_EQ(app_host_kb_first(KC_F1), -1);
+}
+
+static void test_motion_wrong_order(void) {
+  motion_setup("motion(2 3 6 pin5) = f1");
+  // 6 3 2 pin5
+  app_host_pin(4, TRUE);
+  app_host_run_ms(30);
+  app_host_pin(2, TRUE);
+  app_host_run_ms(30);
+  app_host_pin(4, FALSE);
+  app_host_run_ms(30);
+  app_host_pin(5, TRUE);
+  app_host_run_ms(50);
+  TEST_EQ(app_host_kb_first(KC_F1), -1);
+}
+
+static void test_motion_ignores_between(void) {
+  motion_setup("motion(2 3 6 pin5) = f1");
+  app_host_pin(2, TRUE);
+  app_host_run_ms(30);
+  app_host_pin(4, TRUE);
+  app_host_run_ms(30);
+  // other pin between steps
+  app_host_pin(6, TRUE);
+  app_host_run_ms(30);
+  app_host_pin(2, FALSE);
+  app_host_run_ms(30);
+  app_host_pin(5, TRUE);
+  app_host_run_ms(30);
+  TEST_CHECK(app_host_kb_first(KC_F1) >= 0);
+  TEST_CHECK(app_host_kb_first(KC_A) >= 0);
+}
+
+// restarting a macro mid tap releases the tap before running again
+static void test_macro_restart(void) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = macro(a b)"));
+  APP_cfg_set_min_hold_ms(50);
+  app_host_pin(1, TRUE);
+  app_host_run_ms(10);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  app_host_pin(1, FALSE);
+  app_host_run_ms(5);
+  app_host_pin(1, TRUE);
+  app_host_run_ms(5);
+  app_host_pin(1, FALSE);
+  app_host_run_ms(300);
+  // a, released after min hold, a again from restart, then b
+  TEST_EQ(app_host_report_count(DEV_KB), 6);
+  const char *seq = "a-a-b-";
+  int i;
+  for (i = 0; i < 6; i++) {
+    const app_host_report *r = app_host_report_get(DEV_KB, i);
+    TEST_EQ(app_host_kb_report_has(r, KC_A), seq[i] == 'a');
+    TEST_EQ(app_host_kb_report_has(r, KC_B), seq[i] == 'b');
+  }
+  TEST_CHECK(app_host_report_get(DEV_KB, 1)->us - app_host_report_get(DEV_KB, 0)->us >= 50000);
+}
+
+// ternary pins cannot run macros, rejected by parser and by app
+static void test_macro_ternary(void) {
+  def_config cfg;
+  app_host_init();
+  const char *def = "pin1 = pin2 ? a : macro(b)";
+  TEST_CHECK(!def_config_parse(&cfg, def, strlen(def)));
+  TEST_CHECK(app_host_def("pin1 = pin2 ? a : b"));
+  TEST_EQ(APP_cfg_get_def_pool_usage(), 2);
+  // as if loaded from a file
+  const char *plain = "pin1 = macro(c)";
+  TEST_CHECK(def_config_parse(&cfg, plain, strlen(plain)));
+  cfg.tern_pin = 2;
+  cfg.tern_splice = 0;
+  TEST_CHECK(!APP_cfg_set_pin(&cfg));
+  TEST_EQ(APP_cfg_get_def_pool_usage(), 2);
+  // pin2 released selects first option
+  app_host_pin(1, TRUE);
+  app_host_run_ms(10);
+  TEST_CHECK(app_host_kb_has(KC_A));
+}
+
+// keyboard reports as held keys a to c, reports separated by commas
+static const char *tern_reports(void) {
+  static char s[64];
+  const app_host_report *r;
+  int ix, n = 0;
+  enum kb_hid_code k;
+  for (ix = 0; (r = app_host_report_get(DEV_KB, ix)) != NULL && n < sizeof(s) - 5; ix++) {
+    if (ix) s[n++] = ',';
+    for (k = KC_A; k <= KC_C; k++) {
+      if (app_host_kb_report_has(r, k)) s[n++] = 'a' + k - KC_A;
+    }
+  }
+  s[n] = 0;
+  return s;
+}
+
+// pin1 held while its ternary pin2 is pressed and released
+static const char *tern_toggle(bool release_first) {
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = pin2 ? a : b"));
+  TEST_CHECK(app_host_def("pin2 = c"));
+  APP_cfg_set_tern_release_first(release_first);
+  app_host_pin(1, TRUE);
+  app_host_run_ms(20);
+  app_host_pin(2, TRUE);
+  app_host_run_ms(20);
+  app_host_pin(2, FALSE);
+  app_host_run_ms(20);
+  app_host_pin(1, FALSE);
+  app_host_run_ms(20);
+  return tern_reports();
+}
+
+// a held pin switches definitions as its ternary pin changes
+static void test_ternary_toggle(void) {
+  const char *s = tern_toggle(FALSE);
+  TEST_CHECK(strcmp(s, "a,bc,a,") == 0);
+  // old definitions released in a report first
+  s = tern_toggle(TRUE);
+  TEST_CHECK(strcmp(s, "a,c,bc,,a,") == 0);
+}
+
+// appends a pin definition record to config file, after the last pin record
+// as long as no combos or motions are stored
+static void config_append_pin(char *name, u8_t pin, hid_id id) {
+  static u8_t buf[4096];
+  niffs *fs = FS_get_fs();
+  int fd = NIFFS_open(fs, name, NIFFS_O_RDONLY, 0);
+  TEST_CHECK(fd >= 0);
+  int len = NIFFS_read(fs, fd, buf, sizeof(buf));
+  NIFFS_close(fs, fd);
+  TEST_CHECK(len > (int)sizeof(file_config_hdr));
+  ((file_config_hdr *)buf)->nbr_of_pin_defs++;
+  file_pin_def fpd = { .pin = pin, .def_len = 1 };
+  memcpy(&buf[len], &fpd, sizeof(fpd));
+  len += sizeof(fpd);
+  memcpy(&buf[len], &id, sizeof(id));
+  len += sizeof(id);
+  fd = NIFFS_open(fs, name, NIFFS_O_WRONLY | NIFFS_O_TRUNC, 0);
+  TEST_CHECK(fd >= 0);
+  TEST_EQ(NIFFS_write(fs, fd, buf, len), NIFFS_OK);
+  NIFFS_close(fs, fd);
+}
+
+static bool config_equal(char *name1, char *name2) {
+  static u8_t buf1[4096], buf2[4096];
+  niffs *fs = FS_get_fs();
+  int fd1 = NIFFS_open(fs, name1, NIFFS_O_RDONLY, 0);
+  int fd2 = NIFFS_open(fs, name2, NIFFS_O_RDONLY, 0);
+  int len1 = NIFFS_read(fs, fd1, buf1, sizeof(buf1));
+  int len2 = NIFFS_read(fs, fd2, buf2, sizeof(buf2));
+  NIFFS_close(fs, fd1);
+  NIFFS_close(fs, fd2);
+  return len1 > 0 && len1 == len2 && memcmp(buf1, buf2, len1) == 0;
+}
+
+// a config file with a record not applicable starts over with factory
+// defaults, keeping nothing loaded from the file before the record
+static void test_config_bad(void) {
+  app_host_init_default();
+  u16_t defaults = APP_cfg_get_def_pool_usage();
+  TEST_CHECK(defaults > 0);
+  TEST_EQ(FS_save_config("ref"), NIFFS_OK);
+
+  // settings off the defaults, pool filled up by four pins
+  APP_cfg_set_debounce_cycles(3);
+  APP_cfg_set_min_hold_ms(20);
+  APP_cfg_set_latch_mask(0);
+  APP_cfg_set_tern_release_first(TRUE);
+  APP_cfg_set_combo_window_ms(50);
+  APP_cfg_set_turbo_duty(25);
+  APP_cfg_set_usb_latency(TRUE);
+  APP_cfg_set_socd(0, SOCD_NEUTRAL, TRUE);
+  APP_cfg_set_layer(1, 26, LAYER_TOGGLE);
+  vel_curve curve = { .type = VEL_CURVE_QUADRATIC };
+  TEST_CHECK(APP_cfg_set_acc_curve(ACC_MOUSE_Y, &curve));
+  APP_cfg_set_mouse_delta_ms(12);
+  APP_cfg_set_joystick_acc_speed(9);
+  gpio_pin_map map[APP_CONFIG_GPIO_PINS];
+  memcpy(map, GPIO_MAP_get_pin_map(), sizeof(map));
+  gpio_pin_map swap = map[0];
+  map[0] = map[1];
+  map[1] = swap;
+  TEST_CHECK(APP_cfg_set_gpio_map(map));
+  APP_cfg_clear_pins();
+  def_config cfg;
+  int pin, d;
+  for (pin = 1; pin <= 4; pin++) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.pin = pin;
+    for (d = 0; d < APP_CONFIG_DEFS_PER_PIN; d++) {
+      cfg.id[d].type = HID_ID_TYPE_KEYBOARD;
+      cfg.id[d].kb.kb_code = KC_A + d;
+    }
+    TEST_CHECK(APP_cfg_set_pin(&cfg));
+  }
+  TEST_EQ(APP_cfg_get_def_pool_usage(), APP_CONFIG_DEF_POOL);
+  TEST_EQ(FS_save_config("default"), NIFFS_OK);
+  // one more pin overflows the pool when loaded
+  hid_id id = { .type = HID_ID_TYPE_KEYBOARD };
+  id.kb.kb_code = KC_ESCAPE;
+  config_append_pin("default", 5, id);
+
+  app_host_restart();
+  TEST_EQ(APP_cfg_get_def_pool_usage(), defaults);
+  TEST_EQ(APP_cfg_get_pin(0, 5, &cfg), 1);
+  TEST_EQ(FS_save_config("cur"), NIFFS_OK);
+  TEST_CHECK(config_equal("ref", "cur"));
+  // kept on file
+  TEST_CHECK(!config_equal("ref", "default"));
+
+  // bad ternary pins are refused
+  const char *def = "pin1 = pin2 ? a : b";
+  TEST_CHECK(def_config_parse(&cfg, def, strlen(def)));
+  cfg.tern_pin = APP_CONFIG_PINS + 1;
+  TEST_CHECK(!APP_cfg_set_pin(&cfg));
+  cfg.tern_pin = 2;
+  cfg.tern_splice = APP_CONFIG_DEFS_PER_PIN + 1;
+  TEST_CHECK(!APP_cfg_set_pin(&cfg));
+  TEST_EQ(APP_cfg_get_def_pool_usage(), defaults);
+}
+
+static bool suspend_task_ran;
+
+static void suspend_task(u32_t arg, void *arg_p) {
+  suspend_task_ran = TRUE;
+}
+
+static void test_suspend(void) {
+  app_suspend_stats st;
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = a"));
+  app_host_run_ms(10);
+  APP_clear_suspend_stats();
+
+  app_host_suspend(FALSE);
+  app_host_run_ms(10);
+  TEST_EQ(app_host_stops(), 1);
+  TEST_CHECK(!app_host_timer_running());
+  // main loop still runs tasks queued by interrupts, and stops again
+  suspend_task_ran = FALSE;
+  task *t = TASK_create(suspend_task, 0);
+  TASK_run(t, 0, NULL);
+  app_host_run_ms(1);
+  TEST_CHECK(suspend_task_ran);
+  TEST_EQ(app_host_stops(), 2);
+  // suspended again meanwhile
+  app_host_suspend(FALSE);
+  app_host_run_ms(1);
+  APP_get_suspend_stats(&st);
+  TEST_EQ(st.suspends, 1);
+  // no remote wakeup, press is not sampled
+  app_host_pin(1, TRUE);
+  app_host_run_ms(10);
+  TEST_CHECK(app_host_suspended());
+  TEST_EQ(app_host_wakeups(), 0);
+  app_host_pin(1, FALSE);
+
+  app_host_resume();
+  app_host_run_ms(1);
+  u32_t stops = app_host_stops();
+  TEST_CHECK(app_host_timer_running());
+  app_host_run_ms(10);
+  TEST_EQ(app_host_stops(), stops);
+  TEST_EQ(app_host_report_count(DEV_KB), 0);
+
+  // suspended again after resume
+  app_host_suspend(FALSE);
+  app_host_run_ms(5);
+  TEST_CHECK(app_host_stops() > stops);
+  app_host_resume();
+  app_host_run_ms(1);
+  APP_get_suspend_stats(&st);
+  TEST_EQ(st.suspends, 2);
+  TEST_CHECK(app_host_timer_running());
+}
+
+static void test_suspend_remote_wakeup(void) {
+  app_suspend_stats st;
+  app_host_init();
+  TEST_CHECK(app_host_def("pin1 = a"));
+  app_host_run_ms(10);
+  APP_clear_suspend_stats();
+  app_host_suspend(TRUE);
+  app_host_run_ms(10);
+  APP_get_suspend_stats(&st);
+  TEST_CHECK(st.wake_pins > 0);
+
+  // a tap shorter than debouncing wakes the host and is reported
+  app_host_pin(1, TRUE);
+  app_host_run_us(SAMPLE_US);
+  app_host_pin(1, FALSE);
+  TEST_CHECK(!app_host_suspended());
+  TEST_EQ(app_host_wakeups(), 1);
+  TEST_CHECK(app_host_timer_running());
+  app_host_run_ms(20);
+  TEST_EQ(app_host_kb_first(KC_A), 0);
+  TEST_CHECK(!app_host_kb_has(KC_A));
+  APP_get_suspend_stats(&st);
+  TEST_EQ(st.wakeups, 1);
+  TEST_EQ(st.missed, 0);
+}
+
+// a pin sharing its exti line with an armed pin is sampled on the rtc alarm
+static void test_suspend_unarmed_pin(void) {
+  app_suspend_stats st;
+  const gpio_pin_map *in = GPIO_MAP_get_pin_map();
+  int pin = 0, i, j;
+  for (i = 0; pin == 0 && i < APP_CONFIG_GPIO_PINS; i++) {
+    for (j = 0; j < i; j++) {
+      if (!GPIO_MAP_IS_UNUSED(&in[i]) && !GPIO_MAP_IS_UNUSED(&in[j]) &&
+          in[i].pin == in[j].pin) {
+        pin = i + 1;
+        break;
+      }
+    }
+  }
+  TEST_CHECK(pin > 0);
+  char def[16];
+  app_host_init();
+  sprintf(def, "pin%i = a", pin);
+  TEST_CHECK(app_host_def(def));
+  app_host_run_ms(10);
+  APP_clear_suspend_stats();
+  app_host_suspend(TRUE);
+  app_host_run_ms(10);
+  APP_get_suspend_stats(&st);
+  TEST_CHECK(st.unarmed_pins > 0);
+
+  // woken only by the alarm meanwhile
+  u32_t stops = app_host_stops();
+  app_host_run_ms(100);
+  TEST_CHECK(app_host_stops() - stops >= 4);
+  TEST_CHECK(app_host_stops() - stops <= 6);
+  TEST_CHECK(app_host_suspended());
+
+  // held over an alarm period, wakes the host and is reported
+  app_host_pin(pin, TRUE);
+  app_host_run_ms(25);
+  TEST_CHECK(!app_host_suspended());
+  TEST_EQ(app_host_wakeups(), 1);
+  app_host_run_ms(20);
+  TEST_CHECK(app_host_kb_has(KC_A));
+  app_host_pin(pin, FALSE);
+  app_host_run_ms(20);
+  TEST_CHECK(!app_host_kb_has(KC_A));
+  APP_get_suspend_stats(&st);
+  TEST_EQ(st.wakeups, 1);
+  TEST_EQ(st.missed, 0);
+}
+
+int main(void) {
+  TEST_RUN(test_bitset);
+  TEST_RUN(test_debounce);
+  TEST_RUN(test_debounce_bounce);
+  TEST_RUN(test_pins_over_words);
+  TEST_RUN(test_staged_latch);
+  TEST_RUN(test_default_buttons);
+  TEST_RUN(test_combo);
+  TEST_RUN(test_combo_window_timeout);
+  TEST_RUN(test_combo_other_pin_ends_window);
+  TEST_RUN(test_combo_tap_in_window);
+  TEST_RUN(test_combo_bigger);
+  TEST_RUN(test_combo_window_zero);
+  TEST_RUN(test_layer_hold);
+  TEST_RUN(test_layer_toggle);
+  TEST_RUN(test_layer_oneshot);
+  TEST_RUN(test_layer_keep_on_release);
+  TEST_RUN(test_socd_last);
+  TEST_RUN(test_socd_first);
+  TEST_RUN(test_socd_neutral);
+  TEST_RUN(test_socd_4way);
+  TEST_RUN(test_acc_curve_axis);
+  TEST_RUN(test_motion);
+  TEST_RUN(test_motion_min_hold);
+  TEST_RUN(test_motion_too_slow);
+  TEST_RUN(test_motion_step_time);
+  TEST_RUN(test_motion_wrong_order);
+  TEST_RUN(test_motion_ignores_between);
+  TEST_RUN(test_macro_restart);
+  TEST_RUN(test_ternary_toggle);
+  TEST_RUN(test_macro_ternary);
+  TEST_RUN(test_config_bad);
+  TEST_RUN(test_suspend);
+  TEST_RUN(test_suspend_remote_wakeup);
+  TEST_RUN(test_suspend_unarmed_pin);
+  return test_report("app");
+}
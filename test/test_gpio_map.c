@@ -0,0 +1,65 @@
+/*
+ * test_gpio_map.c
+ *
+ * Pin map checks of gpio_map.c, built once per board description.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "test.h"
+#include "gpio_map.h"
+#include <string.h>
+
+static gpio_pin_map map[APP_CONFIG_GPIO_PINS];
+
+// default map with first pin moved to given gpio
+static int check_first(gpio_port port, gpio_pin pin) {
+  int i;
+  memcpy(map, GPIO_MAP_get_default_pin_map(), sizeof(map));
+  for (i = 0; i < APP_CONFIG_GPIO_PINS; i++) {
+    if (map[i].port == port && map[i].pin == pin) map[i].port = GPIO_MAP_UNUSED_PORT;
+  }
+  map[0].port = port;
+  map[0].pin = pin;
+  return GPIO_MAP_check_pin_map(map);
+}
+
+static void test_default_map(void) {
+  TEST_EQ(GPIO_MAP_check_pin_map(GPIO_MAP_get_default_pin_map()), -1);
+  GPIO_MAP_init();
+  u8_t ops;
+  GPIO_MAP_get_sample_ops(&ops);
+  TEST_CHECK(ops > 0);
+  TEST_EQ(ops, GPIO_MAP_count_sample_ops(GPIO_MAP_get_default_pin_map()));
+}
+
+static void test_reserved(void) {
+  const gpio_pin_map *led = GPIO_MAP_get_led_map();
+  TEST_EQ(check_first(PORTA, PIN11), 0);
+  TEST_EQ(check_first(PORTA, PIN13), 0);
+  TEST_EQ(check_first(PORTA, PIN14), 0);
+  TEST_EQ(check_first(BOARD_USB_CABLE_PORT, BOARD_USB_CABLE_PIN), 0);
+  TEST_EQ(check_first(led->port, led->pin), 0);
+  TEST_EQ(check_first(GPIO_MAP_PORTS, PIN0), 0);
+  // jtag pins are free only when jtag is disabled
+  int jtag = BOARD_SWJ_JTAG_DISABLE ? -1 : 0;
+  TEST_EQ(check_first(PORTA, PIN15), jtag);
+  TEST_EQ(check_first(PORTB, PIN3), jtag);
+  TEST_EQ(check_first(PORTB, PIN4), jtag);
+}
+
+static void test_duplicate(void) {
+  memcpy(map, GPIO_MAP_get_default_pin_map(), sizeof(map));
+  map[2] = map[1];
+  TEST_EQ(GPIO_MAP_check_pin_map(map), 2);
+  map[2].port = GPIO_MAP_UNUSED_PORT;
+  TEST_EQ(GPIO_MAP_check_pin_map(map), -1);
+}
+
+int main(void) {
+  TEST_RUN(test_default_map);
+  TEST_RUN(test_reserved);
+  TEST_RUN(test_duplicate);
+  return test_report("gpio_map " BOARD_NAME);
+}
@@ -0,0 +1,246 @@
+/*
+ * test_io_exp.c
+ *
+ * io_exp.c against the MCP23017 register model: configuration, INT driven
+ * reads merged into the expander state, offline backoff and restart of
+ * transfers the driver did not accept.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "test.h"
+#include "host.h"
+#include "mcp23017.h"
+#include "io_exp.h"
+
+#define PIN_GPA(x)  (1 << (x))
+#define PIN_GPB(x)  (1 << (8 + (x)))
+
+static bool int_line(void) {
+  return gpio_get(IO_EXP_INT_PORT, IO_EXP_INT_PIN) != 0;
+}
+
+// pins given as set bits are grounded, others pulled up
+static void press(u16_t pins) {
+  mcp_set_pins(0, ~pins);
+}
+
+static void ms_tick(int ms) {
+  while (ms--) {
+    host_advance_us(1000);
+    IO_EXP_timer();
+  }
+}
+
+static void setup(void) {
+  host_init();
+  mcp_init(IO_EXP_I2C_ADDR, IO_EXP_DEVICES, IO_EXP_INT_PORT, IO_EXP_INT_PIN);
+  IO_EXP_init();
+  mcp_complete_all();
+  IO_EXP_clear_stats();
+}
+
+static void test_config(void) {
+  host_init();
+  mcp_init(IO_EXP_I2C_ADDR, IO_EXP_DEVICES, IO_EXP_INT_PORT, IO_EXP_INT_PIN);
+  IO_EXP_init();
+  TEST_CHECK(mcp_busy());
+  TEST_CHECK(IO_EXP_busy());
+  TEST_CHECK(mcp_complete());
+
+  mcp23017 *m = mcp_get(0);
+  TEST_EQ(m->regs[MCP_IOCON], MCP_IOCON_MIRROR | MCP_IOCON_ODR);
+  TEST_EQ(m->regs[MCP_IODIRA], 0xff);
+  TEST_EQ(m->regs[MCP_IODIRA+1], 0xff);
+  TEST_EQ(m->regs[MCP_IPOLA], 0xff);
+  TEST_EQ(m->regs[MCP_IPOLA+1], 0xff);
+  TEST_EQ(m->regs[MCP_GPINTENA], 0xff);
+  TEST_EQ(m->regs[MCP_GPINTENA+1], 0xff);
+  TEST_EQ(m->regs[MCP_DEFVALA], 0);
+  TEST_EQ(m->regs[MCP_INTCONA], 0);
+  TEST_EQ(m->regs[MCP_GPPUA], 0xff);
+  TEST_EQ(m->regs[MCP_GPPUA+1], 0xff);
+
+  // initial read follows configuration
+  TEST_CHECK(mcp_busy());
+  TEST_CHECK(mcp_complete());
+  TEST_CHECK(!mcp_busy());
+  TEST_CHECK(!IO_EXP_busy());
+  TEST_CHECK(IO_EXP_is_online(0));
+  TEST_EQ(IO_EXP_get_state(0), 0);
+  TEST_EQ(host_critical_depth(), 0);
+}
+
+static void test_int_read(void) {
+  setup();
+  TEST_CHECK(int_line());
+
+  press(PIN_GPA(3) | PIN_GPB(0));
+  TEST_CHECK(!int_line());
+  TEST_CHECK(mcp_busy());
+  // state changes only when read completes
+  TEST_EQ(IO_EXP_get_state(0), 0);
+  host_advance_us(150);
+  TEST_CHECK(mcp_complete());
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPA(3) | PIN_GPB(0));
+  TEST_CHECK(int_line());
+  TEST_CHECK(!mcp_busy());
+
+  press(PIN_GPB(0));
+  TEST_CHECK(mcp_busy());
+  host_advance_us(90);
+  mcp_complete_all();
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPB(0));
+
+  press(0);
+  mcp_complete_all();
+  TEST_EQ(IO_EXP_get_state(0), 0);
+
+  io_exp_stats s;
+  IO_EXP_get_stats(0, &s);
+  TEST_EQ(s.reads, 3);
+  TEST_EQ(s.errors, 0);
+  TEST_EQ(s.lat_last_us, 0);
+  TEST_EQ(s.lat_min_us, 0);
+  TEST_EQ(s.lat_max_us, 150);
+  TEST_EQ(host_critical_depth(), 0);
+}
+
+static void test_change_during_read(void) {
+  setup();
+  press(PIN_GPA(0));
+  TEST_CHECK(mcp_busy());
+  // second change while INT still asserted gives no new flank, the ongoing
+  // read picks it up
+  press(PIN_GPA(0) | PIN_GPA(1));
+  mcp_complete_all();
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPA(0) | PIN_GPA(1));
+  TEST_CHECK(int_line());
+
+  // change after read cleared INT gives a new read
+  press(PIN_GPA(1));
+  TEST_CHECK(mcp_busy());
+  mcp_complete_all();
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPA(1));
+}
+
+static void test_rejected_start(void) {
+  setup();
+  mcp_reject_starts(1);
+  press(PIN_GPA(5));
+  // driver did not accept the read, it stays queued
+  TEST_CHECK(!mcp_busy());
+  TEST_CHECK(!IO_EXP_busy());
+  TEST_EQ(IO_EXP_get_state(0), 0);
+  TEST_CHECK(IO_EXP_is_online(0));
+
+  ms_tick(1);
+  TEST_CHECK(mcp_busy());
+  mcp_complete_all();
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPA(5));
+
+  io_exp_stats s;
+  IO_EXP_get_stats(0, &s);
+  TEST_EQ(s.errors, 1);
+  TEST_EQ(s.reads, 1);
+}
+
+static void test_read_error_retried(void) {
+  setup();
+  mcp_fail_transfers(2);
+  press(PIN_GPB(7));
+  mcp_complete_all();
+  TEST_CHECK(IO_EXP_is_online(0));
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPB(7));
+  io_exp_stats s;
+  IO_EXP_get_stats(0, &s);
+  TEST_EQ(s.errors, 2);
+  TEST_EQ(s.offline, 0);
+}
+
+static void test_offline_backoff(void) {
+  setup();
+  press(PIN_GPA(2));
+  mcp_complete_all();
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPA(2));
+
+  // bus failing, consecutive failed reads take expander offline
+  mcp_fail_transfers(1000);
+  press(PIN_GPA(2) | PIN_GPA(4));
+  mcp_complete_all();
+  TEST_CHECK(!IO_EXP_is_online(0));
+  TEST_EQ(IO_EXP_get_state(0), 0);
+  io_exp_stats s;
+  IO_EXP_get_stats(0, &s);
+  TEST_EQ(s.errors, 4);
+  TEST_EQ(s.offline, 1);
+
+  // first retry after 8 ms, still failing
+  ms_tick(7);
+  TEST_CHECK(!mcp_busy());
+  ms_tick(1);
+  TEST_CHECK(mcp_busy());
+  mcp_complete_all();
+  TEST_CHECK(!IO_EXP_is_online(0));
+  IO_EXP_get_stats(0, &s);
+  TEST_EQ(s.offline, 2);
+
+  // backoff doubled
+  ms_tick(15);
+  TEST_CHECK(!mcp_busy());
+  u32_t started = mcp_started();
+  ms_tick(1);
+  TEST_EQ(mcp_started(), started + 1);
+
+  // bus back, expander lost its configuration meanwhile
+  mcp_fail_transfers(0);
+  mcp_power(0, FALSE);
+  mcp_power(0, TRUE);
+  mcp_complete_all();
+  TEST_CHECK(IO_EXP_is_online(0));
+  mcp23017 *m = mcp_get(0);
+  TEST_EQ(m->regs[MCP_IOCON], MCP_IOCON_MIRROR | MCP_IOCON_ODR);
+  TEST_EQ(m->regs[MCP_GPINTENA], 0xff);
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPA(2) | PIN_GPA(4));
+  TEST_CHECK(int_line());
+
+  // reads again on change
+  press(0);
+  mcp_complete_all();
+  TEST_EQ(IO_EXP_get_state(0), 0);
+  TEST_EQ(host_critical_depth(), 0);
+}
+
+static void test_backoff_reset_when_online(void) {
+  setup();
+  mcp_fail_transfers(4);
+  press(PIN_GPA(0));
+  mcp_complete_all();
+  TEST_CHECK(!IO_EXP_is_online(0));
+  ms_tick(8);
+  mcp_complete_all();
+  TEST_CHECK(IO_EXP_is_online(0));
+  TEST_EQ(IO_EXP_get_state(0), PIN_GPA(0));
+
+  // a later loss starts over at the shortest backoff
+  mcp_fail_transfers(4);
+  press(0);
+  mcp_complete_all();
+  TEST_CHECK(!IO_EXP_is_online(0));
+  ms_tick(8);
+  mcp_complete_all();
+  TEST_CHECK(IO_EXP_is_online(0));
+  TEST_EQ(IO_EXP_get_state(0), 0);
+}
+
+int main(void) {
+  TEST_RUN(test_config);
+  TEST_RUN(test_int_read);
+  TEST_RUN(test_change_during_read);
+  TEST_RUN(test_rejected_start);
+  TEST_RUN(test_read_error_retried);
+  TEST_RUN(test_offline_backoff);
+  TEST_RUN(test_backoff_reset_when_online);
+  return test_report("io_exp");
+}
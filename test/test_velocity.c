@@ -0,0 +1,228 @@
+/*
+ * test_velocity.c
+ *
+ * Fixed point velocities, accelerators and curves of velocity.c.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "test.h"
+#include "velocity.h"
+#include <stdlib.h>
+
+#define PERIOD_US   7000
+
+// counts moved in total_us at given report interval
+static s32_t move(s32_t vel, u32_t interval_us, u32_t total_us) {
+  vel_axis a = { 0 };
+  s32_t sum = 0;
+  u32_t t;
+  for (t = 0; t + interval_us <= total_us; t += interval_us) {
+    sum += VEL_step(&a, vel, interval_us, PERIOD_US);
+  }
+  return sum;
+}
+
+static void test_step_rate_independent(void) {
+  const u32_t intervals[] = { 7000, 3500, 1000, 125 };
+  int i;
+  for (i = 0; i < 4; i++) {
+    // a whole number of intervals and of periods, sub Q16 truncation per
+    // report may lose a count at most
+    u32_t total_us = 7000 * 1000;
+    s32_t c;
+    c = move(VEL_target(5, NULL, 0), intervals[i], total_us);
+    TEST_CHECK(c >= 4999 && c <= 5000);
+    c = move(VEL_target(1, NULL, 0), intervals[i], total_us);
+    TEST_CHECK(c >= 999 && c <= 1000);
+    c = move(-VEL_target(3, NULL, 0), intervals[i], total_us);
+    TEST_CHECK(c >= -3000 && c <= -2999);
+  }
+  // one second at 3.3 ms, not a whole number of periods
+  s32_t c = move(VEL_target(5, NULL, 0), 3300, 1000000);
+  TEST_CHECK(c >= 5 * 999900 / PERIOD_US - 1 && c <= 5 * 999900 / PERIOD_US + 1);
+}
+
+static void test_step_fraction(void) {
+  vel_axis a = { 0 };
+  int i;
+  s32_t sum = 0;
+  int reports = 0;
+  // quarter count per period moves every fourth report
+  for (i = 0; i < 100; i++) {
+    s8_t c = VEL_step(&a, VEL_ONE / 4, PERIOD_US, PERIOD_US);
+    sum += c;
+    if (c) reports++;
+  }
+  TEST_EQ(sum, 25);
+  TEST_EQ(reports, 25);
+
+  // one and a half backwards
+  memset(&a, 0, sizeof(a));
+  sum = 0;
+  for (i = 0; i < 100; i++) {
+    s8_t c = VEL_step(&a, -VEL_ONE * 3 / 2, PERIOD_US, PERIOD_US);
+    TEST_CHECK(c == -1 || c == -2);
+    sum += c;
+  }
+  TEST_EQ(sum, -150);
+}
+
+static void test_step_limits(void) {
+  vel_axis a = { 0 };
+  // stopping drops the remainder
+  TEST_EQ(VEL_step(&a, VEL_ONE / 2, PERIOD_US, PERIOD_US), 0);
+  TEST_CHECK(a.pos != 0);
+  TEST_EQ(VEL_step(&a, 0, PERIOD_US, PERIOD_US), 0);
+  TEST_EQ(a.pos, 0);
+  TEST_EQ(VEL_step(&a, VEL_ONE / 2, PERIOD_US, PERIOD_US), 0);
+
+  // overflowing report is capped and drops the rest
+  memset(&a, 0, sizeof(a));
+  TEST_EQ(VEL_step(&a, 100 * VEL_ONE, 2 * PERIOD_US, PERIOD_US), VEL_REPORT_MAX);
+  TEST_EQ(a.pos, 0);
+  TEST_EQ(VEL_step(&a, -100 * VEL_ONE, 2 * PERIOD_US, PERIOD_US), -VEL_REPORT_MAX);
+  TEST_EQ(a.pos, 0);
+
+  // at least one count per period
+  TEST_EQ(VEL_target(0, NULL, 0), VEL_ONE);
+}
+
+static void test_ramp(void) {
+  // ramped by speed per period of elapsed time
+  TEST_EQ(VEL_ramp(0, 4, PERIOD_US, PERIOD_US), 4 * VEL_ONE);
+  TEST_EQ(VEL_ramp(0, 4, PERIOD_US / 2, PERIOD_US), 2 * VEL_ONE);
+  TEST_EQ(VEL_ramp(VEL_ONE, 4, 0, PERIOD_US), VEL_ONE);
+  TEST_EQ(VEL_ramp(0, 4, 2000 * PERIOD_US, PERIOD_US), (u32_t)VEL_ACC_MAX * VEL_ONE);
+  TEST_EQ(VEL_ramp((u32_t)VEL_ACC_MAX * VEL_ONE, 4, PERIOD_US, PERIOD_US),
+      (u32_t)VEL_ACC_MAX * VEL_ONE);
+
+  u32_t acc = 0;
+  int i;
+  for (i = 0; i < 7; i++) {
+    acc = VEL_ramp(acc, 4, 1000, PERIOD_US);
+  }
+  // truncated a Q16 fraction per ramp at most
+  TEST_CHECK(acc <= 4 * VEL_ONE && acc >= 4 * VEL_ONE - 7);
+}
+
+// accelerated axis from rest, as a held mouse definition
+static s32_t move_accelerated(u8_t data, const u16_t *lut, u32_t interval_us, u32_t total_us) {
+  vel_axis a = { 0 };
+  u32_t acc = 0;
+  s32_t sum = 0;
+  u32_t t;
+  for (t = 0; t + interval_us <= total_us; t += interval_us) {
+    acc = VEL_ramp(acc, 4, interval_us, PERIOD_US);
+    sum += VEL_step(&a, VEL_target(data, lut, acc), interval_us, PERIOD_US);
+  }
+  return sum;
+}
+
+static void test_accelerated_rate_independent(void) {
+  u16_t lut[VEL_LUT_LEN];
+  vel_curve linear = { .type = VEL_CURVE_LINEAR };
+  TEST_CHECK(VEL_build_lut(&linear, lut));
+  // full speed at end of accelerator range
+  TEST_EQ(VEL_target(100, lut, (u32_t)VEL_ACC_MAX * VEL_ONE), 100 * VEL_ONE);
+
+  s32_t ref = move_accelerated(100, lut, 7000, 7000 * 1000);
+  TEST_CHECK(ref > 0);
+  const u32_t intervals[] = { 3500, 1000, 125 };
+  int i;
+  for (i = 0; i < 3; i++) {
+    s32_t c = move_accelerated(100, lut, intervals[i], 7000 * 1000);
+    TEST_CHECK(abs(c - ref) <= ref / 100);
+  }
+}
+
+static void test_curves(void) {
+  u16_t lut[VEL_LUT_LEN];
+  vel_curve c = { 0 };
+  int t, i;
+  for (t = VEL_CURVE_LINEAR; t <= VEL_CURVE_S; t++) {
+    c.type = t;
+    TEST_CHECK(VEL_build_lut(&c, lut));
+    // 0 and full speed at range ends
+    TEST_EQ(lut[0], 0);
+    TEST_EQ(lut[VEL_LUT_LEN-1], VEL_ONE >> 1);
+    for (i = 1; i < VEL_LUT_LEN; i++) {
+      TEST_CHECK(lut[i] >= lut[i-1]);
+    }
+    TEST_EQ(VEL_target(100, lut, (u32_t)VEL_ACC_MAX * VEL_ONE), 100 * VEL_ONE);
+  }
+  // slow starts
+  c.type = VEL_CURVE_QUADRATIC;
+  VEL_build_lut(&c, lut);
+  TEST_CHECK(lut[VEL_LUT_LEN/2] < (VEL_ONE >> 2) + 1024);
+  TEST_CHECK(lut[VEL_LUT_LEN/2] > (VEL_ONE >> 3) - 1024);
+  c.type = VEL_CURVE_S;
+  VEL_build_lut(&c, lut);
+  TEST_CHECK(lut[VEL_LUT_LEN/8] < (VEL_ONE >> 1) / 8);
+  TEST_CHECK(lut[VEL_LUT_LEN-1-VEL_LUT_LEN/8] > (VEL_ONE >> 1) * 7 / 8);
+}
+
+static void test_curve_linear_matches(void) {
+  u16_t lut[VEL_LUT_LEN];
+  vel_curve c = { .type = VEL_CURVE_LINEAR };
+  VEL_build_lut(&c, lut);
+  u32_t acc;
+  s64_t worst = 0;
+  for (acc = 0; acc <= (u32_t)VEL_ACC_MAX * VEL_ONE; acc += VEL_ONE * 7 + 13) {
+    // previous linear accelerator, data scaled by accelerator range
+    s64_t old = ((s64_t)100 * acc) / VEL_ACC_MAX;
+    s64_t vel = VEL_target(100, lut, acc);
+    if (old < VEL_ONE) old = VEL_ONE;
+    worst = MAX(worst, llabs(vel - old));
+  }
+  // Q15 table and interpolation each truncate, so within two counts per
+  // 32768 of full speed
+  TEST_CHECK(worst <= 2 * 100 * VEL_ONE / 32768);
+}
+
+static void test_curve_user(void) {
+  u16_t lut[VEL_LUT_LEN];
+  vel_curve c = { .type = VEL_CURVE_USER, .points = 3,
+      .x = { 0, 50, 100 }, .y = { 10, 20, 100 } };
+  int i;
+  TEST_CHECK(VEL_build_lut(&c, lut));
+  TEST_EQ(lut[0], (VEL_ONE * 10 / 100) >> 1);
+  TEST_EQ(lut[VEL_LUT_LEN-1], VEL_ONE >> 1);
+  for (i = 1; i < VEL_LUT_LEN; i++) {
+    TEST_CHECK(lut[i] >= lut[i-1]);
+  }
+  // knee at half range
+  TEST_CHECK(abs(lut[VEL_LUT_LEN/2] - (VEL_ONE * 20 / 100 >> 1)) < 512);
+
+  // bad user points fall back to linear
+  u16_t lin[VEL_LUT_LEN];
+  vel_curve l = { .type = VEL_CURVE_LINEAR };
+  VEL_build_lut(&l, lin);
+  vel_curve bad[] = {
+      { .type = VEL_CURVE_USER, .points = 0 },
+      { .type = VEL_CURVE_USER, .points = VEL_CURVE_POINTS + 1 },
+      { .type = VEL_CURVE_USER, .points = 2, .x = { 50, 50 }, .y = { 0, 100 } },
+      { .type = VEL_CURVE_USER, .points = 2, .x = { 60, 20 }, .y = { 0, 100 } },
+      { .type = VEL_CURVE_USER, .points = 2, .x = { 0, 101 }, .y = { 0, 100 } },
+      { .type = VEL_CURVE_USER, .points = 2, .x = { 0, 100 }, .y = { 0, 101 } },
+      { .type = _VEL_CURVE_CNT },
+  };
+  for (i = 0; i < (int)(sizeof(bad)/sizeof(bad[0])); i++) {
+    memset(lut, 0xff, sizeof(lut));
+    TEST_CHECK(!VEL_build_lut(&bad[i], lut));
+    TEST_CHECK(memcmp(lut, lin, sizeof(lut)) == 0);
+  }
+}
+
+int main(void) {
+  TEST_RUN(test_step_rate_independent);
+  TEST_RUN(test_step_fraction);
+  TEST_RUN(test_step_limits);
+  TEST_RUN(test_ramp);
+  TEST_RUN(test_accelerated_rate_independent);
+  TEST_RUN(test_curves);
+  TEST_RUN(test_curve_linear_matches);
+  TEST_RUN(test_curve_user);
+  return test_report("velocity");
+}
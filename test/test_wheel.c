@@ -0,0 +1,169 @@
+/*
+ * test_wheel.c
+ *
+ * Timer wheel of wheel.c against a reference of expected expiry ticks, with
+ * random timers started, restarted and stopped over many ticks.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: petera
+ */
+
+#include "test.h"
+#include "host.h"
+#include "wheel.h"
+#include <stdlib.h>
+
+#define TIMERS      200
+#define TICKS       200000
+// level 1 spans this many ticks, later timers go round it
+#define SPAN        (WHEEL_SLOTS * WHEEL_SLOTS)
+
+static struct {
+  wheel_timer t;
+  bool running;
+  u32_t expiry;       // expected tick of next expiry
+  u32_t recurrent;
+  u32_t fired;
+} timers[TIMERS];
+static u32_t now;
+static u32_t late;        // callbacks not on their expiry tick
+static u32_t stray;       // callbacks of stopped timers
+static u32_t round_trips; // expiries of timers started beyond level 1 span
+static bool churn;        // callbacks stop and start timers
+
+static u32_t rand_delay(void) {
+  switch (rand() % 4) {
+  case 0: return rand() % WHEEL_SLOTS;
+  case 1: return rand() % SPAN;
+  case 2: return SPAN + rand() % (4 * SPAN);
+  default: return rand() % 64;
+  }
+}
+
+static void start(int i, u32_t delay, u32_t recurrent);
+
+static void timer_cb(u32_t i, void *arg_p) {
+  TEST_CHECK(arg_p == &timers[i]);
+  if (!timers[i].running) {
+    stray++;
+    return;
+  }
+  if (timers[i].expiry != now) late++;
+  if (timers[i].expiry - timers[i].fired >= SPAN) round_trips++;
+  timers[i].fired = now;
+  if (timers[i].recurrent) {
+    timers[i].expiry = now + timers[i].recurrent;
+  } else {
+    timers[i].running = FALSE;
+  }
+  // callbacks stop or restart themselves, or another timer
+  switch (churn ? rand() % 16 : -1) {
+  case 0:
+    WHEEL_stop(&timers[i].t);
+    timers[i].running = FALSE;
+    break;
+  case 1:
+    start(i, rand_delay(), 0);
+    break;
+  case 2: {
+    int o = rand() % TIMERS;
+    WHEEL_stop(&timers[o].t);
+    timers[o].running = FALSE;
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+static void start(int i, u32_t delay, u32_t recurrent) {
+  WHEEL_start(&timers[i].t, timer_cb, i, &timers[i], delay, recurrent);
+  timers[i].running = TRUE;
+  timers[i].expiry = now + MAX(delay, 1);
+  timers[i].recurrent = recurrent;
+  // counts from start, for round trips
+  timers[i].fired = now;
+}
+
+static void test_random(void) {
+  wheel_stats st;
+  int i;
+  host_init();
+  WHEEL_init();
+  memset(timers, 0, sizeof(timers));
+  now = 0;
+  late = stray = round_trips = 0;
+  churn = TRUE;
+  srand(1);
+  for (i = 0; i < TIMERS; i++) {
+    start(i, rand_delay(), rand() % 3 ? 0 : 1 + rand_delay());
+  }
+  for (now = 1; now <= TICKS; now++) {
+    WHEEL_tick();
+    // some churn from outside callbacks
+    if (rand() % 8 == 0) {
+      i = rand() % TIMERS;
+      if (rand() % 4 == 0) {
+        WHEEL_stop(&timers[i].t);
+        timers[i].running = FALSE;
+      } else {
+        start(i, rand_delay(), rand() % 3 ? 0 : 1 + rand_delay());
+      }
+    }
+  }
+  now--;
+  TEST_EQ(late, 0);
+  TEST_EQ(stray, 0);
+  TEST_CHECK(round_trips > 0);
+  int running = 0;
+  for (i = 0; i < TIMERS; i++) {
+    TEST_EQ(WHEEL_is_running(&timers[i].t), timers[i].running);
+    if (!timers[i].running) continue;
+    running++;
+    // none overdue
+    TEST_CHECK((s32_t)(timers[i].expiry - now) > 0);
+  }
+  WHEEL_get_stats(&st);
+  TEST_EQ(WHEEL_count(), running);
+  TEST_EQ(st.level_timers[0] + st.level_timers[1], running);
+  TEST_EQ(st.ticks, TICKS);
+  TEST_CHECK(st.cascaded > 0);
+  TEST_CHECK(st.expired > TICKS / 10);
+}
+
+// a single timer far beyond level 1 span expires on its tick
+static void test_round_trip(void) {
+  const u32_t delays[] = { 1, WHEEL_SLOTS - 1, WHEEL_SLOTS, SPAN - 1, SPAN, SPAN + 1,
+      3 * SPAN + 17, 1500, 5000 };
+  int d;
+  host_init();
+  WHEEL_init();
+  memset(timers, 0, sizeof(timers));
+  churn = FALSE;
+  for (d = 0; d < (int)(sizeof(delays)/sizeof(delays[0])); d++) {
+    // at all offsets within a level 0 round
+    u32_t offs;
+    for (offs = 0; offs < WHEEL_SLOTS; offs += 7) {
+      memset(&timers[0], 0, sizeof(timers[0]));
+      for (now = 0; now < offs; now++) WHEEL_tick();
+      start(0, delays[d], 0);
+      late = stray = 0;
+      u32_t until = now + delays[d] + 2 * SPAN;
+      while (now < until) {
+        now++;
+        WHEEL_tick();
+      }
+      TEST_EQ(timers[0].fired, timers[0].expiry);
+      TEST_CHECK(!timers[0].running);
+      TEST_EQ(late, 0);
+      TEST_EQ(WHEEL_count(), 0);
+      WHEEL_init();
+    }
+  }
+}
+
+int main(void) {
+  TEST_RUN(test_random);
+  TEST_RUN(test_round_trip);
+  return test_report("wheel");
+}